@@ -2,7 +2,7 @@
 #include <WiFi.h>
 #include <WebServer.h>
 #include <Preferences.h>
-#include "interface.h"
+#include "web_assets.h"
 
 #define PIN_DOOR_OPEN       32
 #define PIN_LOCK_SIGNAL     33
@@ -110,7 +110,7 @@ String extractJsonValue(String json, String key) {
 }
 
 void handleRoot() {
-  server.send(200, "text/html", HTML_PAGE);
+  serveStaticAsset(server, HTML_PAGE);
 }
 
 void handleGetConfig() {
@@ -405,6 +405,7 @@ void setup() {
   server.on("/getConfig", handleGetConfig);
   server.on("/getStatus", handleGetStatus);
   server.on("/saveConfig", HTTP_POST, handleSaveConfig);
+  staticAssetHeaders(server);
   server.begin();
   
   addLog("System ready - " + WiFi.softAPIP().toString());
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Capacidade máxima de blocos (limitada também pela memória disponível).
+#ifndef LADDER_MAX_BLOCKS
+#define LADDER_MAX_BLOCKS 1024
+#endif
+// Heap interna que fica livre para Wi-Fi/servidor ao dimensionar a arena.
+#ifndef LADDER_HEAP_RESERVE
+#define LADDER_HEAP_RESERVE (64 * 1024)
+#endif
+
+// Região única alocada uma vez no boot (PSRAM se houver, senão heap interna)
+// e fatiada em arrays contíguos. Recargas de programa reutilizam as mesmas
+// fatias, então não fragmentam a heap.
+// Sem memória reservada a arena só mede: take() devolve nullptr e soma o
+// tamanho, o que permite calcular a capacidade antes de alocar.
+class BlockArena {
+public:
+    BlockArena();
+    ~BlockArena();
+    BlockArena(const BlockArena&) = delete;
+    BlockArena& operator=(const BlockArena&) = delete;
+
+    bool reserve(size_t bytes);
+    void release();
+    // Volta ao início (nova medição ou novo fatiamento).
+    void rewind() { used = 0; }
+
+    template <class T>
+    T* take(size_t count) {
+        size_t align = alignof(T);
+        size_t at = (used + align - 1) & ~(align - 1);
+        used = at + count * sizeof(T);
+        if (!base) return nullptr;
+        return reinterpret_cast<T*>(base + at);
+    }
+
+    bool measuring() const { return base == nullptr; }
+    size_t bytesUsed() const { return used; }
+    size_t bytesReserved() const { return size; }
+    bool inPsram() const { return psram; }
+
+    // Bytes alocáveis para a arena agora (PSRAM ou maior bloco livre da heap
+    // interna menos LADDER_HEAP_RESERVE).
+    static size_t available();
+
+private:
+    uint8_t* base;
+    size_t size;
+    size_t used;
+    bool psram;
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdint.h>
+
+// Camada de registradores do banco GPIO0..31. No ESP32 lê GPIO_IN e escreve
+// GPIO_OUT_W1TS/W1TC em um único acesso cada; no host usa variáveis que
+// simulam os registradores, para testes e benchmarks fora do alvo.
+#ifdef ARDUINO
+#include "soc/gpio_reg.h"
+#include "soc/soc.h"
+
+namespace gpio_port {
+
+inline uint32_t readIn() {
+    return REG_READ(GPIO_IN_REG);
+}
+
+inline void writeOut(uint32_t setMask, uint32_t clearMask) {
+    REG_WRITE(GPIO_OUT_W1TS_REG, setMask);
+    REG_WRITE(GPIO_OUT_W1TC_REG, clearMask);
+}
+
+} // namespace gpio_port
+
+#else
+
+namespace gpio_port {
+
+extern uint32_t hostIn;     // Nível lido dos pinos (estímulo do teste)
+extern uint32_t hostOut;    // Último valor aplicado em GPIO_OUT
+extern uint32_t hostWrites; // Quantidade de acessos de escrita
+
+inline uint32_t readIn() {
+    return hostIn;
+}
+
+inline void writeOut(uint32_t setMask, uint32_t clearMask) {
+    hostOut = (hostOut | setMask) & ~clearMask;
+    hostWrites += 2;
+}
+
+} // namespace gpio_port
+
+#endif
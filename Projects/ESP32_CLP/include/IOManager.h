@@ -6,15 +6,19 @@ constexpr uint8_t INPUTS_COUNT = 4;
 constexpr uint8_t OUTPUTS_COUNT = 6;
 
 // Pinos escolhidos para evitar conflitos de boot e permitir pull-up interno.
+// Todos ficam no banco GPIO0..31 para leitura/escrita em um único registrador.
 extern const uint8_t INPUT_PINS[INPUTS_COUNT];
 extern const uint8_t OUTPUT_PINS[OUTPUTS_COUNT];
 
+// Imagem de processo: bit i = entrada/saída lógica i.
 class IOManager {
 public:
     IOManager();
 
     void init();
+    // Uma leitura de GPIO_IN por varredura: a imagem de entradas é coerente.
     void scanInputs();
+    // Aplica a imagem de saídas com um par W1TS/W1TC.
     void updateOutputs();
 
     bool getInput(uint8_t index);
@@ -25,9 +29,34 @@ public:
     void getAllOutputs(bool* buffer);
     void setAllOutputs(const bool* buffer);
 
+    // Acesso sem verificação de faixa para o programa compilado
+    // (índices já validados pelo compilador).
+    bool inputAt(uint8_t index) const { return (inputBits >> index) & 1u; }
+    bool outputAt(uint8_t index) const { return (outputBits >> index) & 1u; }
+    void writeOutputAt(uint8_t index, bool state) {
+        uint32_t bit = 1u << index;
+        outputBits = state ? (outputBits | bit) : (outputBits & ~bit);
+    }
+
+    uint32_t getInputBits() const { return inputBits; }
+    uint32_t getOutputBits() const { return outputBits; }
+    // Entradas que mudaram na última varredura.
+    uint32_t getInputChanges() const { return inputChanges; }
+    // Saídas que mudaram na última aplicação da imagem.
+    uint32_t getOutputChanges() const { return outputChanges; }
+    // Incrementa a cada scanInputs(); permite ao consumidor saber se perdeu varreduras.
+    uint32_t getScanCount() const { return scanCount; }
+    // Relê GPIO_IN e diz se alguma entrada difere da imagem atual.
+    bool inputsDifferFromImage() const;
+
 private:
-    bool inputs[INPUTS_COUNT];
-    bool outputs[OUTPUTS_COUNT];
+    uint32_t inputBits;
+    uint32_t outputBits;
+    uint32_t appliedOutputs;
+    uint32_t inputChanges;
+    uint32_t outputChanges;
+    uint32_t scanCount;
+    uint32_t outPinMask;
 };
 
 extern IOManager ioManager;
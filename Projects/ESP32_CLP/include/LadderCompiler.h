@@ -0,0 +1,84 @@
+#pragma once
+
+#include <stdint.h>
+#include "LadderTypes.h"
+#include "BlockArena.h"
+#include "IOManager.h"
+
+// Opcodes do programa compilado. Cada bloco vira exatamente uma instrução,
+// com índices de I/O já validados e operandos já resolvidos para slots.
+enum class OpCode : uint8_t {
+    LD_IN,      // v[dst] = in[io]
+    LD_NIN,     // v[dst] = !in[io]
+    LD_TRUE,    // v[dst] = 1
+    LD_FALSE,   // v[dst] = 0
+    AND,        // v[dst] = v[a] && v[b]
+    OR,         // v[dst] = v[a] || v[b]
+    ANDN,       // v[dst] = AND de v[args[a .. a + b)]
+    ORN,        // v[dst] = OR de v[args[a .. a + b)]
+    NOT,        // v[dst] = !v[a]
+    MOV,        // v[dst] = v[a] (bobina sem saída válida)
+    OUT,        // out[io] = v[dst] = v[a]
+    SET,        // se v[a]: out[io] = 1; v[dst] = out[io]
+    RST,        // se v[a]: out[io] = 0; v[dst] = out[io]
+    TON,        // temporizador na energização (delay em delayUs[dst])
+    TOF,        // temporizador na desenergização
+    TP,         // pulso na borda de subida de v[a]
+    TONR,       // retentivo: acumula com v[a], zera com v[b]
+    CTU,        // contador crescente: bordas de v[a], zera com v[b]
+    CTD         // contador decrescente: bordas de v[a], carrega com v[b]
+};
+
+struct Instr {
+    OpCode op;
+    uint8_t io;     // Índice de I/O validado
+    uint16_t dst;   // Bloco de destino (slot de valor e estado de runtime)
+    uint16_t a;     // Slot do operando A (ANDN/ORN: início em args)
+    uint16_t b;     // Slot do operando B (ANDN/ORN: quantidade)
+};
+
+// Programa achatado em ordem topológica. Arrays fatiados da BlockArena.
+struct CompiledProgram {
+    Instr* code;            // Uma instrução por bloco
+    uint16_t* args;         // Slots dos operandos das portas de N entradas
+    uint16_t slotFalse;     // Slot sempre falso (= capacidade): entradas desconectadas
+    uint16_t length;
+    uint32_t argCount;
+    uint16_t feedbackEdges; // Ciclos quebrados (leem o valor da varredura anterior)
+    uint16_t danglingRefs;  // Referências a blocos inexistentes (viram slotFalse)
+    uint16_t badIo;         // Índices de I/O fora da faixa
+};
+
+// Área de trabalho da ordenação topológica.
+struct CompileScratch {
+    uint16_t* indegree;
+    uint32_t* succStart;
+    uint16_t* succList;
+    uint32_t* ready;        // Bitmap de blocos prontos
+};
+
+// Índices para avaliação por eventos (modo delta). Tudo indexado pela posição
+// da instrução em CompiledProgram::code, não pelo id do bloco.
+struct DeltaIndex {
+    uint16_t* posOf;        // id do bloco -> posição
+    uint32_t* fanStart;     // CSR: consumidores de cada posição
+    uint16_t* fanList;
+    uint32_t* inputUsers;   // Quem lê cada entrada: INPUTS_COUNT linhas de 'words'
+    uint32_t* outputUsers;  // Quem escreve/lê saídas
+    uint16_t words;
+
+    const uint32_t* usersOf(uint8_t input) const { return inputUsers + input * words; }
+};
+
+// Fatiam as estruturas para 'capacity' blocos e 'operandCapacity' operandos.
+void carveProgram(BlockArena& arena, uint16_t capacity, uint32_t operandCapacity,
+                  CompiledProgram& prog, CompileScratch& scratch);
+void carveDeltaIndex(BlockArena& arena, uint16_t capacity, uint32_t operandCapacity, DeltaIndex& out);
+
+// Valida o grafo, ordena topologicamente e emite o fluxo de instruções.
+// Blocos sem dependência mútua mantêm a ordem do JSON; blocos que escrevem
+// na mesma saída também. Ciclos são quebrados no bloco de menor índice.
+void compileProgram(const BlockTable& blocks, CompiledProgram& out, CompileScratch& scratch);
+
+// Monta as listas de fan-out a partir do programa já ordenado.
+void buildDeltaIndex(const CompiledProgram& prog, DeltaIndex& out);
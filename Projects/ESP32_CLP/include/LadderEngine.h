@@ -4,69 +4,179 @@
 #include <ArduinoJson.h>
 #include <LittleFS.h>
 #include "IOManager.h"
+#include "LadderTypes.h"
+#include "BlockArena.h"
+#include "LadderCompiler.h"
+#include "LadderPatch.h"
+#include "ScanProfiler.h"
+#include "TimerWheel.h"
 
-// Tipos de blocos suportados.
-enum class BlockType : uint8_t {
-    CONTACT_NO,
-    CONTACT_NC,
-    COIL,
-    AND,
-    OR,
-    NOT,
-    TIMER_ON,
-    TIMER_OFF,
-    LATCH_SET,
-    LATCH_RESET,
-    CONST_TRUE,
-    CONST_FALSE
-};
+constexpr uint16_t MIN_CYCLE_MS = 1;
+constexpr uint16_t MAX_CYCLE_MS = 100;
+// Capacidade mínima da arena, mesmo com pouca memória (o antigo limite fixo).
+constexpr uint16_t MIN_BLOCK_CAPACITY = 64;
+// Operandos reservados por bloco no pool compartilhado (média).
+constexpr uint8_t OPERANDS_PER_BLOCK = 2;
 
-// Descrição estática do bloco vinda do JSON.
-struct BlockDef {
-    BlockType type;
-    int8_t inA;          // Índice do bloco de entrada A (-1 quando não usado)
-    int8_t inB;          // Índice do bloco de entrada B (-1 quando não usado)
-    uint8_t ioIndex;     // Índice de I/O (entrada/saída) quando aplicável
-    uint32_t delayMs;    // Para temporizadores
+// FULL: avalia todas as instruções a cada varredura.
+// DELTA: avalia só o que está a jusante de entradas alteradas ou de
+// temporizadores vencidos. Resultados idênticos ao FULL.
+enum class EvalMode : uint8_t {
+    FULL,
+    DELTA
 };
 
-// Estado em tempo de execução do bloco (timers/latches).
-struct BlockRuntime {
-    bool value;
-    bool latched;
-    uint32_t timerStart;
-    bool timerActive;
-};
+// Palavras por bloco retentivo (TONR e contadores).
+constexpr uint8_t RETAIN_SLOT_WORDS = 3;
 
-constexpr uint8_t MAX_BLOCKS = 64;
+// Origem do último programa carregado do armazenamento.
+enum class ProgramSource : uint8_t {
+    NONE,
+    IMAGE,   // /program.bin (sem parse)
+    JSON     // /program.json (imagem ausente ou inválida)
+};
 
 class LadderEngine {
 public:
     LadderEngine();
 
-    void init();
+    // Dimensiona a arena (até maxBlocks, limitado pela memória livre) e
+    // carrega o programa salvo. false: nem a capacidade mínima coube e o
+    // motor não pode varrer nem ser consultado.
+    bool init(uint16_t maxBlocks = LADDER_MAX_BLOCKS);
     void clearProgram();
 
     // Carrega programa de JSON (string) e opcionalmente persiste.
     bool loadFromJson(const String& json, bool persist = false);
+    // Variante em duas etapas: o chamador desserializa fora da seção crítica
+    // da varredura e só aplica (e depois persiste) o documento já pronto.
+    bool loadFromDocument(const JsonDocument& doc) { return parseDocument(doc); }
+    bool saveProgram(const String& json) { return saveProgramInternal(json); }
+    // Tenta a imagem binária e cai para o JSON; mede o tempo de carga.
     bool loadFromStorage();
     bool eraseStorage();
+    uint32_t getLoadUs() const { return loadUs; }
+    ProgramSource getLoadSource() const { return loadSource; }
+    // Grava o programa atual (JSON + imagem), p. ex. depois de um patch.
+    bool saveCurrentProgram();
+
+    // Edição online: {"modify": [{id, campos...}], "remove": [ids],
+    // "add": [blocos], "cycle_ms", "eval"}. Ids (alvos e referências) são os
+    // do programa atual; os adicionados recebem count, count + 1, ... na
+    // ordem de "add". Depois da remoção os ids são compactados.
+    // preparePatch só lê o programa (roda sem bloquear a varredura);
+    // commitPatch troca a tabela e herda o estado dos blocos mantidos, e
+    // deve ser chamado com a varredura parada (ScanLock).
+    bool preparePatch(const JsonDocument& doc, LadderPatch& patch) const;
+    void commitPatch(LadderPatch& patch);
+    uint32_t getLastPatchUs() const { return lastPatchUs; }
+
+    // JSON gerado sob demanda direto no destino, sem documento intermediário.
+    void writeProgramJson(Print& out) const;
     String serializeProgram() const;
 
     void tick();
+    // Avaliador original bloco a bloco, na ordem do JSON, com temporizadores
+    // por polling. Mantido como referência para comparação de resultados e de
+    // tempo de varredura; não alternar com tick() no mesmo programa carregado.
+    void tickInterpreted();
     void setCycleMs(uint16_t periodMs);
     uint16_t getCycleMs() const { return cycleMs; }
 
+    // Tempo de varredura (scanInputs + programa + updateOutputs) em µs.
+    uint32_t getLastScanUs() const { return lastScanUs; }
+    uint32_t getMaxScanUs() const { return maxScanUs; }
+    void resetScanStats() { maxScanUs = 0; }
+    const CompiledProgram& getProgram() const { return program; }
+
+    // Perfil por bloco (ScanProfiler); ligar e desligar com a varredura
+    // parada. Zerado a cada programa compilado (os ids mudam de sentido).
+    bool setProfiling(bool on);
+    bool isProfiling() const { return profiler.isEnabled(); }
+    const ScanProfiler& getProfiler() const { return profiler; }
+    void clearProfile() { profiler.clear(); }
+    const BlockTable& getTable() const { return table; }
+
+    void setEvalMode(EvalMode mode);
+    EvalMode getEvalMode() const { return evalMode; }
+    // Instruções avaliadas na última varredura.
+    uint16_t getLastEvalCount() const { return lastEvalCount; }
+    // Modo delta sem trabalho pendente: só uma borda de entrada, um prazo
+    // da roda ou uma alteração externa muda o resultado.
+    bool isSettled() const { return evalMode == EvalMode::DELTA && !deltaReset && settled; }
+    // Próximo prazo de temporizador em µs de esp_timer (UINT64_MAX se nenhum).
+    uint64_t nextDeadlineUs() { return wheel.nextDeadline(); }
+    uint16_t getBlockCount() const { return table.count; }
+    uint16_t getCapacity() const { return table.capacity; }
+    uint32_t getOperandCapacity() const { return table.operandCapacity; }
+    size_t getArenaBytes() const { return arena.bytesReserved(); }
+    bool isArenaInPsram() const { return arena.inPsram(); }
+    // Copia o valor de cada bloco para um bitmap (bit i = bloco i).
+    void packValues(uint32_t* words, uint16_t wordCount) const;
+
+    // Estado retentivo (RetainStore) em palavras de 32 bits: a palavra 0
+    // guarda as saídas comandadas por LATCH_SET/RESET; depois, na ordem dos
+    // blocos, RETAIN_SLOT_WORDS por TONR (tempo acumulado, concluído) e por
+    // contador (contagem, entrada anterior). A assinatura muda quando tipos
+    // ou I/O mudam, invalidando o estado guardado de outro programa.
+    uint16_t getRetainWords() const { return retainWordCount; }
+    uint32_t getRetainSignature() const { return retainSig; }
+    void captureRetain(uint32_t* words) const;
+    // Antes da primeira varredura, com o programa já compilado.
+    void restoreRetain(const uint32_t* words);
+
 private:
     bool parseDocument(const JsonDocument& doc);
     bool loadProgramInternal(File& f);
     bool saveProgramInternal(const String& json);
-    bool computeBlock(uint8_t idx, uint32_t now);
+    bool loadImage();
+    bool saveImage() const;
+    void resetRuntime();
+    bool allocate(uint16_t maxBlocks);
+    void carve(BlockArena& a, uint16_t capacity, uint32_t operandCapacity);
+    bool computeBlock(uint16_t idx, uint64_t now);
+    void compile();
+    template <bool PROFILE> void scan();
+    template <bool PROFILE> void runCompiled(uint64_t now);
+    template <bool PROFILE> void runDelta(uint64_t now);
+    void execInstr(const Instr& in, uint64_t now);
+    void fireExpired(uint32_t* marks);
+    void startTimer(uint16_t id, uint64_t now, uint64_t durationUs);
+    void stopTimer(uint16_t id);
+    void rearmTimers();
+    void layoutRetain();
 
-    BlockDef blocks[MAX_BLOCKS];
-    BlockRuntime runtime[MAX_BLOCKS];
-    uint8_t blockCount;
+    // Tudo abaixo que é array vive na arena (struct-of-arrays).
+    BlockArena arena;
+    BlockTable table;
+    BlockRuntime* runtime;
+    uint8_t* values;                    // capacity + 1: o último é o slot falso
+    CompiledProgram program;
+    CompileScratch scratch;
     uint16_t cycleMs;
+    uint32_t lastScanUs;
+    uint32_t maxScanUs;
+    uint32_t loadUs;
+    uint32_t lastPatchUs;
+    ProgramSource loadSource;
+
+    EvalMode evalMode;
+    DeltaIndex delta;
+    uint32_t* pendingNext;              // Marcados para a próxima varredura
+    uint32_t* dirty;                    // Marcados para esta varredura
+    TimerWheel wheel;
+    bool deltaReset;
+    bool settled;
+    uint32_t lastOutStart;
+    uint16_t lastEvalCount;
+
+    uint16_t retainWordCount;
+    uint32_t retainSig;
+    uint32_t retainOutMask;             // Saídas de latches
+    uint16_t* retainBlocks;             // Índices com slot retentivo, na ordem dos slots
+    uint16_t retainBlockCount;
+
+    ScanProfiler profiler;
 };
 
 extern LadderEngine ladderEngine;
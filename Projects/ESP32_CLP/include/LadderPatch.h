@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include "BlockArena.h"
+#include "LadderTypes.h"
+
+// Edição online já validada. É montada fora da seção crítica da varredura
+// (LadderEngine::preparePatch) e aplicada entre duas varreduras
+// (LadderEngine::commitPatch), que só copia arrays e recompila.
+struct LadderPatch {
+    LadderPatch()
+        : origin(nullptr), kept(0), fresh(0), removed(0), cycleMs(0), evalMode(-1),
+          error(nullptr), prepareUs(0), applyUs(0) {
+        memset(&table, 0, sizeof(table));
+    }
+
+    BlockArena arena;     // Tabela nova e mapas; liberados junto com o patch
+    BlockTable table;     // Programa resultante, já renumerado
+    BlockRef* origin;     // Bloco antigo cujo estado é herdado, ou NO_BLOCK
+    uint16_t kept;        // Blocos com estado preservado
+    uint16_t fresh;       // Adicionados ou com tipo trocado (estado zerado)
+    uint16_t removed;
+    uint16_t cycleMs;     // 0 = mantém
+    int8_t evalMode;      // -1 = mantém
+    const char* error;    // Motivo da recusa
+    uint32_t prepareUs;   // Validação e montagem (sem bloquear a varredura)
+    uint32_t applyUs;     // Tempo com a varredura bloqueada
+};
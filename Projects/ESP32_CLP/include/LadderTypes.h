@@ -0,0 +1,98 @@
+#pragma once
+
+#include <stdint.h>
+
+// Tipos de blocos suportados.
+enum class BlockType : uint8_t {
+    CONTACT_NO,
+    CONTACT_NC,
+    COIL,
+    AND,
+    OR,
+    NOT,
+    TIMER_ON,
+    TIMER_OFF,
+    LATCH_SET,
+    LATCH_RESET,
+    CONST_TRUE,
+    CONST_FALSE,
+    TIMER_PULSE,      // TP: pulso de delay na borda de subida de A
+    TIMER_RETENTIVE,  // TONR: acumula enquanto A; B zera
+    COUNTER_UP,       // CTU: conta bordas de A; B zera; saída = contagem >= preset
+    COUNTER_DOWN      // CTD: desconta bordas de A; B carrega preset; saída = contagem <= 0
+};
+constexpr uint8_t BLOCK_TYPE_COUNT = (uint8_t)BlockType::COUNTER_DOWN + 1;
+
+// Nome do tipo como no JSON do programa.
+const char* blockTypeToString(BlockType t);
+
+// Referência a bloco (id). 16 bits: até 32767 blocos, -1 = não usado.
+using BlockRef = int16_t;
+constexpr BlockRef NO_BLOCK = -1;
+constexpr uint16_t MAX_BLOCK_CAPACITY = 32767;
+
+// Programa em struct-of-arrays: cada campo em seu próprio array contíguo,
+// alocados na BlockArena. Os operandos ficam num pool compartilhado (CSR):
+// os do bloco i são operands[opStart[i] .. opStart[i + 1]).
+// AND/OR aceitam N operandos; os demais tipos guardam só os que usam.
+struct BlockTable {
+    uint16_t count;
+    uint16_t capacity;
+    uint32_t operandCapacity;
+    BlockType* type;
+    uint8_t* ioIndex;     // Índice de I/O (entrada/saída) quando aplicável
+    uint32_t* opStart;    // capacity + 1 posições
+    BlockRef* operands;
+    int32_t* preset;      // Para contadores
+    uint64_t* delayUs;    // Para temporizadores
+
+    uint32_t operandCount() const { return opStart[count]; }
+    uint32_t arity(uint16_t i) const { return opStart[i + 1] - opStart[i]; }
+    BlockRef operand(uint16_t i, uint32_t k) const {
+        return k < arity(i) ? operands[opStart[i] + k] : NO_BLOCK;
+    }
+    BlockRef inA(uint16_t i) const { return operand(i, 0); }
+    BlockRef inB(uint16_t i) const { return operand(i, 1); }
+};
+
+// Operandos fixos de cada tipo (AND/OR: mínimo, aceitam mais).
+inline uint8_t blockOperands(BlockType t) {
+    switch (t) {
+        case BlockType::AND:
+        case BlockType::OR:
+        case BlockType::TIMER_RETENTIVE:
+        case BlockType::COUNTER_UP:
+        case BlockType::COUNTER_DOWN:
+            return 2;
+        case BlockType::NOT:
+        case BlockType::TIMER_ON:
+        case BlockType::TIMER_OFF:
+        case BlockType::TIMER_PULSE:
+        case BlockType::LATCH_SET:
+        case BlockType::LATCH_RESET:
+        case BlockType::COIL:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+inline bool isGate(BlockType t) {
+    return t == BlockType::AND || t == BlockType::OR;
+}
+
+// Estado em tempo de execução do bloco (timers/latches/contadores).
+struct BlockRuntime {
+    uint64_t timerStart; // Início do trecho cronometrado (µs)
+    uint64_t accUs;      // TONR: tempo já acumulado
+    int32_t count;       // Contadores
+    bool latched;
+    bool timerActive;    // Agendado na roda de temporização
+    bool done;           // Prazo atingido
+    bool prevIn;         // Entrada A na varredura anterior (detecção de borda)
+};
+
+// Palavras de 32 bits para um bitmap com um bit por bloco.
+inline uint16_t blockWords(uint16_t blocks) {
+    return (blocks + 31) / 32;
+}
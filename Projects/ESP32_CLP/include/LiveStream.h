@@ -0,0 +1,98 @@
+#pragma once
+
+#include <Arduino.h>
+#include <WiFi.h>
+
+// Porta própria: as conexões ficam abertas e não podem prender o WebServer.
+#ifndef LIVE_STREAM_PORT
+#define LIVE_STREAM_PORT 81
+#endif
+#ifndef LIVE_MAX_CLIENTS
+#define LIVE_MAX_CLIENTS 8
+#endif
+// Taxa máxima de quadros por cliente (o cliente pode pedir menos com ?hz=).
+#ifndef LIVE_MAX_HZ
+#define LIVE_MAX_HZ 30
+#endif
+// Blocos observados por cliente (?watch=id,id,...).
+constexpr uint8_t LIVE_MAX_WATCH = 32;
+// Cliente que não esvazia o socket (aba em segundo plano, rede lenta) por
+// mais que isto é desconectado; até lá os quadros dele são agregados.
+#ifndef LIVE_SLOW_CLIENT_MS
+#define LIVE_SLOW_CLIENT_MS 3000
+#endif
+
+// Canal Server-Sent Events (GET /events na LIVE_STREAM_PORT) com o estado
+// de I/O e de blocos observados. Cada quadro é um JSON mínimo só com os
+// campos alterados desde o último enviado àquele cliente:
+//   data:{"i":<bits entradas>,"o":<bits saídas>,"w":<bits observados>}
+// Mudanças dentro do intervalo mínimo do cliente são agregadas num só
+// quadro. Bordas de I/O acordam a tarefa na hora (notifyChange); os valores
+// observados são conferidos no período do cliente mais rápido.
+//
+// Uma só tarefa atende todos os clientes e nunca bloqueia: a requisição de
+// quem conecta é lida aos poucos a cada volta, e a escrita só entrega ao
+// socket o que cabe no buffer de envio. O resto de um quadro fica no slot
+// e sai antes do próximo; enquanto isso as mudanças são agregadas.
+class LiveStream {
+public:
+    LiveStream();
+
+    void begin();
+    // Chamado pela varredura quando a imagem de I/O publicada muda.
+    void notifyChange();
+    uint8_t getClientCount() const { return clientCount; }
+    uint32_t getFramesSent() const { return framesSent; }
+    uint32_t getSlowDrops() const { return slowDrops; }
+
+private:
+    enum class SlotState : uint8_t { FREE, READING, STREAMING };
+
+    struct Client {
+        SlotState state;
+        WiFiClient sock;
+        // READING: linha da requisição; STREAMING: resto do quadro a enviar.
+        char buf[192];
+        uint16_t bufLen;
+        uint16_t headerLen;    // Tamanho da linha de cabeçalho corrente
+        bool haveRequestLine;
+        uint32_t acceptMs;
+        uint32_t stalledSinceMs; // 0 = socket em dia
+        uint16_t watch[LIVE_MAX_WATCH];
+        uint8_t watchCount;
+        uint16_t intervalMs;
+        uint32_t lastSendMs;
+        uint32_t inputBits;
+        uint32_t outputBits;
+        uint32_t watchBits;
+        bool sentOnce;
+    };
+
+    static void taskEntry(void* arg);
+    void run();
+    void accept();
+    // Lê o que já chegou da requisição do slot; promove a STREAMING na
+    // linha em branco ou descarta em erro/timeout.
+    void pollRequest(uint8_t slot, uint32_t now);
+    bool parseRequestLine(const char* line, Client& c);
+    // Entrega o resto pendente sem bloquear; true se não sobrou nada.
+    bool flushPending(Client& c, uint32_t now);
+    // Envia o quadro pendente do cliente; devolve ms até poder enviar de novo
+    // (0 = nada pendente).
+    uint32_t service(Client& c, uint32_t now);
+    void drop(uint8_t slot);
+    void release(uint8_t slot);
+
+    WiFiServer server;
+    TaskHandle_t handle;
+    Client clients[LIVE_MAX_CLIENTS];
+    uint32_t* valueWords;      // Bitmap de valores lido do snapshot
+    uint16_t wordCount;
+    uint32_t snapInputs;
+    uint32_t snapOutputs;
+    volatile uint8_t clientCount;   // Em STREAMING
+    volatile uint32_t framesSent;
+    volatile uint32_t slowDrops;
+};
+
+extern LiveStream liveStream;
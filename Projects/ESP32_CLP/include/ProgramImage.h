@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "LadderTypes.h"
+
+// Imagem binária do programa gravada ao lado do JSON: cabeçalho seguido dos
+// arrays da BlockTable exatamente como ficam em memória (tipos, I/O, início
+// dos operandos, operandos, presets, delays). No boot cada seção é lida
+// direto para o seu array, sem passar pelo ArduinoJson.
+constexpr uint32_t PROGRAM_IMAGE_MAGIC = 0x3152444C; // "LDR1"
+constexpr uint16_t PROGRAM_IMAGE_VERSION = 2;
+
+struct ProgramImageHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t headerSize;
+    uint16_t blockCount;
+    uint16_t cycleMs;
+    uint32_t operandCount;
+    uint8_t evalMode;
+    uint8_t reserved[3];
+    uint32_t crc;         // CRC-32 do cabeçalho (até aqui) e das seções
+};
+
+static_assert(sizeof(ProgramImageHeader) == 24, "layout do cabeçalho mudou");
+
+// Seção da imagem: um array da BlockTable.
+struct ProgramImageSection {
+    void* data;
+    size_t bytes;
+};
+constexpr uint8_t PROGRAM_IMAGE_SECTIONS = 6;
+
+// CRC-32 (IEEE 802.3), incremental: passar o valor anterior em 'crc'.
+uint32_t crc32Update(uint32_t crc, const void* data, size_t len);
+
+// Seções na ordem do arquivo para os tamanhos do cabeçalho.
+void programImageSections(const BlockTable& t, const ProgramImageHeader& h,
+                          ProgramImageSection out[PROGRAM_IMAGE_SECTIONS]);
+// Preenche o CRC do cabeçalho a partir da tabela.
+void programImageSeal(ProgramImageHeader& h, const BlockTable& t);
+// Valida magic, versão e tamanhos contra a capacidade antes de ler as seções.
+bool programImageHeaderValid(const ProgramImageHeader& h, const BlockTable& t);
+// Valida o cabeçalho, a consistência dos operandos e o CRC.
+bool programImageCheck(const ProgramImageHeader& h, const BlockTable& t);
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <Arduino.h>
+#include "LadderEngine.h"
+
+// Palavras retentivas na RTC (3 por TONR/contador + 1): 512 = ~170 blocos.
+#ifndef RETAIN_MAX_WORDS
+#define RETAIN_MAX_WORDS 512
+#endif
+// Lote para a flash: a cada N varreduras com mudança ou após T ms (o modo
+// delta pode dormir por muito tempo sem varrer).
+#ifndef RETAIN_FLASH_SCANS
+#define RETAIN_FLASH_SCANS 500
+#endif
+#ifndef RETAIN_FLASH_MS
+#define RETAIN_FLASH_MS 10000
+#endif
+// Tamanho do diário antes de compactar numa nova base.
+#ifndef RETAIN_JOURNAL_MAX
+#define RETAIN_JOURNAL_MAX 16384
+#endif
+
+enum class RetainSource : uint8_t {
+    COLD,   // Nada válido: estado inicial do programa
+    RTC,    // Reset quente (brown-out, watchdog, software): memória RTC
+    FLASH   // Falta de energia: base + diário no LittleFS
+};
+
+// Memória retentiva em dois níveis:
+// - RTC slow memory (RTC_NOINIT): sobrevive a resets sem falta de energia.
+//   A cada varredura só as palavras alteradas são regravadas, sem desgaste.
+// - Diário no LittleFS (/retain.bin + /retain.log): lotes só com as
+//   palavras alteradas desde o anterior, no máximo um a cada
+//   RETAIN_FLASH_SCANS varreduras / RETAIN_FLASH_MS; compactado numa base
+//   nova ao passar de RETAIN_JOURNAL_MAX. Lote incompleto (corte no meio da
+//   gravação) falha no CRC e é descartado na leitura; como os lotes
+//   seguintes iriam depois dele, o próximo flush() grava uma base nova.
+// No boot restore() devolve o estado ao motor antes da primeira varredura.
+class RetainStore {
+public:
+    RetainStore();
+
+    // Depois de carregar o programa, antes da primeira varredura.
+    RetainSource restore(LadderEngine& engine);
+    // Tarefa de gravação em flash (no host flush() é chamado direto).
+    void begin();
+
+    // Chamado pela varredura, dona do motor: nunca bloqueia nem grava flash.
+    void capture(const LadderEngine& engine);
+    // Lote pronto para a flash.
+    bool flushDue() const;
+    // Grava o lote pendente no diário.
+    void flush();
+    // Descarta a cópia da RTC (próximo boot lê a flash); também usado pela
+    // simulação para uma falta de energia.
+    void invalidateRtc();
+
+    RetainSource getSource() const { return source; }
+    uint16_t getWords() const { return words; }
+    uint32_t getRtcCommits() const { return rtcCommits; }
+    uint32_t getFlashBatches() const { return flashBatches; }
+    uint32_t getJournalBytes() const { return journalBytes; }
+
+private:
+    static void taskEntry(void* arg);
+    void relayout(const LadderEngine& engine);
+    void writeRtc();
+    bool rtcValid() const;
+    bool loadJournal(bool& clean);
+    bool writeBase(const uint32_t* data, uint16_t n, uint32_t sig);
+    bool appendBatch(const uint32_t* data, uint16_t n);
+    bool tryLock();
+    void lock();
+    void unlock();
+
+    uint32_t live[RETAIN_MAX_WORDS];     // Última captura
+    uint32_t flashed[RETAIN_MAX_WORDS];  // Conteúdo atual do diário (só flush() e restore())
+    uint32_t batch[RETAIN_MAX_WORDS];    // Cópia de 'live' para gravar
+    uint16_t words;
+    uint32_t signature;
+    bool enabled;
+    bool flashedValid;
+    volatile bool pending;               // Mudanças ainda fora da flash
+    uint32_t pendingSinceMs;
+    uint32_t scansSinceFlush;
+    uint32_t seq;
+    RetainSource source;
+    uint32_t rtcCommits;
+    uint32_t flashBatches;
+    uint32_t journalBytes;
+};
+
+extern RetainStore retainStore;
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <Arduino.h>
+#include "LadderTypes.h"
+
+// Varreduras guardadas no anel do perfilador.
+#ifndef PROFILE_RING_SCANS
+#define PROFILE_RING_SCANS 64
+#endif
+// Máximo de blocos na lista dos mais caros.
+constexpr uint8_t PROFILE_TOP_MAX = 32;
+
+// Ciclos de CPU (registrador CCOUNT do Xtensa): uma instrução para ler.
+inline uint32_t profileCycles() {
+    return ESP.getCycleCount();
+}
+
+// Etapas de uma varredura, na ordem em que rodam. TIMERS inclui a roda,
+// os vencimentos e, no modo delta, a marcação do que avaliar.
+enum class ScanPhase : uint8_t { INPUTS, TIMERS, PROGRAM, OUTPUTS };
+constexpr uint8_t SCAN_PHASE_COUNT = 4;
+
+// Uma varredura no anel.
+struct ProfileScan {
+    uint32_t cycles;
+    uint32_t phase[SCAN_PHASE_COUNT];
+    uint16_t evals;
+    uint16_t hotBlock;      // Bloco mais caro desta varredura
+    uint32_t hotCycles;
+};
+
+// Perfil opcional da varredura. Com ele ligado o CCOUNT é lido em volta de
+// cada instrução avaliada (computeBlock no avaliador de referência) e o
+// custo somado por bloco: ciclos, avaliações e pior caso. As últimas
+// PROFILE_RING_SCANS varreduras ficam num anel com o custo de cada etapa.
+// Desligado custa um teste por varredura; ligado, os contadores (16 bytes
+// por bloco) vêm do heap, fora da arena, e o custo fixo da leitura do
+// CCOUNT (medido ao ligar) é descontado de cada amostra.
+class ScanProfiler {
+public:
+    ScanProfiler();
+    ~ScanProfiler();
+
+    // Com a varredura parada (ScanLock).
+    bool enable(uint16_t capacity);
+    void disable();
+    void clear();
+    bool isEnabled() const { return blockCycles != nullptr; }
+    uint32_t getOverheadCycles() const { return overhead; }
+
+    // Chamados pela varredura.
+    void beginScan() {
+        cur = ProfileScan();
+        cur.hotBlock = UINT16_MAX;
+        scanStart = mark = profileCycles();
+    }
+    void endPhase(ScanPhase p) {
+        uint32_t now = profileCycles();
+        cur.phase[(uint8_t)p] += now - mark;
+        mark = now;
+    }
+    void addBlock(uint16_t id, uint32_t cycles) {
+        cycles = cycles > overhead ? cycles - overhead : 0;
+        blockCycles[id] += cycles;
+        blockCalls[id]++;
+        if (cycles > blockMax[id]) blockMax[id] = cycles;
+        if (cycles > cur.hotCycles) {
+            cur.hotCycles = cycles;
+            cur.hotBlock = id;
+        }
+    }
+    void endScan(uint16_t evals);
+
+private:
+    friend class ProfileReport;
+
+    uint16_t capacity;
+    uint64_t* blockCycles;
+    uint32_t* blockCalls;
+    uint32_t* blockMax;
+    ProfileScan ring[PROFILE_RING_SCANS];
+    uint32_t ringHead;                  // Próxima posição; total de varreduras
+    uint64_t phaseTotal[SCAN_PHASE_COUNT];
+    uint64_t scanTotal;
+    uint32_t scanMax;
+    uint32_t overhead;
+    uint32_t scanStart;
+    uint32_t mark;
+    ProfileScan cur;
+};
+
+// Cópia dos contadores tirada com a varredura parada; os relatórios são
+// gerados a partir dela, fora da seção crítica.
+class ProfileReport {
+public:
+    ProfileReport();
+    ~ProfileReport();
+    ProfileReport(const ProfileReport&) = delete;
+    ProfileReport& operator=(const ProfileReport&) = delete;
+
+    // Antes do ScanLock: capture() só copia.
+    bool reserve(uint16_t blocks);
+    void capture(const ScanProfiler& p, uint16_t blocks);
+
+    // {"scans","cycles_avg",...,"phases":{},"types":[],"top":[],"recent":[]}
+    void writeJson(Print& out, const BlockTable& table, uint8_t top) const;
+    // Pilhas dobradas para flamegraph.pl/speedscope, uma por linha:
+    // "scan;program;TIMER_ON;b12 <ciclos>".
+    void writeFolded(Print& out, const BlockTable& table) const;
+    // Resumo em texto para a serial.
+    void printSummary(Print& out, const BlockTable& table, uint8_t top) const;
+
+private:
+    struct TypeCost {
+        uint64_t cycles;
+        uint32_t calls;
+        uint16_t blocks;
+    };
+    uint8_t selectTop(uint16_t* ids, uint8_t top) const;
+    void sumTypes(const BlockTable& table, TypeCost* out) const;
+    uint64_t blockSum() const;
+
+    uint16_t count;
+    uint16_t reserved;
+    uint64_t* cycles;
+    uint32_t* calls;
+    uint32_t* maxCycles;
+    ProfileScan recent[PROFILE_RING_SCANS];
+    uint16_t recentCount;
+    uint32_t scans;
+    uint64_t phaseTotal[SCAN_PHASE_COUNT];
+    uint64_t scanTotal;
+    uint32_t scanMax;
+    uint32_t overhead;
+    uint32_t mhz;
+};
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+#include <esp_timer.h>
+#include "LadderTypes.h"
+
+// Núcleo dedicado à varredura; o servidor web roda no outro núcleo.
+constexpr BaseType_t SCAN_CORE = 1;
+constexpr BaseType_t WEB_CORE = 0;
+constexpr UBaseType_t SCAN_TASK_PRIORITY = configMAX_PRIORITIES - 2;
+
+// Imagem publicada pela varredura para o servidor web. Os valores dos
+// blocos (bit i = bloco i) ficam em buffers dimensionados pela capacidade.
+struct ScanSnapshot {
+    uint32_t scanCount;
+    uint32_t inputBits;
+    uint32_t outputBits;
+};
+
+struct ScanStats {
+    uint32_t scans;
+    uint32_t minUs;
+    uint32_t avgUs;
+    uint32_t maxUs;
+    uint32_t maxJitterUs;
+    uint32_t overruns;     // Disparos do timer perdidos ou varredura > ciclo
+    uint32_t sleeps;       // Modo delta: vezes que a varredura dormiu
+    uint32_t deadlineScans; // Varreduras extras por prazo de temporizador
+};
+
+// Varredura disparada por timer de hardware em uma tarefa de alta prioridade.
+// Prazos de temporizador que caem antes da próxima varredura periódica
+// disparam uma varredura extra por um esp_timer one-shot (resolução de µs).
+// No modo delta, com o programa estável, o timer é parado e a tarefa dorme
+// até uma borda de entrada, o próximo vencimento de temporizador ou uma
+// alteração vinda do servidor web.
+class ScanTask {
+public:
+    ScanTask();
+
+    void begin();
+    void setCycleMs(uint16_t periodMs);
+
+    // Leitura sem bloqueio do último snapshot completo; opcionalmente copia
+    // até 'wordCount' palavras do bitmap de valores.
+    void readSnapshot(ScanSnapshot& out, uint32_t* valueBits = nullptr, uint16_t wordCount = 0) const;
+    ScanStats getStats() const;
+    // Tempo do reset até a primeira varredura (0 antes dela).
+    uint32_t getFirstScanUs() const { return firstScanUs; }
+    void resetStats();
+
+    // Exclusão mútua com a varredura para alterar programa/saídas.
+    void lock();
+    void unlock();
+
+private:
+    static void taskEntry(void* arg);
+    static void IRAM_ATTR onTimer();
+    static void IRAM_ATTR onInputEdge();
+    static void onDeadline(void* arg);
+    // Bits de notificação da tarefa.
+    static constexpr uint32_t NOTIFY_PERIOD = 1u << 0;
+    static constexpr uint32_t NOTIFY_DEADLINE = 1u << 1;
+    static constexpr uint32_t NOTIFY_WAKE = 1u << 2;
+
+    void armDeadline(uint64_t deadlineUs);
+    bool enterSleep();
+    void leaveSleep();
+    void run();
+    void publish();
+
+    TaskHandle_t handle;
+    hw_timer_t* timer;
+    esp_timer_handle_t deadlineTimer;
+    SemaphoreHandle_t mutex;
+
+    // Double buffer com contador de sequência (ímpar = escrita em andamento).
+    ScanSnapshot buffers[2];
+    uint32_t* valueBuffers[2];
+    uint16_t valueWords;
+    std::atomic<uint32_t> seq[2];
+    std::atomic<uint8_t> published;
+
+    // Estatísticas escritas apenas pela tarefa de varredura.
+    volatile uint32_t statScans;
+    volatile uint32_t statMinUs;
+    volatile uint32_t statAvgUs;
+    volatile uint32_t statMaxUs;
+    volatile uint32_t statMaxJitterUs;
+    volatile uint32_t statOverruns;
+    volatile uint32_t statSleeps;
+    volatile uint32_t statDeadlineScans;
+    uint64_t statSumUs;
+    volatile uint32_t missedPeriods;   // Escrito pelo ISR do timer
+    volatile uint32_t firstScanUs;
+    std::atomic<bool> resetRequested;
+    std::atomic<bool> sleeping;
+};
+
+// Guarda RAII para ScanTask::lock()/unlock().
+class ScanLock {
+public:
+    ScanLock();
+    ~ScanLock();
+    ScanLock(const ScanLock&) = delete;
+    ScanLock& operator=(const ScanLock&) = delete;
+};
+
+extern ScanTask scanTask;
@@ -9,14 +9,23 @@ public:
     ServerManager();
     void init(const char* staSsid = nullptr, const char* staPass = nullptr, bool forceAp = false);
     void begin();
+    // Antes de init(): só responde 503 com o motivo, sem tocar no motor.
+    void setFault(const char* reason) { fault = reason; }
     void handleClient();
+    // Atende o servidor em tarefa própria, fora do núcleo da varredura.
+    void startTask();
 
 private:
     WebServer server;
     bool apMode;
+    const char* fault;
     String currentSsid;
     IPAddress currentIp;
+    uint32_t profileSerialMs;   // Resumo do perfil na serial (0 = não)
+    uint32_t profileLastMs;
     void setupRoutes();
+    void pollProfile();
+    static void taskEntry(void* arg);
 };
 
 extern ServerManager serverManager;
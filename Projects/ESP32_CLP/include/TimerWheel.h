@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stdint.h>
+#include "BlockArena.h"
+
+// Roda de temporização hierárquica (8 níveis x 64 posições, resolução de 1 µs,
+// alcance de 2^48 µs). Agendar e cancelar são O(1); avançar o relógio só
+// visita posições ocupadas, usando bitmaps de ocupação por nível.
+// Os temporizadores são identificados pelo id do bloco.
+class TimerWheel {
+public:
+    static constexpr uint16_t NONE = 0xFFFF;
+
+    struct Node {
+        uint64_t deadline;
+        uint16_t prev;
+        uint16_t next;
+        uint16_t list;      // Nível * LEN + posição, EXPIRED ou NONE
+    };
+
+    TimerWheel();
+
+    // Um nó por bloco, fatiado da arena.
+    void carve(BlockArena& arena, uint16_t capacity);
+    // Esvazia a roda e fixa o relógio.
+    void reset(uint64_t nowUs);
+    void schedule(uint16_t id, uint64_t deadlineUs);
+    void cancel(uint16_t id);
+    bool isScheduled(uint16_t id) const { return nodes[id].list != NONE; }
+
+    // Avança o relógio; os vencidos passam para a lista de expirados.
+    void advance(uint64_t nowUs);
+    // Retira um expirado (NONE quando não há mais).
+    uint16_t popExpired();
+
+    // Menor prazo agendado (UINT64_MAX se vazia). Mantido em cache ao agendar;
+    // só é recalculado quando o menor prazo sai da roda.
+    uint64_t nextDeadline();
+    uint16_t activeCount() const { return active; }
+
+private:
+    static constexpr uint8_t BITS = 6;
+    static constexpr uint8_t LEN = 1 << BITS;
+    static constexpr uint8_t LEVELS = 8;
+    static constexpr uint16_t EXPIRED = LEVELS * LEN;
+
+    void link(uint16_t id, uint16_t list);
+    void unlink(uint16_t id);
+    void place(uint16_t id);
+    uint64_t slotFloor(uint8_t level, uint8_t slot) const;
+
+    Node* nodes;
+    uint16_t capacity;
+    uint16_t heads[EXPIRED + 1];
+    uint64_t occupied[LEVELS];
+    uint64_t current;
+    uint64_t cachedNext;
+    bool nextValid;
+    uint16_t active;
+};
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <stdint.h>
+
+// Controle do host sobre o relógio e o console simulados (sim/shim).
+namespace host {
+
+// Tempo virtual em µs: millis(), delay() e esp_timer_get_time() leem daqui.
+// Só a simulação o avança, então uma semana de máquina roda em segundos.
+uint64_t timeUs();
+void setTimeUs(uint64_t us);
+
+// Relógio real do host em ns, para medir custo de varredura e de carga.
+uint64_t realNs();
+
+// Eco do Serial no stderr (desligado por padrão).
+void setSerialEcho(bool on);
+
+// Copia um arquivo do host para o LittleFS em memória.
+bool importFile(const char* hostPath, const char* fsPath);
+
+} // namespace host
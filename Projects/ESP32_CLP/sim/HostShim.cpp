@@ -0,0 +1,75 @@
+#include "HostClock.h"
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <esp_timer.h>
+#include <chrono>
+
+HostSerial Serial;
+HostFS LittleFS;
+EspClass ESP;
+
+namespace {
+uint64_t virtualUs = 0;
+}
+
+namespace host {
+
+uint64_t timeUs() {
+    return virtualUs;
+}
+
+void setTimeUs(uint64_t us) {
+    virtualUs = us;
+}
+
+uint64_t realNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+void setSerialEcho(bool on) {
+    Serial.echo = on;
+}
+
+bool importFile(const char* hostPath, const char* fsPath) {
+    FILE* in = fopen(hostPath, "rb");
+    if (!in) return false;
+    File out = LittleFS.open(fsPath, "w");
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), in)) > 0) out.write(buf, n);
+    fclose(in);
+    out.close();
+    return true;
+}
+
+} // namespace host
+
+uint32_t millis() {
+    return (uint32_t)(virtualUs / 1000);
+}
+
+uint32_t micros() {
+    return (uint32_t)(host::realNs() / 1000);
+}
+
+void delay(uint32_t ms) {
+    virtualUs += (uint64_t)ms * 1000;
+}
+
+void delayMicroseconds(uint32_t us) {
+    virtualUs += us;
+}
+
+int64_t esp_timer_get_time() {
+    return (int64_t)virtualUs;
+}
+
+uint32_t getCpuFrequencyMhz() {
+    return 240;
+}
+
+uint32_t EspClass::getCycleCount() {
+    return (uint32_t)(host::realNs() * 240 / 1000);
+}
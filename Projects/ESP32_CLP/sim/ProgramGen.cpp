@@ -0,0 +1,121 @@
+#include "ProgramGen.h"
+#include "IOManager.h"
+#include "LadderTypes.h"
+#include <string>
+
+namespace {
+
+// Na ordem de BlockType.
+const char* const TYPE_NAMES[] = {
+    "CONTACT_NO", "CONTACT_NC", "COIL", "AND", "OR", "NOT", "TIMER_ON", "TIMER_OFF",
+    "LATCH_SET", "LATCH_RESET", "CONST_TRUE", "CONST_FALSE", "TIMER_PULSE", "TIMER_RETENTIVE",
+    "COUNTER_UP", "COUNTER_DOWN",
+};
+constexpr uint8_t TYPE_COUNT = sizeof(TYPE_NAMES) / sizeof(TYPE_NAMES[0]);
+
+void header(std::string& out, bool delta) {
+    out += "{\"cycle_ms\":20,\"eval\":\"";
+    out += delta ? "delta" : "full";
+    out += "\",\"blocks\":[";
+}
+
+void block(std::string& out, uint16_t id, const char* type) {
+    if (id) out += ',';
+    out += "{\"id\":" + std::to_string(id) + ",\"type\":\"" + type + "\"";
+}
+
+void field(std::string& out, const char* name, long long value) {
+    out += ",\"";
+    out += name;
+    out += "\":" + std::to_string(value);
+}
+
+void operands(std::string& out, const int* refs, uint8_t n) {
+    out += ",\"in\":[";
+    for (uint8_t k = 0; k < n; k++) {
+        if (k) out += ',';
+        out += std::to_string(refs[k]);
+    }
+    out += ']';
+}
+
+} // namespace
+
+String ladderProgram(uint16_t blocks, bool delta) {
+    std::string out;
+    header(out, delta);
+    for (uint16_t id = 0; id < blocks; id++) {
+        uint16_t rung = id / 6;
+        uint16_t base = rung * 6;
+        switch (id % 6) {
+            case 0:
+                block(out, id, "CONTACT_NO");
+                field(out, "io", rung % INPUTS_COUNT);
+                break;
+            case 1:
+                block(out, id, "CONTACT_NC");
+                field(out, "io", (rung + 1) % INPUTS_COUNT);
+                break;
+            case 2: {
+                block(out, id, "AND");
+                // Encadeia no relé do degrau anterior.
+                int refs[3] = {base, base + 1, base - 1};
+                operands(out, refs, rung ? 3 : 2);
+                break;
+            }
+            case 3:
+                block(out, id, "TIMER_ON");
+                field(out, "a", id - 1);
+                field(out, "delay_ms", 20 + (rung % 10) * 30);
+                break;
+            case 4:
+                block(out, id, "OR");
+                field(out, "a", id - 1);
+                field(out, "b", rung ? base - 2 : id - 2);
+                break;
+            case 5:
+                if (rung % 8 == 0) {
+                    block(out, id, "COIL");
+                    field(out, "io", (rung / 8) % OUTPUTS_COUNT);
+                } else {
+                    block(out, id, "NOT");
+                }
+                field(out, "a", id - 1);
+                break;
+        }
+        out += '}';
+    }
+    out += "]}";
+    return String(out);
+}
+
+String randomProgram(std::mt19937& rng, uint16_t blocks, bool feedback) {
+    std::string out;
+    header(out, false);
+    for (uint16_t id = 0; id < blocks; id++) {
+        BlockType type = (BlockType)(rng() % TYPE_COUNT);
+        block(out, id, TYPE_NAMES[(uint8_t)type]);
+
+        uint8_t count = blockOperands(type);
+        if (isGate(type) && rng() % 3 == 0) count = rng() % 6 + 1;
+        int refs[6];
+        int limit = feedback ? blocks : (id ? id : 1);
+        for (uint8_t k = 0; k < count; k++) {
+            refs[k] = (!feedback && id == 0) || rng() % 10 == 0 ? -1 : (int)(rng() % limit);
+            if (rng() % 40 == 0) refs[k] = blocks + 5;
+        }
+        if (isGate(type)) {
+            operands(out, refs, count);
+        } else {
+            if (count >= 1) field(out, "a", refs[0]);
+            if (count >= 2) field(out, "b", refs[1]);
+        }
+        field(out, "io", rng() % 7);
+        if (rng() % 3 == 0) field(out, "delay_us", rng() % 5000);
+        else field(out, "delay_ms", rng() % 50);
+        field(out, "preset", rng() % 5);
+        out += '}';
+    }
+    out += "]}";
+    return String(out);
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <Arduino.h>
+#include <random>
+
+// Programas sintéticos (JSON no formato de /program) para verificações e
+// benchmarks.
+
+// Degraus típicos: contato NA, contato NF, AND com o degrau anterior,
+// TON, OR de selo e bobina (uma saída a cada 8 degraus; os demais são
+// relés internos). Só dependências para trás.
+String ladderProgram(uint16_t blocks, bool delta);
+
+// Tipos e operandos sorteados, com referências inválidas de propósito; com
+// 'feedback' os operandos também apontam para a frente (realimentação).
+String randomProgram(std::mt19937& rng, uint16_t blocks, bool feedback);
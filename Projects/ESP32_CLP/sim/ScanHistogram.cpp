@@ -0,0 +1,66 @@
+#include "ScanHistogram.h"
+#include <string.h>
+
+namespace {
+
+// Faixa b: [2^b, 2^(b+1)) ns; a 0 também leva o 0.
+uint8_t bucketOf(uint64_t ns) {
+    uint8_t b = ns ? 63 - __builtin_clzll(ns) : 0;
+    return b < ScanHistogram::BUCKETS ? b : ScanHistogram::BUCKETS - 1;
+}
+
+} // namespace
+
+ScanHistogram::ScanHistogram() {
+    clear();
+}
+
+void ScanHistogram::clear() {
+    memset(bins, 0, sizeof(bins));
+    samples = 0;
+    sum = 0;
+    lowest = UINT64_MAX;
+    highest = 0;
+}
+
+void ScanHistogram::add(uint64_t ns) {
+    bins[bucketOf(ns)]++;
+    samples++;
+    sum += ns;
+    if (ns < lowest) lowest = ns;
+    if (ns > highest) highest = ns;
+}
+
+uint64_t ScanHistogram::percentileNs(double p) const {
+    if (!samples) return 0;
+    uint64_t target = (uint64_t)(samples * p / 100.0);
+    if (target >= samples) target = samples - 1;
+    uint64_t seen = 0;
+    for (uint8_t b = 0; b < BUCKETS; b++) {
+        seen += bins[b];
+        if (seen > target) return (2ULL << b) - 1;
+    }
+    return highest;
+}
+
+void ScanHistogram::print(FILE* out, const char* title) const {
+    fprintf(out, "%s: %llu varredura(s), min %llu ns, média %llu ns, p50 <= %llu ns, p99 <= %llu ns, max %llu ns\n",
+            title, (unsigned long long)samples, (unsigned long long)minNs(), (unsigned long long)avgNs(),
+            (unsigned long long)percentileNs(50), (unsigned long long)percentileNs(99),
+            (unsigned long long)highest);
+    if (!samples) return;
+    uint64_t peak = 0;
+    for (uint8_t b = 0; b < BUCKETS; b++) {
+        if (bins[b] > peak) peak = bins[b];
+    }
+    for (uint8_t b = 0; b < BUCKETS; b++) {
+        if (!bins[b]) continue;
+        char bar[41];
+        int len = (int)(bins[b] * 40 / peak);
+        if (len == 0) len = 1;
+        memset(bar, '#', len);
+        bar[len] = '\0';
+        fprintf(out, "  %10llu .. %-10llu ns %12llu %6.2f%% %s\n", b ? 1ULL << b : 0ULL, (2ULL << b) - 1,
+                (unsigned long long)bins[b], bins[b] * 100.0 / samples, bar);
+    }
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Histograma do tempo de varredura em faixas de potência de 2 (ns).
+class ScanHistogram {
+public:
+    static constexpr uint8_t BUCKETS = 32;
+
+    ScanHistogram();
+    void clear();
+    void add(uint64_t ns);
+
+    uint64_t count() const { return samples; }
+    uint64_t minNs() const { return samples ? lowest : 0; }
+    uint64_t maxNs() const { return highest; }
+    uint64_t avgNs() const { return samples ? sum / samples : 0; }
+    // Limite superior da faixa que contém o percentil p (0..100).
+    uint64_t percentileNs(double p) const;
+
+    void print(FILE* out, const char* title) const;
+
+private:
+    uint64_t bins[BUCKETS];
+    uint64_t samples;
+    uint64_t sum;
+    uint64_t lowest;
+    uint64_t highest;
+};
@@ -0,0 +1,173 @@
+#include "ScanSim.h"
+#include "HostClock.h"
+#include "IOManager.h"
+#include "LadderEngine.h"
+#include "RetainStore.h"
+#include "ScanHistogram.h"
+#include "TracePlayer.h"
+#include <LittleFS.h>
+#include <string.h>
+#include <string>
+
+ScanSim::ScanSim(LadderEngine& engine, TracePlayer& player)
+    : engine(engine), player(player), trace(nullptr), histogram(nullptr), tracedIn(0), tracedOut(0),
+      traced(false) {
+    memset(&st, 0, sizeof(st));
+}
+
+void ScanSim::run(uint64_t untilUs) {
+    uint64_t now = host::timeUs();
+    uint64_t periodUs = engine.getCycleMs() * 1000ULL;
+    uint64_t nextPeriod = now + periodUs;
+    bool sleeping = false;
+    uint64_t sleepStart = 0;
+    // Tarefa de gravação retentiva: acorda a cada RETAIN_FLASH_MS.
+    uint64_t nextFlush = now + RETAIN_FLASH_MS * 1000ULL;
+
+    for (;;) {
+        uint64_t deadline = engine.nextDeadlineUs();
+        // Prazo já vencido: o esp_timer dispararia na hora.
+        if (deadline <= now) deadline = now + 1;
+        uint64_t next;
+
+        if (sleeping) {
+            uint64_t edge = player.nextEventUs();
+            next = edge < deadline ? edge : deadline;
+            for (; nextFlush <= next && nextFlush <= untilUs; nextFlush += RETAIN_FLASH_MS * 1000ULL) {
+                host::setTimeUs(nextFlush);
+                flushRetain();
+            }
+            if (next > untilUs) break;
+            bool wake = next == deadline;
+            if (player.advanceTo(next)) wake = true;
+            TracePlayer::Restart restart = player.takeRestart();
+            if (restart != TracePlayer::Restart::NONE) {
+                st.sleptUs += next - sleepStart;
+                sleeping = false;
+                now = next;
+                host::setTimeUs(now);
+                reboot(restart);
+                nextPeriod = now + periodUs;
+                nextFlush = now + RETAIN_FLASH_MS * 1000ULL;
+                continue;
+            }
+            if (!wake && !ioManager.inputsDifferFromImage()) {
+                // Evento sem borda (nível repetido): continua dormindo.
+                now = next;
+                continue;
+            }
+            if (next == deadline) st.deadlineScans++;
+            else st.wakeScans++;
+            st.sleptUs += next - sleepStart;
+            sleeping = false;
+            // leaveSleep() reinicia o temporizador periódico.
+            nextPeriod = next + periodUs;
+        } else {
+            bool early = deadline < nextPeriod;
+            next = early ? deadline : nextPeriod;
+            for (; nextFlush <= next && nextFlush <= untilUs; nextFlush += RETAIN_FLASH_MS * 1000ULL) {
+                host::setTimeUs(nextFlush);
+                flushRetain();
+            }
+            if (next > untilUs) break;
+            if (early) st.deadlineScans++;
+            else nextPeriod += periodUs;
+            player.advanceTo(next);
+            TracePlayer::Restart restart = player.takeRestart();
+            if (restart != TracePlayer::Restart::NONE) {
+                if (early) st.deadlineScans--;
+                now = next;
+                host::setTimeUs(now);
+                reboot(restart);
+                nextPeriod = now + periodUs;
+                nextFlush = now + RETAIN_FLASH_MS * 1000ULL;
+                continue;
+            }
+        }
+
+        now = next;
+        host::setTimeUs(now);
+        scan();
+
+        if (engine.isSettled() && !ioManager.inputsDifferFromImage()) {
+            sleeping = true;
+            sleepStart = now;
+            st.sleeps++;
+        }
+    }
+    if (sleeping) st.sleptUs += untilUs - sleepStart;
+    host::setTimeUs(untilUs);
+}
+
+void ScanSim::scan() {
+    uint64_t t0 = histogram ? host::realNs() : 0;
+    engine.tick();
+    if (histogram) histogram->add(host::realNs() - t0);
+    st.scans++;
+    st.evals += engine.getLastEvalCount();
+    retainStore.capture(engine);
+    // No alvo a contagem de varreduras notifica a tarefa de gravação.
+    if (retainStore.flushDue()) flushRetain();
+    if (trace) writeTrace();
+}
+
+void ScanSim::flushRetain() {
+    if (!retainStore.flushDue()) return;
+    retainStore.flush();
+    st.retainFlushes++;
+}
+
+// Corte no meio de um lote: grava o pendente e deixa só a primeira metade
+// do que entrou no diário, como um append interrompido.
+void ScanSim::tearJournal() {
+    const char* path = "/retain.log";
+    size_t before = LittleFS.exists(path) ? LittleFS.open(path).size() : 0;
+    retainStore.flush();
+    File f = LittleFS.exists(path) ? LittleFS.open(path) : File();
+    if (!f || f.size() <= before) return;
+    std::string kept(before + (f.size() - before) / 2, '\0');
+    f.read(reinterpret_cast<uint8_t*>(&kept[0]), kept.size());
+    f.close();
+    LittleFS.open(path, "w").write(reinterpret_cast<const uint8_t*>(kept.data()), kept.size());
+}
+
+// Reinício como no boot: RAM zerada, programa recarregado e estado
+// retentivo de volta antes da primeira varredura.
+void ScanSim::reboot(TracePlayer::Restart kind) {
+    bool powerLost = kind != TracePlayer::Restart::WARM;
+    if (kind == TracePlayer::Restart::TORN) tearJournal();
+    if (powerLost) retainStore.invalidateRtc();
+    st.restarts++;
+    EvalMode mode = engine.getEvalMode();
+    ioManager.init();
+    engine.loadFromStorage();
+    engine.setEvalMode(mode);
+    retainStore.restore(engine);
+    if (trace) {
+        uint64_t t = host::timeUs();
+        fprintf(trace, "# %llu.%06llu %s\n", (unsigned long long)(t / 1000000), (unsigned long long)(t % 1000000),
+                kind == TracePlayer::Restart::TORN ? "tornfail" : powerLost ? "powerfail" : "reset");
+        writeTrace();
+    }
+}
+
+void ScanSim::writeTrace() {
+    uint32_t in = ioManager.getInputBits();
+    uint32_t out = ioManager.getOutputBits();
+    if (traced && in == tracedIn && out == tracedOut) return;
+    if (!traced) fprintf(trace, "# t_s IN0..%u OUT0..%u\n", INPUTS_COUNT - 1, OUTPUTS_COUNT - 1);
+    traced = true;
+    tracedIn = in;
+    tracedOut = out;
+
+    char line[64];
+    uint64_t t = host::timeUs();
+    int n = snprintf(line, sizeof(line), "%llu.%06llu ", (unsigned long long)(t / 1000000),
+                     (unsigned long long)(t % 1000000));
+    for (uint8_t i = 0; i < INPUTS_COUNT; i++) line[n++] = (in >> i) & 1u ? '1' : '0';
+    line[n++] = ' ';
+    for (uint8_t i = 0; i < OUTPUTS_COUNT; i++) line[n++] = (out >> i) & 1u ? '1' : '0';
+    line[n++] = '\n';
+    fwrite(line, 1, n, trace);
+    st.traceLines++;
+}
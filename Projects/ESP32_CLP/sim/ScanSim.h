@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include "TracePlayer.h"
+
+class LadderEngine;
+class ScanHistogram;
+
+struct ScanSimStats {
+    uint64_t scans;
+    uint64_t deadlineScans;   // Fora do ciclo, no prazo de um temporizador
+    uint64_t wakeScans;       // Despertar por borda de entrada ou escrita externa
+    uint64_t sleeps;
+    uint64_t sleptUs;         // Tempo virtual dormindo (modo delta estável)
+    uint64_t evals;           // Instruções avaliadas
+    uint64_t traceLines;
+    uint64_t restarts;        // reset/powerfail/tornfail do roteiro
+    uint64_t retainFlushes;   // Lotes gravados no diário retentivo
+};
+
+// Agenda as varreduras em tempo virtual como a ScanTask no alvo: uma por
+// ciclo, uma extra no prazo de temporizador que vence antes do próximo
+// ciclo e, no modo delta estável, sono até borda de entrada ou prazo.
+// A memória retentiva segue o alvo: captura a cada varredura e gravação
+// em flash pela contagem de varreduras ou a cada RETAIN_FLASH_MS.
+class ScanSim {
+public:
+    ScanSim(LadderEngine& engine, TracePlayer& player);
+
+    // Traço de I/O: uma linha por varredura que muda entradas ou saídas,
+    // "<t em s> <IN0..> <OUT0..>". Só depende do tempo virtual: dois
+    // firmwares com o mesmo roteiro dão traços comparáveis com diff.
+    void setTrace(FILE* out) { trace = out; }
+    // Custo de cada tick() medido no relógio real do host.
+    void setHistogram(ScanHistogram* h) { histogram = h; }
+
+    // Roda de host::timeUs() até untilUs.
+    void run(uint64_t untilUs);
+    const ScanSimStats& stats() const { return st; }
+
+private:
+    void scan();
+    void flushRetain();
+    void reboot(TracePlayer::Restart kind);
+    void tearJournal();
+    void writeTrace();
+
+    LadderEngine& engine;
+    TracePlayer& player;
+    FILE* trace;
+    ScanHistogram* histogram;
+    ScanSimStats st;
+    uint32_t tracedIn;
+    uint32_t tracedOut;
+    bool traced;
+};
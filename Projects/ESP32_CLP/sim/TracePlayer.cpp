@@ -0,0 +1,210 @@
+#include "TracePlayer.h"
+#include "GpioPort.h"
+#include "IOManager.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace {
+
+constexpr uint32_t FIRST_RUN = UINT32_MAX;
+
+const char* skipSpaces(const char* p) {
+    while (*p == ' ' || *p == '\t') p++;
+    return p;
+}
+
+// Próxima palavra da linha em 'word'; devolve o ponteiro depois dela.
+const char* nextWord(const char* p, std::string& word) {
+    p = skipSpaces(p);
+    const char* start = p;
+    while (*p && *p != ' ' && *p != '\t') p++;
+    word.assign(start, p - start);
+    return p;
+}
+
+bool parseIndex(const std::string& word, uint8_t limit, uint8_t& index) {
+    char* end;
+    unsigned long v = strtoul(word.c_str(), &end, 10);
+    if (word.empty() || *end || v >= limit) return false;
+    index = (uint8_t)v;
+    return true;
+}
+
+bool parseLevel(const std::string& word, bool& level) {
+    if (word != "0" && word != "1") return false;
+    level = word == "1";
+    return true;
+}
+
+} // namespace
+
+bool parseDuration(const char* text, uint64_t& us) {
+    char* end;
+    double v = strtod(text, &end);
+    if (end == text || v < 0) return false;
+    double scale;
+    if (*end == '\0' || strcmp(end, "ms") == 0) scale = 1e3;
+    else if (strcmp(end, "us") == 0) scale = 1;
+    else if (strcmp(end, "s") == 0) scale = 1e6;
+    else if (strcmp(end, "m") == 0) scale = 60e6;
+    else if (strcmp(end, "h") == 0) scale = 3600e6;
+    else if (strcmp(end, "d") == 0) scale = 86400e6;
+    else return false;
+    us = (uint64_t)(v * scale + 0.5);
+    return true;
+}
+
+TracePlayer::TracePlayer() : endAt(UINT64_MAX), restart(Restart::NONE) {
+    memset(generation, 0, sizeof(generation));
+}
+
+bool TracePlayer::fail(unsigned line, const char* msg) {
+    char buf[160];
+    snprintf(buf, sizeof(buf), "linha %u: %s", line, msg);
+    lastError = buf;
+    return false;
+}
+
+bool TracePlayer::load(const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        lastError = std::string("não abriu ") + path;
+        return false;
+    }
+    std::string text;
+    char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) text.append(buf, n);
+    fclose(f);
+    return parse(text.c_str());
+}
+
+bool TracePlayer::parse(const char* text) {
+    agenda.clear();
+    endAt = UINT64_MAX;
+    uint64_t last = 0;
+    unsigned lineNo = 0;
+
+    while (*text) {
+        const char* eol = strchr(text, '\n');
+        std::string line(text, eol ? eol - text : strlen(text));
+        text = eol ? eol + 1 : text + line.size();
+        lineNo++;
+
+        size_t hash = line.find('#');
+        if (hash != std::string::npos) line.resize(hash);
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        const char* p = skipSpaces(line.c_str());
+        if (!*p) continue;
+
+        std::string word;
+        p = nextWord(p, word);
+        bool relative = word[0] == '+';
+        uint64_t t;
+        if (!parseDuration(word.c_str() + (relative ? 1 : 0), t)) return fail(lineNo, "tempo inválido");
+        if (relative) t += last;
+        if (t < last) return fail(lineNo, "tempo anterior à linha de cima");
+        last = t;
+
+        Event ev = {Kind::IN, 0, false, 0, 0, 0};
+        std::string cmd;
+        p = nextWord(p, cmd);
+        if (cmd == "every") {
+            p = nextWord(p, word);
+            if (!parseDuration(word.c_str(), ev.periodUs) || ev.periodUs == 0) return fail(lineNo, "período inválido");
+            ev.generation = FIRST_RUN;
+            p = nextWord(p, cmd);
+            if (cmd != "toggle" && cmd != "pulse") return fail(lineNo, "every aceita toggle ou pulse");
+        }
+
+        if (cmd == "end") {
+            endAt = t;
+            continue;
+        }
+        if (cmd == "reset" || cmd == "powerfail" || cmd == "tornfail") {
+            ev.kind = Kind::RESET;
+            ev.index = (uint8_t)(cmd == "reset" ? Restart::WARM : cmd == "powerfail" ? Restart::POWER : Restart::TORN);
+        } else if (cmd == "in" || cmd == "out") {
+            ev.kind = cmd == "in" ? Kind::IN : Kind::OUT;
+            p = nextWord(p, word);
+            if (!parseIndex(word, cmd == "in" ? INPUTS_COUNT : OUTPUTS_COUNT, ev.index)) return fail(lineNo, "índice inválido");
+            p = nextWord(p, word);
+            if (!parseLevel(word, ev.value)) return fail(lineNo, "nível deve ser 0 ou 1");
+        } else if (cmd == "toggle" || cmd == "pulse" || cmd == "stop") {
+            ev.kind = cmd == "toggle" ? Kind::TOGGLE : cmd == "pulse" ? Kind::PULSE : Kind::STOP;
+            p = nextWord(p, word);
+            if (!parseIndex(word, INPUTS_COUNT, ev.index)) return fail(lineNo, "índice inválido");
+            if (ev.kind == Kind::PULSE) {
+                p = nextWord(p, word);
+                if (!parseDuration(word.c_str(), ev.durationUs)) return fail(lineNo, "duração inválida");
+            }
+        } else {
+            return fail(lineNo, "comando desconhecido");
+        }
+        p = nextWord(p, word);
+        if (!word.empty()) return fail(lineNo, "argumentos a mais");
+        agenda.emplace(t, ev);
+    }
+    return true;
+}
+
+TracePlayer::Restart TracePlayer::takeRestart() {
+    Restart r = restart;
+    restart = Restart::NONE;
+    return r;
+}
+
+uint64_t TracePlayer::nextEventUs() const {
+    return agenda.empty() ? UINT64_MAX : agenda.begin()->first;
+}
+
+void TracePlayer::setInput(uint8_t index, bool on) {
+    uint32_t bit = 1u << INPUT_PINS[index];
+    // Pull-up: contato fechado leva o pino a LOW.
+    gpio_port::hostIn = on ? (gpio_port::hostIn & ~bit) : (gpio_port::hostIn | bit);
+}
+
+bool TracePlayer::inputOn(uint8_t index) const {
+    return !((gpio_port::hostIn >> INPUT_PINS[index]) & 1u);
+}
+
+bool TracePlayer::advanceTo(uint64_t us) {
+    bool external = false;
+    while (!agenda.empty() && agenda.begin()->first <= us) {
+        uint64_t t = agenda.begin()->first;
+        Event ev = agenda.begin()->second;
+        agenda.erase(agenda.begin());
+
+        if (ev.periodUs) {
+            if (ev.generation == FIRST_RUN) ev.generation = generation[ev.index];
+            if (ev.generation != generation[ev.index]) continue;
+            agenda.emplace(t + ev.periodUs, ev);
+        }
+        switch (ev.kind) {
+            case Kind::IN:
+                setInput(ev.index, ev.value);
+                break;
+            case Kind::TOGGLE:
+                setInput(ev.index, !inputOn(ev.index));
+                break;
+            case Kind::PULSE: {
+                setInput(ev.index, true);
+                Event off = {Kind::IN, ev.index, false, 0, 0, 0};
+                agenda.emplace(t + ev.durationUs, off);
+                break;
+            }
+            case Kind::STOP:
+                generation[ev.index]++;
+                break;
+            case Kind::OUT:
+                ioManager.setOutput(ev.index, ev.value);
+                external = true;
+                break;
+            case Kind::RESET:
+                restart = (Restart)ev.index;
+                return true;
+        }
+    }
+    return external;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <stdint.h>
+#include <map>
+#include <string>
+
+// Roteiro de estímulos da simulação, uma linha por evento:
+//
+//   <tempo> <comando> [argumentos]      # comentário
+//
+// tempo: número com unidade us, ms, s, m, h ou d (sem unidade = ms); com
+// '+' na frente é relativo à linha anterior. Comandos:
+//
+//   in <i> <0|1>                 entrada lógica i (1 = contato fechado)
+//   toggle <i>                   inverte a entrada i
+//   pulse <i> <duração>          liga a entrada i e desliga após a duração
+//   every <período> toggle <i>   repete a partir deste instante...
+//   every <período> pulse <i> <duração>
+//   stop <i>                     ...até aqui (cancela os every da entrada i)
+//   out <i> <0|1>                escrita externa na saída i (como a API web)
+//   reset                        reinício quente (watchdog, brown-out): RTC mantida
+//   powerfail                    falta de energia: só o que já foi para a flash
+//   tornfail                     falta de energia no meio de um lote do diário
+//   end                          fim da simulação
+//
+// As entradas vão para os pinos simulados (gpio_port::hostIn, ativo em
+// nível baixo como o pull-up da placa); a varredura as lê como no alvo.
+class TracePlayer {
+public:
+    TracePlayer();
+
+    bool load(const char* path);
+    bool parse(const char* text);
+    const std::string& error() const { return lastError; }
+
+    // Próximo evento pendente (UINT64_MAX se nenhum).
+    uint64_t nextEventUs() const;
+    // Instante do 'end' (UINT64_MAX se o roteiro não tiver).
+    uint64_t endUs() const { return endAt; }
+    // Aplica os eventos até 'us' inclusive, em ordem. Devolve true se houve
+    // escrita externa em saída (acorda a varredura adormecida). Para num
+    // reset; o restante do mesmo instante fica para a chamada seguinte.
+    bool advanceTo(uint64_t us);
+    // Reinício pedido pelo último advanceTo (e o limpa).
+    enum class Restart : uint8_t { NONE, WARM, POWER, TORN };
+    Restart takeRestart();
+
+private:
+    enum class Kind : uint8_t { IN, TOGGLE, PULSE, STOP, OUT, RESET };
+    struct Event {
+        Kind kind;
+        uint8_t index;
+        bool value;
+        uint64_t durationUs;
+        uint64_t periodUs;   // 0 = uma vez
+        uint32_t generation; // every cancelado por stop fica obsoleto
+    };
+
+    void setInput(uint8_t index, bool on);
+    bool inputOn(uint8_t index) const;
+    bool fail(unsigned line, const char* msg);
+
+    std::multimap<uint64_t, Event> agenda;
+    uint32_t generation[32];
+    uint64_t endAt;
+    Restart restart;
+    std::string lastError;
+};
+
+// "250ms", "1.5s", "7d"... em µs; false se inválido.
+bool parseDuration(const char* text, uint64_t& us);
@@ -0,0 +1,567 @@
+// Simulação do ESP32_CLP no host (pio run -e native):
+//
+//   program run <programa.json|.bin> [roteiro] [opções]
+//       --until <tempo>   fim (padrão: 'end' do roteiro, senão 60s)
+//       --trace <arq>     traço de I/O (padrão: stdout; "-" desliga)
+//       --eval full|delta sobrepõe o modo do programa
+//       --hist            histograma do custo de varredura no stderr
+//       --profile <N>     perfil por bloco (ScanProfiler) e os N mais caros
+//       --flame <arq>     pilhas dobradas do perfil (flamegraph.pl)
+//       -v                mensagens do motor ([LADDER], [FS]...) no stderr
+//   program check [delta|compile] [programas]
+//       FULL x DELTA (com realimentação) e interpretado x compilado em
+//       programas aleatórios; código de saída 1 se algum divergir. 'delta'
+//       ou 'compile' roda só uma das comparações; a do delta também diz
+//       quantas instruções por varredura cada modo avaliou.
+//   program check retain
+//       Falta de energia no meio de um lote do diário retentivo e outra
+//       depois: o que foi gravado entre as duas tem de voltar no boot.
+//   program bench
+//       Por tamanho de programa: carga JSON x imagem e custo por varredura
+//       interpretado x compilado x delta.
+//   program bench compile [programas]
+//       Avaliador original (tickInterpreted) x programa compilado em
+//       programas de 64 blocos: o degrau típico e DAGs aleatórios; média,
+//       p99 e pior varredura de cada um.
+//   program bench boot
+//       Do boot à primeira varredura (loadFromStorage + tick) a partir do
+//       JSON e da imagem binária, por tamanho de programa.
+//   program bench scale
+//       Custo por varredura x número de blocos, com a arena dimensionada
+//       para cada tamanho: ns por bloco deve ficar plano acima de 1000.
+//
+// O motor é o mesmo do firmware (LadderEngine, IOManager, compilador, roda
+// de temporizadores, imagem binária); só o Arduino, o LittleFS e o relógio
+// são trocados pelos de sim/shim. O formato do roteiro está em TracePlayer.h.
+
+#include "GpioPort.h"
+#include "HostClock.h"
+#include "IOManager.h"
+#include "LadderEngine.h"
+#include "ProgramGen.h"
+#include "RetainStore.h"
+#include "ScanHistogram.h"
+#include "ScanSim.h"
+#include "TracePlayer.h"
+#include <LittleFS.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr uint64_t DEFAULT_RUN_US = 60ULL * 1000000;
+constexpr uint16_t CHECK_CAPACITY = 300;
+constexpr uint16_t BENCH_CAPACITY = 4096;
+const uint16_t BENCH_SIZES[] = {64, 256, 1024, 4096};
+const uint16_t SCALE_SIZES[] = {64, 128, 256, 512, 1024, 2048, 4096};
+constexpr uint16_t COMPILE_BENCH_BLOCKS = 64;
+constexpr uint32_t COMPILE_BENCH_SCANS = 20000;
+
+int usage() {
+    fprintf(stderr,
+            "uso: program run <programa.json|.bin> [roteiro] [--until T] [--trace arq|-] "
+            "[--eval full|delta] [--hist] [--profile N] [--flame arq] [-v]\n"
+            "     program check [delta|compile] [programas] | program check retain\n"
+            "     program bench [compile [programas] | boot | scale]\n");
+    return 2;
+}
+
+bool endsWith(const char* s, const char* suffix) {
+    size_t n = strlen(s), m = strlen(suffix);
+    return n >= m && strcmp(s + n - m, suffix) == 0;
+}
+
+// Estado de I/O e relógio iguais antes de cada execução comparada.
+void resetMachine(uint64_t startUs) {
+    host::setTimeUs(startUs);
+    gpio_port::hostIn = 0xFFFFFFFFu;
+    ioManager.init();
+    ioManager.scanInputs();
+}
+
+const char* sourceName(ProgramSource s) {
+    return s == ProgramSource::IMAGE ? "imagem" : s == ProgramSource::JSON ? "JSON" : "nenhum";
+}
+
+int runCommand(int argc, char** argv) {
+    const char* programPath = nullptr;
+    const char* tracePath = nullptr;
+    const char* outPath = nullptr;
+    const char* evalArg = nullptr;
+    uint64_t untilUs = 0;
+    bool withHist = false;
+    int profileTop = -1;
+    const char* flamePath = nullptr;
+
+    for (int i = 0; i < argc; i++) {
+        const char* a = argv[i];
+        if (strcmp(a, "--until") == 0 && i + 1 < argc) {
+            if (!parseDuration(argv[++i], untilUs)) return usage();
+        } else if (strcmp(a, "--trace") == 0 && i + 1 < argc) {
+            outPath = argv[++i];
+        } else if (strcmp(a, "--eval") == 0 && i + 1 < argc) {
+            evalArg = argv[++i];
+        } else if (strcmp(a, "--profile") == 0 && i + 1 < argc) {
+            profileTop = atoi(argv[++i]);
+        } else if (strcmp(a, "--flame") == 0 && i + 1 < argc) {
+            flamePath = argv[++i];
+        } else if (strcmp(a, "--hist") == 0) {
+            withHist = true;
+        } else if (strcmp(a, "-v") == 0) {
+            host::setSerialEcho(true);
+        } else if (!programPath) {
+            programPath = a;
+        } else if (!tracePath) {
+            tracePath = a;
+        } else {
+            return usage();
+        }
+    }
+    if (!programPath) return usage();
+
+    // Carrega pelo mesmo caminho do boot: imagem se houver, senão JSON.
+    bool image = endsWith(programPath, ".bin");
+    if (!host::importFile(programPath, image ? "/program.bin" : "/program.json")) {
+        fprintf(stderr, "[SIM] Não abriu %s\n", programPath);
+        return 1;
+    }
+    resetMachine(0);
+    ladderEngine.init();
+    ProgramSource expected = image ? ProgramSource::IMAGE : ProgramSource::JSON;
+    if (ladderEngine.getLoadSource() != expected) {
+        fprintf(stderr, "[SIM] Programa inválido: %s (use -v para detalhes)\n", programPath);
+        return 1;
+    }
+    if (evalArg) ladderEngine.setEvalMode(strcmp(evalArg, "delta") == 0 ? EvalMode::DELTA : EvalMode::FULL);
+    retainStore.restore(ladderEngine);
+    if ((profileTop >= 0 || flamePath) && !ladderEngine.setProfiling(true)) return 1;
+
+    TracePlayer player;
+    if (tracePath && !player.load(tracePath)) {
+        fprintf(stderr, "[SIM] Roteiro %s: %s\n", tracePath, player.error().c_str());
+        return 1;
+    }
+    if (!untilUs) untilUs = player.endUs() != UINT64_MAX ? player.endUs() : DEFAULT_RUN_US;
+
+    FILE* out = stdout;
+    if (outPath && strcmp(outPath, "-") == 0) {
+        out = nullptr;
+    } else if (outPath) {
+        out = fopen(outPath, "w");
+        if (!out) {
+            fprintf(stderr, "[SIM] Não criou %s\n", outPath);
+            return 1;
+        }
+    }
+
+    ScanHistogram hist;
+    ScanSim sim(ladderEngine, player);
+    sim.setTrace(out);
+    if (withHist) sim.setHistogram(&hist);
+
+    uint64_t t0 = host::realNs();
+    sim.run(untilUs);
+    double wallS = (host::realNs() - t0) / 1e9;
+    if (out && out != stdout) fclose(out);
+
+    const ScanSimStats& st = sim.stats();
+    double simS = untilUs / 1e6;
+    fprintf(stderr, "[SIM] %u bloco(s) (%s, carga %lu us), ciclo %u ms, eval %s\n", ladderEngine.getBlockCount(),
+            sourceName(ladderEngine.getLoadSource()), (unsigned long)ladderEngine.getLoadUs(),
+            ladderEngine.getCycleMs(), ladderEngine.getEvalMode() == EvalMode::DELTA ? "delta" : "full");
+    fprintf(stderr, "[SIM] %.3f s simulados em %.3f s (%.0fx)\n", simS, wallS, wallS > 0 ? simS / wallS : 0.0);
+    fprintf(stderr,
+            "[SIM] %llu varredura(s): %llu no prazo de temporizador, %llu por despertar; %llu sono(s), "
+            "%.1f%% do tempo dormindo; %.2f instr/varredura; %llu linha(s) de traço\n",
+            (unsigned long long)st.scans, (unsigned long long)st.deadlineScans,
+            (unsigned long long)st.wakeScans, (unsigned long long)st.sleeps,
+            untilUs ? st.sleptUs * 100.0 / untilUs : 0.0, st.scans ? (double)st.evals / st.scans : 0.0,
+            (unsigned long long)st.traceLines);
+    if (st.restarts || retainStore.getWords() > 1) {
+        fprintf(stderr, "[SIM] %llu reinício(s); retentivo %u palavra(s), %lu escrita(s) na RTC, %llu lote(s) na flash, "
+                "diário %lu bytes\n",
+                (unsigned long long)st.restarts, retainStore.getWords(), (unsigned long)retainStore.getRtcCommits(),
+                (unsigned long long)st.retainFlushes, (unsigned long)retainStore.getJournalBytes());
+    }
+    if (withHist) hist.print(stderr, "[SIM] tick()");
+    if (ladderEngine.isProfiling()) {
+        ProfileReport report;
+        report.reserve(ladderEngine.getBlockCount());
+        report.capture(ladderEngine.getProfiler(), ladderEngine.getBlockCount());
+        if (profileTop >= 0) {
+            FilePrint err(stderr);
+            report.printSummary(err, ladderEngine.getTable(), profileTop);
+        }
+        if (flamePath) {
+            FILE* f = fopen(flamePath, "w");
+            if (!f) {
+                fprintf(stderr, "[SIM] Não criou %s\n", flamePath);
+                return 1;
+            }
+            FilePrint fp(f);
+            report.writeFolded(fp, ladderEngine.getTable());
+            fclose(f);
+        }
+    }
+    return 0;
+}
+
+// Estímulo comum às duas execuções comparadas.
+struct Step {
+    uint32_t dtUs;
+    uint32_t pins;
+    int8_t toggleOut; // -1 = nenhuma escrita externa
+};
+
+enum class Runner { FULL, DELTA, INTERPRETED };
+
+// Saídas e valores de todos os blocos após cada varredura.
+void record(const String& json, Runner runner, const std::vector<Step>& steps, std::vector<uint32_t>& log,
+            uint64_t* evals = nullptr) {
+    uint16_t words = blockWords(ladderEngine.getCapacity());
+    std::vector<uint32_t> values(words);
+    resetMachine(1000000);
+    log.clear();
+    if (!ladderEngine.loadFromJson(json)) return;
+    ladderEngine.setEvalMode(runner == Runner::DELTA ? EvalMode::DELTA : EvalMode::FULL);
+    for (const Step& s : steps) {
+        host::setTimeUs(host::timeUs() + s.dtUs);
+        gpio_port::hostIn = s.pins;
+        if (s.toggleOut >= 0) ioManager.setOutput(s.toggleOut, !ioManager.getOutput(s.toggleOut));
+        if (runner == Runner::INTERPRETED) ladderEngine.tickInterpreted();
+        else ladderEngine.tick();
+        if (evals) *evals += ladderEngine.getLastEvalCount();
+        ladderEngine.packValues(values.data(), words);
+        log.push_back(ioManager.getOutputBits());
+        log.insert(log.end(), values.begin(), values.end());
+    }
+}
+
+int checkCommand(int argc, char** argv) {
+    // Par: FULL x DELTA; ímpar: interpretado x compilado.
+    bool kinds[2] = {true, true};
+    if (argc > 0 && (strcmp(argv[0], "delta") == 0 || strcmp(argv[0], "compile") == 0)) {
+        kinds[argv[0][0] == 'd' ? 1 : 0] = false;
+        argc--;
+        argv++;
+    }
+    int programs = argc > 0 ? atoi(argv[0]) : 1000;
+    uint64_t evals[2] = {0, 0}; // FULL, DELTA
+    ladderEngine.init(CHECK_CAPACITY);
+    std::mt19937 rng(7);
+    std::vector<Step> steps;
+    std::vector<uint32_t> a, b;
+    int fails[2] = {0, 0};
+    int skipped = 0;
+
+    for (int prog = 0; prog < programs; prog++) {
+        // Par: FULL x DELTA com realimentação; ímpar: interpretado x
+        // compilado, sem realimentação (o interpretado segue a ordem do JSON).
+        int kind = prog & 1;
+        uint16_t n = rng() % CHECK_CAPACITY + 1;
+        String json = randomProgram(rng, n, kind == 0 && (prog & 2));
+
+        steps.clear();
+        uint32_t pins = rng();
+        for (int t = 0; t < 200; t++) {
+            if (rng() % 5 == 0) pins = rng();
+            int8_t toggle = rng() % 40 == 0 ? (int8_t)(rng() % OUTPUTS_COUNT) : -1;
+            steps.push_back({(uint32_t)(rng() % 7000), pins, toggle});
+        }
+        if (!kinds[kind]) continue; // Mesmo sorteio da verificação completa
+
+        record(json, kind == 0 ? Runner::FULL : Runner::INTERPRETED, steps, a, kind == 0 ? &evals[0] : nullptr);
+        record(json, kind == 0 ? Runner::DELTA : Runner::FULL, steps, b, kind == 0 ? &evals[1] : nullptr);
+        if (a.empty()) {
+            skipped++; // Excedeu o pool de operandos
+            continue;
+        }
+        if (a != b) {
+            if (!fails[kind]) {
+                size_t stride = 1 + blockWords(ladderEngine.getCapacity());
+                size_t at = 0;
+                while (at < a.size() && a[at] == b[at]) at++;
+                fprintf(stderr, "[SIM] Programa %d (%s), varredura %zu diverge\n", prog,
+                        kind == 0 ? "full x delta" : "interpretado x compilado", at / stride);
+            }
+            fails[kind]++;
+        }
+    }
+    printf("full x delta: %d divergência(s); interpretado x compilado: %d divergência(s); %d de %d ignorado(s)\n",
+           fails[0], fails[1], skipped, programs);
+    if (kinds[0] && evals[0]) {
+        printf("instruções avaliadas: delta %.1f%% das do full (%llu x %llu)\n", evals[1] * 100.0 / evals[0],
+               (unsigned long long)evals[1], (unsigned long long)evals[0]);
+    }
+    return fails[0] || fails[1] ? 1 : 0;
+}
+
+// Contador retentivo com uma peça por segundo; um lote cortado aos 20,5 s
+// (tornfail) e, aos 60 s, uma falta de energia logo após um flush. O
+// estado restaurado tem de ser o gravado por último, não o de antes do
+// corte.
+int checkRetainCommand() {
+    const char* json = "{\"cycle_ms\":20,\"blocks\":["
+                       "{\"id\":0,\"type\":\"CONTACT_NO\",\"io\":0},"
+                       "{\"id\":1,\"type\":\"CONTACT_NO\",\"io\":1},"
+                       "{\"id\":2,\"type\":\"COUNTER_UP\",\"a\":0,\"b\":1,\"preset\":1000},"
+                       "{\"id\":3,\"type\":\"COIL\",\"a\":2,\"io\":3}]}";
+    resetMachine(0);
+    LittleFS.remove("/retain.bin");
+    LittleFS.remove("/retain.log");
+    ladderEngine.init(CHECK_CAPACITY);
+    if (!ladderEngine.loadFromJson(json, true)) return 1;
+    retainStore.invalidateRtc();
+    retainStore.restore(ladderEngine);
+
+    TracePlayer player;
+    player.parse("1s every 1s pulse 0 50ms\n20500ms tornfail\n");
+    ScanSim sim(ladderEngine, player);
+    sim.run(60ULL * 1000000);
+    retainStore.flush();
+
+    uint16_t words = ladderEngine.getRetainWords();
+    std::vector<uint32_t> saved(words), restored(words);
+    ladderEngine.captureRetain(saved.data());
+    retainStore.invalidateRtc();
+    ioManager.init();
+    ladderEngine.loadFromStorage();
+    RetainSource source = retainStore.restore(ladderEngine);
+    ladderEngine.captureRetain(restored.data());
+
+    bool ok = source == RetainSource::FLASH && saved == restored;
+    printf("retentivo após lote cortado: contagem gravada %lu, restaurada %lu (%s), %llu lote(s)%s\n",
+           (unsigned long)saved[1], (unsigned long)restored[1], source == RetainSource::FLASH ? "flash" : "outra fonte",
+           (unsigned long long)sim.stats().retainFlushes, ok ? "" : " - DIVERGE");
+    return ok ? 0 : 1;
+}
+
+// ns por varredura, com uma entrada mudando a cada 25 ciclos.
+double measureScans(const String& json, Runner runner, uint32_t scans, double* evalsPerScan) {
+    resetMachine(1000000);
+    ladderEngine.loadFromJson(json);
+    ladderEngine.setEvalMode(runner == Runner::DELTA ? EvalMode::DELTA : EvalMode::FULL);
+    uint64_t cycleUs = ladderEngine.getCycleMs() * 1000ULL;
+    uint64_t evals = 0;
+    uint64_t spent = 0;
+    for (uint32_t s = 0; s < scans; s++) {
+        host::setTimeUs(host::timeUs() + cycleUs);
+        if (s % 25 == 0) gpio_port::hostIn ^= 1u << INPUT_PINS[(s / 25) % INPUTS_COUNT];
+        uint64_t t0 = host::realNs();
+        if (runner == Runner::INTERPRETED) ladderEngine.tickInterpreted();
+        else ladderEngine.tick();
+        spent += host::realNs() - t0;
+        evals += ladderEngine.getLastEvalCount();
+    }
+    if (evalsPerScan) *evalsPerScan = (double)evals / scans;
+    return (double)spent / scans;
+}
+
+// Boot: loadFromStorage() a partir da imagem e, sem ela, do JSON.
+void measureBoot(const String& json, double& jsonUs, double& imageUs, size_t& jsonBytes, size_t& imageBytes) {
+    ladderEngine.loadFromJson(json, true);
+    jsonBytes = LittleFS.open("/program.json").size();
+    imageBytes = LittleFS.open("/program.bin").size();
+
+    uint64_t t0 = host::realNs();
+    ladderEngine.loadFromStorage();
+    imageUs = (host::realNs() - t0) / 1e3;
+
+    LittleFS.remove("/program.bin");
+    t0 = host::realNs();
+    ladderEngine.loadFromStorage(); // Também regrava a imagem
+    jsonUs = (host::realNs() - t0) / 1e3;
+}
+
+// Custo de cada varredura de um avaliador (ns), para média e cauda.
+struct ScanCost {
+    double meanNs = 0;
+    double p99Ns = 0;
+    double worstNs = 0;
+};
+
+bool measureCost(const String& json, Runner runner, uint32_t scans, ScanCost& cost) {
+    resetMachine(1000000);
+    if (!ladderEngine.loadFromJson(json)) return false;
+    ladderEngine.setEvalMode(EvalMode::FULL);
+    uint64_t cycleUs = ladderEngine.getCycleMs() * 1000ULL;
+    std::vector<uint64_t> samples(scans);
+    uint64_t total = 0;
+    for (uint32_t s = 0; s < scans; s++) {
+        host::setTimeUs(host::timeUs() + cycleUs);
+        if (s % 25 == 0) gpio_port::hostIn ^= 1u << INPUT_PINS[(s / 25) % INPUTS_COUNT];
+        uint64_t t0 = host::realNs();
+        if (runner == Runner::INTERPRETED) ladderEngine.tickInterpreted();
+        else ladderEngine.tick();
+        samples[s] = host::realNs() - t0;
+        total += samples[s];
+    }
+    std::sort(samples.begin(), samples.end());
+    cost.meanNs = (double)total / scans;
+    cost.p99Ns = samples[scans * 99 / 100];
+    cost.worstNs = samples.back();
+    return true;
+}
+
+void printCost(const char* name, const ScanCost& interp, const ScanCost& compiled) {
+    printf("%-22s %10.0f %10.0f %10.0f %10.0f %10.0f %10.0f %8.1f\n", name, interp.meanNs, interp.p99Ns,
+           interp.worstNs, compiled.meanNs, compiled.p99Ns, compiled.worstNs,
+           compiled.meanNs > 0 ? interp.meanNs / compiled.meanNs : 0.0);
+}
+
+// O pior caso do compilado é determinístico em instruções (uma por bloco,
+// sem desvio); o pior em ns no host inclui preempção, por isso o p99.
+int benchCompileCommand(int argc, char** argv) {
+    int programs = argc > 0 ? atoi(argv[0]) : 100;
+    ladderEngine.init(CHECK_CAPACITY);
+    printf("%u blocos, %u varreduras por programa (ns por varredura)\n", COMPILE_BENCH_BLOCKS, COMPILE_BENCH_SCANS);
+    printf("%-22s %10s %10s %10s %10s %10s %10s %8s\n", "programa", "interp", "interp_p99", "interp_max", "compil",
+           "compil_p99", "compil_max", "x");
+
+    ScanCost interp, compiled;
+    String json = ladderProgram(COMPILE_BENCH_BLOCKS, false);
+    if (!measureCost(json, Runner::INTERPRETED, COMPILE_BENCH_SCANS, interp) ||
+        !measureCost(json, Runner::FULL, COMPILE_BENCH_SCANS, compiled)) {
+        fprintf(stderr, "[SIM] Programa típico não carregou\n");
+        return 1;
+    }
+    printCost("degraus", interp, compiled);
+
+    // DAGs aleatórios: média das médias, pior p99 e pior varredura.
+    std::mt19937 rng(11);
+    ScanCost sumInterp, sumCompiled;
+    int measured = 0;
+    for (int prog = 0; prog < programs; prog++) {
+        json = randomProgram(rng, COMPILE_BENCH_BLOCKS, false);
+        if (!measureCost(json, Runner::INTERPRETED, COMPILE_BENCH_SCANS / 10, interp) ||
+            !measureCost(json, Runner::FULL, COMPILE_BENCH_SCANS / 10, compiled)) {
+            continue;
+        }
+        measured++;
+        sumInterp.meanNs += interp.meanNs;
+        sumCompiled.meanNs += compiled.meanNs;
+        sumInterp.p99Ns = std::max(sumInterp.p99Ns, interp.p99Ns);
+        sumCompiled.p99Ns = std::max(sumCompiled.p99Ns, compiled.p99Ns);
+        sumInterp.worstNs = std::max(sumInterp.worstNs, interp.worstNs);
+        sumCompiled.worstNs = std::max(sumCompiled.worstNs, compiled.worstNs);
+    }
+    if (!measured) return 1;
+    sumInterp.meanNs /= measured;
+    sumCompiled.meanNs /= measured;
+    char name[32];
+    snprintf(name, sizeof(name), "aleatórios (%d)", measured);
+    printCost(name, sumInterp, sumCompiled);
+    return 0;
+}
+
+// loadFromStorage() e a primeira varredura, como no setup() + ScanTask;
+// melhor de 'rounds' para tirar o ruído do host.
+double bootToFirstScanUs(bool fromImage, uint32_t rounds, double& loadUs) {
+    double best = 1e18;
+    loadUs = 1e18;
+    for (uint32_t r = 0; r < rounds; r++) {
+        if (!fromImage) LittleFS.remove("/program.bin");
+        resetMachine(1000000);
+        uint64_t t0 = host::realNs();
+        ladderEngine.loadFromStorage();
+        uint64_t t1 = host::realNs();
+        ladderEngine.tick();
+        uint64_t t2 = host::realNs();
+        loadUs = std::min(loadUs, (t1 - t0) / 1e3);
+        best = std::min(best, (t2 - t0) / 1e3); // Pelo JSON, o boot também regrava a imagem
+    }
+    return best;
+}
+
+int benchBootCommand() {
+    ladderEngine.init(BENCH_CAPACITY);
+    printf("%7s %9s %9s %10s %12s %10s %12s %8s\n", "blocos", "json_B", "imagem_B", "json_us", "json_1a_us",
+           "imagem_us", "imagem_1a_us", "x");
+    for (uint16_t n : BENCH_SIZES) {
+        if (n > ladderEngine.getCapacity()) break;
+        String json = ladderProgram(n, false);
+        if (!ladderEngine.loadFromJson(json, true)) return 1;
+        size_t jsonBytes = LittleFS.open("/program.json").size();
+        size_t imageBytes = LittleFS.open("/program.bin").size();
+
+        double imageLoad, jsonLoad;
+        double image = bootToFirstScanUs(true, 20, imageLoad);
+        if (ladderEngine.getLoadSource() != ProgramSource::IMAGE) {
+            fprintf(stderr, "[SIM] %u blocos: a imagem não foi usada no boot\n", n);
+            return 1;
+        }
+        double fromJson = bootToFirstScanUs(false, 20, jsonLoad);
+        printf("%7u %9zu %9zu %10.1f %12.1f %10.1f %12.1f %8.1f\n", n, jsonBytes, imageBytes, jsonLoad, fromJson,
+               imageLoad, image, image > 0 ? fromJson / image : 0.0);
+    }
+    return 0;
+}
+
+int benchScaleCommand() {
+    printf("%7s %10s %8s %10s %9s %10s %9s %8s\n", "blocos", "arena_B", "B/bloco", "full_ns", "ns/bloco", "delta_ns",
+           "instr_d", "x_64");
+    double base = 0;
+    for (uint16_t n : SCALE_SIZES) {
+        ladderEngine.init(n);
+        if (ladderEngine.getCapacity() < n) {
+            fprintf(stderr, "[SIM] Arena de %u blocos não coube\n", n);
+            return 1;
+        }
+        String json = ladderProgram(n, false);
+        uint32_t scans = 4000000 / n;
+        if (scans < 500) scans = 500;
+        double deltaEvals = 0;
+        double full = measureScans(json, Runner::FULL, scans, nullptr);
+        double delta = measureScans(json, Runner::DELTA, scans, &deltaEvals);
+        double perBlock = full / n;
+        if (!base) base = perBlock;
+        printf("%7u %10zu %8.1f %10.0f %9.2f %10.0f %9.1f %8.2f\n", n, ladderEngine.getArenaBytes(),
+               (double)ladderEngine.getArenaBytes() / n, full, perBlock, delta, deltaEvals, perBlock / base);
+    }
+    return 0;
+}
+
+int benchCommand() {
+    ladderEngine.init(BENCH_CAPACITY);
+    printf("%7s %10s %10s %9s %9s %12s %10s %10s %8s %8s\n", "blocos", "json_us", "imagem_us", "json_B", "imagem_B",
+           "interp_ns", "full_ns", "delta_ns", "delta_x", "instr_d");
+    for (uint16_t n : BENCH_SIZES) {
+        if (n > ladderEngine.getCapacity()) break;
+        String json = ladderProgram(n, false);
+        double jsonUs, imageUs;
+        size_t jsonBytes, imageBytes;
+        measureBoot(json, jsonUs, imageUs, jsonBytes, imageBytes);
+
+        uint32_t scans = 4000000 / n;
+        if (scans < 500) scans = 500;
+        double deltaEvals = 0;
+        double interp = measureScans(json, Runner::INTERPRETED, scans, nullptr);
+        double full = measureScans(json, Runner::FULL, scans, nullptr);
+        double delta = measureScans(json, Runner::DELTA, scans, &deltaEvals);
+        printf("%7u %10.1f %10.1f %9zu %9zu %12.0f %10.0f %10.0f %8.1f %8.1f\n", n, jsonUs, imageUs, jsonBytes,
+               imageBytes, interp, full, delta, delta > 0 ? full / delta : 0.0, deltaEvals);
+    }
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) return usage();
+    if (strcmp(argv[1], "run") == 0) return runCommand(argc - 2, argv + 2);
+    if (strcmp(argv[1], "check") == 0) {
+        if (argc > 2 && strcmp(argv[2], "retain") == 0) return checkRetainCommand();
+        return checkCommand(argc - 2, argv + 2);
+    }
+    if (strcmp(argv[1], "bench") == 0) {
+        if (argc > 2 && strcmp(argv[2], "compile") == 0) return benchCompileCommand(argc - 3, argv + 3);
+        if (argc > 2 && strcmp(argv[2], "boot") == 0) return benchBootCommand();
+        if (argc > 2 && strcmp(argv[2], "scale") == 0) return benchScaleCommand();
+        return benchCommand();
+    }
+    return usage();
+}
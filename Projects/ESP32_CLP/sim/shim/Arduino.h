@@ -0,0 +1,192 @@
+#pragma once
+
+// Subconjunto do core Arduino-ESP32 usado pelo motor ladder, para compilar
+// LadderEngine/IOManager no host (env:native). Só o necessário: String,
+// Print/Stream (o ArduinoJson lê e grava por elas), Serial e relógio.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <string>
+
+#define PROGMEM
+#define IRAM_ATTR
+
+#define LOW 0
+#define HIGH 1
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+
+#ifndef constrain
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#endif
+
+// Relógio: millis() e delay() seguem o tempo virtual da simulação (HostClock.h);
+// micros() é o relógio real do host, porque o motor só o usa para medir
+// custo (tempo de varredura, de carga e de patch).
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+
+// Contador de ciclos (CCOUNT no alvo): relógio real do host convertido
+// para a frequência nominal, para os perfis saírem nas mesmas unidades.
+uint32_t getCpuFrequencyMhz();
+class EspClass {
+public:
+    uint32_t getCycleCount();
+};
+extern EspClass ESP;
+
+// Os pinos são simulados em gpio_port (GpioPort.h); aqui nada a fazer.
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t, uint8_t) {}
+inline int digitalRead(uint8_t) { return HIGH; }
+
+class String {
+public:
+    String(const char* s = "") : s_(s ? s : "") {}
+    String(const std::string& s) : s_(s) {}
+    explicit String(char c) : s_(1, c) {}
+    explicit String(int v) : s_(std::to_string(v)) {}
+    explicit String(unsigned v) : s_(std::to_string(v)) {}
+    explicit String(long v) : s_(std::to_string(v)) {}
+    explicit String(unsigned long v) : s_(std::to_string(v)) {}
+
+    const char* c_str() const { return s_.c_str(); }
+    unsigned int length() const { return (unsigned int)s_.size(); }
+    bool reserve(unsigned int size) {
+        s_.reserve(size);
+        return true;
+    }
+    bool concat(const char* s) {
+        if (s) s_.append(s);
+        return true;
+    }
+    bool concat(const char* s, unsigned int n) {
+        s_.append(s, n);
+        return true;
+    }
+    bool concat(char c) {
+        s_.push_back(c);
+        return true;
+    }
+    String& operator+=(const char* s) {
+        concat(s);
+        return *this;
+    }
+    String& operator+=(const String& s) {
+        s_ += s.s_;
+        return *this;
+    }
+    String& operator+=(char c) {
+        s_.push_back(c);
+        return *this;
+    }
+    char operator[](unsigned int i) const { return i < s_.size() ? s_[i] : '\0'; }
+    bool operator==(const char* s) const { return s && s_ == s; }
+    bool operator==(const String& s) const { return s_ == s.s_; }
+    bool operator!=(const char* s) const { return !(*this == s); }
+    bool operator!=(const String& s) const { return s_ != s.s_; }
+    bool operator<(const String& s) const { return s_ < s.s_; }
+
+private:
+    std::string s_;
+};
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buf, size_t len) {
+        size_t n = 0;
+        while (len--) n += write(*buf++);
+        return n;
+    }
+    size_t write(const char* s) { return write(reinterpret_cast<const uint8_t*>(s), strlen(s)); }
+
+    size_t print(const char* s) { return write(s); }
+    size_t print(const String& s) { return write(reinterpret_cast<const uint8_t*>(s.c_str()), s.length()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int v) { return printf("%d", v); }
+    size_t print(unsigned int v) { return printf("%u", v); }
+    size_t print(long v) { return printf("%ld", v); }
+    size_t print(unsigned long v) { return printf("%lu", v); }
+    size_t print(long long v) { return printf("%lld", v); }
+    size_t print(unsigned long long v) { return printf("%llu", v); }
+    size_t print(double v, int digits = 2) { return printf("%.*f", digits, v); }
+    size_t println() { return write("\r\n"); }
+    template <typename T>
+    size_t println(const T& v) {
+        size_t n = print(v);
+        return n + println();
+    }
+    size_t printf(const char* fmt, ...) __attribute__((format(printf, 2, 3))) {
+        char local[256];
+        va_list args;
+        va_start(args, fmt);
+        int len = vsnprintf(local, sizeof(local), fmt, args);
+        va_end(args);
+        if (len < 0) return 0;
+        if ((size_t)len < sizeof(local)) return write(reinterpret_cast<const uint8_t*>(local), len);
+        std::string big(len + 1, '\0');
+        va_start(args, fmt);
+        vsnprintf(&big[0], big.size(), fmt, args);
+        va_end(args);
+        return write(reinterpret_cast<const uint8_t*>(big.data()), len);
+    }
+    virtual void flush() {}
+};
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+    size_t readBytes(char* buffer, size_t length) {
+        size_t n = 0;
+        while (n < length) {
+            int c = read();
+            if (c < 0) break;
+            buffer[n++] = (char)c;
+        }
+        return n;
+    }
+    size_t readBytes(uint8_t* buffer, size_t length) { return readBytes(reinterpret_cast<char*>(buffer), length); }
+};
+
+// Serial vai para stderr, e só com o eco ligado (HostClock.h): as mensagens
+// de carga do motor não se misturam aos traços da simulação.
+class HostSerial : public Stream {
+public:
+    void begin(unsigned long) {}
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buf, size_t len) override {
+        if (echo) fwrite(buf, 1, len, stderr);
+        return len;
+    }
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+    using Print::write;
+
+    bool echo = false;
+};
+
+extern HostSerial Serial;
+
+// Print sobre um FILE* do host (relatórios da simulação).
+class FilePrint : public Print {
+public:
+    explicit FilePrint(FILE* f) : file(f) {}
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buf, size_t len) override { return fwrite(buf, 1, len, file); }
+    using Print::write;
+
+private:
+    FILE* file;
+};
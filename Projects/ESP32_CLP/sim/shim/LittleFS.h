@@ -0,0 +1,85 @@
+#pragma once
+
+#include <Arduino.h>
+#include <map>
+#include <memory>
+#include <string>
+
+// LittleFS em memória: cada arquivo é um buffer compartilhado entre os
+// File abertos. Persiste enquanto o processo roda, o bastante para o ciclo
+// salvar / recarregar do motor (JSON + imagem binária).
+class File : public Stream {
+public:
+    File() : pos(0) {}
+    File(std::shared_ptr<std::string> data, size_t pos) : data(std::move(data)), pos(pos) {}
+
+    explicit operator bool() const { return (bool)data; }
+    size_t size() const { return data ? data->size() : 0; }
+    size_t position() const { return pos; }
+    bool seek(size_t p) {
+        if (!data || p > data->size()) return false;
+        pos = p;
+        return true;
+    }
+    void close() { data.reset(); }
+
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buf, size_t len) override {
+        if (!data) return 0;
+        data->replace(pos, len < data->size() - pos ? len : data->size() - pos, reinterpret_cast<const char*>(buf), len);
+        pos += len;
+        return len;
+    }
+    using Print::write;
+
+    int available() override { return data ? (int)(data->size() - pos) : 0; }
+    int read() override { return data && pos < data->size() ? (uint8_t)(*data)[pos++] : -1; }
+    int peek() override { return data && pos < data->size() ? (uint8_t)(*data)[pos] : -1; }
+    size_t read(uint8_t* buf, size_t len) {
+        size_t n = data && pos < data->size() ? data->size() - pos : 0;
+        if (n > len) n = len;
+        if (n) memcpy(buf, data->data() + pos, n);
+        pos += n;
+        return n;
+    }
+
+private:
+    std::shared_ptr<std::string> data;
+    size_t pos;
+};
+
+class HostFS {
+public:
+    bool begin(bool formatOnFail = false) { return true; }
+    bool exists(const char* path) const { return files.count(path) != 0; }
+    bool exists(const String& path) const { return exists(path.c_str()); }
+    // "r" lê, "w" trunca, "a" acrescenta; como no LittleFS, "r" de um
+    // arquivo inexistente devolve File inválido.
+    File open(const char* path, const char* mode = "r") {
+        auto it = files.find(path);
+        if (mode[0] == 'w' || (mode[0] == 'a' && it == files.end())) {
+            auto data = std::make_shared<std::string>();
+            files[path] = data;
+            return File(data, 0);
+        }
+        if (it == files.end()) return File();
+        return File(it->second, mode[0] == 'a' ? it->second->size() : 0);
+    }
+    File open(const String& path, const char* mode = "r") { return open(path.c_str(), mode); }
+    bool remove(const char* path) { return files.erase(path) != 0; }
+    bool remove(const String& path) { return remove(path.c_str()); }
+    bool rename(const char* from, const char* to) {
+        auto it = files.find(from);
+        if (it == files.end()) return false;
+        auto data = it->second;
+        files.erase(it);
+        files[to] = data;
+        return true;
+    }
+    bool rename(const String& from, const String& to) { return rename(from.c_str(), to.c_str()); }
+
+private:
+    std::map<std::string, std::shared_ptr<std::string>> files;
+};
+
+extern HostFS LittleFS;
@@ -0,0 +1,6 @@
+#pragma once
+
+#include <stdint.h>
+
+// Tempo virtual da simulação em µs (o mesmo de millis()).
+int64_t esp_timer_get_time();
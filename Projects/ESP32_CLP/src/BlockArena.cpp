@@ -0,0 +1,49 @@
+#include "BlockArena.h"
+#include <stdlib.h>
+
+#ifdef ARDUINO
+#include <esp_heap_caps.h>
+#include <esp32-hal-psram.h>
+#endif
+
+BlockArena::BlockArena() : base(nullptr), size(0), used(0), psram(false) {}
+
+BlockArena::~BlockArena() {
+    release();
+}
+
+bool BlockArena::reserve(size_t bytes) {
+    release();
+#ifdef ARDUINO
+    if (psramFound()) {
+        base = static_cast<uint8_t*>(heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+        psram = base != nullptr;
+    }
+    if (!base) base = static_cast<uint8_t*>(heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
+#else
+    base = static_cast<uint8_t*>(malloc(bytes));
+#endif
+    if (!base) return false;
+    size = bytes;
+    used = 0;
+    return true;
+}
+
+void BlockArena::release() {
+    if (base) free(base);
+    base = nullptr;
+    size = 0;
+    used = 0;
+    psram = false;
+}
+
+size_t BlockArena::available() {
+#ifdef ARDUINO
+    if (psramFound()) return heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM);
+    size_t largest = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    size_t reserveBytes = LADDER_HEAP_RESERVE;
+    return largest > reserveBytes ? largest - reserveBytes : 0;
+#else
+    return (size_t)64 * 1024 * 1024;
+#endif
+}
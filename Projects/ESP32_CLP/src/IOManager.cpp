@@ -1,4 +1,5 @@
 #include "IOManager.h"
+#include "GpioPort.h"
 
 // Entradas com pull-up interno. Pins escolhidos fora dos strappings principais.
 const uint8_t INPUT_PINS[INPUTS_COUNT] = {13, 14, 25, 26};
@@ -7,9 +8,20 @@ const uint8_t OUTPUT_PINS[OUTPUTS_COUNT] = {16, 17, 18, 19, 21, 22};
 
 IOManager ioManager;
 
-IOManager::IOManager() {
-    memset(inputs, false, sizeof(inputs));
-    memset(outputs, false, sizeof(outputs));
+#ifndef ARDUINO
+namespace gpio_port {
+uint32_t hostIn = 0xFFFFFFFFu; // Pull-ups: tudo em HIGH (desligado)
+uint32_t hostOut = 0;
+uint32_t hostWrites = 0;
+}
+#endif
+
+IOManager::IOManager()
+    : inputBits(0), outputBits(0), appliedOutputs(0), inputChanges(0),
+      outputChanges(0), scanCount(0), outPinMask(0) {
+    for (int i = 0; i < OUTPUTS_COUNT; i++) {
+        outPinMask |= 1u << OUTPUT_PINS[i];
+    }
 }
 
 void IOManager::init() {
@@ -17,51 +29,75 @@ void IOManager::init() {
     for (int i = 0; i < INPUTS_COUNT; i++) {
         pinMode(INPUT_PINS[i], INPUT_PULLUP);
     }
-    
+
     // Configurar saídas
     for (int i = 0; i < OUTPUTS_COUNT; i++) {
         pinMode(OUTPUT_PINS[i], OUTPUT);
-        digitalWrite(OUTPUT_PINS[i], LOW);
-        outputs[i] = false;
     }
+    outputBits = 0;
+    appliedOutputs = 0;
+    gpio_port::writeOut(0, outPinMask);
 }
 
 void IOManager::scanInputs() {
+    uint32_t reg = gpio_port::readIn();
+    uint32_t bits = 0;
     for (int i = 0; i < INPUTS_COUNT; i++) {
         // Invertido porque é pull-up (HIGH = desligado)
-        inputs[i] = !digitalRead(INPUT_PINS[i]);
+        bits |= ((~reg >> INPUT_PINS[i]) & 1u) << i;
+    }
+    inputChanges = bits ^ inputBits;
+    inputBits = bits;
+    scanCount++;
+}
+
+bool IOManager::inputsDifferFromImage() const {
+    uint32_t reg = gpio_port::readIn();
+    for (int i = 0; i < INPUTS_COUNT; i++) {
+        uint32_t bit = (~reg >> INPUT_PINS[i]) & 1u;
+        if (bit != ((inputBits >> i) & 1u)) return true;
     }
+    return false;
 }
 
 void IOManager::updateOutputs() {
+    uint32_t setMask = 0;
+    uint32_t bits = outputBits;
     for (int i = 0; i < OUTPUTS_COUNT; i++) {
-        digitalWrite(OUTPUT_PINS[i], outputs[i] ? HIGH : LOW);
+        setMask |= ((bits >> i) & 1u) << OUTPUT_PINS[i];
     }
+    gpio_port::writeOut(setMask, outPinMask & ~setMask);
+    outputChanges = bits ^ appliedOutputs;
+    appliedOutputs = bits;
 }
 
 bool IOManager::getInput(uint8_t index) {
     if (index >= INPUTS_COUNT) return false;
-    return inputs[index];
+    return inputAt(index);
 }
 
 void IOManager::setOutput(uint8_t index, bool state) {
     if (index >= OUTPUTS_COUNT) return;
-    outputs[index] = state;
+    writeOutputAt(index, state);
 }
 
 bool IOManager::getOutput(uint8_t index) {
     if (index >= OUTPUTS_COUNT) return false;
-    return outputs[index];
+    return outputAt(index);
 }
 
 void IOManager::getAllInputs(bool* buffer) {
-    memcpy(buffer, inputs, INPUTS_COUNT * sizeof(bool));
+    uint32_t bits = inputBits;
+    for (int i = 0; i < INPUTS_COUNT; i++) buffer[i] = (bits >> i) & 1u;
 }
 
 void IOManager::getAllOutputs(bool* buffer) {
-    memcpy(buffer, outputs, OUTPUTS_COUNT * sizeof(bool));
+    uint32_t bits = outputBits;
+    for (int i = 0; i < OUTPUTS_COUNT; i++) buffer[i] = (bits >> i) & 1u;
 }
 
 void IOManager::setAllOutputs(const bool* buffer) {
-    memcpy(outputs, buffer, OUTPUTS_COUNT * sizeof(bool));
+    uint32_t bits = 0;
+    for (int i = 0; i < OUTPUTS_COUNT; i++) bits |= (buffer[i] ? 1u : 0u) << i;
+    outputBits = bits;
 }
@@ -0,0 +1,249 @@
+#include "LadderCompiler.h"
+#include <string.h>
+#include "IOManager.h"
+
+namespace {
+
+// Marca de bloco já emitido em CompileScratch::indegree.
+constexpr uint16_t EMITTED = 0xFFFF;
+constexpr uint16_t NO_WRITER = 0xFFFF;
+
+bool writesOutput(BlockType t) {
+    return t == BlockType::COIL || t == BlockType::LATCH_SET || t == BlockType::LATCH_RESET;
+}
+
+inline void setBit(uint32_t* words, uint16_t pos) {
+    words[pos >> 5] |= 1u << (pos & 31);
+}
+
+inline void clearBit(uint32_t* words, uint16_t pos) {
+    words[pos >> 5] &= ~(1u << (pos & 31));
+}
+
+// Transforma contagens em count[i + 1] em inícios CSR (count[0] = 0).
+void prefixSum(uint32_t* start, uint16_t n) {
+    start[0] = 0;
+    for (uint16_t i = 0; i < n; i++) start[i + 1] += start[i];
+}
+
+// Depois de preencher usando start[i] como cursor, start[i] aponta para o
+// início do próximo; desloca de volta.
+void unshift(uint32_t* start, uint16_t n) {
+    for (uint16_t i = n; i > 0; i--) start[i] = start[i - 1];
+    start[0] = 0;
+}
+
+// Chama fn(pred) para cada predecessor do bloco i: operandos e o escritor
+// anterior da mesma saída ('lastWriter' é atualizado; chamar em ordem de i).
+template <class Fn>
+void forEachPred(const BlockTable& t, uint16_t i, uint16_t* lastWriter, Fn fn) {
+    for (uint32_t k = t.opStart[i]; k < t.opStart[i + 1]; k++) {
+        BlockRef ref = t.operands[k];
+        if (ref >= 0 && ref < t.count && (uint16_t)ref != i) fn((uint16_t)ref);
+    }
+    BlockType ty = t.type[i];
+    uint8_t io = t.ioIndex[i];
+    if (writesOutput(ty) && io < OUTPUTS_COUNT) {
+        if (lastWriter[io] != NO_WRITER) fn(lastWriter[io]);
+        lastWriter[io] = i;
+    }
+}
+
+// Chama fn(slot) para cada operando de uma instrução (sem o slot falso).
+template <class Fn>
+void forEachOperand(const CompiledProgram& prog, const Instr& in, Fn fn) {
+    if (in.op == OpCode::ANDN || in.op == OpCode::ORN) {
+        for (uint16_t k = 0; k < in.b; k++) {
+            uint16_t slot = prog.args[in.a + k];
+            if (slot != prog.slotFalse) fn(slot);
+        }
+        return;
+    }
+    if (in.a != prog.slotFalse) fn(in.a);
+    if (in.b != prog.slotFalse && in.b != in.a) fn(in.b);
+}
+
+} // namespace
+
+void carveProgram(BlockArena& arena, uint16_t capacity, uint32_t operandCapacity,
+                  CompiledProgram& prog, CompileScratch& scratch) {
+    prog.code = arena.take<Instr>(capacity);
+    prog.args = arena.take<uint16_t>(operandCapacity);
+    prog.slotFalse = capacity;
+    prog.length = 0;
+    prog.argCount = 0;
+    prog.feedbackEdges = 0;
+    prog.danglingRefs = 0;
+    prog.badIo = 0;
+    scratch.indegree = arena.take<uint16_t>(capacity);
+    scratch.succStart = arena.take<uint32_t>(capacity + 1);
+    // Um sucessor por operando mais um por escritor de saída encadeado.
+    scratch.succList = arena.take<uint16_t>(operandCapacity + capacity);
+    scratch.ready = arena.take<uint32_t>(blockWords(capacity));
+}
+
+void carveDeltaIndex(BlockArena& arena, uint16_t capacity, uint32_t operandCapacity, DeltaIndex& out) {
+    out.words = blockWords(capacity);
+    out.posOf = arena.take<uint16_t>(capacity);
+    out.fanStart = arena.take<uint32_t>(capacity + 1);
+    out.fanList = arena.take<uint16_t>(operandCapacity);
+    out.inputUsers = arena.take<uint32_t>((size_t)INPUTS_COUNT * out.words);
+    out.outputUsers = arena.take<uint32_t>(out.words);
+}
+
+void compileProgram(const BlockTable& t, CompiledProgram& out, CompileScratch& s) {
+    const uint16_t count = t.count;
+    const uint16_t none = out.slotFalse;
+    out.length = 0;
+    out.argCount = 0;
+    out.feedbackEdges = 0;
+    out.danglingRefs = 0;
+    out.badIo = 0;
+
+    auto resolve = [&](BlockRef ref) -> uint16_t {
+        if (ref < 0 || ref >= count) return none;
+        return static_cast<uint16_t>(ref);
+    };
+
+    // Grafo invertido (sucessores em CSR) e contagem de predecessores.
+    uint16_t lastWriter[OUTPUTS_COUNT];
+    memset(s.indegree, 0, count * sizeof(uint16_t));
+    memset(s.succStart, 0, (count + 1) * sizeof(uint32_t));
+    memset(lastWriter, 0xFF, sizeof(lastWriter));
+    for (uint16_t i = 0; i < count; i++) {
+        forEachPred(t, i, lastWriter, [&](uint16_t p) {
+            s.succStart[p + 1]++;
+            s.indegree[i]++;
+        });
+    }
+    prefixSum(s.succStart, count);
+    memset(lastWriter, 0xFF, sizeof(lastWriter));
+    for (uint16_t i = 0; i < count; i++) {
+        forEachPred(t, i, lastWriter, [&](uint16_t p) { s.succList[s.succStart[p]++] = i; });
+    }
+    unshift(s.succStart, count);
+
+    // Kahn com desempate pelo menor índice: programas já ordenados saem idênticos.
+    const uint16_t words = blockWords(count);
+    memset(s.ready, 0, words * sizeof(uint32_t));
+    for (uint16_t i = 0; i < count; i++) {
+        if (s.indegree[i] == 0) setBit(s.ready, i);
+    }
+    uint16_t firstPending = 0;
+    for (uint16_t n = 0; n < count; n++) {
+        while (s.indegree[firstPending] == EMITTED) firstPending++;
+
+        int32_t pick = -1;
+        for (uint16_t w = firstPending >> 5; w < words; w++) {
+            if (s.ready[w]) {
+                pick = (w << 5) + __builtin_ctz(s.ready[w]);
+                break;
+            }
+        }
+        if (pick < 0) {
+            // Ciclo: o bloco lê o valor da varredura anterior dos predecessores pendentes.
+            pick = firstPending;
+            out.feedbackEdges++;
+        } else {
+            clearBit(s.ready, pick);
+        }
+        s.indegree[pick] = EMITTED;
+        for (uint32_t k = s.succStart[pick]; k < s.succStart[pick + 1]; k++) {
+            uint16_t q = s.succList[k];
+            if (s.indegree[q] != EMITTED && --s.indegree[q] == 0) setBit(s.ready, q);
+        }
+
+        BlockType type = t.type[pick];
+        uint8_t io = t.ioIndex[pick];
+        uint32_t arity = t.arity(pick);
+        Instr& in = out.code[out.length++];
+        in.dst = static_cast<uint16_t>(pick);
+        in.io = io;
+        for (uint32_t k = 0; k < arity; k++) {
+            if (t.operand(pick, k) >= count) out.danglingRefs++;
+        }
+
+        if (isGate(type) && arity > 2) {
+            // Porta de N entradas: operandos resolvidos em args.
+            in.a = static_cast<uint16_t>(out.argCount);
+            in.b = static_cast<uint16_t>(arity);
+            for (uint32_t k = 0; k < arity; k++) out.args[out.argCount++] = resolve(t.operand(pick, k));
+        } else {
+            uint8_t used = blockOperands(type);
+            in.a = used >= 1 ? resolve(t.inA(pick)) : none;
+            in.b = used >= 2 ? resolve(t.inB(pick)) : none;
+        }
+
+        bool inOk = io < INPUTS_COUNT;
+        bool outOk = io < OUTPUTS_COUNT;
+        switch (type) {
+            case BlockType::CONTACT_NO:
+                in.op = inOk ? OpCode::LD_IN : OpCode::LD_FALSE;
+                if (!inOk) out.badIo++;
+                break;
+            case BlockType::CONTACT_NC:
+                in.op = inOk ? OpCode::LD_NIN : OpCode::LD_TRUE;
+                if (!inOk) out.badIo++;
+                break;
+            case BlockType::CONST_TRUE:  in.op = OpCode::LD_TRUE; break;
+            case BlockType::CONST_FALSE: in.op = OpCode::LD_FALSE; break;
+            case BlockType::AND:         in.op = arity > 2 ? OpCode::ANDN : OpCode::AND; break;
+            case BlockType::OR:          in.op = arity > 2 ? OpCode::ORN : OpCode::OR; break;
+            case BlockType::NOT:         in.op = OpCode::NOT; break;
+            case BlockType::TIMER_ON:    in.op = OpCode::TON; break;
+            case BlockType::TIMER_OFF:   in.op = OpCode::TOF; break;
+            case BlockType::TIMER_PULSE: in.op = OpCode::TP; break;
+            case BlockType::TIMER_RETENTIVE: in.op = OpCode::TONR; break;
+            case BlockType::COUNTER_UP:  in.op = OpCode::CTU; break;
+            case BlockType::COUNTER_DOWN: in.op = OpCode::CTD; break;
+            case BlockType::COIL:
+                in.op = outOk ? OpCode::OUT : OpCode::MOV;
+                if (!outOk) out.badIo++;
+                break;
+            case BlockType::LATCH_SET:
+                in.op = outOk ? OpCode::SET : OpCode::LD_FALSE;
+                if (!outOk) out.badIo++;
+                break;
+            case BlockType::LATCH_RESET:
+                in.op = outOk ? OpCode::RST : OpCode::LD_FALSE;
+                if (!outOk) out.badIo++;
+                break;
+        }
+    }
+}
+
+void buildDeltaIndex(const CompiledProgram& prog, DeltaIndex& out) {
+    const uint16_t n = prog.length;
+    for (uint16_t p = 0; p < n; p++) {
+        out.posOf[prog.code[p].dst] = p;
+    }
+    memset(out.inputUsers, 0, (size_t)INPUTS_COUNT * out.words * sizeof(uint32_t));
+    memset(out.outputUsers, 0, out.words * sizeof(uint32_t));
+
+    // Conta consumidores por posição e depois preenche (CSR).
+    memset(out.fanStart, 0, (n + 1) * sizeof(uint32_t));
+    for (uint16_t p = 0; p < n; p++) {
+        forEachOperand(prog, prog.code[p], [&](uint16_t slot) { out.fanStart[out.posOf[slot] + 1]++; });
+    }
+    prefixSum(out.fanStart, n);
+
+    for (uint16_t p = 0; p < n; p++) {
+        const Instr& in = prog.code[p];
+        forEachOperand(prog, in, [&](uint16_t slot) { out.fanList[out.fanStart[out.posOf[slot]]++] = p; });
+
+        switch (in.op) {
+            case OpCode::LD_IN:
+            case OpCode::LD_NIN:
+                setBit(out.inputUsers + in.io * out.words, p);
+                break;
+            case OpCode::OUT:
+            case OpCode::SET:
+            case OpCode::RST:
+                setBit(out.outputUsers, p);
+                break;
+            default:
+                break;
+        }
+    }
+    unshift(out.fanStart, n);
+}
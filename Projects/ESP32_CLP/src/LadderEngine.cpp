@@ -1,10 +1,14 @@
 #include "LadderEngine.h"
+#include "ProgramImage.h"
+#include <esp_timer.h>
 
 LadderEngine ladderEngine;
 
 namespace {
 
 constexpr const char* PROGRAM_PATH = "/program.json";
+constexpr const char* IMAGE_PATH = "/program.bin";
+constexpr const char* IMAGE_TMP_PATH = "/program.bin.tmp";
 
 BlockType blockTypeFromString(const String& t) {
     if (t == "CONTACT_NO") return BlockType::CONTACT_NO;
@@ -19,9 +23,32 @@ BlockType blockTypeFromString(const String& t) {
     if (t == "LATCH_RESET") return BlockType::LATCH_RESET;
     if (t == "CONST_TRUE") return BlockType::CONST_TRUE;
     if (t == "CONST_FALSE") return BlockType::CONST_FALSE;
+    if (t == "TIMER_PULSE") return BlockType::TIMER_PULSE;
+    if (t == "TIMER_RETENTIVE") return BlockType::TIMER_RETENTIVE;
+    if (t == "COUNTER_UP") return BlockType::COUNTER_UP;
+    if (t == "COUNTER_DOWN") return BlockType::COUNTER_DOWN;
     return BlockType::CONST_FALSE;
 }
 
+// ArduinoJson usa por volta do dobro do texto (membros + cópia das strings).
+size_t jsonDocumentSize(size_t textBytes) {
+    return textBytes * 2 + 1024;
+}
+
+struct StringPrint : public Print {
+    String str;
+    size_t write(uint8_t c) override {
+        str += (char)c;
+        return 1;
+    }
+    size_t write(const uint8_t* buf, size_t len) override {
+        str.concat(reinterpret_cast<const char*>(buf), len);
+        return len;
+    }
+};
+
+} // namespace
+
 const char* blockTypeToString(BlockType t) {
     switch (t) {
         case BlockType::CONTACT_NO: return "CONTACT_NO";
@@ -36,17 +63,87 @@ const char* blockTypeToString(BlockType t) {
         case BlockType::LATCH_RESET: return "LATCH_RESET";
         case BlockType::CONST_TRUE: return "CONST_TRUE";
         case BlockType::CONST_FALSE: return "CONST_FALSE";
+        case BlockType::TIMER_PULSE: return "TIMER_PULSE";
+        case BlockType::TIMER_RETENTIVE: return "TIMER_RETENTIVE";
+        case BlockType::COUNTER_UP: return "COUNTER_UP";
+        case BlockType::COUNTER_DOWN: return "COUNTER_DOWN";
     }
     return "CONST_FALSE";
 }
 
-} // namespace
+LadderEngine::LadderEngine()
+    : runtime(nullptr), values(nullptr), cycleMs(20), lastScanUs(0), maxScanUs(0), loadUs(0),
+      lastPatchUs(0), loadSource(ProgramSource::NONE), evalMode(EvalMode::FULL), pendingNext(nullptr), dirty(nullptr),
+      deltaReset(true), settled(false), lastOutStart(0), lastEvalCount(0), retainWordCount(1), retainSig(0),
+      retainOutMask(0), retainBlocks(nullptr), retainBlockCount(0) {
+    memset(&table, 0, sizeof(table));
+    memset(&program, 0, sizeof(program));
+    memset(&scratch, 0, sizeof(scratch));
+    memset(&delta, 0, sizeof(delta));
+}
+
+// Fatia todos os arrays por bloco da arena; com a arena medindo, só soma.
+void LadderEngine::carve(BlockArena& a, uint16_t capacity, uint32_t operandCapacity) {
+    a.rewind();
+    table.count = 0;
+    table.capacity = capacity;
+    table.operandCapacity = operandCapacity;
+    // Campos lidos pela varredura primeiro, juntos.
+    program.code = nullptr;
+    carveProgram(a, capacity, operandCapacity, program, scratch);
+    values = a.take<uint8_t>(capacity + 1);
+    runtime = a.take<BlockRuntime>(capacity);
+    pendingNext = a.take<uint32_t>(blockWords(capacity));
+    dirty = a.take<uint32_t>(blockWords(capacity));
+    carveDeltaIndex(a, capacity, operandCapacity, delta);
+    wheel.carve(a, capacity);
+    table.type = a.take<BlockType>(capacity);
+    table.ioIndex = a.take<uint8_t>(capacity);
+    table.opStart = a.take<uint32_t>(capacity + 1);
+    table.operands = a.take<BlockRef>(operandCapacity);
+    table.preset = a.take<int32_t>(capacity);
+    table.delayUs = a.take<uint64_t>(capacity);
+    retainBlocks = a.take<uint16_t>(capacity);
+}
+
+bool LadderEngine::allocate(uint16_t maxBlocks) {
+    if (maxBlocks > MAX_BLOCK_CAPACITY) maxBlocks = MAX_BLOCK_CAPACITY;
+    if (maxBlocks < MIN_BLOCK_CAPACITY) maxBlocks = MIN_BLOCK_CAPACITY;
 
-LadderEngine::LadderEngine() : blockCount(0), cycleMs(20) {
-    memset(runtime, 0, sizeof(runtime));
+    // Reduz a capacidade até caber na memória disponível.
+    size_t avail = BlockArena::available();
+    uint16_t capacity = maxBlocks;
+    BlockArena probe;
+    for (;;) {
+        carve(probe, capacity, (uint32_t)capacity * OPERANDS_PER_BLOCK);
+        if (probe.bytesUsed() <= avail || capacity <= MIN_BLOCK_CAPACITY) break;
+        capacity -= capacity / 8;
+        if (capacity < MIN_BLOCK_CAPACITY) capacity = MIN_BLOCK_CAPACITY;
+    }
+    if (!arena.reserve(probe.bytesUsed())) {
+        // available() é o maior bloco livre, mas a PSRAM pode falhar à parte:
+        // tenta ainda a capacidade mínima antes de desistir.
+        Serial.printf("[LADDER] Falha ao alocar arena de %u bytes\n", (unsigned)probe.bytesUsed());
+        if (capacity == MIN_BLOCK_CAPACITY) return false;
+        capacity = MIN_BLOCK_CAPACITY;
+        carve(probe, capacity, (uint32_t)capacity * OPERANDS_PER_BLOCK);
+        if (!arena.reserve(probe.bytesUsed())) {
+            Serial.printf("[LADDER] Falha ao alocar arena de %u bytes\n", (unsigned)probe.bytesUsed());
+            return false;
+        }
+    }
+    uint32_t operandCapacity = (uint32_t)capacity * OPERANDS_PER_BLOCK;
+    carve(arena, capacity, operandCapacity);
+    table.opStart[0] = 0;
+    values[program.slotFalse] = 0;
+    Serial.printf("[LADDER] Arena: %u blocos, %lu operandos, %u bytes (%s)\n", capacity,
+                  (unsigned long)operandCapacity, (unsigned)arena.bytesReserved(),
+                  arena.inPsram() ? "PSRAM" : "heap interna");
+    return true;
 }
 
-void LadderEngine::init() {
+bool LadderEngine::init(uint16_t maxBlocks) {
+    if (!allocate(maxBlocks)) return false;
     if (!LittleFS.begin(true)) {
         Serial.println("[FS] Falha ao montar LittleFS");
     }
@@ -85,27 +182,122 @@ void LadderEngine::init() {
         }
     }
     loadFromStorage();
+    return true;
 }
 
 void LadderEngine::clearProgram() {
-    blockCount = 0;
-    memset(runtime, 0, sizeof(runtime));
+    table.count = 0;
+    table.opStart[0] = 0;
+    resetRuntime();
+    compile();
+}
+
+void LadderEngine::resetRuntime() {
+    memset(runtime, 0, table.capacity * sizeof(BlockRuntime));
+    memset(values, 0, table.capacity + 1);
+    // CTD parte do preset, como após um reset.
+    for (uint16_t i = 0; i < table.count; i++) {
+        if (table.type[i] == BlockType::COUNTER_DOWN) runtime[i].count = table.preset[i];
+    }
 }
 
 bool LadderEngine::loadFromStorage() {
-    if (!LittleFS.exists(PROGRAM_PATH)) {
-        Serial.println("[FS] Nenhum programa salvo");
+    uint32_t t0 = micros();
+    bool ok = loadImage();
+    if (ok) {
+        loadSource = ProgramSource::IMAGE;
+    } else {
+        if (!LittleFS.exists(PROGRAM_PATH)) {
+            Serial.println("[FS] Nenhum programa salvo");
+            return false;
+        }
+
+        File f = LittleFS.open(PROGRAM_PATH, "r");
+        if (!f) {
+            Serial.println("[FS] Falha ao abrir programa");
+            return false;
+        }
+
+        ok = loadProgramInternal(f);
+        f.close();
+        if (!ok) return false;
+        loadSource = ProgramSource::JSON;
+    }
+    loadUs = micros() - t0;
+    Serial.printf("[BOOT] Programa carregado de %s em %lu us\n",
+                  loadSource == ProgramSource::IMAGE ? IMAGE_PATH : PROGRAM_PATH, (unsigned long)loadUs);
+    // Imagem ausente ou inválida (primeiro boot após atualização, CRC): regrava.
+    if (loadSource == ProgramSource::JSON) saveImage();
+    return true;
+}
+
+bool LadderEngine::loadImage() {
+    if (!LittleFS.exists(IMAGE_PATH)) return false;
+    File f = LittleFS.open(IMAGE_PATH, "r");
+    if (!f) return false;
+
+    ProgramImageHeader h;
+    bool ok = f.read(reinterpret_cast<uint8_t*>(&h), sizeof(h)) == sizeof(h) && programImageHeaderValid(h, table);
+    if (ok) {
+        // Seções lidas direto para os arrays da tabela; se o CRC falhar o
+        // JSON recarrega tudo.
+        ProgramImageSection sec[PROGRAM_IMAGE_SECTIONS];
+        programImageSections(table, h, sec);
+        for (uint8_t i = 0; ok && i < PROGRAM_IMAGE_SECTIONS; i++) {
+            ok = f.read(static_cast<uint8_t*>(sec[i].data), sec[i].bytes) == sec[i].bytes;
+        }
+        ok = ok && programImageCheck(h, table);
+    }
+    f.close();
+    if (!ok) {
+        table.count = 0;
+        table.opStart[0] = 0;
+        Serial.println("[FS] Imagem do programa inválida, usando JSON");
         return false;
     }
 
-    File f = LittleFS.open(PROGRAM_PATH, "r");
+    cycleMs = constrain(h.cycleMs, MIN_CYCLE_MS, MAX_CYCLE_MS);
+    evalMode = h.evalMode == (uint8_t)EvalMode::DELTA ? EvalMode::DELTA : EvalMode::FULL;
+    table.count = h.blockCount;
+    resetRuntime();
+    compile();
+    return true;
+}
+
+bool LadderEngine::saveImage() const {
+    ProgramImageHeader h;
+    memset(&h, 0, sizeof(h));
+    h.magic = PROGRAM_IMAGE_MAGIC;
+    h.version = PROGRAM_IMAGE_VERSION;
+    h.headerSize = sizeof(ProgramImageHeader);
+    h.blockCount = table.count;
+    h.cycleMs = cycleMs;
+    h.operandCount = table.operandCount();
+    h.evalMode = (uint8_t)evalMode;
+    programImageSeal(h, table);
+
+    // Grava em arquivo temporário e renomeia: um corte de energia no meio
+    // deixa a imagem anterior (ou nenhuma) em vez de uma imagem truncada.
+    File f = LittleFS.open(IMAGE_TMP_PATH, "w");
     if (!f) {
-        Serial.println("[FS] Falha ao abrir programa");
+        Serial.println("[FS] Falha ao salvar imagem do programa");
         return false;
     }
-
-    bool ok = loadProgramInternal(f);
+    bool ok = f.write(reinterpret_cast<const uint8_t*>(&h), sizeof(h)) == sizeof(h);
+    ProgramImageSection sec[PROGRAM_IMAGE_SECTIONS];
+    programImageSections(table, h, sec);
+    for (uint8_t i = 0; ok && i < PROGRAM_IMAGE_SECTIONS; i++) {
+        ok = f.write(static_cast<const uint8_t*>(sec[i].data), sec[i].bytes) == sec[i].bytes;
+    }
     f.close();
+    if (ok) {
+        if (LittleFS.exists(IMAGE_PATH)) LittleFS.remove(IMAGE_PATH);
+        ok = LittleFS.rename(IMAGE_TMP_PATH, IMAGE_PATH);
+    }
+    if (!ok) {
+        LittleFS.remove(IMAGE_TMP_PATH);
+        Serial.println("[FS] Falha ao salvar imagem do programa");
+    }
     return ok;
 }
 
@@ -113,12 +305,15 @@ bool LadderEngine::eraseStorage() {
     if (LittleFS.exists(PROGRAM_PATH)) {
         LittleFS.remove(PROGRAM_PATH);
     }
+    if (LittleFS.exists(IMAGE_PATH)) {
+        LittleFS.remove(IMAGE_PATH);
+    }
     clearProgram();
     return true;
 }
 
 bool LadderEngine::loadFromJson(const String& json, bool persist) {
-    DynamicJsonDocument doc(8192);
+    DynamicJsonDocument doc(jsonDocumentSize(json.length()));
     DeserializationError err = deserializeJson(doc, json);
     if (err) {
         Serial.printf("[JSON] Erro ao parsear: %s\n", err.c_str());
@@ -127,7 +322,7 @@ bool LadderEngine::loadFromJson(const String& json, bool persist) {
 
     bool parsed = parseDocument(doc);
     if (parsed && persist) {
-        saveProgramInternal(json);
+        return saveProgramInternal(json);
     }
     return parsed;
 }
@@ -138,27 +333,71 @@ bool LadderEngine::parseDocument(const JsonDocument& doc) {
         return false;
     }
 
-    cycleMs = constrain(doc["cycle_ms"] | 20, 10, 100);
-
     JsonArrayConst arr = doc["blocks"].as<JsonArrayConst>();
-    blockCount = arr.size() < MAX_BLOCKS ? arr.size() : MAX_BLOCKS;
-    memset(runtime, 0, sizeof(runtime));
+    if (arr.size() > table.capacity) {
+        Serial.printf("[JSON] %u blocos excedem a capacidade (%u)\n", (unsigned)arr.size(), table.capacity);
+        return false;
+    }
 
-    for (uint8_t i = 0; i < blockCount; i++) {
+    // Primeiro valida o pool de operandos: se não couber, o programa atual fica.
+    uint32_t operandTotal = 0;
+    for (JsonObjectConst o : arr) {
+        BlockType type = blockTypeFromString(o["type"].as<String>());
+        JsonArrayConst list = o["in"].as<JsonArrayConst>();
+        operandTotal += isGate(type) && !list.isNull() ? list.size() : blockOperands(type);
+    }
+    if (operandTotal > table.operandCapacity) {
+        Serial.printf("[JSON] %lu operandos excedem a capacidade (%lu)\n",
+                      (unsigned long)operandTotal, (unsigned long)table.operandCapacity);
+        return false;
+    }
+
+    cycleMs = constrain(doc["cycle_ms"] | 20, MIN_CYCLE_MS, MAX_CYCLE_MS);
+    evalMode = strcmp(doc["eval"] | "full", "delta") == 0 ? EvalMode::DELTA : EvalMode::FULL;
+
+    table.count = arr.size();
+    uint32_t k = 0;
+    for (uint16_t i = 0; i < table.count; i++) {
         JsonObjectConst o = arr[i];
-        BlockDef& b = blocks[i];
-        String typeStr = o["type"].as<String>();
-        b.type = blockTypeFromString(typeStr);
-        b.inA = o["a"] | -1;
-        b.inB = o["b"] | -1;
-        b.ioIndex = o["io"] | 0;
-        b.delayMs = o["delay_ms"] | 0;
+        BlockType type = blockTypeFromString(o["type"].as<String>());
+        table.type[i] = type;
+        table.ioIndex[i] = o["io"] | 0;
+        table.opStart[i] = k;
+        // AND/OR aceitam "in": [ids]; os demais usam "a" e "b".
+        JsonArrayConst list = o["in"].as<JsonArrayConst>();
+        if (isGate(type) && !list.isNull()) {
+            for (JsonVariantConst ref : list) table.operands[k++] = ref | NO_BLOCK;
+        } else {
+            uint8_t used = blockOperands(type);
+            if (used >= 1) table.operands[k++] = o["a"] | NO_BLOCK;
+            if (used >= 2) table.operands[k++] = o["b"] | NO_BLOCK;
+        }
+        // delay_us tem precedência; delay_ms continua aceito.
+        uint64_t delayUs = o["delay_us"] | 0ULL;
+        table.delayUs[i] = delayUs ? delayUs : (uint64_t)(o["delay_ms"] | 0UL) * 1000ULL;
+        table.preset[i] = o["preset"] | 0;
     }
+    table.opStart[table.count] = k;
+    resetRuntime();
+    compile();
     return true;
 }
 
+void LadderEngine::compile() {
+    compileProgram(table, program, scratch);
+    buildDeltaIndex(program, delta);
+    wheel.reset(esp_timer_get_time());
+    memset(pendingNext, 0, blockWords(table.capacity) * sizeof(uint32_t));
+    deltaReset = true;
+    maxScanUs = 0;
+    layoutRetain();
+    profiler.clear();
+    Serial.printf("[LADDER] Compilado: %u instr, %u ciclo(s), %u ref(s) inválida(s), %u I/O inválido(s)\n",
+                  program.length, program.feedbackEdges, program.danglingRefs, program.badIo);
+}
+
 bool LadderEngine::loadProgramInternal(File& f) {
-    DynamicJsonDocument doc(8192);
+    DynamicJsonDocument doc(jsonDocumentSize(f.size()));
     DeserializationError err = deserializeJson(doc, f);
     if (err) {
         Serial.printf("[JSON] Erro de leitura: %s\n", err.c_str());
@@ -167,58 +406,423 @@ bool LadderEngine::loadProgramInternal(File& f) {
     return parseDocument(doc);
 }
 
+// O boot prefere a imagem: a antiga sai antes de o JSON mudar, senão uma
+// falha no meio deixaria o programa anterior voltando no próximo boot. Sem
+// imagem o boot só volta a parsear o JSON.
 bool LadderEngine::saveProgramInternal(const String& json) {
+    if (LittleFS.exists(IMAGE_PATH)) LittleFS.remove(IMAGE_PATH);
+    File f = LittleFS.open(PROGRAM_PATH, "w");
+    if (!f) {
+        Serial.println("[FS] Falha ao salvar programa");
+        return false;
+    }
+    bool ok = f.print(json) == json.length();
+    f.close();
+    if (!ok) {
+        Serial.println("[FS] Falha ao salvar programa");
+        return false;
+    }
+    // Chamado depois do parse: a tabela já corresponde ao JSON gravado.
+    return saveImage();
+}
+
+bool LadderEngine::saveCurrentProgram() {
+    if (LittleFS.exists(IMAGE_PATH)) LittleFS.remove(IMAGE_PATH);
     File f = LittleFS.open(PROGRAM_PATH, "w");
     if (!f) {
         Serial.println("[FS] Falha ao salvar programa");
         return false;
     }
-    f.print(json);
+    writeProgramJson(f);
     f.close();
+    return saveImage();
+}
+
+namespace {
+
+constexpr uint16_t NO_INDEX = 0xFFFF;
+
+// Entrada de "modify" para o bloco 'id' (edições têm poucos blocos).
+JsonObjectConst findModify(JsonArrayConst mods, uint16_t id) {
+    for (JsonObjectConst o : mods) {
+        if ((o["id"] | -1) == id) return o;
+    }
+    return JsonObjectConst();
+}
+
+} // namespace
+
+bool LadderEngine::preparePatch(const JsonDocument& doc, LadderPatch& patch) const {
+    uint32_t t0 = micros();
+    JsonArrayConst mods = doc["modify"].as<JsonArrayConst>();
+    JsonArrayConst rems = doc["remove"].as<JsonArrayConst>();
+    JsonArrayConst adds = doc["add"].as<JsonArrayConst>();
+    const uint16_t oldCount = table.count;
+    const uint32_t total = (uint32_t)oldCount + adds.size();
+
+    auto fail = [&](const char* why) {
+        patch.error = why;
+        patch.arena.release();
+        Serial.printf("[LADDER] Patch recusado: %s\n", why);
+        return false;
+    };
+    if (total > table.capacity + rems.size()) return fail("capacidade excedida");
+
+    // Limite de operandos: os atuais mais o máximo que cada entrada pode trazer.
+    uint32_t operandBound = table.operandCount();
+    for (JsonArrayConst list : {mods, adds}) {
+        for (JsonObjectConst o : list) {
+            uint32_t n = o["in"].as<JsonArrayConst>().size();
+            operandBound += n > 2 ? n : 2;
+        }
+    }
+
+    // Uma reserva só: medida, depois fatiada.
+    BlockArena& a = patch.arena;
+    uint16_t* remap = nullptr;
+    uint32_t* modified = nullptr;
+    for (uint8_t pass = 0; pass < 2; pass++) {
+        a.rewind();
+        BlockTable& t = patch.table;
+        t.type = a.take<BlockType>(total);
+        t.ioIndex = a.take<uint8_t>(total);
+        t.opStart = a.take<uint32_t>(total + 1);
+        t.operands = a.take<BlockRef>(operandBound);
+        t.preset = a.take<int32_t>(total);
+        t.delayUs = a.take<uint64_t>(total);
+        patch.origin = a.take<BlockRef>(total);
+        remap = a.take<uint16_t>(total);
+        modified = a.take<uint32_t>(blockWords(oldCount));
+        if (pass == 0 && !a.reserve(a.bytesUsed())) return fail("sem memória");
+    }
+
+    // Remoções e renumeração (ordem preservada, adicionados no fim).
+    for (uint32_t i = 0; i < total; i++) remap[i] = 0;
+    patch.removed = 0;
+    for (JsonVariantConst v : rems) {
+        int32_t id = v | -1;
+        if (id < 0 || id >= oldCount) return fail("remoção de bloco inexistente");
+        if (remap[id] == NO_INDEX) continue;
+        remap[id] = NO_INDEX;
+        patch.removed++;
+    }
+    uint16_t next = 0;
+    for (uint32_t i = 0; i < total; i++) {
+        if (remap[i] != NO_INDEX) remap[i] = next++;
+    }
+    if (next > table.capacity) return fail("capacidade excedida");
+
+    memset(modified, 0, blockWords(oldCount) * sizeof(uint32_t));
+    for (JsonObjectConst o : mods) {
+        int32_t id = o["id"] | -1;
+        if (id < 0 || id >= oldCount || remap[id] == NO_INDEX) return fail("modificação de bloco inexistente");
+        modified[id >> 5] |= 1u << (id & 31);
+    }
+
+    BlockTable& t = patch.table;
+    const char* refError = nullptr;
+    // Referências vêm na numeração antiga e saem na nova. As do patch têm
+    // de apontar para um bloco existente; uma já inválida no programa atual
+    // continua inválida (fica fora da faixa, lida como falso).
+    auto remapRef = [&](int32_t r, bool fromPatch) -> BlockRef {
+        if (r < 0) return NO_BLOCK;
+        if (!fromPatch && r >= oldCount) return (BlockRef)MAX_BLOCK_CAPACITY;
+        if (r >= (int32_t)total) {
+            refError = "referência a bloco inexistente";
+            return NO_BLOCK;
+        }
+        if (remap[r] == NO_INDEX) {
+            refError = "referência a bloco removido";
+            return NO_BLOCK;
+        }
+        return remap[r];
+    };
+
+    t.count = next;
+    t.capacity = next;
+    t.operandCapacity = operandBound;
+    patch.kept = 0;
+    patch.fresh = 0;
+    uint32_t k = 0;
+    auto addIt = adds.begin();
+    for (uint32_t s = 0; s < total; s++) {
+        bool isNew = s >= oldCount;
+        JsonObjectConst o;
+        if (isNew) {
+            o = (*addIt).as<JsonObjectConst>();
+            ++addIt;
+        } else if ((modified[s >> 5] >> (s & 31)) & 1u) {
+            o = findModify(mods, s);
+        }
+        if (remap[s] == NO_INDEX) continue;
+        uint16_t i = remap[s];
+
+        BlockType oldType = isNew ? BlockType::CONST_FALSE : table.type[s];
+        BlockType type = o.containsKey("type") ? blockTypeFromString(o["type"].as<String>()) : oldType;
+        bool reset = isNew || type != oldType;
+        t.type[i] = type;
+        t.ioIndex[i] = o["io"] | (isNew ? 0 : table.ioIndex[s]);
+        t.preset[i] = o["preset"] | (isNew ? 0 : table.preset[s]);
+        // Como na carga completa, delay_us (> 0) tem precedência sobre delay_ms.
+        uint64_t delayUs = o["delay_us"] | 0ULL;
+        if (delayUs) t.delayUs[i] = delayUs;
+        else if (o.containsKey("delay_ms") || o.containsKey("delay_us")) t.delayUs[i] = (uint64_t)(o["delay_ms"] | 0UL) * 1000ULL;
+        else t.delayUs[i] = isNew ? 0 : table.delayUs[s];
+
+        // Operandos: "in" substitui todos; "a"/"b" substituem os dois
+        // primeiros; o que faltar vem do bloco antigo.
+        t.opStart[i] = k;
+        JsonArrayConst list = o["in"].as<JsonArrayConst>();
+        if (isGate(type) && !list.isNull()) {
+            for (JsonVariantConst ref : list) t.operands[k++] = remapRef(ref | -1, true);
+        } else {
+            uint32_t oldArity = isNew ? 0 : table.arity(s);
+            uint32_t arity = reset ? blockOperands(type) : oldArity;
+            if (arity < 2 && o.containsKey("b")) arity = 2;
+            if (arity < 1 && o.containsKey("a")) arity = 1;
+            for (uint32_t n = 0; n < arity; n++) {
+                int32_t r = n < oldArity ? table.operand(s, n) : -1;
+                bool fromPatch = isNew;
+                if (n == 0 && o.containsKey("a")) {
+                    r = o["a"] | -1;
+                    fromPatch = true;
+                }
+                if (n == 1 && o.containsKey("b")) {
+                    r = o["b"] | -1;
+                    fromPatch = true;
+                }
+                t.operands[k++] = remapRef(r, fromPatch);
+            }
+        }
+        if (refError) return fail(refError);
+
+        patch.origin[i] = reset ? NO_BLOCK : (BlockRef)s;
+        if (reset) patch.fresh++;
+        else patch.kept++;
+    }
+    t.opStart[t.count] = k;
+    if (k > table.operandCapacity) return fail("operandos excedem a capacidade");
+
+    patch.cycleMs = doc.containsKey("cycle_ms") ? constrain(doc["cycle_ms"] | 20, MIN_CYCLE_MS, MAX_CYCLE_MS) : 0;
+    patch.evalMode = doc.containsKey("eval") ? (strcmp(doc["eval"] | "full", "delta") == 0 ? 1 : 0) : -1;
+    patch.error = nullptr;
+    patch.prepareUs = micros() - t0;
     return true;
 }
 
+void LadderEngine::commitPatch(LadderPatch& patch) {
+    uint32_t t0 = micros();
+    const BlockTable& t = patch.table;
+
+    // Estado dos blocos mantidos vai para o novo índice. A ordem relativa é
+    // preservada e os ids só diminuem (origin[i] >= i), então a cópia em
+    // ordem crescente nunca sobrescreve uma origem ainda não lida.
+    for (uint16_t i = 0; i < t.count; i++) {
+        BlockRef from = patch.origin[i];
+        if (from == NO_BLOCK) {
+            memset(&runtime[i], 0, sizeof(BlockRuntime));
+            if (t.type[i] == BlockType::COUNTER_DOWN) runtime[i].count = t.preset[i];
+            values[i] = 0;
+        } else if (from != (BlockRef)i) {
+            runtime[i] = runtime[from];
+            values[i] = values[from];
+        }
+    }
+
+    memcpy(table.type, t.type, t.count * sizeof(BlockType));
+    memcpy(table.ioIndex, t.ioIndex, t.count);
+    memcpy(table.opStart, t.opStart, (t.count + 1) * sizeof(uint32_t));
+    memcpy(table.operands, t.operands, t.operandCount() * sizeof(BlockRef));
+    memcpy(table.preset, t.preset, t.count * sizeof(int32_t));
+    memcpy(table.delayUs, t.delayUs, t.count * sizeof(uint64_t));
+    table.count = t.count;
+    if (patch.cycleMs) cycleMs = patch.cycleMs;
+    if (patch.evalMode >= 0) evalMode = patch.evalMode ? EvalMode::DELTA : EvalMode::FULL;
+
+    compile();
+    rearmTimers();
+
+    patch.applyUs = micros() - t0;
+    lastPatchUs = patch.applyUs;
+    Serial.printf("[LADDER] Patch: %u mantido(s), %u novo(s), %u removido(s), %lu us (preparo %lu us)\n",
+                  patch.kept, patch.fresh, patch.removed, (unsigned long)patch.applyUs,
+                  (unsigned long)patch.prepareUs);
+}
+
+void LadderEngine::writeProgramJson(Print& out) const {
+    out.print("{\"cycle_ms\":");
+    out.print(cycleMs);
+    out.print(evalMode == EvalMode::DELTA ? ",\"eval\":\"delta\"" : ",\"eval\":\"full\"");
+    out.print(",\"blocks\":[");
+    for (uint16_t i = 0; i < table.count; i++) {
+        BlockType type = table.type[i];
+        if (i) out.print(',');
+        out.print("{\"id\":");
+        out.print(i);
+        out.print(",\"type\":\"");
+        out.print(blockTypeToString(type));
+        out.print("\",\"a\":");
+        out.print(table.inA(i));
+        out.print(",\"b\":");
+        out.print(table.inB(i));
+        if (isGate(type) && table.arity(i) > 2) {
+            out.print(",\"in\":[");
+            for (uint32_t k = 0; k < table.arity(i); k++) {
+                if (k) out.print(',');
+                out.print(table.operand(i, k));
+            }
+            out.print(']');
+        }
+        out.print(",\"io\":");
+        out.print(table.ioIndex[i]);
+        uint64_t delayUs = table.delayUs[i];
+        if (delayUs % 1000 == 0) {
+            out.print(",\"delay_ms\":");
+            out.print(delayUs / 1000);
+        } else {
+            out.print(",\"delay_us\":");
+            out.print(delayUs);
+        }
+        if (type == BlockType::COUNTER_UP || type == BlockType::COUNTER_DOWN) {
+            out.print(",\"preset\":");
+            out.print(table.preset[i]);
+        }
+        out.print('}');
+    }
+    out.print("]}");
+}
+
 String LadderEngine::serializeProgram() const {
-    DynamicJsonDocument doc(8192);
-    doc["cycle_ms"] = cycleMs;
-    JsonArray arr = doc.createNestedArray("blocks");
-    for (uint8_t i = 0; i < blockCount; i++) {
-        JsonObject o = arr.createNestedObject();
-        o["id"] = i;
-        o["type"] = blockTypeToString(blocks[i].type);
-        o["a"] = blocks[i].inA;
-        o["b"] = blocks[i].inB;
-        o["io"] = blocks[i].ioIndex;
-        o["delay_ms"] = blocks[i].delayMs;
-    }
-    String out;
-    serializeJson(doc, out);
-    return out;
+    StringPrint out;
+    writeProgramJson(out);
+    return out.str;
+}
+
+void LadderEngine::packValues(uint32_t* words, uint16_t wordCount) const {
+    memset(words, 0, wordCount * sizeof(uint32_t));
+    for (uint16_t i = 0; i < table.count && (i >> 5) < wordCount; i++) {
+        if (values[i]) words[i >> 5] |= 1u << (i & 31);
+    }
+}
+
+namespace {
+
+constexpr uint32_t RETAIN_PREV_IN = 1u << 0;
+constexpr uint32_t RETAIN_DONE = 1u << 1;
+
+bool hasRetainSlot(BlockType t) {
+    return t == BlockType::TIMER_RETENTIVE || t == BlockType::COUNTER_UP || t == BlockType::COUNTER_DOWN;
+}
+
+} // namespace
+
+void LadderEngine::layoutRetain() {
+    uint16_t slots = 0;
+    retainOutMask = 0;
+    for (uint16_t i = 0; i < table.count; i++) {
+        BlockType t = table.type[i];
+        if (hasRetainSlot(t)) retainBlocks[slots++] = i;
+        if ((t == BlockType::LATCH_SET || t == BlockType::LATCH_RESET) && table.ioIndex[i] < OUTPUTS_COUNT) {
+            retainOutMask |= 1u << table.ioIndex[i];
+        }
+    }
+    retainBlockCount = slots;
+    retainWordCount = 1 + slots * RETAIN_SLOT_WORDS;
+    retainSig = crc32Update(0, &table.count, sizeof(table.count));
+    retainSig = crc32Update(retainSig, table.type, table.count * sizeof(BlockType));
+    retainSig = crc32Update(retainSig, table.ioIndex, table.count);
+}
+
+void LadderEngine::captureRetain(uint32_t* words) const {
+    uint64_t now = esp_timer_get_time();
+    words[0] = ioManager.getOutputBits() & retainOutMask;
+    uint32_t* slot = words + 1;
+    // Chamado a cada varredura: só os blocos retentivos, não a tabela toda.
+    for (uint16_t k = 0; k < retainBlockCount; k++) {
+        uint16_t i = retainBlocks[k];
+        BlockType t = table.type[i];
+        const BlockRuntime& r = runtime[i];
+        if (t == BlockType::TIMER_RETENTIVE) {
+            // Em andamento: guarda o acumulado até agora; no retorno o TONR
+            // volta parado e recomeça de onde estava se A seguir ligada.
+            uint64_t acc = r.accUs + (r.timerActive ? now - r.timerStart : 0);
+            if (r.done) acc = table.delayUs[i];
+            slot[0] = (uint32_t)acc;
+            slot[1] = (uint32_t)(acc >> 32);
+            slot[2] = r.done ? RETAIN_DONE : 0;
+        } else {
+            slot[0] = (uint32_t)r.count;
+            slot[1] = 0;
+            slot[2] = r.prevIn ? RETAIN_PREV_IN : 0;
+        }
+        slot += RETAIN_SLOT_WORDS;
+    }
+}
+
+void LadderEngine::restoreRetain(const uint32_t* words) {
+    for (uint8_t o = 0; o < OUTPUTS_COUNT; o++) {
+        if ((retainOutMask >> o) & 1u) ioManager.setOutput(o, (words[0] >> o) & 1u);
+    }
+    const uint32_t* slot = words + 1;
+    for (uint16_t i = 0; i < table.count; i++) {
+        BlockType t = table.type[i];
+        if ((t == BlockType::LATCH_SET || t == BlockType::LATCH_RESET) && table.ioIndex[i] < OUTPUTS_COUNT) {
+            runtime[i].latched = (words[0] >> table.ioIndex[i]) & 1u;
+        }
+        if (!hasRetainSlot(t)) continue;
+        BlockRuntime& r = runtime[i];
+        if (t == BlockType::TIMER_RETENTIVE) {
+            uint64_t acc = (uint64_t)slot[1] << 32 | slot[0];
+            r.accUs = acc < table.delayUs[i] ? acc : table.delayUs[i];
+            r.done = slot[2] & RETAIN_DONE;
+            r.timerActive = false;
+        } else {
+            r.count = (int32_t)slot[0];
+            r.prevIn = slot[2] & RETAIN_PREV_IN;
+        }
+        slot += RETAIN_SLOT_WORDS;
+    }
+    // Recalcula tudo na primeira varredura, já com o estado restaurado.
+    deltaReset = true;
 }
 
 void LadderEngine::setCycleMs(uint16_t periodMs) {
-    cycleMs = constrain(periodMs, 10, 100);
+    cycleMs = constrain(periodMs, MIN_CYCLE_MS, MAX_CYCLE_MS);
 }
 
-bool LadderEngine::computeBlock(uint8_t idx, uint32_t now) {
-    BlockDef& b = blocks[idx];
+bool LadderEngine::computeBlock(uint16_t idx, uint64_t now) {
+    const BlockTable& t = table;
     BlockRuntime& r = runtime[idx];
+    const uint8_t io = t.ioIndex[idx];
+    const uint64_t delayUs = t.delayUs[idx];
 
-    auto source = [&](int8_t id) {
-        if (id < 0 || id >= blockCount) return false;
-        return runtime[id].value;
+    auto source = [&](BlockRef id) {
+        if (id < 0 || id >= t.count) return false;
+        return values[id] != 0;
+    };
+    // Polling: conclui o temporizador se a duração já passou.
+    auto poll = [&](uint64_t duration) {
+        if (r.timerActive && (now - r.timerStart) >= duration) {
+            r.timerActive = false;
+            r.done = true;
+        }
+    };
+    auto start = [&](uint64_t duration) {
+        r.done = duration == 0;
+        r.timerActive = !r.done;
+        r.timerStart = now;
     };
 
-    bool inA = source(b.inA);
-    bool inB = source(b.inB);
+    bool inA = source(t.inA(idx));
+    bool inB = source(t.inB(idx));
     bool val = false;
 
-    switch (b.type) {
+    switch (t.type[idx]) {
         case BlockType::CONTACT_NO:
-            val = ioManager.getInput(b.ioIndex);
+            val = ioManager.getInput(io);
             break;
         case BlockType::CONTACT_NC:
-            val = !ioManager.getInput(b.ioIndex);
+            val = !ioManager.getInput(io);
             break;
         case BlockType::CONST_TRUE:
             val = true;
@@ -227,69 +831,431 @@ bool LadderEngine::computeBlock(uint8_t idx, uint32_t now) {
             val = false;
             break;
         case BlockType::AND:
-            val = inA && inB;
+            if (t.arity(idx) > 2) {
+                val = true;
+                for (uint32_t k = 0; k < t.arity(idx); k++) val = val && source(t.operand(idx, k));
+            } else {
+                val = inA && inB;
+            }
             break;
         case BlockType::OR:
-            val = inA || inB;
+            if (t.arity(idx) > 2) {
+                for (uint32_t k = 0; k < t.arity(idx); k++) val = val || source(t.operand(idx, k));
+            } else {
+                val = inA || inB;
+            }
             break;
         case BlockType::NOT:
             val = !inA;
             break;
         case BlockType::TIMER_ON:
             if (inA) {
-                if (!r.timerActive) {
-                    r.timerActive = true;
-                    r.timerStart = now;
-                }
-                val = (now - r.timerStart) >= b.delayMs;
+                poll(delayUs);
+                if (!r.timerActive && !r.done) start(delayUs);
+                val = r.done;
             } else {
                 r.timerActive = false;
+                r.done = false;
                 val = false;
             }
             break;
         case BlockType::TIMER_OFF:
             if (inA) {
                 r.timerActive = false;
+                r.done = false;
                 val = true;
             } else {
-                if (!r.timerActive) {
-                    r.timerActive = true;
-                    r.timerStart = now;
+                poll(delayUs);
+                if (!r.timerActive && !r.done) start(delayUs);
+                val = !r.done;
+            }
+            break;
+        case BlockType::TIMER_PULSE:
+            poll(delayUs);
+            if (inA && !r.prevIn && !r.timerActive) start(delayUs);
+            r.prevIn = inA;
+            val = r.timerActive;
+            break;
+        case BlockType::TIMER_RETENTIVE:
+            if (inB) {
+                r.timerActive = false;
+                r.done = false;
+                r.accUs = 0;
+            } else {
+                uint64_t left = delayUs > r.accUs ? delayUs - r.accUs : 0;
+                poll(left);
+                if (r.done) {
+                    r.accUs = delayUs;
+                } else if (inA) {
+                    if (!r.timerActive) start(left);
+                } else if (r.timerActive) {
+                    r.accUs += now - r.timerStart;
+                    r.timerActive = false;
                 }
-                val = (now - r.timerStart) < b.delayMs;
             }
+            val = r.done;
+            break;
+        case BlockType::COUNTER_UP:
+            if (inB) r.count = 0;
+            else if (inA && !r.prevIn && r.count < INT32_MAX) r.count++;
+            r.prevIn = inA;
+            val = r.count >= t.preset[idx];
+            break;
+        case BlockType::COUNTER_DOWN:
+            if (inB) r.count = t.preset[idx];
+            else if (inA && !r.prevIn && r.count > INT32_MIN) r.count--;
+            r.prevIn = inA;
+            val = r.count <= 0;
             break;
         case BlockType::LATCH_SET:
             if (inA) {
                 r.latched = true;
-                ioManager.setOutput(b.ioIndex, true);
+                ioManager.setOutput(io, true);
             }
-            val = ioManager.getOutput(b.ioIndex);
+            val = ioManager.getOutput(io);
             break;
         case BlockType::LATCH_RESET:
             if (inA) {
                 r.latched = false;
-                ioManager.setOutput(b.ioIndex, false);
+                ioManager.setOutput(io, false);
             }
-            val = ioManager.getOutput(b.ioIndex);
+            val = ioManager.getOutput(io);
             break;
         case BlockType::COIL:
             val = inA;
-            ioManager.setOutput(b.ioIndex, val);
+            ioManager.setOutput(io, val);
             break;
     }
 
-    runtime[idx].value = val;
+    values[idx] = val;
     return val;
 }
 
+namespace {
+
+inline void setBit(uint32_t* words, uint16_t pos) {
+    words[pos >> 5] |= 1u << (pos & 31);
+}
+
+inline void orWords(uint32_t* dst, const uint32_t* src, uint16_t words) {
+    for (uint16_t w = 0; w < words; w++) dst[w] |= src[w];
+}
+
+} // namespace
+
+// Agenda o vencimento na roda; duração zero conclui na hora.
+void LadderEngine::startTimer(uint16_t id, uint64_t now, uint64_t durationUs) {
+    BlockRuntime& r = runtime[id];
+    r.timerStart = now;
+    if (durationUs == 0) {
+        r.timerActive = false;
+        r.done = true;
+        return;
+    }
+    r.timerActive = true;
+    r.done = false;
+    wheel.schedule(id, now + durationUs);
+}
+
+void LadderEngine::stopTimer(uint16_t id) {
+    runtime[id].timerActive = false;
+    wheel.cancel(id);
+}
+
+// Reagenda na roda (zerada pela compilação) os temporizadores em curso,
+// com o delay atual: um prazo já ultrapassado vence na próxima varredura.
+void LadderEngine::rearmTimers() {
+    for (uint16_t i = 0; i < table.count; i++) {
+        const BlockRuntime& r = runtime[i];
+        if (!r.timerActive) continue;
+        uint64_t delay = table.delayUs[i];
+        if (table.type[i] == BlockType::TIMER_RETENTIVE) delay = delay > r.accUs ? delay - r.accUs : 0;
+        wheel.schedule(i, r.timerStart + delay);
+    }
+}
+
+// Conclui os temporizadores vencidos; no modo delta marca o bloco para
+// reavaliação nesta varredura.
+void LadderEngine::fireExpired(uint32_t* marks) {
+    uint16_t id;
+    while ((id = wheel.popExpired()) != TimerWheel::NONE) {
+        BlockRuntime& r = runtime[id];
+        r.timerActive = false;
+        r.done = true;
+        if (table.type[id] == BlockType::TIMER_RETENTIVE) r.accUs = table.delayUs[id];
+        if (marks) setBit(marks, delta.posOf[id]);
+    }
+}
+
+inline void LadderEngine::execInstr(const Instr& in, uint64_t now) {
+    uint8_t* v = values;
+    switch (in.op) {
+        case OpCode::LD_IN:    v[in.dst] = ioManager.inputAt(in.io); break;
+        case OpCode::LD_NIN:   v[in.dst] = !ioManager.inputAt(in.io); break;
+        case OpCode::LD_TRUE:  v[in.dst] = 1; break;
+        case OpCode::LD_FALSE: v[in.dst] = 0; break;
+        case OpCode::AND:      v[in.dst] = v[in.a] & v[in.b]; break;
+        case OpCode::OR:       v[in.dst] = v[in.a] | v[in.b]; break;
+        case OpCode::ANDN: {
+            const uint16_t* arg = program.args + in.a;
+            uint8_t acc = 1;
+            for (uint16_t k = 0; k < in.b; k++) acc &= v[arg[k]];
+            v[in.dst] = acc;
+            break;
+        }
+        case OpCode::ORN: {
+            const uint16_t* arg = program.args + in.a;
+            uint8_t acc = 0;
+            for (uint16_t k = 0; k < in.b; k++) acc |= v[arg[k]];
+            v[in.dst] = acc;
+            break;
+        }
+        case OpCode::NOT:      v[in.dst] = !v[in.a]; break;
+        case OpCode::MOV:      v[in.dst] = v[in.a]; break;
+        case OpCode::OUT:
+            v[in.dst] = v[in.a];
+            ioManager.writeOutputAt(in.io, v[in.a]);
+            break;
+        case OpCode::SET:
+            if (v[in.a]) {
+                runtime[in.dst].latched = true;
+                ioManager.writeOutputAt(in.io, true);
+            }
+            v[in.dst] = ioManager.outputAt(in.io);
+            break;
+        case OpCode::RST:
+            if (v[in.a]) {
+                runtime[in.dst].latched = false;
+                ioManager.writeOutputAt(in.io, false);
+            }
+            v[in.dst] = ioManager.outputAt(in.io);
+            break;
+        // Temporizadores: o vencimento vem da roda (fireExpired); aqui só
+        // se agenda ou cancela nas transições da entrada.
+        case OpCode::TON: {
+            BlockRuntime& r = runtime[in.dst];
+            if (v[in.a]) {
+                if (!r.timerActive && !r.done) startTimer(in.dst, now, table.delayUs[in.dst]);
+                v[in.dst] = r.done;
+            } else {
+                if (r.timerActive) stopTimer(in.dst);
+                r.done = false;
+                v[in.dst] = 0;
+            }
+            break;
+        }
+        case OpCode::TOF: {
+            BlockRuntime& r = runtime[in.dst];
+            if (v[in.a]) {
+                if (r.timerActive) stopTimer(in.dst);
+                r.done = false;
+                v[in.dst] = 1;
+            } else {
+                if (!r.timerActive && !r.done) startTimer(in.dst, now, table.delayUs[in.dst]);
+                v[in.dst] = !r.done;
+            }
+            break;
+        }
+        case OpCode::TP: {
+            BlockRuntime& r = runtime[in.dst];
+            bool a = v[in.a];
+            if (a && !r.prevIn && !r.timerActive) startTimer(in.dst, now, table.delayUs[in.dst]);
+            r.prevIn = a;
+            v[in.dst] = r.timerActive;
+            break;
+        }
+        case OpCode::TONR: {
+            BlockRuntime& r = runtime[in.dst];
+            if (v[in.b]) {
+                if (r.timerActive) stopTimer(in.dst);
+                r.done = false;
+                r.accUs = 0;
+            } else if (v[in.a]) {
+                if (!r.timerActive && !r.done) {
+                    uint64_t delay = table.delayUs[in.dst];
+                    startTimer(in.dst, now, delay > r.accUs ? delay - r.accUs : 0);
+                    if (r.done) r.accUs = delay;
+                }
+            } else if (r.timerActive) {
+                r.accUs += now - r.timerStart;
+                stopTimer(in.dst);
+            }
+            v[in.dst] = r.done;
+            break;
+        }
+        case OpCode::CTU: {
+            BlockRuntime& r = runtime[in.dst];
+            bool a = v[in.a];
+            if (v[in.b]) r.count = 0;
+            else if (a && !r.prevIn && r.count < INT32_MAX) r.count++;
+            r.prevIn = a;
+            v[in.dst] = r.count >= table.preset[in.dst];
+            break;
+        }
+        case OpCode::CTD: {
+            BlockRuntime& r = runtime[in.dst];
+            bool a = v[in.a];
+            if (v[in.b]) r.count = table.preset[in.dst];
+            else if (a && !r.prevIn && r.count > INT32_MIN) r.count--;
+            r.prevIn = a;
+            v[in.dst] = r.count <= 0;
+            break;
+        }
+    }
+}
+
+// PROFILE: instanciado à parte, para o laço sem perfil não ter teste algum.
+template <bool PROFILE>
+void LadderEngine::runCompiled(uint64_t now) {
+    fireExpired(nullptr);
+    if (PROFILE) profiler.endPhase(ScanPhase::TIMERS);
+    const Instr* ip = program.code;
+    const Instr* end = ip + program.length;
+    for (; ip != end; ++ip) {
+        if (PROFILE) {
+            uint32_t c0 = profileCycles();
+            execInstr(*ip, now);
+            profiler.addBlock(ip->dst, profileCycles() - c0);
+        } else {
+            execInstr(*ip, now);
+        }
+    }
+}
+
+template <bool PROFILE>
+void LadderEngine::runDelta(uint64_t now) {
+    const uint16_t words = blockWords(program.length);
+
+    if (deltaReset) {
+        // Primeira varredura após carga/troca de modo: avalia tudo.
+        memset(dirty, 0, words * sizeof(uint32_t));
+        for (uint16_t p = 0; p < program.length; p++) setBit(dirty, p);
+        fireExpired(nullptr);
+        deltaReset = false;
+    } else {
+        memcpy(dirty, pendingNext, words * sizeof(uint32_t));
+
+        uint32_t inCh = ioManager.getInputChanges();
+        for (uint8_t i = 0; i < INPUTS_COUNT; i++) {
+            if ((inCh >> i) & 1u) orWords(dirty, delta.usersOf(i), words);
+        }
+
+        // Acessos à imagem de saídas rodam sempre: o estado que cada um vê
+        // depende dos demais escritores da mesma saída e do servidor web.
+        orWords(dirty, delta.outputUsers, words);
+
+        fireExpired(dirty);
+    }
+    memset(pendingNext, 0, words * sizeof(uint32_t));
+    lastOutStart = ioManager.getOutputBits();
+    if (PROFILE) profiler.endPhase(ScanPhase::TIMERS);
+
+    uint16_t evaluated = 0;
+    uint16_t changed = 0;
+    for (uint16_t w = 0; w < words; w++) {
+        while (dirty[w]) {
+            uint16_t p = (w << 5) + __builtin_ctz(dirty[w]);
+            dirty[w] &= dirty[w] - 1;
+
+            const Instr& in = program.code[p];
+            uint8_t before = values[in.dst];
+            if (PROFILE) {
+                uint32_t c0 = profileCycles();
+                execInstr(in, now);
+                profiler.addBlock(in.dst, profileCycles() - c0);
+            } else {
+                execInstr(in, now);
+            }
+            evaluated++;
+
+            if (values[in.dst] != before) {
+                changed++;
+                for (uint32_t f = delta.fanStart[p]; f < delta.fanStart[p + 1]; f++) {
+                    uint16_t q = delta.fanList[f];
+                    // Consumidor anterior na ordem (realimentação): próxima varredura.
+                    if (q > p) setBit(dirty, q);
+                    else setBit(pendingNext, q);
+                }
+            }
+        }
+    }
+    // Estável: nenhuma mudança de valor e a imagem de saídas terminou como
+    // começou, então a próxima varredura repetiria exatamente esta.
+    settled = changed == 0 && ioManager.getOutputBits() == lastOutStart;
+    lastEvalCount = evaluated;
+}
+
+void LadderEngine::setEvalMode(EvalMode mode) {
+    evalMode = mode;
+    deltaReset = true;
+}
+
+bool LadderEngine::setProfiling(bool on) {
+    if (!on) {
+        profiler.disable();
+        return true;
+    }
+    return profiler.enable(table.capacity);
+}
+
 void LadderEngine::tick() {
-    uint32_t now = millis();
+    if (profiler.isEnabled()) scan<true>();
+    else scan<false>();
+}
+
+template <bool PROFILE>
+void LadderEngine::scan() {
+    uint32_t t0 = micros();
+    if (PROFILE) profiler.beginScan();
+    uint64_t now = esp_timer_get_time();
     ioManager.scanInputs();
+    if (PROFILE) profiler.endPhase(ScanPhase::INPUTS);
+    wheel.advance(now);
+    if (evalMode == EvalMode::DELTA) {
+        runDelta<PROFILE>(now);
+    } else {
+        runCompiled<PROFILE>(now);
+        lastEvalCount = program.length;
+    }
+    if (PROFILE) profiler.endPhase(ScanPhase::PROGRAM);
+    ioManager.updateOutputs();
+    if (PROFILE) {
+        profiler.endPhase(ScanPhase::OUTPUTS);
+        profiler.endScan(lastEvalCount);
+    }
+
+    lastScanUs = micros() - t0;
+    if (lastScanUs > maxScanUs) maxScanUs = lastScanUs;
+}
 
-    for (uint8_t i = 0; i < blockCount; i++) {
-        computeBlock(i, now);
+void LadderEngine::tickInterpreted() {
+    uint32_t t0 = micros();
+    bool profile = profiler.isEnabled();
+    if (profile) profiler.beginScan();
+    uint64_t now = esp_timer_get_time();
+    ioManager.scanInputs();
+    if (profile) {
+        profiler.endPhase(ScanPhase::INPUTS);
+        profiler.endPhase(ScanPhase::TIMERS);
     }
 
+    for (uint16_t i = 0; i < table.count; i++) {
+        if (profile) {
+            uint32_t c0 = profileCycles();
+            computeBlock(i, now);
+            profiler.addBlock(i, profileCycles() - c0);
+        } else {
+            computeBlock(i, now);
+        }
+    }
+
+    if (profile) profiler.endPhase(ScanPhase::PROGRAM);
     ioManager.updateOutputs();
+    if (profile) {
+        profiler.endPhase(ScanPhase::OUTPUTS);
+        profiler.endScan(table.count);
+    }
+
+    lastScanUs = micros() - t0;
+    if (lastScanUs > maxScanUs) maxScanUs = lastScanUs;
 }
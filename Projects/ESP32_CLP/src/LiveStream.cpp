@@ -0,0 +1,289 @@
+#include "LiveStream.h"
+#include "LadderEngine.h"
+#include "ScanTask.h"
+#include <errno.h>
+#include <lwip/sockets.h>
+
+LiveStream liveStream;
+
+namespace {
+
+// Sem clientes a tarefa só confere novas conexões neste intervalo.
+constexpr uint32_t ACCEPT_POLL_MS = 50;
+// Requisição chegando ou quadro pela metade: volta logo para continuar.
+constexpr uint32_t BUSY_POLL_MS = 5;
+// Comentário SSE periódico: mantém proxies abertos e detecta quem caiu.
+constexpr uint32_t KEEPALIVE_MS = 15000;
+constexpr uint32_t REQUEST_TIMEOUT_MS = 300;
+
+const char SSE_HEADERS[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: text/event-stream\r\n"
+    "Cache-Control: no-cache\r\n"
+    "Connection: keep-alive\r\n"
+    "Access-Control-Allow-Origin: *\r\n"
+    "\r\n"
+    "retry: 1000\n\n";
+
+// Só vai a um socket recém-aceito, com o buffer de envio vazio.
+void reject(WiFiClient& sock, const char* status) {
+    sock.printf("HTTP/1.1 %s\r\nConnection: close\r\nAccess-Control-Allow-Origin: *\r\n\r\n", status);
+    sock.stop();
+}
+
+// send() com MSG_DONTWAIT direto no socket lwIP (WiFiClient::write espera
+// o buffer esvaziar). Bytes aceitos, 0 com o buffer cheio, -1 se caiu.
+int sendNow(WiFiClient& sock, const char* data, size_t len) {
+    int fd = sock.fd();
+    if (fd < 0) return -1;
+    int n = send(fd, data, len, MSG_DONTWAIT);
+    if (n >= 0) return n;
+    return errno == EWOULDBLOCK || errno == EAGAIN ? 0 : -1;
+}
+
+} // namespace
+
+LiveStream::LiveStream()
+    : server(LIVE_STREAM_PORT), handle(nullptr), valueWords(nullptr), wordCount(0), snapInputs(0),
+      snapOutputs(0), clientCount(0), framesSent(0), slowDrops(0) {
+    for (Client& c : clients) c.state = SlotState::FREE;
+}
+
+void LiveStream::begin() {
+    wordCount = blockWords(ladderEngine.getCapacity());
+    valueWords = static_cast<uint32_t*>(calloc(wordCount, sizeof(uint32_t)));
+    server.begin();
+    server.setNoDelay(true);
+    xTaskCreatePinnedToCore(taskEntry, "live_stream", 4096, this, 1, &handle, WEB_CORE);
+    Serial.printf("[LIVE] SSE em :%d/events (até %d clientes, %d Hz)\n", LIVE_STREAM_PORT, LIVE_MAX_CLIENTS,
+                  LIVE_MAX_HZ);
+}
+
+void LiveStream::notifyChange() {
+    if (handle && clientCount) xTaskNotifyGive(handle);
+}
+
+void LiveStream::taskEntry(void* arg) {
+    static_cast<LiveStream*>(arg)->run();
+}
+
+void LiveStream::run() {
+    for (;;) {
+        accept();
+
+        uint32_t now = millis();
+        uint32_t waitMs = ACCEPT_POLL_MS;
+        for (uint8_t i = 0; i < LIVE_MAX_CLIENTS; i++) {
+            if (clients[i].state != SlotState::READING) continue;
+            pollRequest(i, now);
+            if (clients[i].state == SlotState::READING) waitMs = BUSY_POLL_MS;
+        }
+
+        if (clientCount) {
+            ScanSnapshot snap;
+            scanTask.readSnapshot(snap, valueWords, wordCount);
+            snapInputs = snap.inputBits;
+            snapOutputs = snap.outputBits;
+
+            now = millis();
+            for (uint8_t i = 0; i < LIVE_MAX_CLIENTS; i++) {
+                if (clients[i].state != SlotState::STREAMING) continue;
+                uint32_t due = service(clients[i], now);
+                if (!clients[i].sock.connected()) {
+                    drop(i);
+                    continue;
+                }
+                // Nada pendente: confere de novo no período do cliente
+                // (valores observados não acordam a tarefa).
+                uint32_t next = due ? due : clients[i].intervalMs;
+                if (next < waitMs) waitMs = next;
+            }
+        }
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(waitMs ? waitMs : 1));
+    }
+}
+
+void LiveStream::accept() {
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+    WiFiClient sock = server.accept();
+#else
+    WiFiClient sock = server.available();
+#endif
+    if (!sock) return;
+
+    uint8_t slot = 0;
+    while (slot < LIVE_MAX_CLIENTS && clients[slot].state != SlotState::FREE) slot++;
+    if (slot == LIVE_MAX_CLIENTS) {
+        reject(sock, "503 Service Unavailable");
+        return;
+    }
+    Client& c = clients[slot];
+    c.sock = sock;
+    c.bufLen = 0;
+    c.headerLen = 0;
+    c.haveRequestLine = false;
+    c.acceptMs = millis();
+    c.state = SlotState::READING;
+}
+
+// GET /events[?hz=N][&watch=id,id,...]; os cabeçalhos são descartados.
+void LiveStream::pollRequest(uint8_t slot, uint32_t now) {
+    Client& c = clients[slot];
+    bool complete = false;
+    while (!complete && c.sock.available() > 0) {
+        int ch = c.sock.read();
+        if (ch < 0) break;
+        if (ch == '\r') continue;
+        if (ch != '\n') {
+            // Excesso da linha da requisição é descartado.
+            if (!c.haveRequestLine && c.bufLen + 1 < sizeof(c.buf)) c.buf[c.bufLen++] = (char)ch;
+            c.headerLen++;
+            continue;
+        }
+        if (!c.haveRequestLine) {
+            c.buf[c.bufLen] = '\0';
+            c.haveRequestLine = true;
+        } else if (c.headerLen == 0) {
+            complete = true;
+        }
+        c.headerLen = 0;
+    }
+
+    if (!complete) {
+        if (!c.sock.connected()) {
+            release(slot);
+        } else if (now - c.acceptMs >= REQUEST_TIMEOUT_MS) {
+            reject(c.sock, "408 Request Timeout");
+            release(slot);
+        }
+        return;
+    }
+    if (!parseRequestLine(c.buf, c)) {
+        reject(c.sock, "404 Not Found");
+        release(slot);
+        return;
+    }
+
+    c.sock.setNoDelay(true);
+    memcpy(c.buf, SSE_HEADERS, sizeof(SSE_HEADERS) - 1);
+    c.bufLen = sizeof(SSE_HEADERS) - 1;
+    c.stalledSinceMs = 0;
+    c.lastSendMs = now;
+    c.sentOnce = false;
+    c.state = SlotState::STREAMING;
+    clientCount++;
+    flushPending(c, now);
+    Serial.printf("[LIVE] Cliente %u conectado (%u ms, %u bloco(s))\n", slot, c.intervalMs, c.watchCount);
+}
+
+bool LiveStream::parseRequestLine(const char* line, Client& c) {
+    if (strncmp(line, "GET /events", 11) != 0) return false;
+
+    uint32_t hz = LIVE_MAX_HZ;
+    const char* p = strstr(line, "hz=");
+    if (p) hz = strtoul(p + 3, nullptr, 10);
+    if (hz < 1) hz = 1;
+    if (hz > LIVE_MAX_HZ) hz = LIVE_MAX_HZ;
+    c.intervalMs = 1000 / hz;
+
+    c.watchCount = 0;
+    p = strstr(line, "watch=");
+    if (p) {
+        p += 6;
+        while (c.watchCount < LIVE_MAX_WATCH && *p >= '0' && *p <= '9') {
+            char* end;
+            c.watch[c.watchCount++] = (uint16_t)strtoul(p, &end, 10);
+            p = *end == ',' ? end + 1 : end;
+        }
+    }
+    return true;
+}
+
+bool LiveStream::flushPending(Client& c, uint32_t now) {
+    if (!c.bufLen) return true;
+    int n = sendNow(c.sock, c.buf, c.bufLen);
+    if (n < 0) {
+        c.sock.stop();
+        return false;
+    }
+    if ((uint16_t)n < c.bufLen) {
+        memmove(c.buf, c.buf + n, c.bufLen - n);
+        c.bufLen -= n;
+        if (!c.stalledSinceMs) c.stalledSinceMs = now ? now : 1;
+        if (now - c.stalledSinceMs >= LIVE_SLOW_CLIENT_MS) {
+            slowDrops++;
+            c.sock.stop();
+        }
+        return false;
+    }
+    c.bufLen = 0;
+    c.stalledSinceMs = 0;
+    return true;
+}
+
+uint32_t LiveStream::service(Client& c, uint32_t now) {
+    // Socket cheio: o quadro anterior sai primeiro; as mudanças de agora
+    // entram juntas no próximo.
+    if (!flushPending(c, now)) return BUSY_POLL_MS;
+
+    uint32_t watchBits = 0;
+    for (uint8_t k = 0; k < c.watchCount; k++) {
+        uint16_t id = c.watch[k];
+        if ((id >> 5) < wordCount && ((valueWords[id >> 5] >> (id & 31)) & 1u)) watchBits |= 1u << k;
+    }
+    bool sendIn = !c.sentOnce || snapInputs != c.inputBits;
+    bool sendOut = !c.sentOnce || snapOutputs != c.outputBits;
+    bool sendWatch = c.watchCount && (!c.sentOnce || watchBits != c.watchBits);
+    uint32_t elapsed = now - c.lastSendMs;
+
+    if (!sendIn && !sendOut && !sendWatch) {
+        if (elapsed >= KEEPALIVE_MS) {
+            memcpy(c.buf, ":\n\n", 3);
+            c.bufLen = 3;
+            c.lastSendMs = now;
+            flushPending(c, now);
+        }
+        return 0;
+    }
+    // Agrega: o que mudar até lá sai junto no próximo quadro.
+    if (c.sentOnce && elapsed < c.intervalMs) return c.intervalMs - elapsed;
+
+    char* frame = c.buf;
+    const size_t size = sizeof(c.buf);
+    int n = snprintf(frame, size, "data:{");
+    const char* sep = "";
+    if (sendIn) {
+        n += snprintf(frame + n, size - n, "\"i\":%lu", (unsigned long)snapInputs);
+        sep = ",";
+    }
+    if (sendOut) {
+        n += snprintf(frame + n, size - n, "%s\"o\":%lu", sep, (unsigned long)snapOutputs);
+        sep = ",";
+    }
+    if (sendWatch) {
+        n += snprintf(frame + n, size - n, "%s\"w\":%lu", sep, (unsigned long)watchBits);
+    }
+    n += snprintf(frame + n, size - n, "}\n\n");
+    c.bufLen = n;
+
+    c.inputBits = snapInputs;
+    c.outputBits = snapOutputs;
+    c.watchBits = watchBits;
+    c.lastSendMs = now;
+    c.sentOnce = true;
+    framesSent++;
+    return flushPending(c, now) ? 0 : BUSY_POLL_MS;
+}
+
+void LiveStream::drop(uint8_t slot) {
+    release(slot);
+    clientCount--;
+    Serial.printf("[LIVE] Cliente %u desconectado\n", slot);
+}
+
+void LiveStream::release(uint8_t slot) {
+    clients[slot].sock.stop();
+    clients[slot].sock = WiFiClient();
+    clients[slot].bufLen = 0;
+    clients[slot].state = SlotState::FREE;
+}
@@ -0,0 +1,62 @@
+#include "ProgramImage.h"
+
+namespace {
+
+// Tabela de 16 entradas (um nibble por vez): 64 bytes de flash em vez de 1 KB.
+const uint32_t CRC_NIBBLE[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+    0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+    0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+
+uint32_t imageCrc(const ProgramImageHeader& h, const BlockTable& t) {
+    uint32_t crc = crc32Update(0, &h, offsetof(ProgramImageHeader, crc));
+    ProgramImageSection sec[PROGRAM_IMAGE_SECTIONS];
+    programImageSections(t, h, sec);
+    for (uint8_t i = 0; i < PROGRAM_IMAGE_SECTIONS; i++) crc = crc32Update(crc, sec[i].data, sec[i].bytes);
+    return crc;
+}
+
+} // namespace
+
+uint32_t crc32Update(uint32_t crc, const void* data, size_t len) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    crc = ~crc;
+    while (len--) {
+        crc ^= *p++;
+        crc = (crc >> 4) ^ CRC_NIBBLE[crc & 0x0F];
+        crc = (crc >> 4) ^ CRC_NIBBLE[crc & 0x0F];
+    }
+    return ~crc;
+}
+
+void programImageSections(const BlockTable& t, const ProgramImageHeader& h,
+                          ProgramImageSection out[PROGRAM_IMAGE_SECTIONS]) {
+    size_t n = h.blockCount;
+    out[0] = { t.type, n * sizeof(BlockType) };
+    out[1] = { t.ioIndex, n * sizeof(uint8_t) };
+    out[2] = { t.opStart, (n + 1) * sizeof(uint32_t) };
+    out[3] = { t.operands, h.operandCount * sizeof(BlockRef) };
+    out[4] = { t.preset, n * sizeof(int32_t) };
+    out[5] = { t.delayUs, n * sizeof(uint64_t) };
+}
+
+void programImageSeal(ProgramImageHeader& h, const BlockTable& t) {
+    h.crc = imageCrc(h, t);
+}
+
+bool programImageHeaderValid(const ProgramImageHeader& h, const BlockTable& t) {
+    if (h.magic != PROGRAM_IMAGE_MAGIC || h.version != PROGRAM_IMAGE_VERSION) return false;
+    if (h.headerSize != sizeof(ProgramImageHeader)) return false;
+    return h.blockCount <= t.capacity && h.operandCount <= t.operandCapacity;
+}
+
+bool programImageCheck(const ProgramImageHeader& h, const BlockTable& t) {
+    if (!programImageHeaderValid(h, t)) return false;
+    if (t.opStart[0] != 0 || t.opStart[h.blockCount] != h.operandCount) return false;
+    for (uint16_t i = 0; i < h.blockCount; i++) {
+        if (t.opStart[i] > t.opStart[i + 1]) return false;
+    }
+    return h.crc == imageCrc(h, t);
+}
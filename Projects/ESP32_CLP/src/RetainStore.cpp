@@ -0,0 +1,427 @@
+#include "RetainStore.h"
+#include "ProgramImage.h"
+#include <LittleFS.h>
+
+#ifdef ARDUINO
+#include <esp_attr.h>
+#include <esp_system.h>
+#include "ScanTask.h"
+#endif
+
+RetainStore retainStore;
+
+namespace {
+
+constexpr const char* BASE_PATH = "/retain.bin";
+constexpr const char* BASE_TMP_PATH = "/retain.bin.tmp";
+constexpr const char* LOG_PATH = "/retain.log";
+
+constexpr uint32_t RTC_MAGIC = 0x4E544552;  // "RETN"
+constexpr uint32_t BASE_MAGIC = 0x31544552; // "RET1"
+constexpr uint16_t BATCH_MAGIC = 0x4252;    // "RB"
+
+// Cópia na RTC. A soma é atualizada palavra a palavra junto com os dados
+// (um CRC completo a cada varredura custaria O(palavras)); com magic e
+// assinatura basta para rejeitar o lixo do power-on.
+struct RetainRtc {
+    uint32_t magic;
+    uint16_t words;
+    uint16_t reserved;
+    uint32_t signature;
+    uint32_t sum;
+    uint32_t data[RETAIN_MAX_WORDS];
+};
+
+struct BaseHeader {
+    uint32_t magic;
+    uint16_t words;
+    uint16_t reserved;
+    uint32_t signature;
+    uint32_t seq;
+    uint32_t crc;   // Cabeçalho até aqui e dados
+};
+
+// Lote do diário: só as palavras que mudaram desde o lote anterior.
+struct BatchHeader {
+    uint16_t magic;
+    uint16_t count;
+    uint32_t seq;
+    uint32_t crc;   // magic, count, seq e entradas
+};
+
+struct BatchEntry {
+    uint16_t index;
+    uint16_t reserved;
+    uint32_t value;
+};
+
+#ifdef ARDUINO
+RTC_NOINIT_ATTR RetainRtc rtc;
+TaskHandle_t flushTask = nullptr;
+SemaphoreHandle_t liveMutex = nullptr;
+#else
+RetainRtc rtc; // Host: zerada, inválida até a primeira gravação
+#endif
+
+uint32_t rtcSum() {
+    uint32_t sum = rtc.magic + rtc.words + rtc.signature;
+    for (uint16_t i = 0; i < rtc.words; i++) sum += rtc.data[i];
+    return ~sum;
+}
+
+const char* sourceName(RetainSource s) {
+    return s == RetainSource::RTC ? "RTC" : s == RetainSource::FLASH ? "flash" : "nenhum (frio)";
+}
+
+} // namespace
+
+RetainStore::RetainStore()
+    : words(0), signature(0), enabled(false), flashedValid(false), pending(false), pendingSinceMs(0),
+      scansSinceFlush(0), seq(0), source(RetainSource::COLD), rtcCommits(0), flashBatches(0), journalBytes(0) {}
+
+bool RetainStore::tryLock() {
+#ifdef ARDUINO
+    return !liveMutex || xSemaphoreTake(liveMutex, 0) == pdTRUE;
+#else
+    return true;
+#endif
+}
+
+void RetainStore::lock() {
+#ifdef ARDUINO
+    if (liveMutex) xSemaphoreTake(liveMutex, portMAX_DELAY);
+#endif
+}
+
+void RetainStore::unlock() {
+#ifdef ARDUINO
+    if (liveMutex) xSemaphoreGive(liveMutex);
+#endif
+}
+
+RetainSource RetainStore::restore(LadderEngine& engine) {
+    words = engine.getRetainWords();
+    signature = engine.getRetainSignature();
+    enabled = words <= RETAIN_MAX_WORDS;
+    source = RetainSource::COLD;
+    if (!enabled) {
+        Serial.printf("[RETAIN] %u palavras excedem RETAIN_MAX_WORDS (%u): sem memória retentiva\n", words,
+                      RETAIN_MAX_WORDS);
+        return source;
+    }
+
+    bool journalClean = true;
+    bool fromFlash = loadJournal(journalClean);
+    bool warm = rtcValid();
+#ifdef ARDUINO
+    // No power-on a RTC não foi preservada, mesmo que a soma feche por acaso.
+    warm = warm && esp_reset_reason() != ESP_RST_POWERON;
+#endif
+    if (warm) {
+        memcpy(live, rtc.data, words * sizeof(uint32_t));
+        source = RetainSource::RTC;
+    } else if (fromFlash) {
+        memcpy(live, flashed, words * sizeof(uint32_t));
+        source = RetainSource::FLASH;
+    }
+    // Lixo no fim do diário (lote cortado): um lote acrescentado depois dele
+    // seria descartado no próximo boot, então a próxima gravação é uma base.
+    flashedValid = fromFlash && journalClean;
+    if (source != RetainSource::COLD) engine.restoreRetain(live);
+
+    engine.captureRetain(live);
+    writeRtc();
+    pending = !flashedValid || memcmp(live, flashed, words * sizeof(uint32_t)) != 0;
+    pendingSinceMs = millis();
+    scansSinceFlush = 0;
+    Serial.printf("[RETAIN] %u palavra(s) restaurada(s) de %s\n", words, sourceName(source));
+    return source;
+}
+
+void RetainStore::begin() {
+#ifdef ARDUINO
+    liveMutex = xSemaphoreCreateMutex();
+    xTaskCreatePinnedToCore(taskEntry, "retain_flush", 4096, this, 1, &flushTask, WEB_CORE);
+#endif
+}
+
+#ifdef ARDUINO
+void RetainStore::taskEntry(void* arg) {
+    RetainStore* self = static_cast<RetainStore*>(arg);
+    for (;;) {
+        // Acorda pelo número de varreduras (capture) ou pelo prazo.
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(RETAIN_FLASH_MS));
+        if (self->flushDue()) self->flush();
+    }
+}
+#else
+void RetainStore::taskEntry(void*) {}
+#endif
+
+// Programa trocado (carga ou patch): o estado em RAM já é o do programa
+// novo, então só recomeça a RTC e força uma base nova no diário.
+void RetainStore::relayout(const LadderEngine& engine) {
+    words = engine.getRetainWords();
+    signature = engine.getRetainSignature();
+    enabled = words <= RETAIN_MAX_WORDS;
+    flashedValid = false;
+    if (!enabled) {
+        rtc.magic = 0;
+        Serial.printf("[RETAIN] %u palavras excedem RETAIN_MAX_WORDS (%u): sem memória retentiva\n", words,
+                      RETAIN_MAX_WORDS);
+        return;
+    }
+    engine.captureRetain(live);
+    writeRtc();
+    pending = true;
+    pendingSinceMs = millis();
+    scansSinceFlush = 0;
+}
+
+void RetainStore::capture(const LadderEngine& engine) {
+    if (engine.getRetainSignature() != signature || engine.getRetainWords() != words) {
+        if (!tryLock()) return;
+        relayout(engine);
+        unlock();
+        return;
+    }
+    if (!enabled) return;
+    // Gravação em flash copiando 'live': tenta na próxima varredura.
+    if (!tryLock()) return;
+    engine.captureRetain(live);
+    bool changed = false;
+    uint32_t sum = ~rtc.sum;
+    for (uint16_t i = 0; i < words; i++) {
+        if (live[i] == rtc.data[i]) continue;
+        sum += live[i] - rtc.data[i];
+        rtc.data[i] = live[i];
+        changed = true;
+    }
+    if (changed) {
+        rtc.sum = ~sum;
+        rtcCommits++;
+        if (!pending) {
+            pending = true;
+            pendingSinceMs = millis();
+            scansSinceFlush = 0;
+        }
+    }
+    unlock();
+
+    if (pending && ++scansSinceFlush == RETAIN_FLASH_SCANS) {
+#ifdef ARDUINO
+        if (flushTask) xTaskNotifyGive(flushTask);
+#endif
+    }
+}
+
+bool RetainStore::flushDue() const {
+    return enabled && pending &&
+           (scansSinceFlush >= RETAIN_FLASH_SCANS || millis() - pendingSinceMs >= RETAIN_FLASH_MS);
+}
+
+void RetainStore::flush() {
+    // Layout e dados copiados sob o mesmo lock do relayout() (varredura);
+    // a gravação usa só a cópia.
+    lock();
+    if (!enabled || !pending) {
+        unlock();
+        return;
+    }
+    uint16_t n = words;
+    uint32_t sig = signature;
+    bool append = flashedValid;
+    memcpy(batch, live, n * sizeof(uint32_t));
+    pending = false;
+    scansSinceFlush = 0;
+    unlock();
+
+    bool ok;
+    if (!append) {
+        ok = writeBase(batch, n, sig);
+    } else {
+        uint32_t changed = 0;
+        for (uint16_t i = 0; i < n; i++) {
+            if (batch[i] != flashed[i]) changed++;
+        }
+        if (changed == 0) return;
+        size_t bytes = sizeof(BatchHeader) + changed * sizeof(BatchEntry);
+        ok = journalBytes + bytes > RETAIN_JOURNAL_MAX ? writeBase(batch, n, sig) : appendBatch(batch, n);
+    }
+
+    lock();
+    if (!ok) {
+        // Tenta de novo no próximo prazo, com uma base: um lote pela metade
+        // pode ter ficado no fim do diário.
+        flashedValid = false;
+        pending = true;
+        pendingSinceMs = millis();
+    } else {
+        memcpy(flashed, batch, n * sizeof(uint32_t));
+        // Programa trocado durante a gravação: relayout() já pediu uma base.
+        if (sig == signature && n == words) flashedValid = true;
+        flashBatches++;
+    }
+    unlock();
+}
+
+void RetainStore::invalidateRtc() {
+    rtc.magic = 0;
+}
+
+void RetainStore::writeRtc() {
+    rtc.magic = RTC_MAGIC;
+    rtc.words = words;
+    rtc.reserved = 0;
+    rtc.signature = signature;
+    memcpy(rtc.data, live, words * sizeof(uint32_t));
+    rtc.sum = rtcSum();
+    rtcCommits++;
+}
+
+bool RetainStore::rtcValid() const {
+    return rtc.magic == RTC_MAGIC && rtc.words == words && rtc.signature == signature && rtc.sum == rtcSum();
+}
+
+// Base e, em ordem, os lotes posteriores a ela até o primeiro inválido.
+// 'clean' fica false se sobrar algo depois do último lote bom.
+bool RetainStore::loadJournal(bool& clean) {
+    clean = true;
+    journalBytes = 0;
+    File f = LittleFS.exists(BASE_PATH) ? LittleFS.open(BASE_PATH, "r") : File();
+    if (!f) return false;
+    BaseHeader h;
+    bool ok = f.read(reinterpret_cast<uint8_t*>(&h), sizeof(h)) == sizeof(h) && h.magic == BASE_MAGIC &&
+              h.words == words && h.signature == signature;
+    ok = ok && f.read(reinterpret_cast<uint8_t*>(flashed), words * sizeof(uint32_t)) == words * sizeof(uint32_t);
+    f.close();
+    if (ok) {
+        uint32_t crc = crc32Update(0, &h, offsetof(BaseHeader, crc));
+        ok = crc32Update(crc, flashed, words * sizeof(uint32_t)) == h.crc;
+    }
+    if (!ok) return false;
+    seq = h.seq;
+
+    f = LittleFS.exists(LOG_PATH) ? LittleFS.open(LOG_PATH, "r") : File();
+    if (!f) return true;
+    uint32_t applied = 0;
+    for (;;) {
+        BatchHeader b;
+        if (f.read(reinterpret_cast<uint8_t*>(&b), sizeof(b)) != sizeof(b) || b.magic != BATCH_MAGIC) break;
+        if (b.count > words) break;
+        BatchEntry entries[32];
+        uint32_t crc = crc32Update(0, &b, offsetof(BatchHeader, crc));
+        // Confere o lote inteiro antes de aplicar: relê em blocos.
+        size_t start = f.position();
+        bool good = true;
+        for (uint16_t done = 0; good && done < b.count;) {
+            uint16_t k = b.count - done < 32 ? b.count - done : 32;
+            good = f.read(reinterpret_cast<uint8_t*>(entries), k * sizeof(BatchEntry)) == k * sizeof(BatchEntry);
+            if (good) crc = crc32Update(crc, entries, k * sizeof(BatchEntry));
+            done += k;
+        }
+        if (!good || crc != b.crc) break;
+        size_t end = f.position();
+        if (b.seq > seq) {
+            f.seek(start);
+            for (uint16_t done = 0; done < b.count;) {
+                uint16_t k = b.count - done < 32 ? b.count - done : 32;
+                f.read(reinterpret_cast<uint8_t*>(entries), k * sizeof(BatchEntry));
+                for (uint16_t e = 0; e < k; e++) {
+                    if (entries[e].index < words) flashed[entries[e].index] = entries[e].value;
+                }
+                done += k;
+            }
+            f.seek(end);
+            seq = b.seq;
+            applied++;
+        }
+        journalBytes = end;
+    }
+    clean = f.size() == journalBytes;
+    f.close();
+    Serial.printf("[RETAIN] Diário: base + %lu lote(s), %lu bytes%s\n", (unsigned long)applied,
+                  (unsigned long)journalBytes, clean ? "" : ", fim corrompido descartado");
+    return true;
+}
+
+// Base nova (temporário + rename) e diário vazio.
+bool RetainStore::writeBase(const uint32_t* data, uint16_t n, uint32_t sig) {
+    BaseHeader h;
+    memset(&h, 0, sizeof(h));
+    h.magic = BASE_MAGIC;
+    h.words = n;
+    h.signature = sig;
+    h.seq = ++seq;
+    h.crc = crc32Update(crc32Update(0, &h, offsetof(BaseHeader, crc)), data, n * sizeof(uint32_t));
+
+    File f = LittleFS.open(BASE_TMP_PATH, "w");
+    if (!f) return false;
+    bool ok = f.write(reinterpret_cast<const uint8_t*>(&h), sizeof(h)) == sizeof(h) &&
+              f.write(reinterpret_cast<const uint8_t*>(data), n * sizeof(uint32_t)) == n * sizeof(uint32_t);
+    f.close();
+    if (ok) {
+        if (LittleFS.exists(BASE_PATH)) LittleFS.remove(BASE_PATH);
+        ok = LittleFS.rename(BASE_TMP_PATH, BASE_PATH);
+    }
+    if (!ok) {
+        LittleFS.remove(BASE_TMP_PATH);
+        Serial.println("[RETAIN] Falha ao gravar base");
+        return false;
+    }
+    // Lotes antigos têm seq <= base: mesmo que a remoção falhe, são ignorados.
+    if (LittleFS.exists(LOG_PATH)) LittleFS.remove(LOG_PATH);
+    journalBytes = 0;
+    return true;
+}
+
+bool RetainStore::appendBatch(const uint32_t* data, uint16_t n) {
+    File f = LittleFS.open(LOG_PATH, "a");
+    if (!f) return false;
+    BatchHeader b;
+    b.magic = BATCH_MAGIC;
+    b.count = 0;
+    for (uint16_t i = 0; i < n; i++) {
+        if (data[i] != flashed[i]) b.count++;
+    }
+    b.seq = seq + 1;
+    uint32_t crc = crc32Update(0, &b, offsetof(BatchHeader, crc));
+    BatchEntry entries[32];
+    uint16_t k = 0;
+    for (uint16_t i = 0; i < n; i++) {
+        if (data[i] == flashed[i]) continue;
+        entries[k].index = i;
+        entries[k].reserved = 0;
+        entries[k].value = data[i];
+        if (++k == 32) {
+            crc = crc32Update(crc, entries, sizeof(entries));
+            k = 0;
+        }
+    }
+    crc = crc32Update(crc, entries, k * sizeof(BatchEntry));
+    b.crc = crc;
+
+    // Cabeçalho primeiro; um corte no meio deixa um lote com CRC errado,
+    // que a leitura descarta junto com o que vier depois.
+    bool ok = f.write(reinterpret_cast<const uint8_t*>(&b), sizeof(b)) == sizeof(b);
+    k = 0;
+    for (uint16_t i = 0; ok && i < n; i++) {
+        if (data[i] == flashed[i]) continue;
+        entries[k].index = i;
+        entries[k].reserved = 0;
+        entries[k].value = data[i];
+        if (++k == 32) {
+            ok = f.write(reinterpret_cast<const uint8_t*>(entries), sizeof(entries)) == sizeof(entries);
+            k = 0;
+        }
+    }
+    if (ok && k) ok = f.write(reinterpret_cast<const uint8_t*>(entries), k * sizeof(BatchEntry)) == k * sizeof(BatchEntry);
+    f.close();
+    if (!ok) {
+        Serial.println("[RETAIN] Falha ao gravar diário");
+        return false;
+    }
+    seq = b.seq;
+    journalBytes += sizeof(b) + b.count * sizeof(BatchEntry);
+    return true;
+}
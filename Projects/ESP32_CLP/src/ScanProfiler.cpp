@@ -0,0 +1,271 @@
+#include "ScanProfiler.h"
+
+namespace {
+
+const char* const PHASE_NAMES[SCAN_PHASE_COUNT] = {"inputs", "timers", "program", "outputs"};
+const char* const PHASE_LABELS[SCAN_PHASE_COUNT] = {"entradas", "temporizadores", "programa", "saídas"};
+
+double percent(uint64_t part, uint64_t whole) {
+    return whole ? part * 100.0 / whole : 0.0;
+}
+
+} // namespace
+
+ScanProfiler::ScanProfiler()
+    : capacity(0), blockCycles(nullptr), blockCalls(nullptr), blockMax(nullptr), ringHead(0), scanTotal(0),
+      scanMax(0), overhead(0), scanStart(0), mark(0) {
+    memset(ring, 0, sizeof(ring));
+    memset(phaseTotal, 0, sizeof(phaseTotal));
+    memset(&cur, 0, sizeof(cur));
+}
+
+ScanProfiler::~ScanProfiler() {
+    disable();
+}
+
+bool ScanProfiler::enable(uint16_t blocks) {
+    if (isEnabled() && capacity == blocks) return true;
+    disable();
+    uint64_t* c = static_cast<uint64_t*>(calloc(blocks, sizeof(uint64_t)));
+    uint32_t* n = static_cast<uint32_t*>(calloc(blocks, sizeof(uint32_t)));
+    uint32_t* m = static_cast<uint32_t*>(calloc(blocks, sizeof(uint32_t)));
+    if (!c || !n || !m) {
+        free(c);
+        free(n);
+        free(m);
+        Serial.printf("[PROF] Sem memória para %u blocos\n", blocks);
+        return false;
+    }
+    capacity = blocks;
+    blockCalls = n;
+    blockMax = m;
+
+    // Custo fixo de duas leituras seguidas do CCOUNT.
+    uint32_t best = UINT32_MAX;
+    for (uint8_t i = 0; i < 16; i++) {
+        uint32_t c0 = profileCycles();
+        uint32_t c1 = profileCycles();
+        if (c1 - c0 < best) best = c1 - c0;
+    }
+    overhead = best;
+    blockCycles = c;
+    clear();
+    Serial.printf("[PROF] Perfil ligado: %u blocos, %u bytes, %lu ciclo(s) de leitura\n", blocks,
+                  (unsigned)(blocks * (sizeof(uint64_t) + 2 * sizeof(uint32_t))), (unsigned long)overhead);
+    return true;
+}
+
+void ScanProfiler::disable() {
+    if (!isEnabled()) return;
+    free(blockCycles);
+    free(blockCalls);
+    free(blockMax);
+    blockCycles = nullptr;
+    blockCalls = nullptr;
+    blockMax = nullptr;
+    capacity = 0;
+    Serial.println("[PROF] Perfil desligado");
+}
+
+void ScanProfiler::clear() {
+    if (!isEnabled()) return;
+    memset(blockCycles, 0, capacity * sizeof(uint64_t));
+    memset(blockCalls, 0, capacity * sizeof(uint32_t));
+    memset(blockMax, 0, capacity * sizeof(uint32_t));
+    memset(ring, 0, sizeof(ring));
+    memset(phaseTotal, 0, sizeof(phaseTotal));
+    ringHead = 0;
+    scanTotal = 0;
+    scanMax = 0;
+}
+
+void ScanProfiler::endScan(uint16_t evals) {
+    cur.cycles = profileCycles() - scanStart;
+    cur.evals = evals;
+    ring[ringHead % PROFILE_RING_SCANS] = cur;
+    ringHead++;
+    for (uint8_t p = 0; p < SCAN_PHASE_COUNT; p++) phaseTotal[p] += cur.phase[p];
+    scanTotal += cur.cycles;
+    if (cur.cycles > scanMax) scanMax = cur.cycles;
+}
+
+ProfileReport::ProfileReport()
+    : count(0), reserved(0), cycles(nullptr), calls(nullptr), maxCycles(nullptr), recentCount(0), scans(0),
+      scanTotal(0), scanMax(0), overhead(0), mhz(getCpuFrequencyMhz()) {
+    memset(phaseTotal, 0, sizeof(phaseTotal));
+}
+
+ProfileReport::~ProfileReport() {
+    free(cycles);
+    free(calls);
+    free(maxCycles);
+}
+
+bool ProfileReport::reserve(uint16_t blocks) {
+    if (blocks <= reserved) return true;
+    free(cycles);
+    free(calls);
+    free(maxCycles);
+    cycles = static_cast<uint64_t*>(malloc(blocks * sizeof(uint64_t)));
+    calls = static_cast<uint32_t*>(malloc(blocks * sizeof(uint32_t)));
+    maxCycles = static_cast<uint32_t*>(malloc(blocks * sizeof(uint32_t)));
+    reserved = cycles && calls && maxCycles ? blocks : 0;
+    return reserved == blocks;
+}
+
+void ProfileReport::capture(const ScanProfiler& p, uint16_t blocks) {
+    count = p.isEnabled() && blocks <= reserved && blocks <= p.capacity ? blocks : 0;
+    if (count) {
+        memcpy(cycles, p.blockCycles, count * sizeof(uint64_t));
+        memcpy(calls, p.blockCalls, count * sizeof(uint32_t));
+        memcpy(maxCycles, p.blockMax, count * sizeof(uint32_t));
+    }
+    // Mais antiga primeiro.
+    scans = p.ringHead;
+    recentCount = scans < PROFILE_RING_SCANS ? scans : PROFILE_RING_SCANS;
+    for (uint16_t i = 0; i < recentCount; i++) {
+        recent[i] = p.ring[(scans - recentCount + i) % PROFILE_RING_SCANS];
+    }
+    memcpy(phaseTotal, p.phaseTotal, sizeof(phaseTotal));
+    scanTotal = p.scanTotal;
+    scanMax = p.scanMax;
+    overhead = p.overhead;
+}
+
+// Os 'top' blocos mais caros, em ordem decrescente (inserção: top é pequeno).
+uint8_t ProfileReport::selectTop(uint16_t* ids, uint8_t top) const {
+    if (top > PROFILE_TOP_MAX) top = PROFILE_TOP_MAX;
+    if (top == 0) return 0;
+    uint8_t n = 0;
+    for (uint16_t i = 0; i < count; i++) {
+        if (!calls[i]) continue;
+        if (n == top && cycles[i] <= cycles[ids[n - 1]]) continue;
+        uint8_t k = n < top ? n++ : n - 1;
+        while (k > 0 && cycles[ids[k - 1]] < cycles[i]) {
+            ids[k] = ids[k - 1];
+            k--;
+        }
+        ids[k] = i;
+    }
+    return n;
+}
+
+void ProfileReport::sumTypes(const BlockTable& table, TypeCost* out) const {
+    memset(out, 0, BLOCK_TYPE_COUNT * sizeof(TypeCost));
+    for (uint16_t i = 0; i < count && i < table.count; i++) {
+        TypeCost& t = out[(uint8_t)table.type[i]];
+        t.cycles += cycles[i];
+        t.calls += calls[i];
+        t.blocks++;
+    }
+}
+
+uint64_t ProfileReport::blockSum() const {
+    uint64_t sum = 0;
+    for (uint16_t i = 0; i < count; i++) sum += cycles[i];
+    return sum;
+}
+
+void ProfileReport::writeJson(Print& out, const BlockTable& table, uint8_t top) const {
+    double usPerCycle = 1.0 / mhz;
+    uint32_t avg = scans ? (uint32_t)(scanTotal / scans) : 0;
+    out.printf("{\"enabled\":%s,\"scans\":%lu,\"mhz\":%lu,\"overhead_cycles\":%lu,", count ? "true" : "false",
+               (unsigned long)scans, (unsigned long)mhz, (unsigned long)overhead);
+    out.printf("\"scan_avg_us\":%.2f,\"scan_max_us\":%.2f,\"phases_us\":{", avg * usPerCycle, scanMax * usPerCycle);
+    for (uint8_t p = 0; p < SCAN_PHASE_COUNT; p++) {
+        out.printf("%s\"%s\":%.2f", p ? "," : "", PHASE_NAMES[p],
+                   scans ? (double)phaseTotal[p] / scans * usPerCycle : 0.0);
+    }
+
+    TypeCost types[BLOCK_TYPE_COUNT];
+    sumTypes(table, types);
+    uint8_t order[BLOCK_TYPE_COUNT];
+    uint8_t used = 0;
+    for (uint8_t t = 0; t < BLOCK_TYPE_COUNT; t++) {
+        if (!types[t].calls) continue;
+        uint8_t k = used++;
+        while (k > 0 && types[order[k - 1]].cycles < types[t].cycles) {
+            order[k] = order[k - 1];
+            k--;
+        }
+        order[k] = t;
+    }
+    out.print("},\"types\":[");
+    for (uint8_t k = 0; k < used; k++) {
+        const TypeCost& t = types[order[k]];
+        out.printf("%s{\"type\":\"%s\",\"blocks\":%u,\"calls\":%lu,\"cycles\":%llu,\"pct\":%.1f}", k ? "," : "",
+                   blockTypeToString((BlockType)order[k]), t.blocks, (unsigned long)t.calls,
+                   (unsigned long long)t.cycles, percent(t.cycles, scanTotal));
+    }
+
+    uint16_t ids[PROFILE_TOP_MAX];
+    uint8_t n = selectTop(ids, top);
+    out.print("],\"top\":[");
+    for (uint8_t k = 0; k < n; k++) {
+        uint16_t i = ids[k];
+        out.printf("%s{\"id\":%u,\"type\":\"%s\",\"calls\":%lu,\"avg_cycles\":%lu,\"max_cycles\":%lu,\"pct\":%.1f}",
+                   k ? "," : "", i, i < table.count ? blockTypeToString(table.type[i]) : "?",
+                   (unsigned long)calls[i], (unsigned long)(cycles[i] / calls[i]), (unsigned long)maxCycles[i],
+                   percent(cycles[i], scanTotal));
+    }
+
+    out.print("],\"recent\":[");
+    for (uint16_t k = 0; k < recentCount; k++) {
+        const ProfileScan& s = recent[k];
+        out.printf("%s{\"us\":%.2f,\"evals\":%u,\"hot\":%d,\"hot_cycles\":%lu}", k ? "," : "", s.cycles * usPerCycle,
+                   s.evals, s.hotBlock == UINT16_MAX ? -1 : (int)s.hotBlock, (unsigned long)s.hotCycles);
+    }
+    out.print("]}");
+}
+
+void ProfileReport::writeFolded(Print& out, const BlockTable& table) const {
+    for (uint8_t p = 0; p < SCAN_PHASE_COUNT; p++) {
+        if ((ScanPhase)p == ScanPhase::PROGRAM) continue;
+        if (phaseTotal[p]) out.printf("scan;%s %llu\n", PHASE_NAMES[p], (unsigned long long)phaseTotal[p]);
+    }
+    // Tempo do programa fora dos blocos: laço, marcação do delta, leituras.
+    uint64_t inBlocks = blockSum();
+    uint64_t program = phaseTotal[(uint8_t)ScanPhase::PROGRAM];
+    if (program > inBlocks) out.printf("scan;program %llu\n", (unsigned long long)(program - inBlocks));
+    for (uint16_t i = 0; i < count && i < table.count; i++) {
+        if (!cycles[i]) continue;
+        out.printf("scan;program;%s;b%u %llu\n", blockTypeToString(table.type[i]), i, (unsigned long long)cycles[i]);
+    }
+}
+
+void ProfileReport::printSummary(Print& out, const BlockTable& table, uint8_t top) const {
+    if (!scans) {
+        out.println("[PROF] Nenhuma varredura medida");
+        return;
+    }
+    double usPerCycle = 1.0 / mhz;
+    out.printf("[PROF] %lu varredura(s): média %.2f us, pior %.2f us (%lu MHz, %lu ciclo(s) descontado(s) por amostra)\n",
+               (unsigned long)scans, (double)scanTotal / scans * usPerCycle, scanMax * usPerCycle,
+               (unsigned long)mhz, (unsigned long)overhead);
+    out.print("[PROF] Etapas:");
+    for (uint8_t p = 0; p < SCAN_PHASE_COUNT; p++) {
+        out.printf(" %s %.2f us (%.1f%%)", PHASE_LABELS[p], (double)phaseTotal[p] / scans * usPerCycle,
+                   percent(phaseTotal[p], scanTotal));
+    }
+    out.println();
+
+    TypeCost types[BLOCK_TYPE_COUNT];
+    sumTypes(table, types);
+    out.print("[PROF] Por tipo:");
+    for (uint8_t t = 0; t < BLOCK_TYPE_COUNT; t++) {
+        if (!types[t].calls) continue;
+        out.printf(" %s %.1f%% (%u)", blockTypeToString((BlockType)t), percent(types[t].cycles, scanTotal),
+                   types[t].blocks);
+    }
+    out.println();
+
+    uint16_t ids[PROFILE_TOP_MAX];
+    uint8_t n = selectTop(ids, top);
+    for (uint8_t k = 0; k < n; k++) {
+        uint16_t i = ids[k];
+        out.printf("[PROF] #%u bloco %u %s: média %lu ciclos, pior %lu, %lu avaliação(ões), %.1f%% da varredura\n",
+                   k + 1, i, i < table.count ? blockTypeToString(table.type[i]) : "?",
+                   (unsigned long)(cycles[i] / calls[i]), (unsigned long)maxCycles[i], (unsigned long)calls[i],
+                   percent(cycles[i], scanTotal));
+    }
+}
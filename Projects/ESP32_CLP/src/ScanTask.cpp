@@ -0,0 +1,264 @@
+#include "ScanTask.h"
+#include "IOManager.h"
+#include "LadderEngine.h"
+#include "LiveStream.h"
+#include "RetainStore.h"
+
+ScanTask scanTask;
+
+ScanTask::ScanTask()
+    : handle(nullptr), timer(nullptr), deadlineTimer(nullptr), mutex(nullptr), published(0),
+      statScans(0), statMinUs(UINT32_MAX), statAvgUs(0), statMaxUs(0),
+      statMaxJitterUs(0), statOverruns(0), statSleeps(0), statDeadlineScans(0),
+      statSumUs(0), missedPeriods(0), firstScanUs(0), resetRequested(false), sleeping(false) {
+    memset(buffers, 0, sizeof(buffers));
+    valueBuffers[0] = nullptr;
+    valueBuffers[1] = nullptr;
+    valueWords = 0;
+    seq[0] = 0;
+    seq[1] = 0;
+}
+
+void ScanTask::begin() {
+    mutex = xSemaphoreCreateMutex();
+    valueWords = blockWords(ladderEngine.getCapacity());
+    for (uint8_t i = 0; i < 2; i++) {
+        valueBuffers[i] = static_cast<uint32_t*>(calloc(valueWords, sizeof(uint32_t)));
+    }
+    xTaskCreatePinnedToCore(taskEntry, "ladder_scan", 4096, this, SCAN_TASK_PRIORITY, &handle, SCAN_CORE);
+
+    esp_timer_create_args_t args = {};
+    args.callback = &ScanTask::onDeadline;
+    args.name = "ladder_deadline";
+    esp_timer_create(&args, &deadlineTimer);
+
+    uint32_t periodUs = ladderEngine.getCycleMs() * 1000UL;
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+    timer = timerBegin(1000000);
+    timerAttachInterrupt(timer, &ScanTask::onTimer);
+    timerAlarm(timer, periodUs, true, 0);
+#else
+    timer = timerBegin(0, 80, true); // 80 MHz / 80 = 1 µs por tick
+    timerAttachInterrupt(timer, &ScanTask::onTimer, true);
+    timerAlarmWrite(timer, periodUs, true);
+    timerAlarmEnable(timer);
+#endif
+    for (uint8_t i = 0; i < INPUTS_COUNT; i++) {
+        attachInterrupt(digitalPinToInterrupt(INPUT_PINS[i]), &ScanTask::onInputEdge, CHANGE);
+    }
+    Serial.printf("[SCAN] Tarefa no núcleo %d, ciclo %u ms\n", (int)SCAN_CORE, ladderEngine.getCycleMs());
+}
+
+void ScanTask::setCycleMs(uint16_t periodMs) {
+    lock();
+    ladderEngine.setCycleMs(periodMs);
+    unlock();
+    if (!timer) return;
+    uint32_t periodUs = ladderEngine.getCycleMs() * 1000UL;
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+    timerAlarm(timer, periodUs, true, 0);
+#else
+    timerAlarmWrite(timer, periodUs, true);
+#endif
+    resetStats();
+}
+
+void IRAM_ATTR ScanTask::onTimer() {
+    BaseType_t woken = pdFALSE;
+    uint32_t previous = 0;
+    xTaskNotifyAndQueryFromISR(scanTask.handle, NOTIFY_PERIOD, eSetBits, &previous, &woken);
+    // Bit ainda pendente: a varredura anterior não consumiu o disparo.
+    if (previous & NOTIFY_PERIOD) scanTask.missedPeriods++;
+    if (woken) portYIELD_FROM_ISR();
+}
+
+void IRAM_ATTR ScanTask::onInputEdge() {
+    // Em modo periódico as bordas são vistas pela próxima varredura.
+    if (!scanTask.sleeping.load(std::memory_order_relaxed)) return;
+    BaseType_t woken = pdFALSE;
+    xTaskNotifyFromISR(scanTask.handle, NOTIFY_WAKE, eSetBits, &woken);
+    if (woken) portYIELD_FROM_ISR();
+}
+
+// Roda na tarefa do esp_timer, não em ISR.
+void ScanTask::onDeadline(void* arg) {
+    xTaskNotify(scanTask.handle, NOTIFY_DEADLINE, eSetBits);
+}
+
+// Dispara uma varredura extra no prazo dado (µs de esp_timer).
+void ScanTask::armDeadline(uint64_t deadlineUs) {
+    esp_timer_stop(deadlineTimer);
+    if (deadlineUs == UINT64_MAX) return;
+    int64_t now = esp_timer_get_time();
+    uint64_t delayUs = (int64_t)deadlineUs > now ? deadlineUs - now : 0;
+    esp_timer_start_once(deadlineTimer, delayUs);
+}
+
+void ScanTask::taskEntry(void* arg) {
+    static_cast<ScanTask*>(arg)->run();
+}
+
+void ScanTask::run() {
+    uint32_t lastStart = 0;
+    bool haveLast = false;
+    uint32_t seenMissed = 0;
+
+    for (;;) {
+        uint32_t bits = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &bits, portMAX_DELAY);
+        if (sleeping.load()) {
+            leaveSleep();
+            haveLast = false; // Despertar não é um ciclo regular
+        }
+        // Varredura fora do ciclo (prazo de temporizador ou despertar):
+        // não entra na estatística de jitter.
+        bool periodic = (bits & NOTIFY_PERIOD) != 0;
+        if (!periodic && (bits & NOTIFY_DEADLINE)) statDeadlineScans++;
+
+        uint32_t start = micros();
+        uint32_t periodUs = ladderEngine.getCycleMs() * 1000UL;
+
+        if (resetRequested.exchange(false)) {
+            statScans = 0;
+            statMinUs = UINT32_MAX;
+            statAvgUs = 0;
+            statMaxUs = 0;
+            statMaxJitterUs = 0;
+            statOverruns = 0;
+            statSleeps = 0;
+            statDeadlineScans = 0;
+            statSumUs = 0;
+            seenMissed = missedPeriods;
+            haveLast = false;
+        }
+
+        xSemaphoreTake(mutex, portMAX_DELAY);
+        if (firstScanUs == 0) {
+            // Tempo desde o reset até a primeira varredura.
+            firstScanUs = esp_timer_get_time();
+            Serial.printf("[BOOT] Primeira varredura em %lu us\n", (unsigned long)firstScanUs);
+        }
+        ladderEngine.tick();
+        publish();
+        retainStore.capture(ladderEngine);
+        bool settled = ladderEngine.isSettled();
+        uint64_t deadline = ladderEngine.nextDeadlineUs();
+        xSemaphoreGive(mutex);
+
+        uint32_t scanUs = ladderEngine.getLastScanUs();
+        uint32_t missed = missedPeriods;
+        if (missed != seenMissed) {
+            // Disparos acumulados: a varredura anterior atrasou além de um ciclo.
+            statOverruns += missed - seenMissed;
+            seenMissed = missed;
+            haveLast = false;
+        }
+        if (periodic) {
+            if (haveLast) {
+                uint32_t delta = start - lastStart;
+                uint32_t jitter = delta > periodUs ? delta - periodUs : periodUs - delta;
+                if (jitter > statMaxJitterUs) statMaxJitterUs = jitter;
+            }
+            lastStart = start;
+            haveLast = true;
+        }
+        if (scanUs > periodUs) statOverruns++;
+
+        statScans++;
+        statSumUs += scanUs;
+        statAvgUs = statSumUs / statScans;
+        if (scanUs < statMinUs) statMinUs = scanUs;
+        if (scanUs > statMaxUs) statMaxUs = scanUs;
+
+        if (settled && enterSleep()) {
+            statSleeps++;
+            armDeadline(deadline);
+        } else if (deadline != UINT64_MAX && deadline < (uint64_t)esp_timer_get_time() + periodUs) {
+            // Prazo antes da próxima varredura periódica.
+            armDeadline(deadline);
+        }
+    }
+}
+
+bool ScanTask::enterSleep() {
+    timerStop(timer);
+    sleeping.store(true);
+    // Borda entre a última leitura e o ISR passar a notificar: não dorme.
+    if (ioManager.inputsDifferFromImage()) {
+        leaveSleep();
+        return false;
+    }
+    return true;
+}
+
+void ScanTask::leaveSleep() {
+    sleeping.store(false);
+    timerWrite(timer, 0);
+    timerStart(timer);
+}
+
+void ScanTask::publish() {
+    uint8_t w = published.load(std::memory_order_relaxed) ^ 1;
+    ScanSnapshot& s = buffers[w];
+
+    seq[w].fetch_add(1, std::memory_order_acq_rel);
+    s.scanCount = ioManager.getScanCount();
+    s.inputBits = ioManager.getInputBits();
+    s.outputBits = ioManager.getOutputBits();
+    if (valueBuffers[w]) ladderEngine.packValues(valueBuffers[w], valueWords);
+    seq[w].fetch_add(1, std::memory_order_release);
+
+    published.store(w, std::memory_order_release);
+
+    // Borda de I/O: o canal ao vivo envia sem esperar o próprio período.
+    const ScanSnapshot& prev = buffers[w ^ 1];
+    if (s.inputBits != prev.inputBits || s.outputBits != prev.outputBits) liveStream.notifyChange();
+}
+
+void ScanTask::readSnapshot(ScanSnapshot& out, uint32_t* valueBits, uint16_t wordCount) const {
+    if (wordCount > valueWords) wordCount = valueWords;
+    for (;;) {
+        uint8_t r = published.load(std::memory_order_acquire);
+        uint32_t s1 = seq[r].load(std::memory_order_acquire);
+        if (s1 & 1u) continue;
+        memcpy(&out, &buffers[r], sizeof(out));
+        if (valueBits && valueBuffers[r]) memcpy(valueBits, valueBuffers[r], wordCount * sizeof(uint32_t));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (seq[r].load(std::memory_order_relaxed) == s1) return;
+    }
+}
+
+ScanStats ScanTask::getStats() const {
+    ScanStats st;
+    st.scans = statScans;
+    st.minUs = statScans ? statMinUs : 0;
+    st.avgUs = statAvgUs;
+    st.maxUs = statMaxUs;
+    st.maxJitterUs = statMaxJitterUs;
+    st.overruns = statOverruns;
+    st.sleeps = statSleeps;
+    st.deadlineScans = statDeadlineScans;
+    return st;
+}
+
+void ScanTask::resetStats() {
+    resetRequested.store(true);
+}
+
+void ScanTask::lock() {
+    if (mutex) xSemaphoreTake(mutex, portMAX_DELAY);
+}
+
+void ScanTask::unlock() {
+    if (mutex) xSemaphoreGive(mutex);
+    // Alteração externa (programa, saídas, ciclo): acorda a varredura.
+    if (handle && sleeping.load()) xTaskNotify(handle, NOTIFY_WAKE, eSetBits);
+}
+
+ScanLock::ScanLock() {
+    scanTask.lock();
+}
+
+ScanLock::~ScanLock() {
+    scanTask.unlock();
+}
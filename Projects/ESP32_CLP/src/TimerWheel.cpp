@@ -0,0 +1,195 @@
+#include "TimerWheel.h"
+#include <string.h>
+
+namespace {
+
+inline uint64_t rotl(uint64_t v, uint8_t c) {
+    c &= 63;
+    return c ? (v << c) | (v >> (64 - c)) : v;
+}
+
+inline uint64_t rotr(uint64_t v, uint8_t c) {
+    c &= 63;
+    return c ? (v >> c) | (v << (64 - c)) : v;
+}
+
+} // namespace
+
+TimerWheel::TimerWheel() : nodes(nullptr), capacity(0) {
+    reset(0);
+}
+
+void TimerWheel::carve(BlockArena& arena, uint16_t cap) {
+    nodes = arena.take<Node>(cap);
+    capacity = arena.measuring() ? 0 : cap;
+    reset(current);
+}
+
+void TimerWheel::reset(uint64_t nowUs) {
+    for (uint16_t i = 0; i < capacity; i++) {
+        nodes[i].list = NONE;
+        nodes[i].prev = NONE;
+        nodes[i].next = NONE;
+        nodes[i].deadline = 0;
+    }
+    for (uint16_t i = 0; i <= EXPIRED; i++) heads[i] = NONE;
+    memset(occupied, 0, sizeof(occupied));
+    current = nowUs;
+    cachedNext = UINT64_MAX;
+    nextValid = true;
+    active = 0;
+}
+
+void TimerWheel::link(uint16_t id, uint16_t list) {
+    Node& n = nodes[id];
+    n.list = list;
+    n.prev = NONE;
+    n.next = heads[list];
+    if (n.next != NONE) nodes[n.next].prev = id;
+    heads[list] = id;
+    if (list != EXPIRED) occupied[list / LEN] |= 1ULL << (list % LEN);
+}
+
+void TimerWheel::unlink(uint16_t id) {
+    Node& n = nodes[id];
+    if (n.prev != NONE) nodes[n.prev].next = n.next;
+    else heads[n.list] = n.next;
+    if (n.next != NONE) nodes[n.next].prev = n.prev;
+    if (n.list != EXPIRED && heads[n.list] == NONE) {
+        occupied[n.list / LEN] &= ~(1ULL << (n.list % LEN));
+    }
+    n.list = NONE;
+}
+
+// Escolhe o nível pelo bit mais alto do tempo restante; em níveis > 0 a
+// posição é a anterior à do prazo, para que o temporizador desça de nível
+// (cascata) antes de vencer.
+void TimerWheel::place(uint16_t id) {
+    uint64_t deadline = nodes[id].deadline;
+    if (deadline <= current) {
+        link(id, EXPIRED);
+        return;
+    }
+    uint64_t rem = deadline - current;
+    constexpr uint64_t MAX_REM = (1ULL << (BITS * LEVELS)) - 1;
+    if (rem > MAX_REM) rem = MAX_REM;
+    uint8_t level = (63 - __builtin_clzll(rem)) / BITS;
+    uint8_t slot = ((deadline >> (level * BITS)) - (level ? 1 : 0)) & (LEN - 1);
+    link(id, level * LEN + slot);
+}
+
+void TimerWheel::schedule(uint16_t id, uint64_t deadlineUs) {
+    if (nodes[id].list != NONE) {
+        if (nodes[id].deadline == cachedNext) nextValid = false;
+        unlink(id);
+    } else {
+        active++;
+    }
+    nodes[id].deadline = deadlineUs;
+    place(id);
+    if (nextValid && deadlineUs < cachedNext) cachedNext = deadlineUs;
+}
+
+void TimerWheel::cancel(uint16_t id) {
+    if (nodes[id].list == NONE) return;
+    if (nodes[id].deadline == cachedNext) nextValid = false;
+    unlink(id);
+    active--;
+}
+
+void TimerWheel::advance(uint64_t nowUs) {
+    if (nowUs <= current) return;
+
+    uint64_t elapsed = nowUs - current;
+    uint16_t todo = NONE;
+
+    for (uint8_t level = 0; level < LEVELS; level++) {
+        uint8_t shift = level * BITS;
+        uint64_t pending;
+        if ((elapsed >> shift) > (LEN - 1)) {
+            pending = ~0ULL;
+        } else {
+            uint8_t steps = (elapsed >> shift) & (LEN - 1);
+            uint8_t oldSlot = (current >> shift) & (LEN - 1);
+            uint8_t newSlot = (nowUs >> shift) & (LEN - 1);
+            uint64_t run = (1ULL << steps) - 1;
+            pending = rotl(run, oldSlot);
+            pending |= rotr(rotl(run, newSlot), steps);
+            pending |= 1ULL << newSlot;
+        }
+
+        uint64_t hit = pending & occupied[level];
+        while (hit) {
+            uint8_t slot = __builtin_ctzll(hit);
+            hit &= hit - 1;
+            uint16_t list = level * LEN + slot;
+            // Move a lista inteira para 'todo' (reencadeada via next).
+            while (heads[list] != NONE) {
+                uint16_t id = heads[list];
+                unlink(id);
+                nodes[id].next = todo;
+                todo = id;
+            }
+        }
+
+        // Sem volta completa neste nível: os níveis acima não giraram.
+        if (!(pending & 1ULL)) break;
+        // Continuando, o próximo nível avança pelo menos uma posição.
+        uint64_t minStep = (uint64_t)LEN << shift;
+        if (elapsed < minStep) elapsed = minStep;
+    }
+
+    current = nowUs;
+    while (todo != NONE) {
+        uint16_t id = todo;
+        todo = nodes[id].next;
+        place(id);
+    }
+}
+
+uint16_t TimerWheel::popExpired() {
+    uint16_t id = heads[EXPIRED];
+    if (id == NONE) return NONE;
+    if (nodes[id].deadline == cachedNext) nextValid = false;
+    unlink(id);
+    active--;
+    return id;
+}
+
+// Limite inferior dos prazos de uma posição ocupada: a janela do nível com
+// esse índice a partir do relógio (a colocação garante no máximo uma volta
+// à frente); em níveis > 0 o prazo cai na janela seguinte (cascata).
+uint64_t TimerWheel::slotFloor(uint8_t level, uint8_t slot) const {
+    uint8_t shift = level * BITS;
+    uint64_t window = current >> shift;
+    window += (uint8_t)(slot - (window & (LEN - 1))) & (LEN - 1);
+    if (level) window++;
+    return window << shift;
+}
+
+uint64_t TimerWheel::nextDeadline() {
+    if (!nextValid) {
+        // Recalcula só quando o menor prazo saiu da roda. Em cada nível as
+        // posições são visitadas na ordem do relógio e a busca para quando o
+        // limite da posição não pode mais bater o melhor prazo: em geral só
+        // uma lista por nível é percorrida.
+        cachedNext = UINT64_MAX;
+        for (uint16_t id = heads[EXPIRED]; id != NONE; id = nodes[id].next) {
+            if (nodes[id].deadline < cachedNext) cachedNext = nodes[id].deadline;
+        }
+        for (uint8_t level = 0; level < LEVELS; level++) {
+            uint8_t from = (current >> (level * BITS)) & (LEN - 1);
+            uint64_t bits = rotr(occupied[level], from);
+            while (bits) {
+                uint8_t slot = (from + __builtin_ctzll(bits)) & (LEN - 1);
+                bits &= bits - 1;
+                if (slotFloor(level, slot) >= cachedNext) break;
+                for (uint16_t id = heads[level * LEN + slot]; id != NONE; id = nodes[id].next) {
+                    if (nodes[id].deadline < cachedNext) cachedNext = nodes[id].deadline;
+                }
+            }
+        }
+        nextValid = true;
+    }
+    return cachedNext;
+}
@@ -2,8 +2,12 @@
 #include <WiFi.h>
 #include <LittleFS.h>
 #include "ServerManager.h"
+#include "web_assets.h"
 #include "IOManager.h"
 #include "LadderEngine.h"
+#include "LiveStream.h"
+#include "RetainStore.h"
+#include "ScanTask.h"
 
 #ifndef WIFI_STA_SSID
 #define WIFI_STA_SSID ""
@@ -18,324 +22,41 @@ static constexpr const char* AP_PASS = "12345678";
 
 ServerManager serverManager;
 
-// SPA minimalista para edição de blocos e monitoramento.
-const char INDEX_HTML[] PROGMEM = R"rawliteral(
-<!DOCTYPE html>
-<html lang="pt-br">
-<head>
-    <meta charset="utf-8" />
-    <meta name="viewport" content="width=device-width, initial-scale=1" />
-    <title>ESP32 CLP</title>
-    <style>
-        :root {
-            --bg: #0f172a;
-            --panel: #111827;
-            --card: #1f2937;
-            --accent: #38bdf8;
-            --accent-2: #22c55e;
-            --text: #e5e7eb;
-            --muted: #94a3b8;
-            --border: #1f2937;
-            font-family: 'Segoe UI', system-ui, -apple-system, sans-serif;
-        }
-        * { box-sizing: border-box; }
-        body { background: radial-gradient(circle at 20% 20%, #0b1831, #070d1d 60%); color: var(--text); margin: 0; padding: 16px; }
-        h1 { margin: 0; font-size: 24px; letter-spacing: 0.5px; }
-        .layout { max-width: 1100px; margin: 0 auto; display: grid; gap: 16px; }
-        header { background: var(--panel); border: 1px solid var(--border); padding: 14px 16px; border-radius: 12px; display: flex; flex-wrap: wrap; gap: 12px; align-items: center; justify-content: space-between; }
-        .status { display: flex; align-items: center; gap: 10px; color: var(--muted); }
-        .pill { padding: 6px 10px; background: rgba(56,189,248,0.1); border: 1px solid rgba(56,189,248,0.4); border-radius: 999px; color: var(--text); }
-        .grid { display: grid; grid-template-columns: repeat(auto-fit, minmax(260px, 1fr)); gap: 12px; }
-        .card { background: var(--card); border: 1px solid var(--border); border-radius: 12px; padding: 14px; }
-        .card h2 { margin: 0 0 10px 0; font-size: 14px; letter-spacing: 0.2px; color: var(--muted); text-transform: uppercase; }
-        .io-row { display: flex; justify-content: space-between; align-items: center; padding: 8px 10px; border-radius: 8px; border: 1px solid var(--border); margin-bottom: 6px; background: #0b1224; }
-        .badge { padding: 4px 8px; border-radius: 8px; font-weight: 600; font-size: 12px; min-width: 52px; text-align: center; }
-        .on { background: rgba(34,197,94,0.2); color: #86efac; border: 1px solid rgba(34,197,94,0.4); }
-        .off { background: rgba(239,68,68,0.2); color: #fca5a5; border: 1px solid rgba(239,68,68,0.4); }
-        button { cursor: pointer; border: 1px solid var(--border); border-radius: 10px; padding: 10px 14px; background: #0ea5e9; color: #0b1224; font-weight: 700; transition: transform 0.08s ease, background 0.2s ease; }
-        button.secondary { background: #1f2937; color: var(--text); }
-        button.danger { background: #ef4444; color: #0b1224; }
-        button:hover { transform: translateY(-1px); }
-        button:active { transform: translateY(0); }
-        .editor { background: var(--panel); border: 1px solid var(--border); border-radius: 12px; padding: 12px; }
-        .palette { display: grid; grid-template-columns: repeat(auto-fit, minmax(140px, 1fr)); gap: 8px; margin-bottom: 10px; }
-        .block-chip { border: 1px dashed rgba(56,189,248,0.5); padding: 8px; border-radius: 10px; text-align: center; background: rgba(56,189,248,0.08); color: var(--text); font-weight: 600; user-select: none; }
-        .canvas { border: 2px dashed rgba(148,163,184,0.3); padding: 10px; min-height: 140px; border-radius: 12px; background: #0b1224; margin-bottom: 10px; }
-        .block { border: 1px solid var(--border); background: #111827; border-radius: 10px; padding: 8px; margin-bottom: 8px; }
-        .block header { display: flex; justify-content: space-between; align-items: center; background: transparent; border: none; padding: 0; }
-        .block-title { font-weight: 700; color: var(--text); }
-        .block form { display: grid; grid-template-columns: repeat(auto-fit, minmax(110px, 1fr)); gap: 6px; margin-top: 6px; }
-        label { font-size: 11px; color: var(--muted); display: flex; flex-direction: column; gap: 4px; }
-        input, select { border-radius: 8px; border: 1px solid var(--border); background: #0b1224; color: var(--text); padding: 6px; }
-        textarea { width: 100%; min-height: 120px; border-radius: 10px; border: 1px solid var(--border); background: #0b1224; color: var(--text); padding: 10px; font-family: 'JetBrains Mono', monospace; font-size: 12px; }
-        .actions { display: flex; flex-wrap: wrap; gap: 8px; }
-    </style>
-</head>
-<body>
-    <div class="layout">
-        <header>
-            <h1>ESP32 CLP • Ladder / Blocos</h1>
-            <div class="status">
-                <span class="pill" id="netInfo">NET: --</span>
-                <span class="pill" id="cycleLabel">Ciclo: -- ms</span>
-                <label>Ciclo (10-100 ms)
-                    <input id="cycleMs" type="number" min="10" max="100" value="20" />
-                </label>
-                <button class="secondary" onclick="updateCycle()">Aplicar</button>
-            </div>
-        </header>
-
-        <div class="grid">
-            <div class="card">
-                <h2>Entradas (pull-up, ativo em LOW)</h2>
-                <div id="inputs"></div>
-            </div>
-            <div class="card">
-                <h2>Saídas (nível HIGH)</h2>
-                <div id="outputs"></div>
-            </div>
-        </div>
-
-        <div class="editor">
-            <h2 style="margin: 0 0 8px 0;">Editor gráfico (arraste blocos)</h2>
-            <div class="palette" id="palette"></div>
-            <div id="canvas" class="canvas">Arraste blocos aqui ou clique em um bloco na paleta.</div>
-            <textarea id="programJson" spellcheck="false"></textarea>
-            <div class="actions">
-                <button onclick="loadProgram()">Carregar</button>
-                <button onclick="saveProgram()">Salvar</button>
-                <button class="secondary" onclick="pushToRuntime()">Aplicar na RAM</button>
-                <button class="danger" onclick="eraseProgram()">Apagar</button>
-            </div>
-        </div>
-    </div>
-
-    <script>
-        const palette = [
-            { type: 'CONTACT_NO', label: 'Contato NA' },
-            { type: 'CONTACT_NC', label: 'Contato NF' },
-            { type: 'COIL', label: 'Bobina' },
-            { type: 'AND', label: 'AND' },
-            { type: 'OR', label: 'OR' },
-            { type: 'NOT', label: 'NOT' },
-            { type: 'TIMER_ON', label: 'Timer ON' },
-            { type: 'TIMER_OFF', label: 'Timer OFF' },
-            { type: 'LATCH_SET', label: 'Latch SET' },
-            { type: 'LATCH_RESET', label: 'Latch RESET' },
-            { type: 'CONST_TRUE', label: 'Const TRUE' },
-            { type: 'CONST_FALSE', label: 'Const FALSE' }
-        ];
-
-        let blocks = [];
-        let nextId = 0;
-
-        const $ = (id) => document.getElementById(id);
-
-        function renderPalette() {
-            const p = $('palette');
-            palette.forEach(item => {
-                const chip = document.createElement('div');
-                chip.className = 'block-chip';
-                chip.draggable = true;
-                chip.textContent = item.label;
-                chip.dataset.type = item.type;
-                chip.addEventListener('dragstart', (e) => {
-                    e.dataTransfer.setData('text/plain', item.type);
-                });
-                chip.addEventListener('click', () => addBlock(item.type));
-                p.appendChild(chip);
-            });
-        }
-
-        function addBlock(type) {
-            blocks.push({
-                id: nextId++,
-                type,
-                a: -1,
-                b: -1,
-                io: 0,
-                delay_ms: type.includes('TIMER') ? 500 : 0
-            });
-            renderBlocks();
-        }
-
-        function renderBlocks() {
-            const canvas = $('canvas');
-            canvas.innerHTML = '';
-            blocks.forEach((b, idx) => {
-                const card = document.createElement('div');
-                card.className = 'block';
-
-                const head = document.createElement('header');
-                const title = document.createElement('div');
-                title.className = 'block-title';
-                title.textContent = `${b.type} (#${idx})`;
-                const removeBtn = document.createElement('button');
-                removeBtn.className = 'secondary';
-                removeBtn.textContent = 'Excluir';
-                removeBtn.onclick = () => { blocks.splice(idx, 1); renderBlocks(); };
-                head.appendChild(title);
-                head.appendChild(removeBtn);
-                card.appendChild(head);
-
-                const form = document.createElement('form');
-                form.onsubmit = (e) => e.preventDefault();
-
-                form.appendChild(makeSelect('Tipo', b.type, palette.map(p => p.type), (v) => { b.type = v; renderBlocks(); }));
-                form.appendChild(makeNumber('Fonte A (id)', b.a, (v) => b.a = v));
-                form.appendChild(makeNumber('Fonte B (id)', b.b, (v) => b.b = v));
-                form.appendChild(makeNumber('IO (0..5)', b.io, (v) => b.io = v));
-                form.appendChild(makeNumber('Delay ms', b.delay_ms, (v) => b.delay_ms = v));
-
-                card.appendChild(form);
-                canvas.appendChild(card);
-            });
-            updateProgramJson();
-        }
-
-        function makeSelect(labelTxt, value, options, onChange) {
-            const label = document.createElement('label');
-            label.textContent = labelTxt;
-            const select = document.createElement('select');
-            options.forEach(op => {
-                const o = document.createElement('option');
-                o.value = op; o.textContent = op; if (op === value) o.selected = true; select.appendChild(o);
-            });
-            select.onchange = (e) => onChange(e.target.value);
-            label.appendChild(select);
-            return label;
-        }
-
-        function makeNumber(labelTxt, value, onChange) {
-            const label = document.createElement('label');
-            label.textContent = labelTxt;
-            const input = document.createElement('input');
-            input.type = 'number';
-            input.value = value;
-            input.onchange = (e) => onChange(parseInt(e.target.value));
-            label.appendChild(input);
-            return label;
-        }
+namespace {
 
-        function updateProgramJson() {
-            const cycle = parseInt($('cycleMs').value || '20');
-            const obj = { cycle_ms: cycle, blocks };
-            $('programJson').value = JSON.stringify(obj, null, 2);
-        }
-
-        function setProgramFromJson(text) {
-            try {
-                const data = JSON.parse(text);
-                blocks = (data.blocks || []).map(b => ({
-                    id: b.id ?? 0,
-                    type: b.type,
-                    a: b.a ?? -1,
-                    b: b.b ?? -1,
-                    io: b.io ?? 0,
-                    delay_ms: b.delay_ms ?? 0
-                }));
-                nextId = blocks.length;
-                $('cycleMs').value = data.cycle_ms ?? 20;
-                renderBlocks();
-            } catch (e) {
-                alert('JSON inválido: ' + e);
-            }
-        }
-
-        function loadProgram() {
-            fetch('/program').then(r => r.json()).then(data => {
-                setProgramFromJson(JSON.stringify(data));
-            }).catch(err => alert('Erro ao carregar: ' + err));
-        }
-
-        function saveProgram() {
-            const json = $('programJson').value;
-            fetch('/program', { method: 'POST', headers: { 'Content-Type': 'application/json' }, body: json })
-                .then(r => r.text())
-                .then(msg => alert(msg))
-                .catch(err => alert('Erro ao salvar: ' + err));
-        }
-
-        function pushToRuntime() {
-            const json = $('programJson').value;
-            fetch('/program', { method: 'POST', headers: { 'Content-Type': 'application/json' }, body: json })
-                .then(r => r.text())
-                .then(msg => alert('Aplicado: ' + msg))
-                .catch(err => alert('Erro: ' + err));
-        }
-
-        function eraseProgram() {
-            if (!confirm('Apagar programa salvo?')) return;
-            fetch('/program', { method: 'DELETE' })
-                .then(r => r.text())
-                .then(msg => alert(msg))
-                .catch(err => alert('Erro: ' + err));
-        }
+// Print que envia a resposta em blocos (Transfer-Encoding: chunked), para
+// gerar documentos grandes sem montá-los inteiros em RAM.
+class ChunkedPrint : public Print {
+public:
+    explicit ChunkedPrint(WebServer& s) : server(s), used(0) {}
+    ~ChunkedPrint() { flush(); }
 
-        function updateCycle() {
-            const ms = parseInt($('cycleMs').value || '20');
-            fetch('/cycle', { method: 'POST', headers: { 'Content-Type': 'application/json' }, body: JSON.stringify({ ms }) })
-                .then(r => r.text())
-                .then(() => $('cycleLabel').textContent = `Ciclo: ${ms} ms`)
-                .catch(err => alert('Erro ciclo: ' + err));
-        }
-
-        function toggleOutput(idx, state) {
-            fetch('/setOutput', { method: 'POST', headers: { 'Content-Type': 'application/json' }, body: JSON.stringify({ index: idx, state }) });
-        }
+    size_t write(uint8_t c) override {
+        buf[used++] = static_cast<char>(c);
+        if (used == sizeof(buf)) flush();
+        return 1;
+    }
 
-        function refreshStatus() {
-            fetch('/status').then(r => r.json()).then(data => {
-                $('cycleLabel').textContent = `Ciclo: ${data.cycle_ms} ms`;
-                $('cycleMs').value = data.cycle_ms;
-                $('netInfo').textContent = `NET: ${data.mode} ${data.ssid} ${data.ip}`;
-                const inDiv = $('inputs'); inDiv.innerHTML = '';
-                data.inputs.forEach((v, i) => {
-                    const row = document.createElement('div');
-                    row.className = 'io-row';
-                    row.innerHTML = `<span>IN${i}</span><span class="badge ${v ? 'on' : 'off'}">${v ? 'ON' : 'OFF'}</span>`;
-                    inDiv.appendChild(row);
-                });
-                const outDiv = $('outputs'); outDiv.innerHTML = '';
-                data.outputs.forEach((v, i) => {
-                    const row = document.createElement('div');
-                    row.className = 'io-row';
-                    const btn = document.createElement('button');
-                    btn.className = 'secondary';
-                    btn.textContent = v ? 'ON' : 'OFF';
-                    btn.onclick = () => toggleOutput(i, !v);
-                    row.innerHTML = `<span>OUT${i}</span>`;
-                    row.appendChild(btn);
-                    outDiv.appendChild(row);
-                });
-            }).catch(err => console.error(err));
-        }
+    size_t write(const uint8_t* data, size_t len) override {
+        for (size_t i = 0; i < len; i++) write(data[i]);
+        return len;
+    }
 
-        function setupDnD() {
-            const canvas = $('canvas');
-            canvas.addEventListener('dragover', (e) => e.preventDefault());
-            canvas.addEventListener('drop', (e) => {
-                e.preventDefault();
-                const type = e.dataTransfer.getData('text/plain');
-                addBlock(type);
-            });
-        }
+    void flush() override {
+        if (used == 0) return;
+        server.sendContent(buf, used);
+        used = 0;
+    }
 
-        function init() {
-            renderPalette();
-            renderBlocks();
-            setupDnD();
-            refreshStatus();
-            setInterval(refreshStatus, 800);
-        }
+private:
+    WebServer& server;
+    char buf[512];
+    size_t used;
+};
 
-        window.addEventListener('load', init);
-    </script>
-</body>
-</html>
-)rawliteral";
+} // namespace
 
-ServerManager::ServerManager() : server(80), apMode(true) {}
+ServerManager::ServerManager() : server(80), apMode(true), fault(nullptr), profileSerialMs(0), profileLastMs(0) {}
 
 void ServerManager::init(const char* staSsid, const char* staPass, bool forceAp) {
     auto startAp = [&]() {
@@ -375,27 +96,37 @@ void ServerManager::init(const char* staSsid, const char* staPass, bool forceAp)
 }
 
 void ServerManager::setupRoutes() {
+        if (fault) {
+                server.onNotFound([this]() {
+                        server.sendHeader("Access-Control-Allow-Origin", "*");
+                        server.send(503, "text/plain", fault);
+                });
+                return;
+        }
+
         server.on("/", HTTP_GET, [this]() {
                 server.sendHeader("Access-Control-Allow-Origin", "*");
-                server.send_P(200, "text/html", INDEX_HTML);
+                // SPA minimalista para edição de blocos e monitoramento (web/index.html).
+                serveStaticAsset(server, INDEX_HTML);
         });
 
         server.on("/status", HTTP_GET, [this]() {
                 server.sendHeader("Access-Control-Allow-Origin", "*");
-                StaticJsonDocument<256> doc;
-                bool ins[INPUTS_COUNT];
-                bool outs[OUTPUTS_COUNT];
-                ioManager.getAllInputs(ins);
-                ioManager.getAllOutputs(outs);
+                StaticJsonDocument<384> doc;
+                ScanSnapshot snap;
+                scanTask.readSnapshot(snap);
 
                 JsonArray aIn = doc.createNestedArray("inputs");
-                for (uint8_t i = 0; i < INPUTS_COUNT; i++) aIn.add(ins[i]);
+                for (uint8_t i = 0; i < INPUTS_COUNT; i++) aIn.add((snap.inputBits >> i) & 1u);
                 JsonArray aOut = doc.createNestedArray("outputs");
-                for (uint8_t i = 0; i < OUTPUTS_COUNT; i++) aOut.add(outs[i]);
+                for (uint8_t i = 0; i < OUTPUTS_COUNT; i++) aOut.add((snap.outputBits >> i) & 1u);
                 doc["cycle_ms"] = ladderEngine.getCycleMs();
+                doc["scan_us"] = ladderEngine.getLastScanUs();
+                doc["scan_max_us"] = ladderEngine.getMaxScanUs();
                 doc["mode"] = apMode ? "AP" : "STA";
                 doc["ssid"] = currentSsid;
                 doc["ip"] = currentIp.toString();
+                doc["live_port"] = LIVE_STREAM_PORT;
 
                 String res;
                 serializeJson(doc, res);
@@ -412,6 +143,7 @@ void ServerManager::setupRoutes() {
                 int index = doc["index"] | -1;
                 bool state = doc.containsKey("state") ? doc["state"].as<bool>() : !ioManager.getOutput(index);
                 if (index >= 0 && index < OUTPUTS_COUNT) {
+                        ScanLock lock;
                         ioManager.setOutput(index, state);
                         ioManager.updateOutputs();
                         server.send(200, "text/plain", "OK");
@@ -422,9 +154,15 @@ void ServerManager::setupRoutes() {
 
         server.on("/program", HTTP_GET, [this]() {
                 server.sendHeader("Access-Control-Allow-Origin", "*");
-                String json = ladderEngine.serializeProgram();
-                server.sendHeader("Content-Type", "application/json");
-                server.send(200, "application/json", json);
+                // Sem ScanLock: a tabela de blocos só é alterada por este
+                // mesmo task (POST/DELETE), nunca pela varredura.
+                server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+                server.send(200, "application/json", "");
+                {
+                        ChunkedPrint out(server);
+                        ladderEngine.writeProgramJson(out);
+                }
+                server.sendContent("");
         });
 
         server.on("/program", HTTP_POST, [this]() {
@@ -436,7 +174,22 @@ void ServerManager::setupRoutes() {
                 }
                 String body = server.arg("plain");
                 Serial.printf("[HTTP] POST /program: %d bytes\n", body.length());
-                if (ladderEngine.loadFromJson(body, true)) {
+                DynamicJsonDocument doc(body.length() * 2 + 1024);
+                DeserializationError err = deserializeJson(doc, body);
+                if (err) {
+                        Serial.printf("[JSON] Erro ao parsear: %s\n", err.c_str());
+                        server.send(400, "text/plain", "Programa inválido");
+                        return;
+                }
+                bool ok;
+                {
+                        ScanLock lock;
+                        ok = ladderEngine.loadFromDocument(doc);
+                }
+                if (ok && !ladderEngine.saveProgram(body)) {
+                        server.send(500, "text/plain", "Programa carregado, mas falhou ao salvar na flash");
+                        Serial.println("[HTTP] Programa carregado, falha ao salvar");
+                } else if (ok) {
                         server.send(200, "text/plain", "Programa salvo e carregado");
                         Serial.println("[HTTP] Programa salvo OK");
                 } else {
@@ -445,9 +198,51 @@ void ServerManager::setupRoutes() {
                 }
         });
 
+        // Edição online: diff aplicado entre duas varreduras, sem zerar o
+        // estado (temporizadores, latches, contadores) dos blocos mantidos.
+        server.on("/program", HTTP_PATCH, [this]() {
+                server.sendHeader("Access-Control-Allow-Origin", "*");
+                if (!server.hasArg("plain")) { server.send(400, "text/plain", "Bad Request"); return; }
+                String body = server.arg("plain");
+                DynamicJsonDocument doc(body.length() * 2 + 1024);
+                DeserializationError err = deserializeJson(doc, body);
+                if (err) {
+                        Serial.printf("[JSON] Erro ao parsear: %s\n", err.c_str());
+                        server.send(400, "text/plain", "JSON error");
+                        return;
+                }
+                LadderPatch patch;
+                if (!ladderEngine.preparePatch(doc, patch)) {
+                        server.send(400, "text/plain", patch.error);
+                        return;
+                }
+                {
+                        ScanLock lock;
+                        ladderEngine.commitPatch(patch);
+                }
+                if (!ladderEngine.saveCurrentProgram()) {
+                        server.send(500, "text/plain", "Patch aplicado, mas falhou ao salvar na flash");
+                        return;
+                }
+
+                StaticJsonDocument<192> res;
+                res["blocks"] = ladderEngine.getBlockCount();
+                res["kept"] = patch.kept;
+                res["fresh"] = patch.fresh;
+                res["removed"] = patch.removed;
+                res["prepare_us"] = patch.prepareUs;
+                res["apply_us"] = patch.applyUs;
+                String out;
+                serializeJson(res, out);
+                server.send(200, "application/json", out);
+        });
+
         server.on("/program", HTTP_DELETE, [this]() {
                 server.sendHeader("Access-Control-Allow-Origin", "*");
-                ladderEngine.eraseStorage();
+                {
+                        ScanLock lock;
+                        ladderEngine.eraseStorage();
+                }
                 server.send(200, "text/plain", "Programa apagado");
         });
 
@@ -457,10 +252,103 @@ void ServerManager::setupRoutes() {
                 StaticJsonDocument<64> doc;
                 if (deserializeJson(doc, server.arg("plain"))) { server.send(400, "text/plain", "JSON error"); return; }
                 uint16_t ms = doc["ms"] | ladderEngine.getCycleMs();
-                ladderEngine.setCycleMs(ms);
+                scanTask.setCycleMs(ms);
                 server.send(200, "text/plain", "Cycle updated");
         });
 
+        server.on("/api/diag", HTTP_GET, [this]() {
+                server.sendHeader("Access-Control-Allow-Origin", "*");
+                ScanStats st = scanTask.getStats();
+                StaticJsonDocument<768> doc;
+                doc["cycle_ms"] = ladderEngine.getCycleMs();
+                doc["scans"] = st.scans;
+                doc["scan_min_us"] = st.minUs;
+                doc["scan_avg_us"] = st.avgUs;
+                doc["scan_max_us"] = st.maxUs;
+                doc["jitter_max_us"] = st.maxJitterUs;
+                doc["overruns"] = st.overruns;
+                doc["sleeps"] = st.sleeps;
+                doc["deadline_scans"] = st.deadlineScans;
+                doc["eval"] = ladderEngine.getEvalMode() == EvalMode::DELTA ? "delta" : "full";
+                doc["eval_last"] = ladderEngine.getLastEvalCount();
+                doc["free_heap"] = ESP.getFreeHeap();
+                doc["load_us"] = ladderEngine.getLoadUs();
+                doc["load_src"] = ladderEngine.getLoadSource() == ProgramSource::IMAGE ? "bin" : "json";
+                doc["first_scan_us"] = scanTask.getFirstScanUs();
+                doc["blocks"] = ladderEngine.getBlockCount();
+                doc["capacity"] = ladderEngine.getCapacity();
+                doc["arena_bytes"] = ladderEngine.getArenaBytes();
+                doc["arena_psram"] = ladderEngine.isArenaInPsram();
+                doc["patch_us"] = ladderEngine.getLastPatchUs();
+                doc["live_clients"] = liveStream.getClientCount();
+                doc["live_frames"] = liveStream.getFramesSent();
+                doc["live_slow_drops"] = liveStream.getSlowDrops();
+                RetainSource rs = retainStore.getSource();
+                doc["retain_words"] = retainStore.getWords();
+                doc["retain_src"] = rs == RetainSource::RTC ? "rtc" : rs == RetainSource::FLASH ? "flash" : "cold";
+                doc["retain_rtc_commits"] = retainStore.getRtcCommits();
+                doc["retain_flash_batches"] = retainStore.getFlashBatches();
+                doc["retain_journal_bytes"] = retainStore.getJournalBytes();
+                String res;
+                serializeJson(doc, res);
+                server.send(200, "application/json", res);
+        });
+
+        server.on("/api/diag", HTTP_DELETE, [this]() {
+                server.sendHeader("Access-Control-Allow-Origin", "*");
+                scanTask.resetStats();
+                server.send(200, "text/plain", "Diag reset");
+        });
+
+        // Perfil da varredura: ?top=N (padrão 10) e ?format=folded para
+        // pilhas dobradas (flamegraph.pl, speedscope).
+        server.on("/api/profile", HTTP_GET, [this]() {
+                server.sendHeader("Access-Control-Allow-Origin", "*");
+                uint8_t top = server.hasArg("top") ? constrain(server.arg("top").toInt(), 0, PROFILE_TOP_MAX) : 10;
+                bool folded = server.arg("format") == "folded";
+                ProfileReport report;
+                uint16_t blocks = ladderEngine.getBlockCount();
+                if (!report.reserve(blocks)) { server.send(503, "text/plain", "Sem memória"); return; }
+                {
+                        ScanLock lock;
+                        report.capture(ladderEngine.getProfiler(), blocks);
+                }
+                server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+                server.send(200, folded ? "text/plain" : "application/json", "");
+                {
+                        ChunkedPrint out(server);
+                        if (folded) report.writeFolded(out, ladderEngine.getTable());
+                        else report.writeJson(out, ladderEngine.getTable(), top);
+                }
+                server.sendContent("");
+        });
+
+        // {"enable": bool, "serial_ms": período do resumo na serial (0 = não)}
+        server.on("/api/profile", HTTP_POST, [this]() {
+                server.sendHeader("Access-Control-Allow-Origin", "*");
+                if (!server.hasArg("plain")) { server.send(400, "text/plain", "Bad Request"); return; }
+                StaticJsonDocument<96> doc;
+                if (deserializeJson(doc, server.arg("plain"))) { server.send(400, "text/plain", "JSON error"); return; }
+                bool ok = true;
+                if (doc.containsKey("enable")) {
+                        ScanLock lock;
+                        ok = ladderEngine.setProfiling(doc["enable"].as<bool>());
+                }
+                profileSerialMs = doc["serial_ms"] | profileSerialMs;
+                profileLastMs = millis();
+                if (!ok) { server.send(503, "text/plain", "Sem memória"); return; }
+                server.send(200, "text/plain", ladderEngine.isProfiling() ? "Perfil ligado" : "Perfil desligado");
+        });
+
+        server.on("/api/profile", HTTP_DELETE, [this]() {
+                server.sendHeader("Access-Control-Allow-Origin", "*");
+                {
+                        ScanLock lock;
+                        ladderEngine.clearProfile();
+                }
+                server.send(200, "text/plain", "Perfil zerado");
+        });
+
         server.onNotFound([this]() {
                 server.sendHeader("Access-Control-Allow-Origin", "*");
                 server.send(404, "text/plain", "Not found");
@@ -468,6 +356,7 @@ void ServerManager::setupRoutes() {
 }
 
 void ServerManager::begin() {
+        staticAssetHeaders(server);
         server.begin();
         Serial.println("[HTTP] Servidor na porta 80");
 }
@@ -475,3 +364,31 @@ void ServerManager::begin() {
 void ServerManager::handleClient() {
         server.handleClient();
 }
+
+void ServerManager::startTask() {
+        xTaskCreatePinnedToCore(taskEntry, "web_server", 8192, this, 1, nullptr, WEB_CORE);
+}
+
+void ServerManager::taskEntry(void* arg) {
+        ServerManager* self = static_cast<ServerManager*>(arg);
+        for (;;) {
+                self->handleClient();
+                self->pollProfile();
+                vTaskDelay(1); // cede CPU para Wi-Fi
+        }
+}
+
+void ServerManager::pollProfile() {
+        if (fault) return;
+        if (!profileSerialMs || !ladderEngine.isProfiling()) return;
+        if (millis() - profileLastMs < profileSerialMs) return;
+        profileLastMs = millis();
+        ProfileReport report;
+        uint16_t blocks = ladderEngine.getBlockCount();
+        if (!report.reserve(blocks)) return;
+        {
+                ScanLock lock;
+                report.capture(ladderEngine.getProfiler(), blocks);
+        }
+        report.printSummary(Serial, ladderEngine.getTable(), 5);
+}
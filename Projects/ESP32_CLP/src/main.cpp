@@ -1,10 +1,11 @@
 #include <Arduino.h>
 #include "IOManager.h"
 #include "LadderEngine.h"
+#include "LiveStream.h"
+#include "RetainStore.h"
+#include "ScanTask.h"
 #include "ServerManager.h"
 
-uint32_t lastScan = 0;
-
 void setup() {
     Serial.begin(115200);
     delay(300);
@@ -12,18 +13,28 @@ void setup() {
     Serial.println("ESP32 CLP - inicializando");
 
     ioManager.init();
-    ladderEngine.init();
+    if (!ladderEngine.init()) {
+        // Sem arena não há varredura: só o HTTP, explicando o motivo.
+        Serial.println("[LADDER] Sem memória para o motor, varredura desativada");
+        serverManager.setFault("Motor ladder sem memória");
+        serverManager.init();
+        serverManager.begin();
+        serverManager.startTask();
+        return;
+    }
+    // Estado retentivo de volta antes da primeira varredura.
+    retainStore.restore(ladderEngine);
+    retainStore.begin();
     serverManager.init();
     serverManager.begin();
+
+    // Varredura no SCAN_CORE disparada por timer; HTTP no WEB_CORE.
+    scanTask.begin();
+    serverManager.startTask();
+    liveStream.begin();
 }
 
 void loop() {
-    serverManager.handleClient();
-
-    uint32_t now = millis();
-    if (now - lastScan >= ladderEngine.getCycleMs()) {
-        ladderEngine.tick();
-        lastScan = now;
-    }
-    delay(1); // cede CPU para Wi-Fi
-}
\ No newline at end of file
+    // Todo o trabalho roda nas tarefas de varredura e do servidor.
+    vTaskDelete(nullptr);
+}
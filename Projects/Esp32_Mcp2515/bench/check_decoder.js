@@ -0,0 +1,49 @@
+// Confere o decodeBatch() do web/index.html com os lotes gravados pelo bench:
+//   .pio/build/native/program 10 /tmp/lotes.bin && node bench/check_decoder.js /tmp/lotes.bin
+// Compara, linha a linha, com os quadros esperados em /tmp/lotes.bin.txt.
+
+const fs = require('fs');
+const path = require('path');
+
+// Recorta uma função do <script> da página pelo nome (chaves balanceadas).
+function extractFunction(source, name) {
+  const start = source.indexOf(`function ${name}(`);
+  if (start < 0) throw new Error(`${name}() nao encontrada no index.html`);
+  let depth = 0;
+  for (let i = source.indexOf('{', start); i < source.length; i++) {
+    if (source[i] === '{') depth++;
+    if (source[i] === '}' && --depth === 0) return source.slice(start, i + 1);
+  }
+  throw new Error(`${name}() sem fim`);
+}
+
+const html = fs.readFileSync(path.join(__dirname, '..', 'web', 'index.html'), 'utf8');
+const decodeBatch = new Function(`${extractFunction(html, 'hex')}\n${extractFunction(html, 'decodeBatch')}\nreturn decodeBatch;`)();
+
+const file = process.argv[2];
+const blob = fs.readFileSync(file);
+const expected = fs.readFileSync(`${file}.txt`, 'utf8').trim().split('\n');
+
+let line = 0;
+let batches = 0;
+const started = process.hrtime.bigint();
+for (let pos = 0; pos < blob.length; batches++) {
+  const size = blob.readUInt16LE(pos);
+  const batch = blob.buffer.slice(blob.byteOffset + pos + 2, blob.byteOffset + pos + 2 + size);
+  pos += 2 + size;
+  for (const f of decodeBatch(batch)) {
+    const got = `${f.seq} ${f.ts} ${f.id} ${f.type} ${f.dlc}${f.data ? ' ' + f.data : ''}`;
+    if (got !== expected[line]) {
+      console.log(`FALHA na linha ${line + 1}:\n  esperado ${expected[line]}\n  decodificado ${got}`);
+      process.exit(1);
+    }
+    line++;
+  }
+}
+const ms = Number(process.hrtime.bigint() - started) / 1e6;
+
+if (line !== expected.length) {
+  console.log(`FALHA: ${line} quadros decodificados, ${expected.length} esperados`);
+  process.exit(1);
+}
+console.log(`decodeBatch(): ${line} quadros em ${batches} lotes iguais ao esperado, ${(ms * 1e6 / line).toFixed(0)} ns/quadro`);
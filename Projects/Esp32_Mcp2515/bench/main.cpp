@@ -0,0 +1,883 @@
+// Replay no host de um barramento CAN de 500 kbps 100% ocupado pelo caminho
+// de streaming do WebSocket (pio run -e native && .pio/build/native/program
+// [segundos] [lotes.bin]).
+//
+//   - gera o tráfego com o tempo de bit real: cada quadro dura os seus bits,
+//     com o bit stuffing calculado sobre o CRC-15 de verdade, mais os 3 do
+//     intervalo; uma pausa de 80 ms no meio exercita o delta em u32
+//   - cada quadro entra na CanFrameRing no instante em que termina (como a
+//     tarefa de RX) e sai como no loop(): a cada LOOP_PERIOD_US, fechando o
+//     lote cheio ou mais velho que FRAME_BATCH_MAX_AGE_MS
+//   - decodifica os lotes (a mesma lógica do decodeBatch() do index.html) e
+//     compara quadro a quadro com o que entrou; código de saída 1 se algo
+//     divergir ou a fila transbordar
+//   - mede ns/quadro do FrameBatchEncoder e os bytes/s no fio, contra o
+//     JSON de /api/frames
+//   - captura em arquivo (can_capture.cpp) com 2 e CAPTURE_BLOCKS blocos
+//     de 4 KB sobre modelos de tempo de escrita do LittleFS e de um cartão
+//     SD; lê os blocos de volta e confere o texto candump de cada quadro.
+//     Perder quadro com CAPTURE_BLOCKS blocos é falha
+//   - filtros de hardware (can_filter_plan.cpp) para alguns pedidos típicos
+//     sobre o tráfego do replay: todo ID pedido passa, nenhuma máscara de
+//     buffer com filtro padrão olha os bytes de dados, e quanto do
+//     barramento ainda atravessa o SPI
+//   - OBD (obd_poller.cpp) contra ECUs simuladas: rápida, lenta, que só
+//     responde um PID por pedido, desligada e sem os PIDs 0x21-0x40 (não
+//     pode ser consultada por eles depois do bitmap 0x00). Respostas com mais de 7 bytes
+//     vão em ISO-TP e só continuam depois do Flow Control. Confere cada
+//     valor decodificado e quantas vezes por segundo cada PID do painel é
+//     atualizado, contra o antigo 1 PID a cada 350 ms
+//
+// Com [lotes.bin] grava os lotes (u16 tamanho + lote) e, em lotes.bin.txt,
+// os quadros esperados, para node bench/check_decoder.js lotes.bin.
+
+#include <Arduino.h>
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "can_filter_plan.h"
+#include "can_frame_ring.h"
+#include "can_log_format.h"
+#include "frame_stream.h"
+#include "obd_poller.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t CAN_RX_RING_FRAMES = 512;   // O mesmo de can_rx.h
+constexpr uint32_t BIT_TIME_NS = 2000;       // 500 kbps
+constexpr uint64_t LOOP_PERIOD_US = 2000;    // loop() com HTTP e Serial no caminho
+constexpr uint64_t IDLE_GAP_US = 80000;
+constexpr uint32_t DEFAULT_SECONDS = 10;
+constexpr size_t WS_HEADER_BYTES = 4;        // Quadro binário do WebSocket com 126 <= tamanho < 64 KB
+constexpr uint32_t JSON_POLL_MS = 250;       // refreshFrames() antigo
+constexpr size_t JSON_LOG_FRAMES = 180;      // MAX_LOGGED_FRAMES do main.cpp
+constexpr size_t CAPTURE_BLOCK_BYTES = 4096; // Os mesmos de can_capture.h
+constexpr size_t CAPTURE_BLOCKS = 6;
+constexpr uint64_t CAPTURE_FLUSH_US = 5000000;
+constexpr size_t CAPTURE_SYNC_BLOCKS = 8;
+constexpr uint64_t CAN_FRAME_US = 250;       // Quadro de 8 bytes a 500 kbps, com folga
+constexpr uint32_t OBD_SIM_SECONDS = 10;
+constexpr uint32_t LEGACY_OBD_INTERVAL_MS = 350;
+
+struct Recorded {
+  CanFrame frame;
+  uint32_t seq;
+};
+
+// Tráfego de um carro: IDs padrão com 8 bytes quase sempre, alguns
+// estendidos (J1939/diagnóstico) e um RTR de vez em quando.
+struct TrafficGenerator {
+  uint32_t state = 0x12345678;
+  uint32_t index = 0;
+
+  uint32_t next() {
+    state = state * 1664525UL + 1013904223UL;
+    return state >> 8;
+  }
+
+  CanFrame make() {
+    CanFrame frame;
+    const uint32_t kind = index++ % 40;
+    if (kind == 39) {
+      frame.extended = true;
+      frame.rtr = true;
+      frame.id = 0x18EA00F9UL;
+      frame.len = 3;
+    } else if (kind % 8 == 7) {
+      frame.extended = true;
+      frame.id = 0x18F00000UL | (next() & 0xFFFF);
+      frame.len = 8;
+    } else {
+      frame.id = 0x100 + (next() % 0x600);
+      frame.len = kind % 10 == 3 ? static_cast<uint8_t>(next() % 9) : 8;
+    }
+    if (!frame.rtr) {
+      for (uint8_t i = 0; i < frame.len; i++) {
+        frame.data[i] = static_cast<uint8_t>(next());
+      }
+    }
+    return frame;
+  }
+};
+
+// Bits do quadro no fio, do SOF ao fim do intervalo entre quadros.
+uint32_t frameBits(const CanFrame &frame) {
+  uint8_t bits[160];
+  size_t count = 0;
+  auto put = [&](uint32_t value, int width) {
+    for (int i = width - 1; i >= 0; i--) {
+      bits[count++] = (value >> i) & 1;
+    }
+  };
+
+  put(0, 1);   // SOF
+  if (frame.extended) {
+    put(frame.id >> 18, 11);
+    put(1, 1);   // SRR
+    put(1, 1);   // IDE
+    put(frame.id & 0x3FFFF, 18);
+    put(frame.rtr, 1);
+    put(0, 2);   // r1 r0
+  } else {
+    put(frame.id, 11);
+    put(frame.rtr, 1);
+    put(0, 1);   // IDE
+    put(0, 1);   // r0
+  }
+  put(frame.len, 4);
+  if (!frame.rtr) {
+    for (uint8_t i = 0; i < frame.len; i++) {
+      put(frame.data[i], 8);
+    }
+  }
+
+  uint16_t crc = 0;
+  for (size_t i = 0; i < count; i++) {
+    const bool feedback = bits[i] ^ ((crc >> 14) & 1);
+    crc = (crc << 1) & 0x7FFF;
+    if (feedback) {
+      crc ^= 0x4599;
+    }
+  }
+  put(crc, 15);
+
+  // Depois de 5 bits iguais entra um invertido, que já conta para a próxima sequência.
+  uint32_t stuffed = 0;
+  uint8_t last = 2;
+  int run = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (bits[i] == last) {
+      run++;
+    } else {
+      last = bits[i];
+      run = 1;
+    }
+    if (run == 5) {
+      stuffed++;
+      last = !last;
+      run = 1;
+    }
+  }
+
+  return static_cast<uint32_t>(count) + stuffed + 1 /* delim. CRC */ + 2 /* ACK */ + 7 /* EOF */ + 3 /* IFS */;
+}
+
+bool decodeBatch(const uint8_t *batch, size_t size, std::vector<Recorded> &out) {
+  FrameBatchReader reader;
+  if (!reader.begin(batch, size)) {
+    return false;
+  }
+  Recorded record;
+  while (reader.next(record.frame, record.seq)) {
+    out.push_back(record);
+  }
+  return true;
+}
+
+bool sameFrame(const Recorded &a, const Recorded &b) {
+  return a.seq == b.seq && a.frame.timestampUs == b.frame.timestampUs && a.frame.id == b.frame.id &&
+         a.frame.extended == b.frame.extended && a.frame.rtr == b.frame.rtr && a.frame.len == b.frame.len &&
+         (a.frame.rtr || memcmp(a.frame.data, b.frame.data, a.frame.len) == 0);
+}
+
+// Objeto de /api/frames para o mesmo quadro (formatCanIdTo/formatDataBytesTo).
+size_t jsonBytes(const Recorded &record) {
+  static const char HEX_DIGITS[] = "0123456789ABCDEF";
+  char data[24];
+  size_t pos = 0;
+  for (uint8_t i = 0; i < record.frame.len; i++) {
+    if (i > 0) {
+      data[pos++] = ' ';
+    }
+    data[pos++] = HEX_DIGITS[record.frame.data[i] >> 4];
+    data[pos++] = HEX_DIGITS[record.frame.data[i] & 0x0F];
+  }
+  data[pos] = '\0';
+
+  char json[160];
+  const int length = snprintf(json, sizeof(json),
+                              record.frame.extended ? "{\"seq\":%lu,\"ts\":%lu,\"id\":\"0x%08lX\",\"type\":\"%s\",\"dlc\":%u,\"data\":\"%s\"},"
+                                                    : "{\"seq\":%lu,\"ts\":%lu,\"id\":\"0x%03lX\",\"type\":\"%s\",\"dlc\":%u,\"data\":\"%s\"},",
+                              static_cast<unsigned long>(record.seq),
+                              static_cast<unsigned long>(record.frame.timestampUs / 1000),
+                              static_cast<unsigned long>(record.frame.id),
+                              record.frame.rtr ? "RTR" : (record.frame.extended ? "EXT" : "STD"),
+                              record.frame.len,
+                              data);
+  return length > 0 ? static_cast<size_t>(length) : 0;
+}
+
+// Tempo de um write() de 4 KB (mais o flush() a cada CAPTURE_SYNC_BLOCKS)
+// por bloco gravado; números típicos de datasheet, não medidos.
+struct StorageModel {
+  const char *name;
+  uint32_t blockUs;      // Programar 4 KB (e apagar o setor, na flash)
+  uint32_t syncUs;       // Commit de metadados no flush()
+  uint32_t stallEvery;   // A cada N blocos...
+  uint32_t stallUs;      // ...uma pausa longa (compactação do LittleFS, "busy" do cartão)
+
+  uint32_t writeUs(size_t block) const {
+    uint32_t us = blockUs;
+    if ((block + 1) % CAPTURE_SYNC_BLOCKS == 0) {
+      us += syncUs;
+    }
+    if ((block + 1) % stallEvery == 0) {
+      us += stallUs;
+    }
+    return us;
+  }
+};
+
+// LittleFS: 16 páginas de 256 B a 0,4 ms + apagar o setor (45 ms, W25Q32)
+// e ~150 ms de compactação de metadados a cada 16 blocos. SD em SPI a
+// 20 MHz: ~2,5 ms por 4 KB e 250 ms de "busy" a cada 64 blocos.
+const StorageModel STORAGE_MODELS[] = {
+  {"LittleFS", 6400 + 45000, 12000, 16, 150000},
+  {"SD", 2500, 5000, 64, 250000},
+};
+
+struct CaptureResult {
+  size_t frames = 0;
+  size_t dropped = 0;
+  size_t maxQueued = 0;
+  uint64_t busyUs = 0;
+  std::vector<std::vector<uint8_t>> blocks;   // Na ordem do arquivo
+};
+
+// A lógica de can_capture.cpp em tempo simulado: loop() a cada
+// LOOP_PERIOD_US enche blocos de 4 KB; a "tarefa" grava um por vez com o
+// tempo do modelo e devolve o bloco ao terminar.
+CaptureResult captureReplay(const std::vector<Recorded> &sent, const StorageModel &model, size_t blockCount) {
+  struct Pending {
+    std::vector<uint8_t> data;
+    uint64_t readyUs;
+  };
+
+  CaptureResult result;
+  std::vector<Pending> queue;
+  std::vector<uint8_t> current;
+  size_t freeBlocks = blockCount;
+  bool writing = false;
+  uint64_t doneUs = 0;
+  uint64_t blockStartUs = 0;
+  uint8_t placeholder[FRAME_BATCH_HEADER_BYTES];
+  FrameBatchEncoder encoder(placeholder, sizeof(placeholder));
+  std::vector<uint8_t> inFlight;
+  size_t next = 0;
+
+  auto submit = [&](uint64_t nowUs) {
+    encoder.data();
+    queue.push_back({current, nowUs});
+    current.clear();
+    if (queue.size() > result.maxQueued) {
+      result.maxQueued = queue.size();
+    }
+  };
+  auto take = [&](uint64_t nowUs) {
+    if (freeBlocks == 0) {
+      return false;
+    }
+    freeBlocks--;
+    current.assign(CAPTURE_BLOCK_BYTES, 0);
+    encoder.attach(current.data(), current.size());
+    blockStartUs = nowUs;
+    return true;
+  };
+  auto runWriter = [&](uint64_t nowUs) {
+    for (;;) {
+      if (writing && doneUs <= nowUs) {
+        result.blocks.push_back(inFlight);
+        freeBlocks++;
+        writing = false;
+      }
+      if (writing || queue.empty()) {
+        return;
+      }
+      const uint64_t startUs = queue.front().readyUs > doneUs ? queue.front().readyUs : doneUs;
+      if (startUs > nowUs) {
+        return;
+      }
+      const uint32_t us = model.writeUs(result.blocks.size());
+      inFlight = queue.front().data;
+      queue.erase(queue.begin());
+      writing = true;
+      doneUs = startUs + us;
+      result.busyUs += us;
+    }
+  };
+
+  const uint64_t lastUs = sent.back().frame.timestampUs + LOOP_PERIOD_US;
+  for (uint64_t nowUs = sent.front().frame.timestampUs; nowUs <= lastUs; nowUs += LOOP_PERIOD_US) {
+    runWriter(nowUs);
+    while (next < sent.size() && sent[next].frame.timestampUs <= nowUs) {
+      const Recorded &record = sent[next++];
+      if (current.empty() && !take(nowUs)) {
+        result.dropped++;
+        continue;
+      }
+      if (!encoder.append(record.frame, record.seq)) {
+        submit(nowUs);
+        if (!take(nowUs)) {
+          result.dropped++;
+          continue;
+        }
+        encoder.append(record.frame, record.seq);
+      }
+      result.frames++;
+    }
+    if (!current.empty() && !encoder.empty() && nowUs - blockStartUs >= CAPTURE_FLUSH_US) {
+      submit(nowUs);
+    }
+  }
+  if (!current.empty() && !encoder.empty()) {
+    submit(lastUs);
+  }
+  runWriter(UINT64_MAX / 2);
+  runWriter(UINT64_MAX / 2);
+  return result;
+}
+
+// Os blocos gravados, lidos de volta e passados pelo texto candump, batem
+// com os quadros que entraram (na ordem, sem os descartados)?
+bool checkCaptureFile(const std::vector<Recorded> &sent, const CaptureResult &result) {
+  std::vector<Recorded> read;
+  for (const std::vector<uint8_t> &block : result.blocks) {
+    if (!decodeBatch(block.data(), block.size(), read)) {
+      printf("FALHA: bloco da captura não decodificou\n");
+      return false;
+    }
+  }
+  if (read.size() != result.frames) {
+    printf("FALHA: %zu quadros no arquivo, %zu capturados\n", read.size(), result.frames);
+    return false;
+  }
+
+  size_t cursor = 0;
+  for (const Recorded &record : read) {
+    while (cursor < sent.size() && sent[cursor].seq != record.seq) {
+      cursor++;
+    }
+    if (cursor == sent.size() || !sameFrame(sent[cursor], record)) {
+      printf("FALHA: quadro seq %lu diferente no arquivo\n", static_cast<unsigned long>(record.seq));
+      return false;
+    }
+
+    char line[CAN_LOG_LINE_MAX];
+    const size_t length = formatCanLogLine(line, sizeof(line), CanLogFormat::CANDUMP, record.frame);
+    line[length - 1] = '\0';
+    unsigned long long seconds = 0;
+    unsigned long micros = 0;
+    unsigned long id = 0;
+    char payload[24] = {0};
+    const int fields = sscanf(line, "(%llu.%6lu) can0 %lx#%23s", &seconds, &micros, &id, payload);
+    CanFrame parsed;
+    parsed.timestampUs = seconds * 1000000ULL + micros;
+    parsed.id = id;
+    const char *idText = strstr(line, "can0 ") + 5;
+    parsed.extended = strchr(idText, '#') - idText == 8;
+    parsed.rtr = payload[0] == 'R';
+    parsed.len = parsed.rtr ? static_cast<uint8_t>(payload[1] != '\0' ? payload[1] - '0' : 0)
+                            : static_cast<uint8_t>(strlen(payload) / 2);
+    for (uint8_t i = 0; !parsed.rtr && i < parsed.len; i++) {
+      unsigned byte = 0;
+      sscanf(payload + i * 2, "%2x", &byte);
+      parsed.data[i] = static_cast<uint8_t>(byte);
+    }
+    if (fields < 3 || parsed.timestampUs != record.frame.timestampUs || parsed.id != record.frame.id ||
+        parsed.extended != record.frame.extended || parsed.rtr != record.frame.rtr || parsed.len != record.frame.len ||
+        (!parsed.rtr && memcmp(parsed.data, record.frame.data, parsed.len) != 0)) {
+      printf("FALHA: candump \"%s\" não volta ao quadro\n", line);
+      return false;
+    }
+  }
+  return true;
+}
+
+// Taxa de cada ID no replay, como o main.cpp tira do FrameTracker.
+std::vector<TrafficSample> trafficOf(const std::vector<Recorded> &sent, double seconds) {
+  std::map<std::pair<uint32_t, bool>, uint32_t> counts;
+  for (const Recorded &record : sent) {
+    counts[{record.frame.id, record.frame.extended}]++;
+  }
+  std::vector<TrafficSample> traffic;
+  for (const auto &entry : counts) {
+    traffic.push_back({entry.first.first, entry.first.second, static_cast<float>(entry.second / seconds)});
+  }
+  return traffic;
+}
+
+bool checkFilterPlan(const char *ranges, const std::vector<TrafficSample> &traffic) {
+  CanFilterPlan plan;
+  if (!parseFilterRanges(ranges, plan)) {
+    printf("FALHA: \"%s\" não foi aceito\n", ranges);
+    return false;
+  }
+  const Clock::time_point t0 = Clock::now();
+  computeFilterPlan(plan, traffic.data(), traffic.size());
+  const double us = std::chrono::duration<double, std::micro>(Clock::now() - t0).count();
+
+  bool ok = true;
+  for (size_t r = 0; r < plan.rangeCount; r++) {
+    const CanIdRange &range = plan.ranges[r];
+    for (uint64_t id = range.first; id <= range.last; id += range.last - range.first > 65536 ? 4099 : 1) {
+      if (!plan.hardwarePasses(static_cast<uint32_t>(id), range.extended) || !plan.wants(static_cast<uint32_t>(id), range.extended)) {
+        printf("FALHA: %s barra o ID pedido 0x%lX\n", ranges, static_cast<unsigned long>(id));
+        ok = false;
+        break;
+      }
+    }
+  }
+  for (int buffer = 0; buffer < 2; buffer++) {
+    for (size_t i = buffer == 0 ? 0 : 2; i < (buffer == 0 ? 2u : 6u); i++) {
+      if (!plan.filters[i].extended && (plan.masks[buffer] & 0x3FFFF) != 0) {
+        printf("FALHA: %s: RXM%d compara bytes de dados de quadros padrão\n", ranges, buffer);
+        ok = false;
+      }
+    }
+  }
+
+  const FilterEstimate &e = plan.estimate;
+  printf("filtros:    %-40s RXM0=%08lX RXM1=%08lX | %lu IDs aceitos p/ %lu pedidos | SPI %.1f%% do barramento, %.0f%% útil | %.0f us\n",
+         ranges, static_cast<unsigned long>(plan.masks[0]), static_cast<unsigned long>(plan.masks[1]),
+         static_cast<unsigned long>(e.acceptedIds), static_cast<unsigned long>(e.wantedIds),
+         100.0 * e.passedFps / e.trafficFps, e.passedFps > 0 ? 100.0 * e.wantedFps / e.passedFps : 100.0, us);
+  return ok;
+}
+
+// ECU do modo 01: responde a 0x7DF depois de latencyMs pelo 0x7E8, em
+// ISO-TP se passar de 7 bytes (CFs só depois do Flow Control em 0x7E0).
+// Sem upperPids não tem 0x20 nem 0x2F: omite os dois da resposta, como uma
+// ECU real faz com PID não suportado.
+struct SimEcu {
+  const char *name;
+  uint32_t latencyMs;
+  bool multiPid;
+  bool silent;
+  bool upperPids;
+
+  SimEcu(const char *name, uint32_t latencyMs, bool multiPid, bool silent, bool upperPids = true)
+      : name(name), latencyMs(latencyMs), multiPid(multiPid), silent(silent), upperPids(upperPids) {}
+
+  struct Pending {
+    uint64_t dueUs;
+    uint8_t data[8];
+  };
+  std::vector<Pending> outbox;
+  std::vector<uint8_t> payload;
+  size_t sentBytes = 0;
+  bool awaitingFc = false;
+  std::map<uint8_t, std::vector<uint8_t>> lastRaw;   // O último valor mandado de cada PID
+  uint32_t unsupportedAsked = 0;                      // Pedidos de PID fora do bitmap (fora o 0x20 inicial)
+
+  bool supports(uint8_t pid) const {
+    return upperPids || pid < 0x20;
+  }
+
+  // Valor bruto que muda com o tempo, para pegar decodificação trocada.
+  std::vector<uint8_t> raw(uint8_t pid, uint64_t nowUs) const {
+    const uint8_t t = static_cast<uint8_t>(nowUs / 100000);
+    switch (pid) {
+      case 0x00: return {0x18, 0x1A, 0x80, static_cast<uint8_t>(upperPids ? 0x01 : 0x00)};   // 04 05 0C 0D 0F 11 [20]
+      case 0x20: return {0x00, 0x02, 0x00, 0x00};   // 2F
+      case 0x0C: return {static_cast<uint8_t>(0x0C + t % 16), static_cast<uint8_t>(t * 7)};
+      default: return {static_cast<uint8_t>(pid * 11 + t)};
+    }
+  }
+
+  void onRequest(const uint8_t *frame, uint64_t nowUs) {
+    if (silent || frame[1] != 0x01 || frame[0] < 2 || frame[0] > 7) {
+      return;
+    }
+    payload.assign(1, 0x41);
+    const bool bitmapSent = lastRaw.count(0x00) != 0;
+    const size_t count = multiPid ? frame[0] - 1 : 1;
+    for (size_t i = 0; i < count; i++) {
+      const uint8_t pid = frame[2 + i];
+      if (!supports(pid)) {
+        unsupportedAsked += pid != 0x20 || bitmapSent;
+        continue;
+      }
+      const std::vector<uint8_t> value = raw(pid, nowUs);
+      payload.push_back(pid);
+      payload.insert(payload.end(), value.begin(), value.end());
+      lastRaw[pid] = value;
+    }
+    if (payload.size() == 1) {
+      return;
+    }
+
+    Pending first = {nowUs + latencyMs * 1000ULL, {0}};
+    if (payload.size() <= 7) {
+      first.data[0] = static_cast<uint8_t>(payload.size());
+      memcpy(first.data + 1, payload.data(), payload.size());
+      awaitingFc = false;
+    } else {
+      first.data[0] = 0x10;
+      first.data[1] = static_cast<uint8_t>(payload.size());
+      memcpy(first.data + 2, payload.data(), 6);
+      sentBytes = 6;
+      awaitingFc = true;
+    }
+    outbox.push_back(first);
+  }
+
+  void onFlowControl(const uint8_t *frame, uint64_t nowUs) {
+    if (!awaitingFc || frame[0] != 0x30) {
+      return;
+    }
+    awaitingFc = false;
+    uint8_t sn = 1;
+    uint64_t due = nowUs + CAN_FRAME_US;
+    while (sentBytes < payload.size()) {
+      Pending cf = {due, {0}};
+      cf.data[0] = static_cast<uint8_t>(0x20 | sn);
+      const size_t chunk = payload.size() - sentBytes > 7 ? 7 : payload.size() - sentBytes;
+      memcpy(cf.data + 1, payload.data() + sentBytes, chunk);
+      sentBytes += chunk;
+      sn = (sn + 1) & 0x0F;
+      due += CAN_FRAME_US;
+      outbox.push_back(cf);
+    }
+  }
+};
+
+// A conta do J1979, escrita de novo (não pela tabela) para conferir.
+float expectedObdValue(uint8_t pid, const std::vector<uint8_t> &raw) {
+  switch (pid) {
+    case 0x0C: return (raw[0] * 256.0f + raw[1]) / 4.0f;
+    case 0x0D: return raw[0];
+    case 0x05:
+    case 0x0F: return static_cast<int>(raw[0]) - 40;
+    default: return raw[0] * 100.0f / 255.0f;
+  }
+}
+
+bool checkObdPolling(SimEcu ecu) {
+  LiveData live;
+  ObdPoller poller(live);
+  uint32_t seen[LIVE_FIELD_COUNT] = {0};
+  bool ok = true;
+  const uint64_t endUs = OBD_SIM_SECONDS * 1000000ULL;
+
+  for (uint64_t nowUs = 0; nowUs < endUs; nowUs += LOOP_PERIOD_US) {
+    const uint32_t nowMs = static_cast<uint32_t>(nowUs / 1000);
+    // Na ordem em que chegaram na fila de RX.
+    while (!ecu.outbox.empty() && ecu.outbox.front().dueUs <= nowUs) {
+      const SimEcu::Pending frame = ecu.outbox.front();
+      ecu.outbox.erase(ecu.outbox.begin());
+      uint32_t fcId = 0;
+      uint8_t fc[8];
+      if (poller.onFrame(OBD_RESPONSE_FIRST_ID, frame.data, 8, nowMs, fcId, fc)) {
+        if (fcId != 0x7E0) {
+          printf("FALHA: %s: Flow Control para 0x%03lX\n", ecu.name, static_cast<unsigned long>(fcId));
+          ok = false;
+        }
+        ecu.onFlowControl(fc, nowUs + CAN_FRAME_US);
+      }
+    }
+
+    for (const ObdPid &pid : OBD_PIDS) {
+      const LiveValue &value = live[pid.field];
+      const size_t field = static_cast<size_t>(pid.field);
+      if (value.updates != seen[field]) {
+        seen[field] = value.updates;
+        const float expected = expectedObdValue(pid.pid, ecu.lastRaw[pid.pid]);
+        if (value.value < expected - 0.01f || value.value > expected + 0.01f) {
+          printf("FALHA: %s: PID %02X decodificado %.2f, esperado %.2f\n", ecu.name, pid.pid, value.value, expected);
+          ok = false;
+        }
+      }
+    }
+
+    uint8_t request[8];
+    if (poller.nextRequest(nowMs, request)) {
+      ecu.onRequest(request, nowUs + CAN_FRAME_US);
+    }
+  }
+
+  const ObdPollerStats stats = poller.stats();
+  float slowestHz = 1e9f;
+  for (const ObdPid &pid : OBD_PIDS) {
+    if (!ecu.supports(pid.pid)) {
+      continue;
+    }
+    const float hz = static_cast<float>(live[pid.field].updates) / OBD_SIM_SECONDS;
+    slowestHz = hz < slowestHz ? hz : slowestHz;
+  }
+  printf("obd:        %-12s %2lu ms: %4lu pedidos (%lu completos, %lu parciais, %lu sem resposta), resposta %lu ms, intervalo %lu ms, %u PIDs/pedido, PID mais lento %.1f/s\n",
+         ecu.name, static_cast<unsigned long>(ecu.latencyMs), static_cast<unsigned long>(stats.requests),
+         static_cast<unsigned long>(stats.responses), static_cast<unsigned long>(stats.partial),
+         static_cast<unsigned long>(stats.timeouts), static_cast<unsigned long>(stats.responseMs),
+         static_cast<unsigned long>(stats.intervalMs), stats.pidsPerRequest, slowestHz);
+
+  if (stats.isoTpErrors != 0) {
+    printf("FALHA: %s: %lu erros ISO-TP\n", ecu.name, static_cast<unsigned long>(stats.isoTpErrors));
+    ok = false;
+  }
+  if (ecu.silent) {
+    // Ignição desligada: recua até um pedido por segundo.
+    if (stats.intervalMs != OBD_MAX_INTERVAL_MS || stats.requests > OBD_SIM_SECONDS + 6) {
+      printf("FALHA: %s: não recuou (%lu pedidos)\n", ecu.name, static_cast<unsigned long>(stats.requests));
+      ok = false;
+    }
+  } else if (slowestHz < (ecu.multiPid ? 5.0f : 2.0f)) {
+    printf("FALHA: %s: painel atualizado só %.1f vezes/s\n", ecu.name, slowestHz);
+    ok = false;
+  } else if (ecu.unsupportedAsked != 0) {
+    printf("FALHA: %s: %lu pedidos de PID não anunciado\n", ecu.name, static_cast<unsigned long>(ecu.unsupportedAsked));
+    ok = false;
+  } else if (!ecu.multiPid && stats.pidsPerRequest != 1) {
+    printf("FALHA: %s: continuou pedindo vários PIDs\n", ecu.name);
+    ok = false;
+  }
+  return ok;
+}
+
+void writeExpected(FILE *out, const Recorded &record) {
+  fprintf(out, "%lu %lu 0x%0*lX %s %u",
+          static_cast<unsigned long>(record.seq),
+          static_cast<unsigned long>(record.frame.timestampUs / 1000),
+          record.frame.extended ? 8 : 3,
+          static_cast<unsigned long>(record.frame.id),
+          record.frame.rtr ? "RTR" : (record.frame.extended ? "EXT" : "STD"),
+          record.frame.len);
+  for (uint8_t i = 0; !record.frame.rtr && i < record.frame.len; i++) {
+    fprintf(out, " %02X", record.frame.data[i]);
+  }
+  fputc('\n', out);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  const uint32_t seconds = argc > 1 ? static_cast<uint32_t>(strtoul(argv[1], nullptr, 10)) : DEFAULT_SECONDS;
+  FILE *dump = argc > 2 ? fopen(argv[2], "wb") : nullptr;
+  FILE *expected = nullptr;
+  if (dump != nullptr) {
+    const std::string path = std::string(argv[2]) + ".txt";
+    expected = fopen(path.c_str(), "w");
+  }
+
+  // Tráfego: quadros colados um no outro, timestamp no fim de cada um.
+  TrafficGenerator traffic;
+  std::vector<Recorded> sent;
+  const uint64_t endUs = static_cast<uint64_t>(seconds) * 1000000ULL;
+  const uint64_t gapAtUs = endUs / 2;
+  uint64_t busNs = 1000000000ULL;   // Começa em 1 s, como esp_timer depois do boot
+  uint64_t busBits = 0;
+  bool gapDone = false;
+  while (busNs / 1000 < 1000000ULL + endUs) {
+    if (!gapDone && busNs / 1000 >= 1000000ULL + gapAtUs) {
+      busNs += IDLE_GAP_US * 1000;
+      gapDone = true;
+    }
+    Recorded record;
+    record.frame = traffic.make();
+    const uint32_t bits = frameBits(record.frame);
+    busBits += bits;
+    busNs += static_cast<uint64_t>(bits) * BIT_TIME_NS;
+    record.frame.timestampUs = busNs / 1000;
+    record.seq = static_cast<uint32_t>(sent.size() + 1);
+    sent.push_back(record);
+  }
+  const double busSeconds = seconds + IDLE_GAP_US / 1e6;
+  const double framesPerSecond = sent.size() / busSeconds;
+  printf("barramento: %zu quadros em %.2f s = %.0f quadros/s, %.1f bits/quadro, ocupação %.1f%%\n",
+         sent.size(), busSeconds, framesPerSecond, static_cast<double>(busBits) / sent.size(),
+         100.0 * busBits * BIT_TIME_NS / 1e9 / busSeconds);
+
+  // Replay: RX põe na fila no tempo do quadro, o "loop()" consome a cada LOOP_PERIOD_US.
+  static CanFrameRing<CAN_RX_RING_FRAMES> ring;
+  static uint8_t batchBuffer[FRAME_BATCH_BYTES];
+  FrameBatchEncoder encoder(batchBuffer, sizeof(batchBuffer));
+  std::vector<Recorded> received;
+  size_t wireBytes = 0;
+  size_t batches = 0;
+  size_t next = 0;
+  uint64_t batchStartUs = 0;
+  uint64_t maxLatencyUs = 0;
+  double latencySumUs = 0;
+  const uint64_t startUs = sent.front().frame.timestampUs;
+  const uint64_t lastUs = sent.back().frame.timestampUs + FRAME_BATCH_MAX_AGE_MS * 1000 + LOOP_PERIOD_US;
+
+  auto flush = [&](uint64_t nowUs) {
+    if (encoder.empty()) {
+      return;
+    }
+    const uint8_t *batch = encoder.data();
+    const size_t first = received.size();
+    if (!decodeBatch(batch, encoder.size(), received) || received.size() - first != encoder.count()) {
+      printf("FALHA: lote %zu não decodificou\n", batches);
+      exit(1);
+    }
+    for (size_t i = first; i < received.size(); i++) {
+      const uint64_t latency = nowUs - received[i].frame.timestampUs;
+      latencySumUs += latency;
+      if (latency > maxLatencyUs) {
+        maxLatencyUs = latency;
+      }
+    }
+    if (dump != nullptr) {
+      const uint16_t size = static_cast<uint16_t>(encoder.size());
+      fwrite(&size, sizeof(size), 1, dump);
+      fwrite(batch, 1, size, dump);
+    }
+    wireBytes += encoder.size() + WS_HEADER_BYTES;
+    batches++;
+    encoder.reset();
+  };
+
+  for (uint64_t nowUs = startUs; nowUs <= lastUs; nowUs += LOOP_PERIOD_US) {
+    while (next < sent.size() && sent[next].frame.timestampUs <= nowUs) {
+      ring.push(sent[next++].frame);
+    }
+
+    CanFrame frame;
+    uint32_t seq = static_cast<uint32_t>(received.size() + encoder.count());
+    while (ring.pop(frame)) {
+      seq++;
+      if (encoder.empty()) {
+        batchStartUs = nowUs;
+      }
+      if (!encoder.append(frame, seq)) {
+        flush(nowUs);
+        batchStartUs = nowUs;
+        encoder.append(frame, seq);
+      }
+    }
+    if (!encoder.empty() && nowUs - batchStartUs >= FRAME_BATCH_MAX_AGE_MS * 1000) {
+      flush(nowUs);
+    }
+  }
+  flush(lastUs);
+
+  bool ok = ring.overflows() == 0 && received.size() == sent.size();
+  for (size_t i = 0; ok && i < sent.size(); i++) {
+    if (!sameFrame(sent[i], received[i])) {
+      printf("FALHA: quadro %zu diferente depois do lote\n", i);
+      ok = false;
+    }
+  }
+  if (expected != nullptr) {
+    for (const Recorded &record : sent) {
+      writeExpected(expected, record);
+    }
+    fclose(expected);
+    fclose(dump);
+  }
+
+  size_t json = 0;
+  for (const Recorded &record : sent) {
+    json += jsonBytes(record);
+  }
+  const double maxJsonFps = JSON_LOG_FRAMES * 1000.0 / JSON_POLL_MS;
+
+  printf("replay:     %zu/%zu quadros iguais, fila pico %zu/%zu, perdidos %lu, loop() a cada %llu us\n",
+         ok ? received.size() : 0, sent.size(), ring.highWater(), ring.capacity(),
+         static_cast<unsigned long>(ring.overflows()), static_cast<unsigned long long>(LOOP_PERIOD_US));
+  printf("websocket:  %zu lotes (%.0f/s, %.1f quadros/lote), %.1f bytes/quadro, %.1f KB/s, latência média %.1f ms, máx %.1f ms\n",
+         batches, batches / busSeconds, static_cast<double>(sent.size()) / batches,
+         static_cast<double>(wireBytes) / sent.size(), wireBytes / busSeconds / 1024.0,
+         latencySumUs / received.size() / 1000.0, maxLatencyUs / 1000.0);
+  printf("json:       %.1f bytes/quadro, %.1f KB/s se desse; o poll de %u ms com %zu no log entrega no máximo %.0f quadros/s (%.0f%% do barramento)\n",
+         static_cast<double>(json) / sent.size(), json / busSeconds / 1024.0, JSON_POLL_MS, JSON_LOG_FRAMES,
+         maxJsonFps, 100.0 * maxJsonFps / framesPerSecond);
+  printf("folga:      a fila de %zu quadros segura o loop() parado por %.0f ms\n",
+         ring.capacity(), ring.capacity() / framesPerSecond * 1000.0);
+
+  // Captura em arquivo: a mesma carga com blocos de 4 KB em cada modelo.
+  for (const StorageModel &model : STORAGE_MODELS) {
+    for (size_t blocks : {static_cast<size_t>(2), CAPTURE_BLOCKS}) {
+      const CaptureResult capture = captureReplay(sent, model, blocks);
+      const double kBps = capture.blocks.size() * CAPTURE_BLOCK_BYTES / 1024.0 / (capture.busyUs / 1e6);
+      printf("captura:    %-8s %zu blocos: %zu gravados, %.1f quadros/bloco, precisa %.1f KB/s, grava %.1f KB/s, fila pico %zu, perdidos %zu\n",
+             model.name, blocks, capture.blocks.size(), static_cast<double>(capture.frames) / capture.blocks.size(),
+             (capture.frames + capture.dropped) * capture.blocks.size() / static_cast<double>(capture.frames) *
+                 CAPTURE_BLOCK_BYTES / 1024.0 / busSeconds,
+             kBps, capture.maxQueued,
+             capture.dropped);
+      if (!checkCaptureFile(sent, capture)) {
+        ok = false;
+      }
+      if (blocks == CAPTURE_BLOCKS && capture.dropped != 0) {
+        printf("FALHA: captura com %zu blocos perdeu quadros em %s\n", CAPTURE_BLOCKS, model.name);
+        ok = false;
+      }
+    }
+  }
+
+  const std::vector<TrafficSample> rates = trafficOf(sent, busSeconds);
+  for (const char *ranges : {"7E8-7EF", "7DF,7E0-7EF", "201,420,7E8-7EF", "18DAF100-18DAF1FF", "100-17F,300,305,18F00000-18F0FFFF",
+                             "123,234,345,456,567,678,789,1AB,2BC,3CD",
+                             // FILTER_MAX_CELLS blocos estendidos (o último é 1ABCDEF0) antes do padrão.
+                             "10000001-100000FE,10000101-100001FE,10000201-100002FE,10000301-100003FE,"
+                             "10000401-10000407,10000409-1000040F,10000411,1ABCDEF0,7E8"}) {
+    if (!checkFilterPlan(ranges, rates)) {
+      ok = false;
+    }
+  }
+
+  // Com o poller ativo o firmware soma 0x7E8-0x7EF às faixas pedidas, mesmo
+  // com as 16 ocupadas; sem isso toda resposta OBD morria no filtro.
+  {
+    CanFilterPlan plan;
+    parseFilterRanges("100,101,102,103,104,105,106,107,108,109,10A,10B,10C,10D,10E,18DAF100", plan);
+    const bool added = includeFilterRange(plan, CanIdRange{OBD_RESPONSE_FIRST_ID, OBD_RESPONSE_LAST_ID, false});
+    computeFilterPlan(plan, rates.data(), rates.size());
+    for (uint32_t id = OBD_RESPONSE_FIRST_ID; id <= OBD_RESPONSE_LAST_ID; id++) {
+      if (!added || !plan.hardwarePasses(id, false) || !plan.wants(id, false)) {
+        printf("FALHA: filtro com o poller ativo barra a resposta OBD 0x%03lX\n", static_cast<unsigned long>(id));
+        ok = false;
+        break;
+      }
+    }
+  }
+
+  for (const SimEcu &ecu : {SimEcu{"rápida", 5, true, false}, SimEcu{"lenta", 40, true, false},
+                            SimEcu{"1 PID", 10, false, false}, SimEcu{"desligada", 0, true, true},
+                            SimEcu{"sem 0x20", 10, true, false, false}}) {
+    if (!checkObdPolling(ecu)) {
+      ok = false;
+    }
+  }
+  printf("obd:        antes: 1 PID a cada %lu ms, cada um dos %zu PIDs %.2f vezes/s\n",
+         static_cast<unsigned long>(LEGACY_OBD_INTERVAL_MS), OBD_PID_COUNT, 1000.0 / (LEGACY_OBD_INTERVAL_MS * OBD_PID_COUNT));
+
+  char line[CAN_LOG_LINE_MAX];
+  for (size_t i : {static_cast<size_t>(0), static_cast<size_t>(7), static_cast<size_t>(39)}) {
+    for (CanLogFormat format : {CanLogFormat::CANDUMP, CanLogFormat::GVRET}) {
+      const size_t length = formatCanLogLine(line, sizeof(line), format, sent[i].frame);
+      printf("            %.*s", static_cast<int>(length), line);
+    }
+  }
+
+  // Custo do codificador (host): o mesmo tráfego em lotes, várias vezes.
+  FrameBatchEncoder timed(batchBuffer, sizeof(batchBuffer));
+  const int rounds = 20;
+  volatile size_t sink = 0;
+  const Clock::time_point t0 = Clock::now();
+  for (int round = 0; round < rounds; round++) {
+    for (const Recorded &record : sent) {
+      if (!timed.append(record.frame, record.seq)) {
+        sink = sink + timed.data()[2];
+        timed.reset();
+        timed.append(record.frame, record.seq);
+      }
+    }
+    timed.reset();
+  }
+  const double ns = std::chrono::duration<double, std::nano>(Clock::now() - t0).count();
+  printf("encoder:    %.1f ns/quadro no host (%.2f%% de um núcleo a %.0f quadros/s)\n",
+         ns / (rounds * sent.size()), 100.0 * ns / (rounds * sent.size()) * framesPerSecond / 1e9, framesPerSecond);
+
+  if (!ok) {
+    printf("FALHA\n");
+    return 1;
+  }
+  return 0;
+}
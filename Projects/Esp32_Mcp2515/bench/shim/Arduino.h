@@ -0,0 +1,10 @@
+#pragma once
+
+// O mínimo do core Arduino-ESP32 que frame_stream e can_frame_ring usam,
+// para compilar o bench no host (env:native).
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
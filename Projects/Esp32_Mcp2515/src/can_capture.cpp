@@ -0,0 +1,252 @@
+#include "can_capture.h"
+
+#include <esp_timer.h>
+
+#include "frame_stream.h"
+
+namespace {
+
+// Prioridade baixa, no núcleo do Wi-Fi, que fica ocioso entre pacotes: a
+// gravação só usa o tempo que sobra e nunca atrasa o loop() nem o RX.
+constexpr UBaseType_t WRITER_TASK_PRIORITY = tskIDLE_PRIORITY + 1;
+constexpr uint32_t WRITER_TASK_STACK = 4096;
+constexpr BaseType_t WRITER_TASK_CORE = ARDUINO_RUNNING_CORE == 0 ? 1 : 0;
+constexpr int16_t CLOSE_FILE = -1;
+
+fs::FS *storage = nullptr;
+uint8_t blocks[CAPTURE_BLOCKS][CAPTURE_BLOCK_BYTES];
+QueueHandle_t freeBlocks = nullptr;   // Índices livres (loop() pega)
+QueueHandle_t fullBlocks = nullptr;   // Índices para gravar ou CLOSE_FILE (tarefa pega)
+
+// Lado do loop().
+bool active = false;
+int16_t currentBlock = -1;
+FrameBatchEncoder encoder(blocks[0], CAPTURE_BLOCK_BYTES);
+uint32_t blockStartMs = 0;
+uint32_t framesCaptured = 0;
+uint32_t droppedNoBlock = 0;
+
+// Lado da tarefa (lidos pelo loop() em captureStats()).
+File file;
+size_t fileBytes = 0;
+size_t unsyncedBlocks = 0;
+volatile uint32_t firstFileIndex = 0;
+volatile uint32_t nextFileIndex = 0;
+volatile uint32_t droppedOnWrite = 0;
+volatile uint32_t blocksWritten = 0;
+volatile uint32_t writeErrors = 0;
+volatile uint32_t bytesWritten = 0;
+volatile uint64_t writeUsTotal = 0;
+volatile uint32_t maxWriteUs = 0;
+
+uint16_t blockFrameCount(const uint8_t *block) {
+  return static_cast<uint16_t>(block[2] | block[3] << 8);
+}
+
+void closeFile() {
+  if (file) {
+    file.close();
+  }
+  fileBytes = 0;
+  unsyncedBlocks = 0;
+}
+
+bool openNextFile() {
+  char path[32];
+  const uint32_t index = nextFileIndex;
+  capturePath(path, sizeof(path), index);
+  file = storage->open(path, FILE_WRITE);
+  if (!file) {
+    return false;
+  }
+
+  nextFileIndex = index + 1;
+  while (nextFileIndex - firstFileIndex > CAPTURE_MAX_FILES) {
+    capturePath(path, sizeof(path), firstFileIndex);
+    storage->remove(path);
+    firstFileIndex = firstFileIndex + 1;
+  }
+  return true;
+}
+
+void writeBlock(const uint8_t *block) {
+  if (file && fileBytes + CAPTURE_BLOCK_BYTES > CAPTURE_FILE_BYTES) {
+    closeFile();
+  }
+  if (!file && !openNextFile()) {
+    writeErrors = writeErrors + 1;
+    droppedOnWrite = droppedOnWrite + blockFrameCount(block);
+    return;
+  }
+
+  const int64_t startUs = esp_timer_get_time();
+  const size_t written = file.write(block, CAPTURE_BLOCK_BYTES);
+  if (++unsyncedBlocks >= CAPTURE_SYNC_BLOCKS) {
+    file.flush();
+    unsyncedBlocks = 0;
+  }
+  const uint32_t elapsedUs = static_cast<uint32_t>(esp_timer_get_time() - startUs);
+
+  writeUsTotal = writeUsTotal + elapsedUs;
+  if (elapsedUs > maxWriteUs) {
+    maxWriteUs = elapsedUs;
+  }
+  if (written != CAPTURE_BLOCK_BYTES) {
+    writeErrors = writeErrors + 1;
+    droppedOnWrite = droppedOnWrite + blockFrameCount(block);
+    closeFile();
+    return;
+  }
+
+  fileBytes += written;
+  bytesWritten = bytesWritten + written;
+  blocksWritten = blocksWritten + 1;
+}
+
+void writerTask(void *) {
+  for (;;) {
+    int16_t index = CLOSE_FILE;
+    xQueueReceive(fullBlocks, &index, portMAX_DELAY);
+    if (index == CLOSE_FILE) {
+      closeFile();
+      continue;
+    }
+    writeBlock(blocks[index]);
+    xQueueSend(freeBlocks, &index, 0);
+  }
+}
+
+bool takeBlock() {
+  int16_t index = 0;
+  if (xQueueReceive(freeBlocks, &index, 0) != pdTRUE) {
+    return false;
+  }
+  currentBlock = index;
+  encoder.attach(blocks[index], CAPTURE_BLOCK_BYTES);
+  blockStartMs = millis();
+  return true;
+}
+
+void submitBlock() {
+  encoder.data();
+  memset(blocks[currentBlock] + encoder.size(), 0, CAPTURE_BLOCK_BYTES - encoder.size());
+  xQueueSend(fullBlocks, &currentBlock, portMAX_DELAY);   // Cabe sempre: fila com CAPTURE_BLOCKS + 1
+  currentBlock = -1;
+}
+
+} // namespace
+
+bool captureBegin(fs::FS &fs) {
+  if (!fs.exists(CAPTURE_DIR) && !fs.mkdir(CAPTURE_DIR)) {
+    return false;
+  }
+
+  // Continua a numeração de onde parou (o nome é o índice em decimal).
+  bool found = false;
+  uint32_t lowest = 0;
+  uint32_t highest = 0;
+  File dir = fs.open(CAPTURE_DIR);
+  for (File entry = dir.openNextFile(); entry; entry = dir.openNextFile()) {
+    const char *name = strrchr(entry.name(), '/');
+    name = name != nullptr ? name + 1 : entry.name();
+    char *end = nullptr;
+    const uint32_t index = strtoul(name, &end, 10);
+    if (end == name || strcmp(end, ".bin") != 0) {
+      continue;
+    }
+    lowest = !found || index < lowest ? index : lowest;
+    highest = !found || index > highest ? index : highest;
+    found = true;
+  }
+  firstFileIndex = found ? lowest : 0;
+  nextFileIndex = found ? highest + 1 : 0;
+
+  freeBlocks = xQueueCreate(CAPTURE_BLOCKS, sizeof(int16_t));
+  fullBlocks = xQueueCreate(CAPTURE_BLOCKS + 1, sizeof(int16_t));
+  for (int16_t i = 0; i < static_cast<int16_t>(CAPTURE_BLOCKS); i++) {
+    xQueueSend(freeBlocks, &i, 0);
+  }
+
+  storage = &fs;
+  if (xTaskCreatePinnedToCore(writerTask, "can_capture", WRITER_TASK_STACK, nullptr, WRITER_TASK_PRIORITY, nullptr,
+                              WRITER_TASK_CORE) != pdPASS) {
+    storage = nullptr;
+    return false;
+  }
+  return true;
+}
+
+bool captureStart() {
+  if (storage == nullptr) {
+    return false;
+  }
+  active = true;
+  return true;
+}
+
+// O arquivo fecha e a próxima captura começa outro.
+void captureStop() {
+  if (!active) {
+    return;
+  }
+  if (currentBlock >= 0) {
+    if (encoder.empty()) {
+      xQueueSend(freeBlocks, &currentBlock, 0);
+      currentBlock = -1;
+    } else {
+      submitBlock();
+    }
+  }
+  xQueueSend(fullBlocks, &CLOSE_FILE, portMAX_DELAY);
+  active = false;
+}
+
+bool captureActive() {
+  return active;
+}
+
+void captureFrame(const CanFrame &frame, uint32_t seq) {
+  if (!active) {
+    return;
+  }
+  if (currentBlock < 0 && !takeBlock()) {
+    droppedNoBlock++;
+    return;
+  }
+  if (!encoder.append(frame, seq)) {
+    submitBlock();
+    if (!takeBlock()) {
+      droppedNoBlock++;
+      return;
+    }
+    encoder.append(frame, seq);
+  }
+  framesCaptured++;
+}
+
+void captureLoop() {
+  if (currentBlock >= 0 && !encoder.empty() && millis() - blockStartMs >= CAPTURE_FLUSH_MS) {
+    submitBlock();
+  }
+}
+
+CaptureStats captureStats() {
+  CaptureStats stats;
+  stats.active = active;
+  stats.frames = framesCaptured;
+  stats.dropped = droppedNoBlock + droppedOnWrite;
+  stats.blocks = blocksWritten;
+  stats.writeErrors = writeErrors;
+  stats.bytesWritten = bytesWritten;
+  const uint64_t us = writeUsTotal;
+  stats.writeKBps = us > 0 ? static_cast<uint32_t>(static_cast<uint64_t>(stats.bytesWritten) * 1000000ULL / us / 1024) : 0;
+  stats.maxWriteUs = maxWriteUs;
+  stats.queued = fullBlocks != nullptr ? uxQueueMessagesWaiting(fullBlocks) : 0;
+  stats.firstFile = firstFileIndex;
+  stats.nextFile = nextFileIndex;
+  return stats;
+}
+
+void capturePath(char *out, size_t size, uint32_t index) {
+  snprintf(out, size, "%s/%08lu.bin", CAPTURE_DIR, static_cast<unsigned long>(index));
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <Arduino.h>
+#include <FS.h>
+
+#include "can_frame_ring.h"
+
+// Captura contínua dos quadros em arquivo (LittleFS ou cartão SD: qualquer
+// fs::FS). O loop() põe cada quadro, no formato de lote de frame_stream.h,
+// num bloco de 4 KB em RAM; bloco cheio vai por fila para uma tarefa de
+// prioridade baixa que grava alinhado em 4 KB (um setor da flash / 8 do
+// cartão) enquanto o loop() já enche o próximo. Se todos os blocos estão na
+// fila de gravação, os quadros são descartados e contados em dropped; a
+// fila de RX e o loop() nunca esperam pelo arquivo.
+//
+// Arquivos /capture/NNNNNNNN.bin de até CAPTURE_FILE_BYTES; ao abrir um novo
+// apaga o que passou de CAPTURE_MAX_FILES. Cada bloco é um lote completo
+// (cabeçalho com seq e tempo de base) mais zeros até 4 KB.
+
+constexpr size_t CAPTURE_BLOCK_BYTES = 4096;
+// Um sendo gravado e um enchendo, e mais quatro (~290 ms de barramento
+// cheio) para as pausas longas: compactação do LittleFS, "busy" do cartão SD.
+// No bench, 5 já não perdem nada com 250 ms de pausa; 24 KB de RAM.
+constexpr size_t CAPTURE_BLOCKS = 6;
+constexpr size_t CAPTURE_FILE_BYTES = 256 * 1024;
+constexpr size_t CAPTURE_MAX_FILES = 4;           // 1 MB no total
+constexpr uint32_t CAPTURE_FLUSH_MS = 5000;       // Bloco incompleto vai para o arquivo depois disso
+constexpr size_t CAPTURE_SYNC_BLOCKS = 8;         // flush() do arquivo a cada 32 KB (visível no download)
+constexpr char CAPTURE_DIR[] = "/capture";
+
+struct CaptureStats {
+  bool active;
+  uint32_t frames;        // Quadros que entraram em blocos
+  uint32_t dropped;       // Sem bloco livre ou bloco que falhou na gravação
+  uint32_t blocks;        // Blocos gravados
+  uint32_t writeErrors;
+  uint32_t bytesWritten;
+  uint32_t writeKBps;     // Vazão da gravação (bytes / tempo dentro de write())
+  uint32_t maxWriteUs;    // Pior write() + flush() de um bloco
+  uint32_t queued;        // Blocos esperando a tarefa
+  uint32_t firstFile;     // Arquivos existentes: [firstFile, nextFile)
+  uint32_t nextFile;
+};
+
+// Cria a pasta, acha a numeração dos arquivos que já existem e a tarefa.
+bool captureBegin(fs::FS &fs);
+bool captureStart();
+void captureStop();
+bool captureActive();
+
+// Só no loop().
+void captureFrame(const CanFrame &frame, uint32_t seq);
+void captureLoop();
+
+CaptureStats captureStats();
+void capturePath(char *out, size_t size, uint32_t index);
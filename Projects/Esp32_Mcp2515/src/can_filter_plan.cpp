@@ -0,0 +1,334 @@
+#include "can_filter_plan.h"
+
+#include <ctype.h>
+
+namespace {
+
+// Conjunto aceito por um filtro: tudo com (reg & mask) == value.
+struct Cell {
+  uint32_t value;
+  uint32_t mask;
+  bool extended;
+};
+
+struct Score {
+  float unwantedFps;
+  uint32_t acceptedIds;
+
+  bool operator<(const Score &other) const {
+    // Meio quadro por segundo de diferença é ruído da média do FrameTracker.
+    if (unwantedFps + 0.5f < other.unwantedFps || other.unwantedFps + 0.5f < unwantedFps) {
+      return unwantedFps < other.unwantedFps;
+    }
+    return acceptedIds < other.acceptedIds;
+  }
+};
+
+uint32_t toRegister(uint32_t id, bool extended) {
+  return extended ? id & FILTER_ALL_BITS : (id & 0x7FF) << 18;
+}
+
+uint32_t domainBits(bool extended) {
+  return extended ? FILTER_ALL_BITS : FILTER_SID_BITS;
+}
+
+uint32_t cellSize(uint32_t mask, bool extended) {
+  const int freeBits = __builtin_popcount(domainBits(extended) & ~mask);
+  return freeBits >= 32 ? 0xFFFFFFFFUL : 1UL << freeBits;
+}
+
+Cell merged(const Cell &a, const Cell &b) {
+  Cell cell;
+  cell.mask = a.mask & b.mask & ~(a.value ^ b.value);
+  cell.value = a.value & cell.mask;
+  cell.extended = a.extended;
+  return cell;
+}
+
+// Junta o par do mesmo tipo que menos aumenta o número de IDs aceitos.
+bool mergeCheapestPair(Cell *cells, size_t &count) {
+  size_t bestA = count;
+  size_t bestB = count;
+  uint64_t bestGrowth = UINT64_MAX;
+  for (size_t a = 0; a < count; a++) {
+    for (size_t b = a + 1; b < count; b++) {
+      if (cells[a].extended != cells[b].extended) {
+        continue;
+      }
+      const uint64_t growth = static_cast<uint64_t>(cellSize(merged(cells[a], cells[b]).mask, cells[a].extended)) -
+                              cellSize(cells[a].mask, cells[a].extended) - cellSize(cells[b].mask, cells[b].extended);
+      if (growth < bestGrowth) {
+        bestGrowth = growth;
+        bestA = a;
+        bestB = b;
+      }
+    }
+  }
+  if (bestA == count) {
+    return false;
+  }
+
+  cells[bestA] = merged(cells[bestA], cells[bestB]);
+  cells[bestB] = cells[--count];
+  return true;
+}
+
+// Quebra cada faixa em blocos alinhados de potência de 2 (como um CIDR).
+size_t splitRanges(const CanFilterPlan &plan, Cell *cells) {
+  size_t count = 0;
+  for (size_t r = 0; r < plan.rangeCount; r++) {
+    const CanIdRange &range = plan.ranges[r];
+    uint64_t id = range.first;
+    while (id <= range.last) {
+      uint32_t size = 1;
+      while (size < (1UL << 28) && (id & (size * 2 - 1)) == 0 && id + size * 2 - 1 <= range.last) {
+        size *= 2;
+      }
+
+      Cell cell;
+      cell.extended = range.extended;
+      cell.mask = range.extended ? FILTER_ALL_BITS & ~(size - 1) : FILTER_SID_BITS & ~((size - 1) << 18);
+      cell.value = toRegister(static_cast<uint32_t>(id), range.extended) & cell.mask;
+
+      // Sem espaço: junta ao bloco do mesmo tipo mais próximo.
+      if (count == FILTER_MAX_CELLS) {
+        size_t best = count;
+        uint32_t bestSize = 0xFFFFFFFFUL;
+        for (size_t i = 0; i < count; i++) {
+          if (cells[i].extended == cell.extended && cellSize(merged(cells[i], cell).mask, cell.extended) < bestSize) {
+            best = i;
+            bestSize = cellSize(merged(cells[i], cell).mask, cell.extended);
+          }
+        }
+        if (best < count) {
+          cells[best] = merged(cells[best], cell);
+        } else {
+          // Todos os blocos são do outro tipo: junta o par deles mais
+          // próximo para abrir espaço. Nenhum bloco é descartado.
+          mergeCheapestPair(cells, count);
+          cells[count++] = cell;
+        }
+      } else {
+        cells[count++] = cell;
+      }
+      id += size;
+    }
+  }
+  return count;
+}
+
+// Monta a configuração com as células dos bits em buffer0 no RXB0 e o resto
+// no RXB1. A máscara de cada buffer é o AND das células dele.
+void buildConfig(const Cell *cells, size_t count, uint32_t buffer0, CanFilterPlan &plan) {
+  Cell groups[2][4];
+  size_t sizes[2] = {0, 0};
+  for (size_t i = 0; i < count; i++) {
+    const int buffer = (buffer0 >> i) & 1 ? 0 : 1;
+    groups[buffer][sizes[buffer]++] = cells[i];
+  }
+
+  for (int buffer = 0; buffer < 2; buffer++) {
+    // Buffer vazio repete o outro: não aceita nada além do que já passa.
+    const int source = sizes[buffer] > 0 ? buffer : 1 - buffer;
+    uint32_t mask = FILTER_ALL_BITS;
+    for (size_t i = 0; i < sizes[source]; i++) {
+      mask &= groups[source][i].mask;
+    }
+    plan.masks[buffer] = mask;
+
+    const size_t first = buffer == 0 ? 0 : 2;
+    const size_t slots = buffer == 0 ? 2 : 4;
+    for (size_t slot = 0; slot < slots; slot++) {
+      const Cell &cell = groups[source][slot < sizes[source] ? slot : 0];
+      plan.filters[first + slot].value = cell.value & mask;
+      plan.filters[first + slot].extended = cell.extended;
+    }
+  }
+}
+
+uint32_t acceptedIds(const CanFilterPlan &plan) {
+  uint64_t total = 0;
+  for (size_t i = 0; i < 6; i++) {
+    const uint32_t mask = plan.masks[i < 2 ? 0 : 1];
+    bool repeated = false;
+    for (size_t j = 0; j < i; j++) {
+      const uint32_t otherMask = plan.masks[j < 2 ? 0 : 1];
+      repeated = repeated || (otherMask == mask && plan.filters[j].extended == plan.filters[i].extended &&
+                              ((plan.filters[j].value ^ plan.filters[i].value) & mask) == 0);
+    }
+    if (!repeated) {
+      total += cellSize(mask, plan.filters[i].extended);
+    }
+  }
+  return total > 0xFFFFFFFFULL ? 0xFFFFFFFFUL : static_cast<uint32_t>(total);
+}
+
+Score score(const CanFilterPlan &plan, const TrafficSample *traffic, size_t trafficCount) {
+  Score result = {0, acceptedIds(plan)};
+  for (size_t i = 0; i < trafficCount; i++) {
+    if (plan.hardwarePasses(traffic[i].id, traffic[i].extended) && !plan.wants(traffic[i].id, traffic[i].extended)) {
+      result.unwantedFps += traffic[i].fps;
+    }
+  }
+  return result;
+}
+
+bool parseHex(const char *&p, uint32_t &value, size_t &digits) {
+  value = 0;
+  digits = 0;
+  while (isxdigit(static_cast<unsigned char>(*p))) {
+    const char c = static_cast<char>(toupper(static_cast<unsigned char>(*p++)));
+    value = (value << 4) | static_cast<uint32_t>(c <= '9' ? c - '0' : c - 'A' + 10);
+    if (++digits > 8) {
+      return false;
+    }
+  }
+  return digits > 0;
+}
+
+} // namespace
+
+bool CanFilterPlan::wants(uint32_t id, bool extended) const {
+  if (rangeCount == 0) {
+    return true;
+  }
+  for (size_t i = 0; i < rangeCount; i++) {
+    if (ranges[i].extended == extended && id >= ranges[i].first && id <= ranges[i].last) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool CanFilterPlan::hardwarePasses(uint32_t id, bool extended) const {
+  const uint32_t reg = toRegister(id, extended);
+  for (size_t i = 0; i < 6; i++) {
+    const uint32_t mask = masks[i < 2 ? 0 : 1];
+    if (filters[i].extended == extended && ((reg ^ filters[i].value) & mask) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool parseFilterRanges(const char *text, CanFilterPlan &plan) {
+  plan.rangeCount = 0;
+  const char *p = text;
+  while (*p != '\0') {
+    while (*p == ' ' || *p == ',') {
+      p++;
+    }
+    if (*p == '\0') {
+      break;
+    }
+    if (plan.rangeCount == FILTER_MAX_RANGES) {
+      return false;
+    }
+
+    CanIdRange range;
+    size_t digits = 0;
+    size_t lastDigits = 0;
+    if (!parseHex(p, range.first, digits)) {
+      return false;
+    }
+    range.last = range.first;
+    if (*p == '-') {
+      p++;
+      if (!parseHex(p, range.last, lastDigits)) {
+        return false;
+      }
+      digits = digits > lastDigits ? digits : lastDigits;
+    }
+    if (*p != '\0' && *p != ',' && *p != ' ') {
+      return false;
+    }
+
+    range.extended = digits > 3;
+    const uint32_t limit = range.extended ? FILTER_ALL_BITS : 0x7FF;
+    if (range.last < range.first || range.last > limit) {
+      return false;
+    }
+    plan.ranges[plan.rangeCount++] = range;
+  }
+  return true;
+}
+
+bool includeFilterRange(CanFilterPlan &plan, const CanIdRange &range) {
+  if (plan.acceptAll()) {
+    return true;
+  }
+  for (size_t i = 0; i < plan.rangeCount; i++) {
+    const CanIdRange &existing = plan.ranges[i];
+    if (existing.extended == range.extended && existing.first <= range.first && existing.last >= range.last) {
+      return true;
+    }
+  }
+  if (plan.rangeCount > FILTER_MAX_RANGES) {
+    return false;
+  }
+  plan.ranges[plan.rangeCount++] = range;
+  return true;
+}
+
+void computeFilterPlan(CanFilterPlan &plan, const TrafficSample *traffic, size_t trafficCount) {
+  // Aceita tudo: máscaras zeradas e filtros alternando estendido/padrão,
+  // como o mcp_can deixa no begin().
+  plan.masks[0] = 0;
+  plan.masks[1] = 0;
+  for (size_t i = 0; i < 6; i++) {
+    plan.filters[i].value = 0;
+    plan.filters[i].extended = i % 2 == 0;
+  }
+
+  if (!plan.acceptAll()) {
+    Cell cells[FILTER_MAX_CELLS];
+    size_t count = splitRanges(plan, cells);
+    while (count > 6 && mergeCheapestPair(cells, count)) {
+    }
+
+    // Cada nível de agrupamento (6 células, 5, ... 1) e cada divisão entre
+    // RXB0 (até 2) e RXB1 (até 4): fica a de menor custo.
+    CanFilterPlan best = plan;
+    Score bestScore = {0, 0};
+    bool found = false;
+    while (count <= 6) {
+      for (uint32_t buffer0 = 0; buffer0 < (1UL << count); buffer0++) {
+        const int inBuffer0 = __builtin_popcount(buffer0);
+        if (inBuffer0 > 2 || static_cast<int>(count) - inBuffer0 > 4) {
+          continue;
+        }
+        CanFilterPlan candidate = plan;
+        buildConfig(cells, count, buffer0, candidate);
+        const Score candidateScore = score(candidate, traffic, trafficCount);
+        if (!found || candidateScore < bestScore) {
+          best = candidate;
+          bestScore = candidateScore;
+          found = true;
+        }
+      }
+      if (count == 1 || !mergeCheapestPair(cells, count)) {
+        break;
+      }
+    }
+    memcpy(plan.masks, best.masks, sizeof(plan.masks));
+    memcpy(plan.filters, best.filters, sizeof(plan.filters));
+  }
+
+  FilterEstimate &estimate = plan.estimate;
+  estimate = FilterEstimate();
+  for (size_t i = 0; i < trafficCount; i++) {
+    estimate.trafficFps += traffic[i].fps;
+    if (plan.hardwarePasses(traffic[i].id, traffic[i].extended)) {
+      estimate.passedFps += traffic[i].fps;
+      if (plan.wants(traffic[i].id, traffic[i].extended)) {
+        estimate.wantedFps += traffic[i].fps;
+      }
+    }
+  }
+  estimate.acceptedIds = plan.acceptAll() ? 0x800UL + 0x20000000UL : acceptedIds(plan);
+  uint64_t wanted = 0;
+  for (size_t i = 0; i < plan.rangeCount; i++) {
+    wanted += plan.ranges[i].last - plan.ranges[i].first + 1;
+  }
+  estimate.wantedIds = plan.acceptAll() ? estimate.acceptedIds : static_cast<uint32_t>(wanted > 0xFFFFFFFFULL ? 0xFFFFFFFFULL : wanted);
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "can_frame_ring.h"
+
+// Máscaras e filtros de aceitação do MCP2515 calculados a partir dos IDs
+// que interessam. O chip tem dois buffers de RX: RXB0 com a máscara RXM0 e
+// os filtros RXF0-RXF1, RXB1 com RXM1 e RXF2-RXF5. Um quadro passa se, para
+// algum filtro do buffer, (id & máscara) == (filtro & máscara) e o filtro
+// for do mesmo tipo (padrão/estendido) do quadro.
+//
+// Tudo aqui usa o "espaço de registrador" de 29 bits: ID estendido como
+// está, ID padrão em << 18 (os 11 bits de SID). Os 18 bits baixos (EID) da
+// máscara de um buffer que tenha filtro padrão ficam sempre em zero, senão
+// o chip compararia os dois primeiros bytes de dados dos quadros padrão.
+//
+// O que o hardware deixa passar a mais é descartado por wants() no loop().
+
+constexpr size_t FILTER_MAX_RANGES = 16;
+constexpr size_t FILTER_MAX_CELLS = 64;   // Blocos alinhados antes de agrupar
+constexpr uint32_t FILTER_SID_BITS = 0x1FFC0000UL;
+constexpr uint32_t FILTER_ALL_BITS = 0x1FFFFFFFUL;
+
+struct CanIdRange {
+  uint32_t first = 0;
+  uint32_t last = 0;
+  bool extended = false;
+};
+
+struct HardwareFilter {
+  uint32_t value = 0;   // Espaço de registrador
+  bool extended = false;
+};
+
+// Tráfego observado por ID (do FrameTracker), para pesar o que passa a mais.
+struct TrafficSample {
+  uint32_t id;
+  bool extended;
+  float fps;
+};
+
+struct FilterEstimate {
+  float trafficFps = 0;    // Tudo o que foi observado no barramento
+  float passedFps = 0;     // O que o hardware deixaria passar
+  float wantedFps = 0;     // O que de fato interessa
+  uint32_t acceptedIds = 0;   // IDs aceitos pelo hardware (teto: soma das células)
+  uint32_t wantedIds = 0;
+};
+
+struct CanFilterPlan {
+  CanIdRange ranges[FILTER_MAX_RANGES + 1];   // + uma de includeFilterRange()
+  size_t rangeCount = 0;   // 0: aceita tudo
+  uint32_t masks[2] = {0, 0};
+  HardwareFilter filters[6];
+  FilterEstimate estimate;
+
+  bool acceptAll() const { return rangeCount == 0; }
+  // Filtro de software (faixas pedidas).
+  bool wants(uint32_t id, bool extended) const;
+  // O que o MCP2515 faria com esta configuração.
+  bool hardwarePasses(uint32_t id, bool extended) const;
+};
+
+// "7E8-7EF,201,18DAF100-18DAF1FF": hexadecimal, com até 3 dígitos é ID
+// padrão e com mais é estendido (como no candump). false em erro.
+bool parseFilterRanges(const char *text, CanFilterPlan &plan);
+
+// Acrescenta às faixas pedidas uma que o próprio firmware precisa (as
+// respostas OBD enquanto o poller roda). Nada muda se o plano aceita tudo
+// ou já cobre a faixa; false se a vaga extra já foi usada.
+bool includeFilterRange(CanFilterPlan &plan, const CanIdRange &range);
+
+// Máscaras e filtros que cobrem todas as faixas com o mínimo de tráfego
+// indesejado (e, no empate, de IDs aceitos a mais); preenche estimate.
+// Sem faixas, configura o "aceita tudo".
+void computeFilterPlan(CanFilterPlan &plan, const TrafficSample *traffic, size_t trafficCount);
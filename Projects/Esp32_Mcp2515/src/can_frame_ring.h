@@ -0,0 +1,70 @@
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+
+// Quadro CAN recebido, já sem os bits de flag que o mcp_can mistura no ID.
+struct CanFrame {
+  uint64_t timestampUs = 0;   // esp_timer_get_time() na leitura do MCP2515
+  uint32_t id = 0;
+  uint8_t len = 0;
+  bool extended = false;
+  bool rtr = false;
+  uint8_t data[8] = {0};
+};
+
+// Fila circular de quadros com um único produtor (tarefa de RX) e um único
+// consumidor (loop()), sem trava: cada lado só escreve no seu índice e lê o
+// do outro com acquire. Os índices correm livres e a posição é índice &
+// (CAPACITY - 1). Cheia, o quadro novo é descartado e contado em overflows().
+template <size_t CAPACITY>
+class CanFrameRing {
+  static_assert(CAPACITY > 0 && (CAPACITY & (CAPACITY - 1)) == 0, "CAPACITY precisa ser potencia de 2");
+
+public:
+  // Só o produtor.
+  bool push(const CanFrame &frame) {
+    const uint32_t head = head_.load(std::memory_order_relaxed);
+    const uint32_t tail = tail_.load(std::memory_order_acquire);
+    const uint32_t used = head - tail;
+    if (used >= CAPACITY) {
+      overflows_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+
+    frames_[head & (CAPACITY - 1)] = frame;
+    head_.store(head + 1, std::memory_order_release);
+    if (used + 1 > highWater_.load(std::memory_order_relaxed)) {
+      highWater_.store(used + 1, std::memory_order_relaxed);
+    }
+    return true;
+  }
+
+  // Só o consumidor.
+  bool pop(CanFrame &frame) {
+    const uint32_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail == head_.load(std::memory_order_acquire)) {
+      return false;
+    }
+
+    frame = frames_[tail & (CAPACITY - 1)];
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Leitura aproximada, para status. tail antes de head: nunca negativo.
+  size_t size() const {
+    const uint32_t tail = tail_.load(std::memory_order_acquire);
+    return head_.load(std::memory_order_acquire) - tail;
+  }
+  static constexpr size_t capacity() { return CAPACITY; }
+  size_t highWater() const { return highWater_.load(std::memory_order_relaxed); }
+  uint32_t overflows() const { return overflows_.load(std::memory_order_relaxed); }
+
+private:
+  CanFrame frames_[CAPACITY];
+  std::atomic<uint32_t> head_{0};   // Próximo a escrever (produtor)
+  std::atomic<uint32_t> tail_{0};   // Próximo a ler (consumidor)
+  std::atomic<uint32_t> highWater_{0};
+  std::atomic<uint32_t> overflows_{0};
+};
@@ -0,0 +1,102 @@
+#include "can_log_format.h"
+
+namespace {
+
+const char HEX_DIGITS[] = "0123456789ABCDEF";
+
+char *putHex(char *out, uint32_t value, uint8_t digits) {
+  for (int8_t i = digits - 1; i >= 0; i--) {
+    out[i] = HEX_DIGITS[value & 0x0F];
+    value >>= 4;
+  }
+  return out + digits;
+}
+
+// Decimal com zeros à esquerda até minDigits.
+char *putDecimal(char *out, uint64_t value, uint8_t minDigits) {
+  char digits[20];
+  uint8_t count = 0;
+  do {
+    digits[count++] = static_cast<char>('0' + value % 10);
+    value /= 10;
+  } while (value != 0);
+  while (count < minDigits) {
+    digits[count++] = '0';
+  }
+  while (count > 0) {
+    *out++ = digits[--count];
+  }
+  return out;
+}
+
+char *putText(char *out, const char *text) {
+  while (*text != '\0') {
+    *out++ = *text++;
+  }
+  return out;
+}
+
+} // namespace
+
+bool parseCanLogFormat(const char *name, CanLogFormat &format) {
+  if (strcmp(name, "candump") == 0) {
+    format = CanLogFormat::CANDUMP;
+    return true;
+  }
+  if (strcmp(name, "gvret") == 0) {
+    format = CanLogFormat::GVRET;
+    return true;
+  }
+  return false;
+}
+
+const char *canLogFileExtension(CanLogFormat format) {
+  return format == CanLogFormat::GVRET ? "csv" : "log";
+}
+
+const char *canLogHeader(CanLogFormat format) {
+  return format == CanLogFormat::GVRET ? "Time Stamp,ID,Extended,Dir,Bus,LEN,D1,D2,D3,D4,D5,D6,D7,D8\n" : "";
+}
+
+size_t formatCanLogLine(char *out, size_t size, CanLogFormat format, const CanFrame &frame) {
+  if (size < CAN_LOG_LINE_MAX) {
+    return 0;
+  }
+
+  const uint8_t len = frame.len > 8 ? 8 : frame.len;
+  char *p = out;
+
+  if (format == CanLogFormat::GVRET) {
+    p = putDecimal(p, frame.timestampUs, 1);
+    *p++ = ',';
+    p = putHex(p, frame.id, 8);
+    p = putText(p, frame.extended ? ",true,Rx,0," : ",false,Rx,0,");
+    *p++ = static_cast<char>('0' + len);
+    *p++ = ',';
+    for (uint8_t i = 0; !frame.rtr && i < len; i++) {
+      p = putHex(p, frame.data[i], 2);
+      *p++ = ',';
+    }
+  } else {
+    *p++ = '(';
+    p = putDecimal(p, frame.timestampUs / 1000000ULL, 10);
+    *p++ = '.';
+    p = putDecimal(p, frame.timestampUs % 1000000ULL, 6);
+    p = putText(p, ") can0 ");
+    p = putHex(p, frame.id, frame.extended ? 8 : 3);
+    *p++ = '#';
+    if (frame.rtr) {
+      *p++ = 'R';
+      if (len > 0) {
+        *p++ = static_cast<char>('0' + len);
+      }
+    } else {
+      for (uint8_t i = 0; i < len; i++) {
+        p = putHex(p, frame.data[i], 2);
+      }
+    }
+  }
+
+  *p++ = '\n';
+  return static_cast<size_t>(p - out);
+}
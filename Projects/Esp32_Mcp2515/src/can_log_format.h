@@ -0,0 +1,21 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "can_frame_ring.h"
+
+// Texto dos logs baixados da captura, gerado quadro a quadro:
+//   candump  (0000001234.567890) can0 18F01234#1122334455667788, "123#R3" em RTR
+//            (o formato de candump -l / canplayer)
+//   gvret    CSV do SavvyCAN: Time Stamp,ID,Extended,Dir,Bus,LEN,D1..D8
+// O tempo é o do esp_timer (µs desde o boot), não o relógio de parede.
+enum class CanLogFormat : uint8_t { CANDUMP, GVRET };
+
+constexpr size_t CAN_LOG_LINE_MAX = 72;   // Maior linha dos dois formatos, com '\n'
+
+bool parseCanLogFormat(const char *name, CanLogFormat &format);
+const char *canLogFileExtension(CanLogFormat format);
+// Primeira linha do arquivo ("" no candump).
+const char *canLogHeader(CanLogFormat format);
+// Escreve a linha (com '\n', sem '\0') e devolve o tamanho; 0 se size < CAN_LOG_LINE_MAX.
+size_t formatCanLogLine(char *out, size_t size, CanLogFormat format, const CanFrame &frame);
@@ -0,0 +1,106 @@
+#include "can_rx.h"
+
+#include <esp_timer.h>
+
+namespace {
+
+// Acima do loop() (1) e abaixo das tarefas de Wi-Fi/LwIP; no mesmo núcleo
+// do loop(), que ela interrompe quando chega quadro.
+constexpr UBaseType_t RX_TASK_PRIORITY = configMAX_PRIORITIES - 5;
+constexpr uint32_t RX_TASK_STACK = 3072;
+// Sem notificação, confere o MCP2515 mesmo assim: cobre uma borda perdida
+// (INT já baixo quando a interrupção foi ligada).
+constexpr uint32_t RX_IDLE_CHECK_MS = 20;
+
+constexpr unsigned long MCP_EXT_FLAG = 0x80000000UL;
+constexpr unsigned long MCP_RTR_FLAG = 0x40000000UL;
+
+MCP_CAN *canBus = nullptr;
+SemaphoreHandle_t spiMutex = nullptr;
+TaskHandle_t rxTaskHandle = nullptr;
+CanFrameRing<CAN_RX_RING_FRAMES> rxRing;
+volatile uint32_t rxWakeups = 0;
+
+void IRAM_ATTR onCanInterrupt() {
+  BaseType_t woken = pdFALSE;
+  vTaskNotifyGiveFromISR(rxTaskHandle, &woken);
+  if (woken == pdTRUE) {
+    portYIELD_FROM_ISR();
+  }
+}
+
+// Lê enquanto houver quadro em RXB0/RXB1 (readMsgBuf limpa o flag e o INT
+// sobe quando os dois esvaziam).
+void drainReceiveBuffers() {
+  canLock();
+  while (canBus->checkReceive() == CAN_MSGAVAIL) {
+    unsigned long rawId = 0;
+    CanFrame frame;
+    if (canBus->readMsgBuf(&rawId, &frame.len, frame.data) != CAN_OK) {
+      break;
+    }
+
+    frame.timestampUs = static_cast<uint64_t>(esp_timer_get_time());
+    frame.extended = (rawId & MCP_EXT_FLAG) != 0;
+    frame.rtr = (rawId & MCP_RTR_FLAG) != 0;
+    frame.id = rawId & 0x1FFFFFFFUL;
+    if (frame.len > 8) {
+      frame.len = 8;
+    }
+    rxRing.push(frame);
+  }
+  canUnlock();
+}
+
+void rxTask(void *) {
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(RX_IDLE_CHECK_MS));
+    rxWakeups = rxWakeups + 1;
+    drainReceiveBuffers();
+  }
+}
+
+} // namespace
+
+void canRxBegin(MCP_CAN &can, uint8_t intPin) {
+  canBus = &can;
+  spiMutex = xSemaphoreCreateMutex();
+  xTaskCreatePinnedToCore(rxTask, "can_rx", RX_TASK_STACK, nullptr, RX_TASK_PRIORITY, &rxTaskHandle,
+                          ARDUINO_RUNNING_CORE);
+
+  pinMode(intPin, INPUT_PULLUP);
+  attachInterrupt(digitalPinToInterrupt(intPin), onCanInterrupt, FALLING);
+}
+
+bool canRxPop(CanFrame &frame) {
+  return rxRing.pop(frame);
+}
+
+CanRxStats canRxStats() {
+  CanRxStats stats;
+  stats.used = rxRing.size();
+  stats.capacity = rxRing.capacity();
+  stats.highWater = rxRing.highWater();
+  stats.overflows = rxRing.overflows();
+  stats.wakeups = rxWakeups;
+  return stats;
+}
+
+byte canSend(uint32_t id, uint8_t ext, uint8_t len, uint8_t *data) {
+  canLock();
+  const byte status = canBus->sendMsgBuf(id, ext, len, data);
+  canUnlock();
+  return status;
+}
+
+void canLock() {
+  if (spiMutex != nullptr) {
+    xSemaphoreTake(spiMutex, portMAX_DELAY);
+  }
+}
+
+void canUnlock() {
+  if (spiMutex != nullptr) {
+    xSemaphoreGive(spiMutex);
+  }
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <Arduino.h>
+#include <mcp_can.h>
+
+#include "can_frame_ring.h"
+
+// Recepção do MCP2515 fora do loop(): a borda de descida do INT acorda uma
+// tarefa de prioridade alta, que esvazia os dois buffers de RX pelo SPI e
+// põe os quadros em CanFrameRing. O loop() consome com canRxPop() no seu
+// ritmo; HTTP ou Serial lentos só enchem a fila em vez de perder quadros.
+//
+// O SPI do MCP2515 passa a ter dois usuários (a tarefa e o loop()), então
+// todo acesso ao chip fora da tarefa deve passar por canSend() ou
+// canLock()/canUnlock().
+
+constexpr size_t CAN_RX_RING_FRAMES = 512;   // ~12 KB; ~60 ms de barramento cheio a 500 kbps
+
+struct CanRxStats {
+  size_t used;
+  size_t capacity;
+  size_t highWater;
+  uint32_t overflows;
+  uint32_t wakeups;   // Vezes que a tarefa acordou (INT ou timeout)
+};
+
+// Chamar depois de can.begin()/setMode().
+void canRxBegin(MCP_CAN &can, uint8_t intPin);
+bool canRxPop(CanFrame &frame);
+CanRxStats canRxStats();
+
+byte canSend(uint32_t id, uint8_t ext, uint8_t len, uint8_t *data);
+void canLock();
+void canUnlock();
@@ -0,0 +1,137 @@
+#include "frame_stream.h"
+
+bool FrameBatchEncoder::append(const CanFrame &frame, uint32_t seq) {
+  if (used_ + FRAME_BATCH_MAX_RECORD_BYTES > capacity_ || count_ == 0xFFFF) {
+    return false;
+  }
+
+  if (count_ == 0) {
+    lastUs_ = frame.timestampUs;
+    used_ = 4;
+    put32(seq);
+    put32(static_cast<uint32_t>(frame.timestampUs));
+    put32(static_cast<uint32_t>(frame.timestampUs >> 32));
+  }
+
+  const uint64_t delta = frame.timestampUs >= lastUs_ ? frame.timestampUs - lastUs_ : 0;
+  const bool longDelta = delta > 0xFFFF;
+  const uint8_t len = frame.len > 8 ? 8 : frame.len;
+
+  uint8_t flags = len;
+  if (frame.extended) {
+    flags |= FRAME_FLAG_EXT;
+  }
+  if (frame.rtr) {
+    flags |= FRAME_FLAG_RTR;
+  }
+  if (longDelta) {
+    flags |= FRAME_FLAG_LONG_DELTA;
+  }
+
+  buffer_[used_++] = flags;
+  if (longDelta) {
+    put32(delta > 0xFFFFFFFFULL ? 0xFFFFFFFFUL : static_cast<uint32_t>(delta));
+  } else {
+    put16(static_cast<uint16_t>(delta));
+  }
+  if (frame.extended) {
+    put32(frame.id);
+  } else {
+    put16(static_cast<uint16_t>(frame.id));
+  }
+  if (!frame.rtr) {
+    memcpy(buffer_ + used_, frame.data, len);
+    used_ += len;
+  }
+
+  lastUs_ = frame.timestampUs;
+  count_++;
+  return true;
+}
+
+void FrameBatchEncoder::attach(uint8_t *buffer, size_t capacity) {
+  buffer_ = buffer;
+  capacity_ = capacity;
+  reset();
+}
+
+void FrameBatchEncoder::reset() {
+  used_ = 0;
+  count_ = 0;
+  lastUs_ = 0;
+}
+
+uint8_t *FrameBatchEncoder::data() {
+  buffer_[0] = FRAME_BATCH_MAGIC;
+  buffer_[1] = FRAME_BATCH_VERSION;
+  buffer_[2] = static_cast<uint8_t>(count_);
+  buffer_[3] = static_cast<uint8_t>(count_ >> 8);
+  return buffer_;
+}
+
+void FrameBatchEncoder::put16(uint16_t value) {
+  buffer_[used_++] = static_cast<uint8_t>(value);
+  buffer_[used_++] = static_cast<uint8_t>(value >> 8);
+}
+
+void FrameBatchEncoder::put32(uint32_t value) {
+  put16(static_cast<uint16_t>(value));
+  put16(static_cast<uint16_t>(value >> 16));
+}
+
+bool FrameBatchReader::begin(const uint8_t *batch, size_t size) {
+  batch_ = batch;
+  size_ = size;
+  pos_ = FRAME_BATCH_HEADER_BYTES;
+  read_ = 0;
+  count_ = 0;
+  if (size < FRAME_BATCH_HEADER_BYTES || batch[0] != FRAME_BATCH_MAGIC || batch[1] != FRAME_BATCH_VERSION) {
+    return false;
+  }
+
+  count_ = get16(2);
+  seq_ = get32(4);
+  us_ = get32(8) | static_cast<uint64_t>(get32(12)) << 32;
+  return true;
+}
+
+bool FrameBatchReader::next(CanFrame &frame, uint32_t &seq) {
+  if (read_ >= count_ || pos_ + 5 > size_) {
+    return false;
+  }
+
+  const uint8_t flags = batch_[pos_];
+  const size_t deltaBytes = (flags & FRAME_FLAG_LONG_DELTA) ? 4 : 2;
+  const size_t idBytes = (flags & FRAME_FLAG_EXT) ? 4 : 2;
+  const uint8_t len = flags & 0x0F;
+  const size_t dataBytes = (flags & FRAME_FLAG_RTR) ? 0 : len;
+  if (len > 8 || pos_ + 1 + deltaBytes + idBytes + dataBytes > size_) {
+    return false;
+  }
+
+  pos_++;
+  us_ += deltaBytes == 4 ? get32(pos_) : get16(pos_);
+  pos_ += deltaBytes;
+  frame.id = idBytes == 4 ? get32(pos_) : get16(pos_);
+  pos_ += idBytes;
+
+  frame.timestampUs = us_;
+  frame.extended = (flags & FRAME_FLAG_EXT) != 0;
+  frame.rtr = (flags & FRAME_FLAG_RTR) != 0;
+  frame.len = len;
+  memset(frame.data, 0, sizeof(frame.data));
+  memcpy(frame.data, batch_ + pos_, dataBytes);
+  pos_ += dataBytes;
+
+  seq = seq_++;
+  read_++;
+  return true;
+}
+
+uint16_t FrameBatchReader::get16(size_t pos) const {
+  return static_cast<uint16_t>(batch_[pos] | batch_[pos + 1] << 8);
+}
+
+uint32_t FrameBatchReader::get32(size_t pos) const {
+  return get16(pos) | static_cast<uint32_t>(get16(pos + 2)) << 16;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "can_frame_ring.h"
+
+// Lotes binários de quadros: os do WebSocket da interface (porta 81) e os
+// blocos de 4 KB da captura em arquivo (can_capture.h). O decodificador do
+// navegador é decodeBatch() em web/index.html; mudou aqui, mude lá.
+//
+// Cabeçalho (16 bytes, little-endian):
+//   u8  0xCA (magic)   u8 versão (1)   u16 quantidade de registros
+//   u32 seq do primeiro registro (o mesmo de /api/frames)
+//   u64 instante de referência em µs (esp_timer); o delta do primeiro
+//       registro conta a partir dele
+// Registro (5 a 17 bytes):
+//   u8  flags: bits 0-3 DLC, bit 4 EXT, bit 5 RTR, bit 6 delta em u32
+//   u16 (ou u32) µs desde o registro anterior
+//   u16 ID padrão (ou u32 se EXT)
+//   DLC bytes de dados (nenhum em RTR)
+//
+// Um quadro padrão de 8 bytes ocupa 13 bytes, contra ~90 no JSON.
+constexpr uint8_t FRAME_BATCH_MAGIC = 0xCA;
+constexpr uint8_t FRAME_BATCH_VERSION = 1;
+constexpr size_t FRAME_BATCH_HEADER_BYTES = 16;
+constexpr size_t FRAME_BATCH_MAX_RECORD_BYTES = 17;
+constexpr size_t FRAME_BATCH_BYTES = 1436;   // Um segmento TCP (MSS do lwIP)
+constexpr uint32_t FRAME_BATCH_MAX_AGE_MS = 50;   // Lote não cheio sai depois disso
+
+constexpr uint8_t FRAME_FLAG_EXT = 0x10;
+constexpr uint8_t FRAME_FLAG_RTR = 0x20;
+constexpr uint8_t FRAME_FLAG_LONG_DELTA = 0x40;
+
+class FrameBatchEncoder {
+public:
+  FrameBatchEncoder(uint8_t *buffer, size_t capacity) { attach(buffer, capacity); }
+
+  // Troca o buffer (e esvazia o lote); capacity >= FRAME_BATCH_HEADER_BYTES.
+  void attach(uint8_t *buffer, size_t capacity);
+
+  // false se o lote estiver cheio: envie (data()/size()), reset() e repita.
+  bool append(const CanFrame &frame, uint32_t seq);
+  void reset();
+
+  bool empty() const { return count_ == 0; }
+  uint16_t count() const { return count_; }
+  // Lote pronto para enviar (cabeçalho preenchido). Não const porque o
+  // broadcastBIN() do WebSocketsServer pede uint8_t*.
+  uint8_t *data();
+  size_t size() const { return used_; }
+
+private:
+  uint8_t *buffer_;
+  size_t capacity_;
+  size_t used_;
+  uint16_t count_;
+  uint64_t lastUs_;
+
+  void put16(uint16_t value);
+  void put32(uint32_t value);
+};
+
+// Lê um lote de volta (captura em arquivo, bench); espelho do decodeBatch().
+class FrameBatchReader {
+public:
+  // false se não for um lote desta versão. Bytes depois do último registro
+  // (o preenchimento dos blocos da captura) são ignorados.
+  bool begin(const uint8_t *batch, size_t size);
+  // false no fim do lote ou se um registro passar do tamanho.
+  bool next(CanFrame &frame, uint32_t &seq);
+
+  uint16_t count() const { return count_; }
+
+private:
+  const uint8_t *batch_ = nullptr;
+  size_t size_ = 0;
+  size_t pos_ = 0;
+  uint16_t count_ = 0;
+  uint16_t read_ = 0;
+  uint32_t seq_ = 0;
+  uint64_t us_ = 0;
+
+  uint16_t get16(size_t pos) const;
+  uint32_t get32(size_t pos) const;
+};
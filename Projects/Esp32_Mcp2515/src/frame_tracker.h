@@ -0,0 +1,219 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "can_frame_ring.h"
+
+constexpr uint32_t TRACKER_EXT_BIT = 0x80000000UL;
+
+// Estado por ID de CAN para o filtro de mudanças e para análise da rede.
+struct TrackedFrame {
+  uint32_t key = 0;             // ID | TRACKER_EXT_BIT se estendido
+  uint32_t hash = 0;
+  uint32_t count = 0;           // Quadros vistos
+  uint32_t lastSeenUs = 0;      // 32 bits bastam para a diferença entre quadros
+  uint32_t periodUs = 0;        // Média móvel (1/8) do intervalo entre quadros
+  uint32_t lastPrintMs = 0;     // Usado pelo filtro de mudanças do main.cpp
+  uint8_t len = 0;
+  uint8_t data[8] = {0};
+  uint8_t changedMask = 0;      // Bytes que mudaram no último quadro (bit i = data[i])
+  uint8_t activeMask = 0;       // Bytes que já mudaram alguma vez
+  uint16_t newer = 0;           // Lista LRU (índices em entries_)
+  uint16_t older = 0;
+
+  uint32_t id() const { return key & ~TRACKER_EXT_BIT; }
+  bool extended() const { return (key & TRACKER_EXT_BIT) != 0; }
+};
+
+enum class FrameChange : uint8_t { NEW_ID, CHANGED, SAME };
+
+// Tabela de IDs com endereçamento aberto (sondagem linear, 2x CAPACITY
+// posições, então no máximo meio cheia) sobre um pool fixo de entradas.
+// observe() é O(1): acha ou cria a entrada e a põe no topo da lista LRU.
+// Cheia, o ID visto há mais tempo sai (remoção por deslocamento para trás,
+// sem lápides), então IDs novos nunca escapam do filtro.
+template <size_t CAPACITY>
+class FrameTracker {
+  static_assert(CAPACITY >= 2 && CAPACITY <= 16384 && (CAPACITY & (CAPACITY - 1)) == 0,
+                "CAPACITY precisa ser potencia de 2 entre 2 e 16384");
+
+public:
+  FrameTracker() { clear(); }
+
+  void clear() {
+    for (uint16_t &slot : slots_) {
+      slot = NONE;
+    }
+    size_ = 0;
+    newest_ = NONE;
+    oldest_ = NONE;
+  }
+
+  TrackedFrame &observe(const CanFrame &frame, FrameChange &change) {
+    const uint32_t key = frame.id | (frame.extended ? TRACKER_EXT_BIT : 0);
+    const uint32_t hash = hashKey(key);
+    const uint32_t nowUs = static_cast<uint32_t>(frame.timestampUs);
+
+    size_t slot = hash & SLOT_MASK;
+    while (slots_[slot] != NONE) {
+      TrackedFrame &entry = entries_[slots_[slot]];
+      if (entry.key == key) {
+        update(entry, frame, nowUs, change);
+        touch(slots_[slot]);
+        return entry;
+      }
+      slot = (slot + 1) & SLOT_MASK;
+    }
+
+    uint16_t index = 0;
+    if (size_ < CAPACITY) {
+      index = static_cast<uint16_t>(size_++);
+    } else {
+      index = oldest_;
+      unlink(index);
+      eraseSlot(index);
+      evictions_++;
+      // A remoção pode ter deslocado a cadeia: procura a posição livre de novo.
+      slot = hash & SLOT_MASK;
+      while (slots_[slot] != NONE) {
+        slot = (slot + 1) & SLOT_MASK;
+      }
+    }
+
+    TrackedFrame &entry = entries_[index];
+    entry = TrackedFrame();
+    entry.key = key;
+    entry.hash = hash;
+    entry.count = 1;
+    entry.lastSeenUs = nowUs;
+    entry.len = frame.len;
+    memcpy(entry.data, frame.data, frame.len);
+    slots_[slot] = index;
+    pushNewest(index);
+    change = FrameChange::NEW_ID;
+    return entry;
+  }
+
+  const TrackedFrame *find(uint32_t id, bool extended) const {
+    const uint32_t key = id | (extended ? TRACKER_EXT_BIT : 0);
+    for (size_t slot = hashKey(key) & SLOT_MASK; slots_[slot] != NONE; slot = (slot + 1) & SLOT_MASK) {
+      if (entries_[slots_[slot]].key == key) {
+        return &entries_[slots_[slot]];
+      }
+    }
+    return nullptr;
+  }
+
+  // Do visto mais recentemente ao mais antigo.
+  template <typename Fn>
+  void forEachRecent(Fn fn) const {
+    for (uint16_t index = newest_; index != NONE; index = entries_[index].older) {
+      fn(entries_[index]);
+    }
+  }
+
+  size_t size() const { return size_; }
+  static constexpr size_t capacity() { return CAPACITY; }
+  uint32_t evictions() const { return evictions_; }
+
+private:
+  static constexpr uint16_t NONE = 0xFFFF;
+  static constexpr size_t SLOT_COUNT = CAPACITY * 2;
+  static constexpr size_t SLOT_MASK = SLOT_COUNT - 1;
+
+  TrackedFrame entries_[CAPACITY];
+  uint16_t slots_[SLOT_COUNT];
+  size_t size_ = 0;
+  uint16_t newest_ = NONE;
+  uint16_t oldest_ = NONE;
+  uint32_t evictions_ = 0;
+
+  // Multiplicativo (Fibonacci) com a metade alta dobrada sobre a baixa:
+  // IDs que só diferem nos bits altos (0x100, 0x200...) não colidem.
+  static uint32_t hashKey(uint32_t key) {
+    const uint32_t h = key * 2654435769UL;
+    return h ^ (h >> 16);
+  }
+
+  static void update(TrackedFrame &entry, const CanFrame &frame, uint32_t nowUs, FrameChange &change) {
+    const uint32_t interval = nowUs - entry.lastSeenUs;
+    entry.periodUs = entry.count == 1 ? interval
+                                      : static_cast<uint32_t>(static_cast<int32_t>(entry.periodUs) +
+                                                              (static_cast<int32_t>(interval - entry.periodUs) >> 3));
+    entry.lastSeenUs = nowUs;
+    entry.count++;
+
+    uint8_t mask = 0;
+    for (uint8_t i = 0; i < 8; i++) {
+      const uint8_t previous = i < entry.len ? entry.data[i] : 0;
+      const uint8_t current = i < frame.len ? frame.data[i] : 0;
+      if (previous != current || (i < entry.len) != (i < frame.len)) {
+        mask |= 1 << i;
+      }
+    }
+
+    change = mask != 0 ? FrameChange::CHANGED : FrameChange::SAME;
+    entry.changedMask = mask;
+    entry.activeMask |= mask;
+    entry.len = frame.len;
+    memcpy(entry.data, frame.data, frame.len);
+  }
+
+  void touch(uint16_t index) {
+    if (index != newest_) {
+      unlink(index);
+      pushNewest(index);
+    }
+  }
+
+  void pushNewest(uint16_t index) {
+    entries_[index].newer = NONE;
+    entries_[index].older = newest_;
+    if (newest_ != NONE) {
+      entries_[newest_].newer = index;
+    }
+    newest_ = index;
+    if (oldest_ == NONE) {
+      oldest_ = index;
+    }
+  }
+
+  void unlink(uint16_t index) {
+    TrackedFrame &entry = entries_[index];
+    if (entry.newer != NONE) {
+      entries_[entry.newer].older = entry.older;
+    } else {
+      newest_ = entry.older;
+    }
+    if (entry.older != NONE) {
+      entries_[entry.older].newer = entry.newer;
+    } else {
+      oldest_ = entry.newer;
+    }
+  }
+
+  // Tira a entrada da tabela e puxa para trás os seguintes da cadeia que
+  // ficariam inalcançáveis.
+  void eraseSlot(uint16_t index) {
+    size_t hole = entries_[index].hash & SLOT_MASK;
+    while (slots_[hole] != index) {
+      hole = (hole + 1) & SLOT_MASK;
+    }
+
+    size_t next = hole;
+    for (;;) {
+      next = (next + 1) & SLOT_MASK;
+      if (slots_[next] == NONE) {
+        break;
+      }
+      const size_t home = entries_[slots_[next]].hash & SLOT_MASK;
+      // Move se a posição de origem não estiver em (hole, next] circular.
+      const bool between = hole <= next ? (home > hole && home <= next) : (home > hole || home <= next);
+      if (!between) {
+        slots_[hole] = slots_[next];
+        hole = next;
+      }
+    }
+    slots_[hole] = NONE;
+  }
+};
@@ -0,0 +1,79 @@
+#include "iso_tp.h"
+
+IsoTpEvent IsoTpReceiver::feed(const uint8_t *data, uint8_t len, uint32_t nowMs) {
+  if (len == 0) {
+    return IsoTpEvent::NONE;
+  }
+  if (active_ && nowMs - lastFrameMs_ > ISOTP_N_CR_MS) {
+    reset();
+  }
+
+  switch (data[0] >> 4) {
+    case 0x0: {   // Single Frame
+      const size_t size = data[0] & 0x0F;
+      if (size == 0 || size + 1 > len) {
+        return IsoTpEvent::ERROR;
+      }
+      active_ = false;
+      memcpy(buffer_, data + 1, size);
+      expected_ = size;
+      received_ = size;
+      return IsoTpEvent::COMPLETE;
+    }
+
+    case 0x1: {   // First Frame
+      const size_t size = (static_cast<size_t>(data[0] & 0x0F) << 8) | (len > 1 ? data[1] : 0);
+      if (len < 8 || size < 8 || size > ISOTP_MAX_PAYLOAD) {
+        reset();
+        return IsoTpEvent::ERROR;
+      }
+      memcpy(buffer_, data + 2, 6);
+      expected_ = size;
+      received_ = 6;
+      nextSn_ = 1;
+      active_ = true;
+      lastFrameMs_ = nowMs;
+      return IsoTpEvent::FIRST_FRAME;
+    }
+
+    case 0x2: {   // Consecutive Frame
+      if (!active_) {
+        return IsoTpEvent::NONE;
+      }
+      if ((data[0] & 0x0F) != nextSn_) {
+        reset();
+        return IsoTpEvent::ERROR;
+      }
+      size_t chunk = expected_ - received_;
+      chunk = chunk > 7 ? 7 : chunk;
+      if (static_cast<size_t>(len - 1) < chunk) {
+        reset();
+        return IsoTpEvent::ERROR;
+      }
+      memcpy(buffer_ + received_, data + 1, chunk);
+      received_ += chunk;
+      nextSn_ = (nextSn_ + 1) & 0x0F;
+      lastFrameMs_ = nowMs;
+      if (received_ < expected_) {
+        return IsoTpEvent::NONE;
+      }
+      active_ = false;
+      return IsoTpEvent::COMPLETE;
+    }
+
+    default:      // Flow Control de outra conversa
+      return IsoTpEvent::NONE;
+  }
+}
+
+void IsoTpReceiver::reset() {
+  expected_ = 0;
+  received_ = 0;
+  nextSn_ = 0;
+  active_ = false;
+}
+
+void IsoTpReceiver::flowControl(uint8_t frame[8]) {
+  memset(frame, 0, 8);
+  frame[0] = 0x30;
+}
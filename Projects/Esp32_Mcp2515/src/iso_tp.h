@@ -0,0 +1,39 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Recepção ISO-TP (ISO 15765-2) de uma ECU: junta First Frame e
+// Consecutive Frames de uma resposta maior que 7 bytes. Quem chama manda o
+// Flow Control (flowControl()) quando feed() devolve FIRST_FRAME; a ECU só
+// continua depois dele.
+
+constexpr size_t ISOTP_MAX_PAYLOAD = 64;      // 6 PIDs com 4 bytes cabem em 31
+constexpr uint32_t ISOTP_N_CR_MS = 150;       // Espera máxima por um CF (N_Cr)
+
+enum class IsoTpEvent : uint8_t {
+  NONE,          // Nada a fazer (CF no meio, quadro alheio)
+  FIRST_FRAME,   // Mandar o Flow Control
+  COMPLETE,      // payload() pronto
+  ERROR          // Sequência quebrada ou tamanho inválido; transferência descartada
+};
+
+class IsoTpReceiver {
+public:
+  IsoTpEvent feed(const uint8_t *data, uint8_t len, uint32_t nowMs);
+  void reset();
+
+  bool active() const { return active_; }
+  const uint8_t *payload() const { return buffer_; }
+  size_t length() const { return expected_; }
+
+  // "Pode mandar tudo": BS=0 (sem novo FC) e STmin=0.
+  static void flowControl(uint8_t frame[8]);
+
+private:
+  uint8_t buffer_[ISOTP_MAX_PAYLOAD];
+  size_t expected_ = 0;
+  size_t received_ = 0;
+  uint8_t nextSn_ = 0;
+  bool active_ = false;
+  uint32_t lastFrameMs_ = 0;
+};
@@ -1,8 +1,21 @@
 #include <Arduino.h>
 #include <SPI.h>
+#include <LittleFS.h>
 #include <WiFi.h>
 #include <WebServer.h>
+#include <WebSocketsServer.h>
 #include <mcp_can.h>
+#include <JsonResponse.h>
+#include <esp_timer.h>
+#include "can_capture.h"
+#include "can_filter_plan.h"
+#include "can_log_format.h"
+#include "can_rx.h"
+#include "frame_stream.h"
+#include "frame_tracker.h"
+#include "obd_pids.h"
+#include "obd_poller.h"
+#include "web_assets.h"
 #include <cctype>
 #include <cstring>
 #include <cstdlib>
@@ -26,42 +39,16 @@ constexpr char WIFI_AP_SSID[] = "ESP32-CAN-Hacker";
 constexpr char WIFI_AP_PASS[] = "12345678";
 
 constexpr uint32_t WIFI_CONNECT_TIMEOUT_MS = 12000;
-constexpr uint32_t OBD_REQUEST_INTERVAL_MS = 350;
 constexpr uint32_t DASHBOARD_INTERVAL_MS = 1000;
 constexpr uint32_t RAW_REPRINT_MS = 500;
-constexpr size_t MAX_TRACKED_IDS = 32;
+constexpr size_t MAX_TRACKED_IDS = 512;           // potência de 2; ~22 KB de RAM (FrameTracker)
 constexpr size_t MAX_LOGGED_FRAMES = 180;
+constexpr uint16_t FRAME_SOCKET_PORT = 81;       // Lotes binários de quadros (frame_stream.h)
 
 MCP_CAN CAN(CAN_CS_PIN);
+fs::FS &captureStorage = LittleFS;               // troque por SD (SD.begin() no setup) para capturas longas
 WebServer server(80);
-
-struct LiveData {
-  bool rpmValid = false;
-  bool speedValid = false;
-  bool coolantValid = false;
-  bool throttleValid = false;
-  bool loadValid = false;
-  bool fuelValid = false;
-  bool intakeValid = false;
-
-  float rpm = 0.0f;
-  uint8_t speed = 0;
-  int coolant = 0;
-  float throttle = 0.0f;
-  float engineLoad = 0.0f;
-  float fuelLevel = 0.0f;
-  int intakeTemp = 0;
-
-  uint32_t lastResponseMs = 0;
-} liveData;
-
-struct FrameTracker {
-  bool used = false;
-  uint32_t id = 0;
-  uint8_t len = 0;
-  uint8_t data[8] = {0};
-  uint32_t lastPrintMs = 0;
-};
+WebSocketsServer frameSocket(FRAME_SOCKET_PORT);
 
 struct FrameLogEntry {
   uint32_t seq = 0;
@@ -73,181 +60,30 @@ struct FrameLogEntry {
   uint8_t data[8] = {0};
 };
 
-FrameTracker trackedFrames[MAX_TRACKED_IDS];
+LiveData liveData;
+ObdPoller obdPoller(liveData);                   // Pedidos de até 6 PIDs, ritmo pelo tempo de resposta
+FrameTracker<MAX_TRACKED_IDS> frameTracker;
+CanFilterPlan filterPlan;                        // Aplicado no MCP2515; sem faixas aceita tudo
+CanFilterPlan requestedFilter;                   // Só as faixas pedidas em /api/filters
+TrafficSample trafficSamples[MAX_TRACKED_IDS];
 FrameLogEntry frameLog[MAX_LOGGED_FRAMES];
+uint8_t frameBatchBuffer[FRAME_BATCH_BYTES];
+FrameBatchEncoder frameBatch(frameBatchBuffer, sizeof(frameBatchBuffer));
 
 bool rawOutputEnabled = true;
 bool printOnlyChangedFrames = true;
 bool obdPollingEnabled = true;
 uint32_t rxFrameCount = 0;
-uint32_t lastObdRequestMs = 0;
 uint32_t lastObdErrorMs = 0;
 uint32_t lastDashboardMs = 0;
 uint32_t frameSequence = 0;
-size_t nextPidIndex = 0;
 size_t frameLogHead = 0;
 size_t frameLogCount = 0;
-
-const uint8_t obdPidList[] = {
-  0x0C, // RPM
-  0x0D, // velocidade
-  0x05, // temperatura do motor
-  0x11, // throttle
-  0x04, // carga do motor
-  0x2F, // combustível
-  0x0F  // temperatura do ar de admissão
-};
-
-const char INDEX_HTML[] PROGMEM = R"HTML(
-<!DOCTYPE html>
-<html lang="pt-BR">
-<head>
-  <meta charset="utf-8">
-  <meta name="viewport" content="width=device-width,initial-scale=1">
-  <title>ESP32 CAN Hacker</title>
-  <style>
-    :root{--bg:#0b1020;--card:#131a2e;--line:#24304d;--text:#e8f1ff;--accent:#39d98a;--warn:#ffb020}
-    *{box-sizing:border-box}body{margin:0;background:var(--bg);color:var(--text);font-family:Arial,sans-serif}
-    .wrap{max-width:1200px;margin:auto;padding:16px}.title{display:flex;justify-content:space-between;gap:10px;flex-wrap:wrap;align-items:center}
-    .muted{color:#9eb2d2}.grid{display:grid;grid-template-columns:repeat(auto-fit,minmax(155px,1fr));gap:10px;margin:14px 0}
-    .card{background:var(--card);border:1px solid var(--line);border-radius:12px;padding:12px}.card strong{display:block;font-size:1.3rem;margin-top:6px;color:var(--accent)}
-    .panel{background:var(--card);border:1px solid var(--line);border-radius:12px;padding:12px;margin:10px 0}
-    button{background:#1c2742;color:var(--text);border:1px solid #35508a;border-radius:10px;padding:9px 12px;cursor:pointer}
-    button:hover{background:#24345d}input{background:#09101d;color:var(--text);border:1px solid #30476d;border-radius:8px;padding:9px;width:100%}
-    .controls,.send{display:grid;grid-template-columns:repeat(auto-fit,minmax(140px,1fr));gap:8px}.send{align-items:end}
-    table{width:100%;border-collapse:collapse;font-size:.92rem}th,td{padding:8px;border-bottom:1px solid #1f2c47;text-align:left}thead{position:sticky;top:0;background:#0e1730}
-    .table-wrap{max-height:420px;overflow:auto}.ok{color:var(--accent)}.warn{color:var(--warn)}code{color:#8fe3ff}
-  </style>
-</head>
-<body>
-  <div class="wrap">
-    <div class="title">
-      <div>
-        <h1>ESP32 CAN Hacker Web</h1>
-        <div class="muted">Sniffer CAN/OBD-II estilo CAN Hacker via navegador</div>
-      </div>
-      <div class="muted" id="wifiInfo">Carregando...</div>
-    </div>
-
-    <div class="grid">
-      <div class="card"><span>Frames RX</span><strong id="rxCount">0</strong></div>
-      <div class="card"><span>RPM</span><strong id="rpm">--</strong></div>
-      <div class="card"><span>Velocidade</span><strong id="speed">--</strong></div>
-      <div class="card"><span>Temp. motor</span><strong id="coolant">--</strong></div>
-      <div class="card"><span>Throttle</span><strong id="throttle">--</strong></div>
-      <div class="card"><span>Combustível</span><strong id="fuel">--</strong></div>
-    </div>
-
-    <div class="panel">
-      <div class="controls">
-        <button onclick="toggleFlag('raw')">Alternar RAW serial</button>
-        <button onclick="toggleFlag('changes')">Somente mudanças</button>
-        <button onclick="toggleFlag('obd')">OBD polling</button>
-        <button onclick="clearFrames()">Limpar buffer</button>
-        <button id="pauseBtn" onclick="togglePause()">Pausar captura</button>
-        <input id="idFilter" placeholder="Filtrar ID (ex: 7E8)">
-      </div>
-      <p class="muted" id="statusLine">Lendo status...</p>
-    </div>
-
-    <div class="panel">
-      <h3>Enviar frame CAN manual</h3>
-      <form class="send" onsubmit="sendFrame(event)">
-        <div><label>ID hex</label><input id="txId" value="7DF" maxlength="8"></div>
-        <div><label>Dados hex</label><input id="txData" value="02 01 0C 00 00 00 00 00"></div>
-        <div><label>Frame</label><input id="txType" value="0 = padrão / 1 = estendido"></div>
-        <div><button type="submit">Enviar</button></div>
-      </form>
-      <p class="muted">Aceita formatos como <code>11 22 33 AA</code> ou <code>112233AA</code>.</p>
-    </div>
-
-    <div class="panel table-wrap">
-      <table>
-        <thead><tr><th>#</th><th>Tempo</th><th>ID</th><th>Tipo</th><th>DLC</th><th>Dados</th></tr></thead>
-        <tbody id="frames"></tbody>
-      </table>
-    </div>
-  </div>
-
-<script>
-let lastSeq = 0;
-let paused = false;
-
-function val(valid, value, suffix='') { return valid ? `${value}${suffix}` : '--'; }
-
-function applyFilter() {
-  const filter = document.getElementById('idFilter').value.trim().toUpperCase();
-  document.querySelectorAll('#frames tr').forEach((row) => {
-    row.style.display = !filter || row.dataset.id.includes(filter) ? '' : 'none';
-  });
-}
-
-function addFrameRow(frame) {
-  const tbody = document.getElementById('frames');
-  const row = document.createElement('tr');
-  row.dataset.id = frame.id.toUpperCase();
-  row.innerHTML = `<td>${frame.seq}</td><td>${frame.ts} ms</td><td>${frame.id}</td><td>${frame.type}</td><td>${frame.dlc}</td><td><code>${frame.data || '--'}</code></td>`;
-  tbody.prepend(row);
-  while (tbody.children.length > 250) tbody.removeChild(tbody.lastChild);
-}
-
-async function refreshStatus() {
-  const resp = await fetch('/api/status');
-  const s = await resp.json();
-  document.getElementById('rxCount').textContent = s.rxCount;
-  document.getElementById('rpm').textContent = val(s.rpmValid, s.rpm.toFixed(0), ' rpm');
-  document.getElementById('speed').textContent = val(s.speedValid, s.speed, ' km/h');
-  document.getElementById('coolant').textContent = val(s.coolantValid, s.coolant, ' °C');
-  document.getElementById('throttle').textContent = val(s.throttleValid, s.throttle.toFixed(1), ' %');
-  document.getElementById('fuel').textContent = val(s.fuelValid, s.fuel.toFixed(1), ' %');
-  document.getElementById('wifiInfo').textContent = s.wifi;
-  document.getElementById('statusLine').innerHTML = `RAW: <b>${s.rawEnabled ? 'on' : 'off'}</b> | Mudanças: <b>${s.onlyChanges ? 'on' : 'off'}</b> | OBD: <b>${s.obdEnabled ? 'on' : 'off'}</b> | CAN: <b>${s.canProfile}</b>`;
-}
-
-async function refreshFrames() {
-  if (paused) return;
-  const resp = await fetch(`/api/frames?since=${lastSeq}`);
-  const payload = await resp.json();
-  (payload.frames || []).forEach(addFrameRow);
-  lastSeq = payload.lastSeq || lastSeq;
-  applyFilter();
-}
-
-async function toggleFlag(name) {
-  await fetch(`/api/toggle?name=${name}`);
-  refreshStatus();
-}
-
-async function clearFrames() {
-  await fetch('/api/clear');
-  document.getElementById('frames').innerHTML = '';
-  lastSeq = 0;
-}
-
-function togglePause() {
-  paused = !paused;
-  document.getElementById('pauseBtn').textContent = paused ? 'Retomar captura' : 'Pausar captura';
-}
-
-async function sendFrame(event) {
-  event.preventDefault();
-  const id = document.getElementById('txId').value.trim();
-  const data = document.getElementById('txData').value.trim();
-  const ext = document.getElementById('txType').value.trim() === '1' ? '1' : '0';
-  const resp = await fetch(`/api/send?id=${encodeURIComponent(id)}&data=${encodeURIComponent(data)}&ext=${ext}`);
-  const result = await resp.json();
-  alert(result.message || (result.ok ? 'Frame enviado.' : 'Falha ao enviar.'));
-}
-
-document.getElementById('idFilter').addEventListener('input', applyFilter);
-setInterval(refreshStatus, 1000);
-setInterval(refreshFrames, 250);
-refreshStatus();
-refreshFrames();
-</script>
-</body>
-</html>
-)HTML";
+uint32_t frameBatchStartMs = 0;
+uint32_t streamedBatches = 0;
+uint32_t streamFailures = 0;
+uint32_t filterHwFrames = 0;
+uint32_t filterSwAccepted = 0;
 
 void printHexByte(uint8_t value) {
   if (value < 0x10) {
@@ -256,49 +92,55 @@ void printHexByte(uint8_t value) {
   Serial.print(value, HEX);
 }
 
-String formatCanId(uint32_t id, bool extended) {
-  char buffer[12] = {0};
-  snprintf(buffer, sizeof(buffer), extended ? "0x%08lX" : "0x%03lX", static_cast<unsigned long>(id));
-  return String(buffer);
+// Versões em buffer (sem String) para o JSON; out precisa de 12 e 24 bytes.
+void formatCanIdTo(char *out, size_t size, uint32_t id, bool extended) {
+  snprintf(out, size, extended ? "0x%08lX" : "0x%03lX", static_cast<unsigned long>(id));
 }
 
-String formatDataBytes(const uint8_t *data, uint8_t len) {
-  String text;
-  text.reserve(24);
+void formatDataBytesTo(char *out, size_t size, const uint8_t *data, uint8_t len) {
+  static const char HEX_DIGITS[] = "0123456789ABCDEF";
+  size_t pos = 0;
 
-  for (uint8_t i = 0; i < len; i++) {
-    if (data[i] < 0x10) {
-      text += '0';
-    }
-    text += String(data[i], HEX);
-    text.toUpperCase();
-    if (i + 1 < len) {
-      text += ' ';
+  for (uint8_t i = 0; i < len && pos + 3 < size; i++) {
+    if (i > 0) {
+      out[pos++] = ' ';
     }
+    out[pos++] = HEX_DIGITS[data[i] >> 4];
+    out[pos++] = HEX_DIGITS[data[i] & 0x0F];
   }
 
-  return text;
+  out[pos] = '\0';
 }
 
-String jsonBool(bool value) {
-  return value ? "true" : "false";
+String formatCanId(uint32_t id, bool extended) {
+  char buffer[12] = {0};
+  formatCanIdTo(buffer, sizeof(buffer), id, extended);
+  return String(buffer);
 }
 
-String wifiSummary() {
-  String text = "AP: ";
-  text += WIFI_AP_SSID;
-  text += " -> http://";
-  text += WiFi.softAPIP().toString();
+String formatDataBytes(const uint8_t *data, uint8_t len) {
+  char buffer[24] = {0};
+  formatDataBytesTo(buffer, sizeof(buffer), data, len);
+  return String(buffer);
+}
+
+void formatWifiSummaryTo(char *out, size_t size) {
+  const IPAddress ap = WiFi.softAPIP();
+  int pos = snprintf(out, size, "AP: %s -> http://%u.%u.%u.%u", WIFI_AP_SSID, ap[0], ap[1], ap[2], ap[3]);
 
-  if (WiFi.status() == WL_CONNECTED) {
-    text += " | STA: ";
-    text += WiFi.localIP().toString();
+  if (WiFi.status() == WL_CONNECTED && pos > 0 && static_cast<size_t>(pos) < size) {
+    const IPAddress sta = WiFi.localIP();
+    snprintf(out + pos, size - pos, " | STA: %u.%u.%u.%u", sta[0], sta[1], sta[2], sta[3]);
   }
+}
 
-  return text;
+String wifiSummary() {
+  char buffer[80] = {0};
+  formatWifiSummaryTo(buffer, sizeof(buffer));
+  return String(buffer);
 }
 
-void logFrame(uint32_t id, bool extended, bool rtr, uint8_t len, const uint8_t *data) {
+void logFrame(const CanFrame &frame) {
   size_t index = 0;
 
   if (frameLogCount < MAX_LOGGED_FRAMES) {
@@ -311,13 +153,13 @@ void logFrame(uint32_t id, bool extended, bool rtr, uint8_t len, const uint8_t *
 
   FrameLogEntry &entry = frameLog[index];
   entry.seq = ++frameSequence;
-  entry.timestampMs = millis();
-  entry.id = id;
-  entry.extended = extended;
-  entry.rtr = rtr;
-  entry.len = len;
+  entry.timestampMs = static_cast<uint32_t>(frame.timestampUs / 1000);
+  entry.id = frame.id;
+  entry.extended = frame.extended;
+  entry.rtr = frame.rtr;
+  entry.len = frame.len;
   memset(entry.data, 0, sizeof(entry.data));
-  memcpy(entry.data, data, len);
+  memcpy(entry.data, frame.data, frame.len);
 }
 
 void clearFrameLog() {
@@ -332,39 +174,19 @@ void printFrame(uint32_t id, bool extended, uint8_t len, const uint8_t *data) {
                 formatDataBytes(data, len).c_str());
 }
 
-bool shouldPrintFrame(uint32_t id, uint8_t len, const uint8_t *data) {
+// ID novo ou dado diferente do último quadro imprime na hora; repetido só
+// a cada RAW_REPRINT_MS.
+bool shouldPrintFrame(TrackedFrame &tracked, FrameChange change) {
   const uint32_t now = millis();
-
-  for (FrameTracker &tracker : trackedFrames) {
-    if (tracker.used && tracker.id == id) {
-      const bool changed = (tracker.len != len) || (memcmp(tracker.data, data, len) != 0);
-      if (changed || (now - tracker.lastPrintMs >= RAW_REPRINT_MS)) {
-        tracker.len = len;
-        memcpy(tracker.data, data, len);
-        tracker.lastPrintMs = now;
-        return true;
-      }
-      return false;
-    }
-  }
-
-  for (FrameTracker &tracker : trackedFrames) {
-    if (!tracker.used) {
-      tracker.used = true;
-      tracker.id = id;
-      tracker.len = len;
-      memcpy(tracker.data, data, len);
-      tracker.lastPrintMs = now;
-      return true;
-    }
+  if (change != FrameChange::SAME || now - tracked.lastPrintMs >= RAW_REPRINT_MS) {
+    tracked.lastPrintMs = now;
+    return true;
   }
-
-  return true;
+  return false;
 }
 
-void sendObdRequest(uint8_t pid) {
-  uint8_t request[8] = {0x02, 0x01, pid, 0x00, 0x00, 0x00, 0x00, 0x00};
-  const byte status = CAN.sendMsgBuf(0x7DF, 0, 8, request);
+void sendObdFrame(uint32_t id, uint8_t *frame) {
+  const byte status = canSend(id, 0, 8, frame);
 
   if (status != CAN_OK) {
     const uint32_t now = millis();
@@ -375,58 +197,16 @@ void sendObdRequest(uint8_t pid) {
   }
 }
 
-void decodeObdFrame(uint32_t id, uint8_t len, const uint8_t *data) {
-  if (id < 0x7E8 || id > 0x7EF || len < 4) {
+// Respostas 0x7E8-0x7EF; o Flow Control vai logo, a ECU espera por ele.
+void decodeObdFrame(const CanFrame &frame) {
+  if (frame.extended || frame.rtr) {
     return;
   }
 
-  if (data[1] != 0x41) {
-    return;
-  }
-
-  const uint8_t pid = data[2];
-  liveData.lastResponseMs = millis();
-
-  switch (pid) {
-    case 0x0C:
-      if (len >= 5) {
-        liveData.rpm = ((data[3] * 256.0f) + data[4]) / 4.0f;
-        liveData.rpmValid = true;
-      }
-      break;
-
-    case 0x0D:
-      liveData.speed = data[3];
-      liveData.speedValid = true;
-      break;
-
-    case 0x05:
-      liveData.coolant = static_cast<int>(data[3]) - 40;
-      liveData.coolantValid = true;
-      break;
-
-    case 0x11:
-      liveData.throttle = (data[3] * 100.0f) / 255.0f;
-      liveData.throttleValid = true;
-      break;
-
-    case 0x04:
-      liveData.engineLoad = (data[3] * 100.0f) / 255.0f;
-      liveData.loadValid = true;
-      break;
-
-    case 0x2F:
-      liveData.fuelLevel = (data[3] * 100.0f) / 255.0f;
-      liveData.fuelValid = true;
-      break;
-
-    case 0x0F:
-      liveData.intakeTemp = static_cast<int>(data[3]) - 40;
-      liveData.intakeValid = true;
-      break;
-
-    default:
-      break;
+  uint32_t fcId = 0;
+  uint8_t fc[8];
+  if (obdPoller.onFrame(frame.id, frame.data, frame.len, millis(), fcId, fc)) {
+    sendObdFrame(fcId, fc);
   }
 }
 
@@ -437,16 +217,12 @@ void decodeSniffedVehicleFrame(uint32_t id, uint8_t len, const uint8_t *data) {
         const uint16_t rawRpm = (static_cast<uint16_t>(data[0]) << 8) | data[1];
         const float rpm = rawRpm / 4.0f;
         if (rpm >= 300.0f && rpm <= 8000.0f) {
-          liveData.rpm = rpm;
-          liveData.rpmValid = true;
-          liveData.lastResponseMs = millis();
+          liveData.set(LiveField::RPM, rpm, millis());
         }
       }
 
       if (len >= 7) {
-        liveData.speed = data[6];
-        liveData.speedValid = true;
-        liveData.lastResponseMs = millis();
+        liveData.set(LiveField::SPEED, data[6], millis());
       }
       break;
 
@@ -454,9 +230,7 @@ void decodeSniffedVehicleFrame(uint32_t id, uint8_t len, const uint8_t *data) {
       if (len >= 1) {
         const int coolant = static_cast<int>(data[0]) - 40;
         if (coolant >= -40 && coolant <= 150) {
-          liveData.coolant = coolant;
-          liveData.coolantValid = true;
-          liveData.lastResponseMs = millis();
+          liveData.set(LiveField::COOLANT, coolant, millis());
         }
       }
       break;
@@ -514,82 +288,62 @@ bool parseDataBytes(const String &input, uint8_t *data, uint8_t &len) {
   return true;
 }
 
-String buildStatusJson() {
-  String json;
-  json.reserve(420);
-
-  json += "{";
-  json += "\"rxCount\":" + String(rxFrameCount);
-  json += ",\"lastSeq\":" + String(frameSequence);
-  json += ",\"rawEnabled\":" + jsonBool(rawOutputEnabled);
-  json += ",\"onlyChanges\":" + jsonBool(printOnlyChangedFrames);
-  json += ",\"obdEnabled\":" + jsonBool(obdPollingEnabled);
-  json += ",\"rpm\":" + String(liveData.rpm, 1);
-  json += ",\"rpmValid\":" + jsonBool(liveData.rpmValid);
-  json += ",\"speed\":" + String(liveData.speed);
-  json += ",\"speedValid\":" + jsonBool(liveData.speedValid);
-  json += ",\"coolant\":" + String(liveData.coolant);
-  json += ",\"coolantValid\":" + jsonBool(liveData.coolantValid);
-  json += ",\"throttle\":" + String(liveData.throttle, 1);
-  json += ",\"throttleValid\":" + jsonBool(liveData.throttleValid);
-  json += ",\"fuel\":" + String(liveData.fuelLevel, 1);
-  json += ",\"fuelValid\":" + jsonBool(liveData.fuelValid);
-  json += ",\"wifi\":\"" + wifiSummary() + "\"";
-  json += ",\"canProfile\":\"500 kbps / 8 MHz | OBD + sniff 0x201/0x420\"";
-  json += "}";
-
-  return json;
-}
-
-String buildFramesJson(uint32_t sinceSeq) {
-  String json;
-  json.reserve(12000);
-  json += "{\"lastSeq\":" + String(frameSequence) + ",\"frames\":[";
-
-  bool first = true;
-  for (size_t i = 0; i < frameLogCount; i++) {
-    const FrameLogEntry &entry = frameLog[(frameLogHead + i) % MAX_LOGGED_FRAMES];
-    if (entry.seq <= sinceSeq) {
-      continue;
-    }
-
-    if (!first) {
-      json += ',';
-    }
-    first = false;
+void flushFrameBatch() {
+  if (frameBatch.empty()) {
+    return;
+  }
+  if (frameSocket.broadcastBIN(frameBatch.data(), frameBatch.size())) {
+    streamedBatches++;
+  } else {
+    streamFailures++;
+  }
+  frameBatch.reset();
+}
 
-    json += "{";
-    json += "\"seq\":" + String(entry.seq);
-    json += ",\"ts\":" + String(entry.timestampMs);
-    json += ",\"id\":\"" + formatCanId(entry.id, entry.extended) + "\"";
-    json += ",\"type\":\"" + String(entry.rtr ? "RTR" : (entry.extended ? "EXT" : "STD")) + "\"";
-    json += ",\"dlc\":" + String(entry.len);
-    json += ",\"data\":\"" + formatDataBytes(entry.data, entry.len) + "\"";
-    json += "}";
+void streamFrame(const CanFrame &frame, uint32_t seq) {
+  if (frameBatch.empty()) {
+    frameBatchStartMs = millis();
   }
+  if (!frameBatch.append(frame, seq)) {
+    flushFrameBatch();
+    frameBatchStartMs = millis();
+    frameBatch.append(frame, seq);
+  }
+}
 
-  json += "]}";
-  return json;
+// Um envio por lote cheio (~110 quadros) ou a cada FRAME_BATCH_MAX_AGE_MS.
+void handleFrameStream() {
+  frameSocket.loop();
+  if (!frameBatch.empty() && millis() - frameBatchStartMs >= FRAME_BATCH_MAX_AGE_MS) {
+    flushFrameBatch();
+  }
 }
 
+// Consome o que a tarefa de RX (can_rx.cpp) deixou na fila.
 void handleCanReceive() {
-  while (CAN.checkReceive() == CAN_MSGAVAIL) {
-    unsigned long canId = 0;
-    uint8_t len = 0;
-    uint8_t data[8] = {0};
-
-    if (CAN.readMsgBuf(&canId, &len, data) != CAN_OK) {
-      break;
-    }
-
-    const bool extended = canId > 0x7FF;
+  const bool streaming = frameSocket.connectedClients() > 0;
+  CanFrame frame;
+  while (canRxPop(frame)) {
     rxFrameCount++;
-    logFrame(canId, extended, false, len, data);
-    decodeObdFrame(canId, len, data);
-    decodeSniffedVehicleFrame(canId, len, data);
-
-    if (rawOutputEnabled && (!printOnlyChangedFrames || shouldPrintFrame(canId, len, data))) {
-      printFrame(canId, extended, len, data);
+    if (!filterPlan.acceptAll()) {
+      filterHwFrames++;
+      if (!filterPlan.wants(frame.id, frame.extended)) {
+        continue;
+      }
+      filterSwAccepted++;
+    }
+    logFrame(frame);
+    if (streaming) {
+      streamFrame(frame, frameSequence);
+    }
+    captureFrame(frame, frameSequence);
+    decodeObdFrame(frame);
+    decodeSniffedVehicleFrame(frame.id, frame.len, frame.data);
+
+    FrameChange change = FrameChange::SAME;
+    TrackedFrame &tracked = frameTracker.observe(frame, change);
+    if (rawOutputEnabled && (!printOnlyChangedFrames || shouldPrintFrame(tracked, change))) {
+      printFrame(frame.id, frame.extended, frame.len, frame.data);
     }
   }
 }
@@ -603,43 +357,74 @@ void printDashboard() {
   lastDashboardMs = now;
   Serial.print("[DASH] ");
 
-  if (liveData.rpmValid) {
-    Serial.printf("RPM=%.0f | ", liveData.rpm);
-  } else {
-    Serial.print("RPM=-- | ");
+  for (const ObdPid &pid : OBD_PIDS) {
+    const LiveValue &live = liveData[pid.field];
+    if (live.valid) {
+      Serial.printf("%s=%.*f %s | ", pid.label, pid.decimals, live.value, pid.unit);
+    } else {
+      Serial.printf("%s=-- | ", pid.label);
+    }
   }
 
-  if (liveData.speedValid) {
-    Serial.printf("VEL=%u km/h | ", liveData.speed);
-  } else {
-    Serial.print("VEL=-- | ");
-  }
+  Serial.printf("RX=%lu", static_cast<unsigned long>(rxFrameCount));
 
-  if (liveData.coolantValid) {
-    Serial.printf("TEMP=%d C | ", liveData.coolant);
-  } else {
-    Serial.print("TEMP=-- | ");
+  if (liveData.lastResponseMs == 0 || (now - liveData.lastResponseMs > 4000)) {
+    Serial.print(" | OBD sem resposta");
   }
 
-  if (liveData.throttleValid) {
-    Serial.printf("TPS=%.1f%% | ", liveData.throttle);
-  } else {
-    Serial.print("TPS=-- | ");
-  }
+  Serial.println();
+}
 
-  if (liveData.fuelValid) {
-    Serial.printf("FUEL=%.1f%% | ", liveData.fuelLevel);
-  } else {
-    Serial.print("FUEL=-- | ");
+// Grava o plano no MCP2515. O mcp_can passa o chip para configuração e volta
+// ao modo normal a cada registrador, então alguns quadros se perdem aqui.
+void applyFilterPlan(const CanFilterPlan &plan) {
+  canLock();
+  for (uint8_t i = 0; i < 2; i++) {
+    CAN.init_Mask(i, 1, plan.masks[i]);   // ext=1: o valor já está no layout de 29 bits
+  }
+  for (uint8_t i = 0; i < 6; i++) {
+    const HardwareFilter &filter = plan.filters[i];
+    // No mcp_can o filtro padrão leva o SID em << 16 (bits baixos = bytes de dados).
+    CAN.init_Filt(i, filter.extended ? 1 : 0, filter.extended ? filter.value : (filter.value >> 18) << 16);
   }
+  canUnlock();
 
-  Serial.printf("RX=%lu", static_cast<unsigned long>(rxFrameCount));
+  filterPlan = plan;
+  filterHwFrames = 0;
+  filterSwAccepted = 0;
+}
 
-  if (liveData.lastResponseMs == 0 || (now - liveData.lastResponseMs > 4000)) {
-    Serial.print(" | OBD sem resposta");
+// Taxa de cada ID visto nos últimos 5 s, para pesar o que passaria a mais.
+// Calcule com os filtros abertos: com filtro aplicado o resto nem chega.
+size_t collectTraffic() {
+  const uint32_t nowUs = static_cast<uint32_t>(esp_timer_get_time());
+  size_t count = 0;
+  frameTracker.forEachRecent([&](const TrackedFrame &tracked) {
+    if (tracked.count > 1 && tracked.periodUs > 0 && nowUs - tracked.lastSeenUs < 5000000UL) {
+      trafficSamples[count++] = {tracked.id(), tracked.extended(), 1000000.0f / tracked.periodUs};
+    }
+  });
+  return count;
+}
+
+// Faixas pedidas mais as respostas OBD (0x7E8-0x7EF) se o poller estiver
+// ativo: sem elas o filtro descartaria toda resposta e o poller só veria
+// timeouts.
+void planFilter(CanFilterPlan &plan) {
+  if (obdPollingEnabled) {
+    includeFilterRange(plan, CanIdRange{OBD_RESPONSE_FIRST_ID, OBD_RESPONSE_LAST_ID, false});
   }
+  computeFilterPlan(plan, trafficSamples, collectTraffic());
+}
 
-  Serial.println();
+// Liga/desliga o poller e refaz o filtro aplicado (com ou sem 0x7E8-0x7EF).
+void setObdPolling(bool enabled) {
+  obdPollingEnabled = enabled;
+  if (!requestedFilter.acceptAll()) {
+    CanFilterPlan plan = requestedFilter;
+    planFilter(plan);
+    applyFilterPlan(plan);
+  }
 }
 
 void handleSerialCommands() {
@@ -648,7 +433,17 @@ void handleSerialCommands() {
 
     switch (cmd) {
       case 'h':
-        Serial.println("\r\nComandos: [r]=raw on/off | [c]=somente mudancas | [o]=OBD polling | [w]=wifi/url | [s]=status | [h]=ajuda");
+        Serial.println("\r\nComandos: [r]=raw on/off | [c]=somente mudancas | [o]=OBD polling | [g]=captura em arquivo | [w]=wifi/url | [s]=status | [h]=ajuda");
+        break;
+
+      case 'g':
+        if (captureActive()) {
+          captureStop();
+        } else if (!captureStart()) {
+          Serial.println("[CAP] Armazenamento indisponivel.");
+          break;
+        }
+        Serial.printf("[CAP] Captura %s\r\n", captureActive() ? "ATIVADA" : "DESATIVADA");
         break;
 
       case 'r':
@@ -662,7 +457,7 @@ void handleSerialCommands() {
         break;
 
       case 'o':
-        obdPollingEnabled = !obdPollingEnabled;
+        setObdPolling(!obdPollingEnabled);
         Serial.printf("[CFG] OBD polling %s\r\n", obdPollingEnabled ? "ATIVADO" : "DESATIVADO");
         break;
 
@@ -690,22 +485,133 @@ void requestNextPidIfNeeded() {
     return;
   }
 
-  const uint32_t now = millis();
-  if (now - lastObdRequestMs < OBD_REQUEST_INTERVAL_MS) {
-    return;
+  uint8_t request[8];
+  if (obdPoller.nextRequest(millis(), request)) {
+    sendObdFrame(OBD_FUNCTIONAL_ID, request);
   }
-
-  lastObdRequestMs = now;
-  sendObdRequest(obdPidList[nextPidIndex]);
-  nextPidIndex = (nextPidIndex + 1) % (sizeof(obdPidList) / sizeof(obdPidList[0]));
 }
 
 void handleRoot() {
-  server.send_P(200, "text/html", INDEX_HTML);
+  serveStaticAsset(server, INDEX_HTML);
+}
+
+// Campos do painel pela tabela OBD_PIDS: "<key>" e "<key>Valid".
+void writeLiveFields(JsonWriter &json) {
+  char validKey[24];
+  for (const ObdPid &pid : OBD_PIDS) {
+    const LiveValue &live = liveData[pid.field];
+    snprintf(validKey, sizeof(validKey), "%sValid", pid.key);
+    json.field(pid.key, live.value, pid.decimals);
+    json.field(validKey, live.valid);
+  }
+}
+
+void writeObdStats(JsonWriter &json) {
+  const ObdPollerStats obd = obdPoller.stats();
+  json.key("obd").beginObject();
+  json.field("requests", obd.requests);
+  json.field("responses", obd.responses);
+  json.field("partial", obd.partial);
+  json.field("timeouts", obd.timeouts);
+  json.field("isoTpErrors", obd.isoTpErrors);
+  json.field("responseMs", obd.responseMs);
+  json.field("intervalMs", obd.intervalMs);
+  json.field("pidsPerRequest", obd.pidsPerRequest);
+  json.endObject();
 }
 
+// Só o painel, consultado várias vezes por segundo pela página: a tabela
+// inteira (rótulo, unidade) para montar os cartões e a idade de cada valor.
+void handleLiveApi() {
+  const uint32_t now = millis();
+  JsonResponse json(server);
+  json.beginObject();
+  json.field("rxCount", rxFrameCount);
+  json.key("pids").beginArray();
+  for (const ObdPid &pid : OBD_PIDS) {
+    const LiveValue &live = liveData[pid.field];
+    json.beginObject();
+    json.field("pid", pid.pid);
+    json.field("key", pid.key);
+    json.field("label", pid.label);
+    json.field("unit", pid.unit);
+    json.field("value", live.value, pid.decimals);
+    json.field("valid", live.valid);
+    json.field("supported", obdPoller.supported(pid.pid));
+    json.field("ageMs", live.valid ? now - live.updatedMs : 0);
+    json.endObject();
+  }
+  json.endArray();
+  writeObdStats(json);
+  json.endObject();
+}
+
+// JSON direto no socket (JsonResponse), sem String: este endpoint é
+// consultado a cada segundo e não deve fragmentar o heap com o tempo.
 void handleStatusApi() {
-  server.send(200, "application/json", buildStatusJson());
+  char wifi[80];
+  formatWifiSummaryTo(wifi, sizeof(wifi));
+  const CanRxStats rx = canRxStats();
+
+  JsonResponse json(server);
+  json.beginObject();
+  json.field("rxCount", rxFrameCount);
+  json.field("lastSeq", frameSequence);
+  json.field("rawEnabled", rawOutputEnabled);
+  json.field("onlyChanges", printOnlyChangedFrames);
+  json.field("obdEnabled", obdPollingEnabled);
+  writeLiveFields(json);
+  json.field("wifi", wifi);
+  json.field("canProfile", "500 kbps / 8 MHz | OBD + sniff 0x201/0x420");
+
+  json.key("rxRing").beginObject();
+  json.field("used", rx.used);
+  json.field("capacity", rx.capacity);
+  json.field("highWater", rx.highWater);
+  json.field("overflows", rx.overflows);
+  json.field("wakeups", rx.wakeups);
+  json.endObject();
+
+  json.key("ids").beginObject();
+  json.field("tracked", frameTracker.size());
+  json.field("capacity", frameTracker.capacity());
+  json.field("evictions", frameTracker.evictions());
+  json.endObject();
+
+  json.key("stream").beginObject();
+  json.field("port", FRAME_SOCKET_PORT);
+  json.field("clients", frameSocket.connectedClients());
+  json.field("batches", streamedBatches);
+  json.field("failures", streamFailures);
+  json.endObject();
+
+  const CaptureStats capture = captureStats();
+  json.key("capture").beginObject();
+  json.field("active", capture.active);
+  json.field("frames", capture.frames);
+  json.field("dropped", capture.dropped);
+  json.field("blocks", capture.blocks);
+  json.field("errors", capture.writeErrors);
+  json.field("bytes", capture.bytesWritten);
+  json.field("writeKBps", capture.writeKBps);
+  json.field("maxWriteMs", capture.maxWriteUs / 1000.0, 1);
+  json.field("queued", capture.queued);
+  json.endObject();
+
+  writeObdStats(json);
+
+  json.key("filters").beginObject();
+  json.field("applied", !filterPlan.acceptAll());
+  json.field("hwFrames", filterHwFrames);
+  json.field("swAccepted", filterSwAccepted);
+  json.endObject();
+
+  json.key("heap").beginObject();
+  json.field("free", ESP.getFreeHeap());
+  json.field("largest", ESP.getMaxAllocHeap());
+  json.field("minFree", ESP.getMinFreeHeap());
+  json.endObject();
+  json.endObject();
 }
 
 void handleFramesApi() {
@@ -713,7 +619,141 @@ void handleFramesApi() {
   if (server.hasArg("since")) {
     since = static_cast<uint32_t>(server.arg("since").toInt());
   }
-  server.send(200, "application/json", buildFramesJson(since));
+
+  JsonResponse json(server);
+  json.beginObject();
+  json.field("lastSeq", frameSequence);
+  json.key("frames").beginArray();
+
+  for (size_t i = 0; i < frameLogCount; i++) {
+    const FrameLogEntry &entry = frameLog[(frameLogHead + i) % MAX_LOGGED_FRAMES];
+    if (entry.seq <= since) {
+      continue;
+    }
+
+    char id[12];
+    char data[24];
+    formatCanIdTo(id, sizeof(id), entry.id, entry.extended);
+    formatDataBytesTo(data, sizeof(data), entry.data, entry.len);
+
+    json.beginObject();
+    json.field("seq", entry.seq);
+    json.field("ts", entry.timestampMs);
+    json.field("id", id);
+    json.field("type", entry.rtr ? "RTR" : (entry.extended ? "EXT" : "STD"));
+    json.field("dlc", entry.len);
+    json.field("data", data);
+    json.endObject();
+  }
+
+  json.endArray();
+  json.endObject();
+}
+
+// Estatísticas por ID (FrameTracker), do visto mais recentemente ao mais
+// antigo: contagem, período médio, último dado e bytes que mudam.
+void handleIdsApi() {
+  JsonResponse json(server);
+  json.beginObject();
+  json.field("evictions", frameTracker.evictions());
+  json.key("ids").beginArray();
+
+  frameTracker.forEachRecent([&json](const TrackedFrame &tracked) {
+    char id[12];
+    char data[24];
+    formatCanIdTo(id, sizeof(id), tracked.id(), tracked.extended());
+    formatDataBytesTo(data, sizeof(data), tracked.data, tracked.len);
+
+    json.beginObject();
+    json.field("id", id);
+    json.field("count", tracked.count);
+    json.field("periodMs", tracked.periodUs / 1000.0, 1);
+    json.field("dlc", tracked.len);
+    json.field("data", data);
+    json.field("changed", tracked.changedMask);
+    json.field("active", tracked.activeMask);
+    json.endObject();
+  });
+
+  json.endArray();
+  json.endObject();
+}
+
+void writeFilterPlan(JsonWriter &json, const CanFilterPlan &plan) {
+  char text[12];
+  json.key("ranges").beginArray();
+  for (size_t i = 0; i < plan.rangeCount; i++) {
+    json.beginObject();
+    formatCanIdTo(text, sizeof(text), plan.ranges[i].first, plan.ranges[i].extended);
+    json.field("first", text);
+    formatCanIdTo(text, sizeof(text), plan.ranges[i].last, plan.ranges[i].extended);
+    json.field("last", text);
+    json.endObject();
+  }
+  json.endArray();
+
+  json.key("masks").beginArray();
+  for (uint32_t mask : plan.masks) {
+    snprintf(text, sizeof(text), "0x%08lX", static_cast<unsigned long>(mask));
+    json.value(text);
+  }
+  json.endArray();
+  json.key("filters").beginArray();
+  for (const HardwareFilter &filter : plan.filters) {
+    snprintf(text, sizeof(text), "0x%08lX", static_cast<unsigned long>(filter.value));
+    json.beginObject().field("value", text).field("ext", filter.extended).endObject();
+  }
+  json.endArray();
+
+  const FilterEstimate &e = plan.estimate;
+  json.key("estimate").beginObject();
+  json.field("trafficFps", e.trafficFps, 1);
+  json.field("passedFps", e.passedFps, 1);
+  json.field("wantedFps", e.wantedFps, 1);
+  json.field("hardwarePass", e.trafficFps > 0 ? 100.0 * e.passedFps / e.trafficFps : 100.0, 1);
+  json.field("useful", e.passedFps > 0 ? 100.0 * e.wantedFps / e.passedFps : 100.0, 1);
+  json.field("acceptedIds", e.acceptedIds);
+  json.field("wantedIds", e.wantedIds);
+  json.endObject();
+}
+
+// /api/filters                  plano aplicado e contadores
+// /api/filters?ids=7E8-7EF,201  calcula sem aplicar (&apply=1 aplica)
+// /api/filters?clear=1          volta a aceitar tudo
+void handleFiltersApi() {
+  CanFilterPlan plan = filterPlan;
+  if (server.hasArg("clear")) {
+    requestedFilter = CanFilterPlan();
+    plan = requestedFilter;
+    planFilter(plan);
+    applyFilterPlan(plan);
+  } else if (server.hasArg("ids")) {
+    CanFilterPlan requested;
+    if (!parseFilterRanges(server.arg("ids").c_str(), requested)) {
+      server.send(400, "application/json",
+                  "{\"ok\":false,\"message\":\"IDs invalidos. Use hex como 7E8-7EF,201 (ate 16 faixas; 8 digitos = estendido).\"}");
+      return;
+    }
+    plan = requested;
+    planFilter(plan);
+    if (server.arg("apply") == "1") {
+      requestedFilter = requested;
+      applyFilterPlan(plan);
+    }
+  }
+
+  JsonResponse json(server);
+  json.beginObject();
+  json.field("applied", !filterPlan.acceptAll());
+  json.key("plan").beginObject();
+  writeFilterPlan(json, plan);
+  json.endObject();
+  json.key("live").beginObject();
+  json.field("hwFrames", filterHwFrames);
+  json.field("swAccepted", filterSwAccepted);
+  json.field("useful", filterHwFrames > 0 ? 100.0 * filterSwAccepted / filterHwFrames : 100.0, 1);
+  json.endObject();
+  json.endObject();
 }
 
 void handleToggleApi() {
@@ -724,7 +764,7 @@ void handleToggleApi() {
   } else if (name == "changes") {
     printOnlyChangedFrames = !printOnlyChangedFrames;
   } else if (name == "obd") {
-    obdPollingEnabled = !obdPollingEnabled;
+    setObdPolling(!obdPollingEnabled);
   }
 
   handleStatusApi();
@@ -735,6 +775,93 @@ void handleClearApi() {
   server.send(200, "application/json", "{\"ok\":true,\"message\":\"Buffer limpo.\"}");
 }
 
+void handleCaptureApi() {
+  const String action = server.arg("action");
+  if (action == "start") {
+    captureStart();
+  } else if (action == "stop") {
+    captureStop();
+  }
+
+  const CaptureStats capture = captureStats();
+  JsonResponse json(server);
+  json.beginObject();
+  json.field("active", capture.active);
+  json.key("files").beginArray();
+  for (uint32_t index = capture.firstFile; index < capture.nextFile; index++) {
+    char path[32];
+    capturePath(path, sizeof(path), index);
+    File file = captureStorage.open(path, FILE_READ);
+    if (!file) {
+      continue;
+    }
+    json.beginObject();
+    json.field("index", index);
+    json.field("bytes", static_cast<uint32_t>(file.size()));
+    json.field("current", capture.active && index + 1 == capture.nextFile);
+    json.endObject();
+  }
+  json.endArray();
+  json.endObject();
+}
+
+// Converte o arquivo binário em candump/GVRET enquanto envia. O download de
+// um arquivo cheio leva alguns segundos, então entre blocos de texto volta a
+// esvaziar a fila de RX (que só segura ~120 ms de barramento cheio).
+void handleCaptureLogApi() {
+  CanLogFormat format = CanLogFormat::CANDUMP;
+  if (server.hasArg("format") && !parseCanLogFormat(server.arg("format").c_str(), format)) {
+    server.send(400, "application/json", "{\"ok\":false,\"message\":\"Formato invalido (candump ou gvret).\"}");
+    return;
+  }
+
+  const uint32_t index = static_cast<uint32_t>(server.arg("file").toInt());
+  char path[32];
+  capturePath(path, sizeof(path), index);
+  File file;
+  if (server.hasArg("file")) {
+    file = captureStorage.open(path, FILE_READ);
+  }
+  if (!file) {
+    server.send(404, "application/json", "{\"ok\":false,\"message\":\"Arquivo de captura nao encontrado.\"}");
+    return;
+  }
+
+  char disposition[64];
+  snprintf(disposition, sizeof(disposition), "attachment; filename=\"captura_%08lu.%s\"",
+           static_cast<unsigned long>(index), canLogFileExtension(format));
+  server.sendHeader("Content-Disposition", disposition);
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "text/plain", "");
+
+  static uint8_t block[CAPTURE_BLOCK_BYTES];
+  char text[FRAME_BATCH_BYTES];
+  size_t used = strlen(canLogHeader(format));
+  memcpy(text, canLogHeader(format), used);
+
+  while (file.read(block, sizeof(block)) == sizeof(block)) {
+    FrameBatchReader reader;
+    if (!reader.begin(block, sizeof(block))) {
+      continue;
+    }
+    CanFrame frame;
+    uint32_t seq = 0;
+    while (reader.next(frame, seq)) {
+      if (used + CAN_LOG_LINE_MAX > sizeof(text)) {
+        server.sendContent(text, used);
+        used = 0;
+        handleCanReceive();
+      }
+      used += formatCanLogLine(text + used, sizeof(text) - used, format, frame);
+    }
+  }
+
+  if (used > 0) {
+    server.sendContent(text, used);
+  }
+  server.sendContent("", 0);   // Bloco vazio: fim do chunked
+}
+
 void handleSendApi() {
   if (!server.hasArg("id")) {
     server.send(400, "application/json", "{\"ok\":false,\"message\":\"Parametro id ausente.\"}");
@@ -755,7 +882,7 @@ void handleSendApi() {
   }
 
   const byte ext = (server.arg("ext") == "1") ? 1 : 0;
-  const byte status = CAN.sendMsgBuf(frameId, ext, len, data);
+  const byte status = canSend(frameId, ext, len, data);
 
   if (status == CAN_OK) {
     server.send(200, "application/json", "{\"ok\":true,\"message\":\"Frame enviado com sucesso.\"}");
@@ -792,14 +919,21 @@ void setupWiFi() {
 void setupWebServer() {
   server.on("/", HTTP_GET, handleRoot);
   server.on("/api/status", HTTP_GET, handleStatusApi);
+  server.on("/api/live", HTTP_GET, handleLiveApi);
   server.on("/api/frames", HTTP_GET, handleFramesApi);
+  server.on("/api/ids", HTTP_GET, handleIdsApi);
   server.on("/api/toggle", HTTP_GET, handleToggleApi);
   server.on("/api/clear", HTTP_GET, handleClearApi);
   server.on("/api/send", HTTP_GET, handleSendApi);
+  server.on("/api/filters", HTTP_GET, handleFiltersApi);
+  server.on("/api/capture", HTTP_GET, handleCaptureApi);
+  server.on("/api/capture/log", HTTP_GET, handleCaptureLogApi);
   server.onNotFound([]() {
     server.send(404, "text/plain", "404 - rota nao encontrada");
   });
+  staticAssetHeaders(server);
   server.begin();
+  frameSocket.begin();
   Serial.println("[WEB] Interface pronta.");
 }
 
@@ -807,7 +941,6 @@ void setup() {
   Serial.begin(SERIAL_BAUD);
   delay(1500);
 
-  pinMode(CAN_INT_PIN, INPUT_PULLUP);
   SPI.begin(CAN_SCK_PIN, CAN_MISO_PIN, CAN_MOSI_PIN, CAN_CS_PIN);
 
   Serial.println();
@@ -818,12 +951,19 @@ void setup() {
   Serial.println("Padrao atual: CAN 500 kbps / cristal 8 MHz");
   Serial.println("Se nao houver trafego, teste 250 kbps ou ajuste para 16 MHz.");
 
-  while (CAN.begin(MCP_ANY, CAN_BUS_SPEED, MCP2515_CLOCK) != CAN_OK) {
+  // MCP_STDEXT liga máscaras e filtros; o begin() os deixa zerados (aceita
+  // tudo) até /api/filters aplicar um plano.
+  while (CAN.begin(MCP_STDEXT, CAN_BUS_SPEED, MCP2515_CLOCK) != CAN_OK) {
     Serial.println("[ERRO] MCP2515 nao inicializou. Verifique SPI, alimentacao e pino CS.");
     delay(1000);
   }
 
   CAN.setMode(MCP_NORMAL);
+  canRxBegin(CAN, CAN_INT_PIN);
+
+  if (!LittleFS.begin(true) || !captureBegin(captureStorage)) {
+    Serial.println("[ERRO] LittleFS indisponivel; captura em arquivo desligada.");
+  }
   setupWiFi();
   setupWebServer();
 
@@ -835,6 +975,8 @@ void setup() {
 void loop() {
   handleSerialCommands();
   handleCanReceive();
+  handleFrameStream();
+  captureLoop();
   requestNextPidIfNeeded();
   printDashboard();
   server.handleClient();
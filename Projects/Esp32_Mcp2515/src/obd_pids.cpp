@@ -0,0 +1,45 @@
+#include "obd_pids.h"
+
+const ObdPid *findObdPid(uint8_t pid) {
+  for (const ObdPid &entry : OBD_PIDS) {
+    if (entry.pid == pid) {
+      return &entry;
+    }
+  }
+  return nullptr;
+}
+
+float decodeObdValue(const ObdPid &pid, const uint8_t *bytes) {
+  const uint32_t raw = pid.bytes == 2 ? (static_cast<uint32_t>(bytes[0]) << 8) | bytes[1] : bytes[0];
+  return raw * pid.scale + pid.offset;
+}
+
+uint8_t obdPidDataBytes(uint8_t pid) {
+  if (pid % 0x20 == 0) {
+    return 4;
+  }
+  const ObdPid *entry = findObdPid(pid);
+  return entry != nullptr ? entry->bytes : 0;
+}
+
+size_t parseObdResponse(const uint8_t *payload, size_t length, ObdPidValue *out, size_t maxValues) {
+  if (length < 2 || payload[0] != 0x41) {
+    return 0;
+  }
+
+  size_t count = 0;
+  size_t pos = 1;
+  while (pos < length && count < maxValues) {
+    const uint8_t pid = payload[pos];
+    const uint8_t bytes = obdPidDataBytes(pid);
+    if (bytes == 0 || pos + 1 + bytes > length) {
+      break;
+    }
+
+    ObdPidValue &value = out[count++];
+    value.pid = pid;
+    memcpy(value.bytes, payload + pos + 1, bytes);
+    pos += 1 + bytes;
+  }
+  return count;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <Arduino.h>
+
+// PIDs do modo 01 (SAE J1979) que o painel mostra. A tabela decide como
+// cada resposta é decodificada, o que vai no JSON de status e o que o
+// poller pede ao carro: para acrescentar um PID basta uma linha aqui e um
+// campo em LiveField.
+
+enum class LiveField : uint8_t {
+  RPM,
+  SPEED,
+  COOLANT,
+  THROTTLE,
+  LOAD,
+  FUEL,
+  INTAKE,
+  COUNT
+};
+
+constexpr size_t LIVE_FIELD_COUNT = static_cast<size_t>(LiveField::COUNT);
+
+// valor = (A, ou A*256+B com 2 bytes) * scale + offset
+struct ObdPid {
+  uint8_t pid;
+  uint8_t bytes;
+  float scale;
+  float offset;
+  uint8_t decimals;
+  const char *key;     // Campo no JSON de status (e "<key>Valid")
+  const char *label;   // Painel web e Serial
+  const char *unit;
+  LiveField field;
+};
+
+constexpr ObdPid OBD_PIDS[] = {
+  {0x0C, 2, 0.25f, 0.0f, 0, "rpm", "RPM", "rpm", LiveField::RPM},
+  {0x0D, 1, 1.0f, 0.0f, 0, "speed", "Velocidade", "km/h", LiveField::SPEED},
+  {0x05, 1, 1.0f, -40.0f, 0, "coolant", "Temp. motor", "°C", LiveField::COOLANT},
+  {0x11, 1, 100.0f / 255.0f, 0.0f, 1, "throttle", "Throttle", "%", LiveField::THROTTLE},
+  {0x04, 1, 100.0f / 255.0f, 0.0f, 1, "load", "Carga", "%", LiveField::LOAD},
+  {0x2F, 1, 100.0f / 255.0f, 0.0f, 1, "fuel", "Combustível", "%", LiveField::FUEL},
+  {0x0F, 1, 1.0f, -40.0f, 0, "intake", "Temp. admissão", "°C", LiveField::INTAKE},
+};
+
+constexpr size_t OBD_PID_COUNT = sizeof(OBD_PIDS) / sizeof(OBD_PIDS[0]);
+
+struct LiveValue {
+  float value = 0.0f;
+  bool valid = false;
+  uint32_t updatedMs = 0;
+  uint32_t updates = 0;
+};
+
+// Valores do painel, vindos do OBD ou de quadros farejados (0x201/0x420).
+struct LiveData {
+  LiveValue fields[LIVE_FIELD_COUNT];
+  uint32_t lastResponseMs = 0;
+
+  void set(LiveField field, float value, uint32_t nowMs) {
+    LiveValue &live = fields[static_cast<size_t>(field)];
+    live.value = value;
+    live.valid = true;
+    live.updatedMs = nowMs;
+    live.updates++;
+    lastResponseMs = nowMs;
+  }
+
+  const LiveValue &operator[](LiveField field) const { return fields[static_cast<size_t>(field)]; }
+};
+
+const ObdPid *findObdPid(uint8_t pid);
+
+float decodeObdValue(const ObdPid &pid, const uint8_t *bytes);
+
+// Bytes de dados que seguem o PID numa resposta 0x41: os da tabela, 4 nos
+// PIDs de "suportados" (0x00, 0x20, ...) e 0 se desconhecido.
+uint8_t obdPidDataBytes(uint8_t pid);
+
+struct ObdPidValue {
+  uint8_t pid;
+  uint8_t bytes[4];
+};
+
+// Percorre uma resposta do modo 01 ("41 0C 1A F8 0D 3C ..."), que pode
+// trazer até 6 PIDs. Para no primeiro PID desconhecido (sem ele não se sabe
+// onde começa o próximo); devolve quantos valores foram lidos.
+size_t parseObdResponse(const uint8_t *payload, size_t length, ObdPidValue *out, size_t maxValues);
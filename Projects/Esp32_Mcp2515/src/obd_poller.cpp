@@ -0,0 +1,171 @@
+#include "obd_poller.h"
+
+ObdPoller::ObdPoller(LiveData &live) : live_(live) {}
+
+bool ObdPoller::nextRequest(uint32_t nowMs, uint8_t frame[8]) {
+  if (waiting_) {
+    if (nowMs - sentMs_ < OBD_RESPONSE_TIMEOUT_MS) {
+      return false;
+    }
+    finishRequest(true);
+  }
+  if (stats_.requests > 0 && nowMs - sentMs_ < intervalMs_) {
+    return false;
+  }
+
+  // Primeiro descobre o que a ECU suporta (0x00: PIDs 01-20, 0x20: 21-40).
+  uint8_t pids[OBD_MAX_PIDS_PER_REQUEST];
+  size_t count = 0;
+  if (!supportKnown_[0]) {
+    pids[count++] = 0x00;
+    if (pidsPerRequest_ > 1) {
+      pids[count++] = 0x20;
+    }
+  } else {
+    count = buildPidList(pids);
+  }
+  if (count == 0) {
+    return false;
+  }
+
+  memset(frame, 0, 8);
+  frame[0] = static_cast<uint8_t>(count + 1);   // Single Frame
+  frame[1] = 0x01;
+  memcpy(frame + 2, pids, count);
+
+  memcpy(requested_, pids, count);
+  requestedCount_ = count;
+  answered_ = 0;
+  waiting_ = true;
+  sentMs_ = nowMs;
+  stats_.requests++;
+  return true;
+}
+
+bool ObdPoller::onFrame(uint32_t id, const uint8_t *data, uint8_t len, uint32_t nowMs, uint32_t &fcId, uint8_t fcFrame[8]) {
+  if (id < OBD_RESPONSE_FIRST_ID || id > OBD_RESPONSE_LAST_ID) {
+    return false;
+  }
+
+  IsoTpReceiver &receiver = receivers_[id - OBD_RESPONSE_FIRST_ID];
+  switch (receiver.feed(data, len, nowMs)) {
+    case IsoTpEvent::FIRST_FRAME:
+      fcId = id - OBD_PHYSICAL_OFFSET;
+      IsoTpReceiver::flowControl(fcFrame);
+      return true;
+
+    case IsoTpEvent::COMPLETE:
+      handlePayload(receiver.payload(), receiver.length(), nowMs);
+      break;
+
+    case IsoTpEvent::ERROR:
+      stats_.isoTpErrors++;
+      break;
+
+    default:
+      break;
+  }
+  return false;
+}
+
+bool ObdPoller::supported(uint8_t pid) const {
+  const size_t range = (pid - 1) / 0x20;
+  if (pid == 0 || range >= 2) {
+    return true;
+  }
+  // Bit 0 da resposta 0x00 é o próprio PID 0x20: limpo, a ECU não tem nada
+  // em 0x21-0x40 e não vai responder o 0x20.
+  if (range == 1 && supportKnown_[0] && (supportMask_[0] & 1) == 0) {
+    return false;
+  }
+  if (!supportKnown_[range]) {
+    return true;
+  }
+  return (supportMask_[range] >> (31 - (pid - 1) % 0x20)) & 1;
+}
+
+ObdPollerStats ObdPoller::stats() const {
+  ObdPollerStats result = stats_;
+  result.responseMs = responseAvgMs_;
+  result.intervalMs = intervalMs_;
+  result.pidsPerRequest = pidsPerRequest_;
+  result.supportKnown = supportKnown_[0];
+  return result;
+}
+
+void ObdPoller::handlePayload(const uint8_t *payload, size_t length, uint32_t nowMs) {
+  // Resposta negativa; 0x78 ("aguarde") ainda vai responder.
+  if (length >= 3 && payload[0] == 0x7F && payload[1] == 0x01) {
+    if (waiting_ && payload[2] != 0x78) {
+      finishRequest(true);
+    }
+    return;
+  }
+
+  ObdPidValue values[OBD_MAX_PIDS_PER_REQUEST];
+  const size_t count = parseObdResponse(payload, length, values, OBD_MAX_PIDS_PER_REQUEST);
+  for (size_t i = 0; i < count; i++) {
+    const ObdPidValue &value = values[i];
+    if (value.pid % 0x20 == 0) {
+      const size_t range = value.pid / 0x20;
+      if (range < 2) {
+        supportMask_[range] |= (static_cast<uint32_t>(value.bytes[0]) << 24) | (static_cast<uint32_t>(value.bytes[1]) << 16) |
+                               (static_cast<uint32_t>(value.bytes[2]) << 8) | value.bytes[3];
+        supportKnown_[range] = true;
+      }
+    } else if (const ObdPid *entry = findObdPid(value.pid)) {
+      live_.set(entry->field, decodeObdValue(*entry, value.bytes), nowMs);
+    }
+
+    for (size_t r = 0; r < requestedCount_; r++) {
+      if (requested_[r] == value.pid) {
+        answered_ |= 1 << r;
+      }
+    }
+  }
+  if (count > 0) {
+    lastAnswerMs_ = nowMs;
+  }
+
+  if (waiting_ && answered_ == (1 << requestedCount_) - 1) {
+    finishRequest(false);
+  }
+}
+
+void ObdPoller::finishRequest(bool timedOut) {
+  waiting_ = false;
+
+  if (!timedOut) {
+    stats_.responses++;
+    const uint32_t elapsed = lastAnswerMs_ - sentMs_;
+    responseAvgMs_ = stats_.responses == 1 ? elapsed : (responseAvgMs_ * 3 + elapsed) / 4;
+    const uint32_t interval = responseAvgMs_ * 2;
+    intervalMs_ = interval < OBD_MIN_INTERVAL_MS ? OBD_MIN_INTERVAL_MS : interval > OBD_MAX_INTERVAL_MS ? OBD_MAX_INTERVAL_MS : interval;
+  } else if (answered_ == 0) {
+    stats_.timeouts++;
+    intervalMs_ = intervalMs_ * 2 > OBD_MAX_INTERVAL_MS ? OBD_MAX_INTERVAL_MS : intervalMs_ * 2;
+  } else {
+    stats_.partial++;
+  }
+
+  // ECU que só responde o primeiro PID de um pedido múltiplo.
+  if (requestedCount_ > 1 && answered_ != 0) {
+    if (answered_ != 1) {
+      singleAnswers_ = 0;
+    } else if (++singleAnswers_ >= OBD_SINGLE_PID_AFTER) {
+      pidsPerRequest_ = 1;
+    }
+  }
+}
+
+size_t ObdPoller::buildPidList(uint8_t *pids) {
+  size_t count = 0;
+  for (size_t checked = 0; checked < OBD_PID_COUNT && count < pidsPerRequest_; checked++) {
+    const ObdPid &entry = OBD_PIDS[nextIndex_];
+    nextIndex_ = (nextIndex_ + 1) % OBD_PID_COUNT;
+    if (supported(entry.pid)) {
+      pids[count++] = entry.pid;
+    }
+  }
+  return count;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "iso_tp.h"
+#include "obd_pids.h"
+
+// Consulta dos PIDs de OBD_PIDS pelo endereço funcional 0x7DF (ISO 15765-4,
+// 11 bits). Um pedido do modo 01 leva até 6 PIDs; a resposta com mais de
+// 7 bytes vem em ISO-TP e cada ECU (0x7E8-0x7EF) tem seu IsoTpReceiver.
+//
+// Sem E/S: nextRequest() diz quando e o que mandar, onFrame() recebe as
+// respostas e devolve o Flow Control que o chamador deve transmitir.
+//
+// O próximo pedido sai quando a resposta completa chega (ou no timeout) e
+// pelo menos intervalMs depois do anterior. O intervalo é o dobro da média
+// do tempo de resposta medido, entre OBD_MIN_INTERVAL_MS e
+// OBD_MAX_INTERVAL_MS: metade do tempo o canal de diagnóstico da ECU fica
+// livre. Sem resposta, o intervalo dobra até o máximo (ignição desligada).
+
+constexpr uint32_t OBD_FUNCTIONAL_ID = 0x7DF;
+constexpr uint32_t OBD_RESPONSE_FIRST_ID = 0x7E8;
+constexpr uint32_t OBD_RESPONSE_LAST_ID = 0x7EF;
+constexpr uint32_t OBD_PHYSICAL_OFFSET = 8;         // Resposta 0x7E8 -> pedido físico 0x7E0
+constexpr size_t OBD_MAX_PIDS_PER_REQUEST = 6;
+constexpr uint32_t OBD_RESPONSE_TIMEOUT_MS = 150;   // P2 máx. 50 ms + ISO-TP + atraso do loop()
+constexpr uint32_t OBD_MIN_INTERVAL_MS = 50;
+constexpr uint32_t OBD_MAX_INTERVAL_MS = 1000;
+constexpr uint8_t OBD_SINGLE_PID_AFTER = 3;         // Pedidos múltiplos respondidos só no 1º PID
+
+struct ObdPollerStats {
+  uint32_t requests = 0;
+  uint32_t responses = 0;      // Pedidos com todos os PIDs respondidos
+  uint32_t partial = 0;        // Timeout com parte dos PIDs
+  uint32_t timeouts = 0;       // Timeout sem nada
+  uint32_t isoTpErrors = 0;
+  uint32_t responseMs = 0;     // Média móvel
+  uint32_t intervalMs = 0;
+  uint8_t pidsPerRequest = 0;
+  bool supportKnown = false;
+};
+
+class ObdPoller {
+public:
+  explicit ObdPoller(LiveData &live);
+
+  // Preenche o quadro de 8 bytes para OBD_FUNCTIONAL_ID se for hora.
+  bool nextRequest(uint32_t nowMs, uint8_t frame[8]);
+
+  // true se fcFrame deve ir para fcId (Flow Control após um First Frame).
+  bool onFrame(uint32_t id, const uint8_t *data, uint8_t len, uint32_t nowMs, uint32_t &fcId, uint8_t fcFrame[8]);
+
+  // PID anunciado pela ECU (0x00/0x20); antes da resposta, todos valem.
+  bool supported(uint8_t pid) const;
+  ObdPollerStats stats() const;
+
+private:
+  void handlePayload(const uint8_t *payload, size_t length, uint32_t nowMs);
+  void finishRequest(bool timedOut);
+  size_t buildPidList(uint8_t *pids);
+
+  LiveData &live_;
+  IsoTpReceiver receivers_[OBD_RESPONSE_LAST_ID - OBD_RESPONSE_FIRST_ID + 1];
+  uint8_t requested_[OBD_MAX_PIDS_PER_REQUEST];
+  size_t requestedCount_ = 0;
+  uint8_t answered_ = 0;          // Bit i: requested_[i] respondido
+  bool waiting_ = false;
+  uint32_t sentMs_ = 0;
+  uint32_t lastAnswerMs_ = 0;
+  size_t nextIndex_ = 0;
+  uint8_t pidsPerRequest_ = OBD_MAX_PIDS_PER_REQUEST;
+  uint8_t singleAnswers_ = 0;
+  uint32_t supportMask_[2] = {0, 0};    // PIDs 0x01-0x20 e 0x21-0x40
+  bool supportKnown_[2] = {false, false};
+  uint32_t responseAvgMs_ = 0;
+  uint32_t intervalMs_ = OBD_MIN_INTERVAL_MS;
+  ObdPollerStats stats_;
+};
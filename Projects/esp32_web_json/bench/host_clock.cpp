@@ -0,0 +1,108 @@
+#include "host_clock.h"
+
+#include <Arduino.h>
+#include <esp_timer.h>
+
+#include <chrono>
+#include <vector>
+
+struct HostTimer {
+  esp_timer_cb_t callback;
+  void* arg;
+  uint64_t deadlineUs;
+  bool armed;
+};
+
+namespace {
+
+bool virtualClock = false;
+uint64_t virtualUs = 0;
+std::vector<HostTimer*> timers;
+
+uint64_t realUs() {
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                                   std::chrono::steady_clock::now().time_since_epoch())
+                                   .count());
+}
+
+}  // namespace
+
+namespace host {
+
+void useVirtualClock(bool on) {
+  virtualClock = on;
+}
+
+uint64_t timeUs() {
+  return virtualClock ? virtualUs : realUs();
+}
+
+void setTimeUs(uint64_t us) {
+  virtualUs = us;
+}
+
+void runTimersUntil(uint64_t us) {
+  for (;;) {
+    HostTimer* next = nullptr;
+    for (HostTimer* timer : timers) {
+      if (timer->armed && timer->deadlineUs <= us && (!next || timer->deadlineUs < next->deadlineUs)) {
+        next = timer;
+      }
+    }
+    if (!next) {
+      break;
+    }
+
+    if (next->deadlineUs > virtualUs) {
+      virtualUs = next->deadlineUs;
+    }
+    next->armed = false;
+    next->callback(next->arg);
+  }
+  virtualUs = us;
+}
+
+}  // namespace host
+
+uint32_t millis() {
+  return static_cast<uint32_t>(host::timeUs() / 1000);
+}
+
+uint32_t micros() {
+  return static_cast<uint32_t>(host::timeUs());
+}
+
+void delayMicroseconds(uint32_t) {}
+
+int64_t esp_timer_get_time() {
+  return static_cast<int64_t>(host::timeUs());
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t* args, esp_timer_handle_t* out) {
+  HostTimer* timer = new HostTimer{args->callback, args->arg, 0, false};
+  timers.push_back(timer);
+  *out = timer;
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeoutUs) {
+  timer->deadlineUs = host::timeUs() + timeoutUs;
+  timer->armed = true;
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+  timer->armed = false;
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer) {
+  for (size_t i = 0; i < timers.size(); ++i) {
+    if (timers[i] == timer) {
+      timers.erase(timers.begin() + i);
+      break;
+    }
+  }
+  delete timer;
+  return ESP_OK;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <stdint.h>
+
+// Relogio do host para o bench. Por padrao millis()/micros()/
+// esp_timer_get_time() seguem o relogio real; com o relogio virtual ligado
+// so andam por setTimeUs()/runTimersUntil().
+namespace host {
+
+void useVirtualClock(bool on);
+uint64_t timeUs();
+void setTimeUs(uint64_t us);
+
+// Avanca o relogio virtual ate 'us' disparando, em ordem, os esp_timer
+// armados que vencem no caminho (cada um exatamente no seu prazo).
+void runTimersUntil(uint64_t us);
+
+}  // namespace host
@@ -0,0 +1,79 @@
+#include "host_heap.h"
+
+#include <stdlib.h>
+
+#include <cstddef>
+#include <new>
+
+namespace {
+
+// Cada bloco leva o tamanho pedido num cabecalho alinhado.
+constexpr size_t kHeader = alignof(std::max_align_t);
+
+size_t inUse = 0;
+size_t peak = 0;
+size_t allocations = 0;
+
+void* allocate(size_t size) {
+  unsigned char* block = static_cast<unsigned char*>(malloc(size + kHeader));
+  if (block == nullptr) {
+    return nullptr;
+  }
+  *reinterpret_cast<size_t*>(block) = size;
+  ++allocations;
+  inUse += size;
+  if (inUse > peak) {
+    peak = inUse;
+  }
+  return block + kHeader;
+}
+
+void release(void* ptr) {
+  if (ptr == nullptr) {
+    return;
+  }
+  unsigned char* block = static_cast<unsigned char*>(ptr) - kHeader;
+  inUse -= *reinterpret_cast<size_t*>(block);
+  free(block);
+}
+
+void* allocateOrThrow(size_t size) {
+  void* ptr = allocate(size);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+}  // namespace
+
+namespace host {
+
+size_t heapInUse() {
+  return inUse;
+}
+
+size_t heapPeak() {
+  return peak;
+}
+
+size_t heapAllocations() {
+  return allocations;
+}
+
+void resetHeapPeak() {
+  peak = inUse;
+}
+
+}  // namespace host
+
+void* operator new(size_t size) { return allocateOrThrow(size); }
+void* operator new[](size_t size) { return allocateOrThrow(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+void operator delete(void* ptr) noexcept { release(ptr); }
+void operator delete[](void* ptr) noexcept { release(ptr); }
+void operator delete(void* ptr, size_t) noexcept { release(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { release(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { release(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { release(ptr); }
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <stddef.h>
+
+// Contabilidade do heap do host: host_heap.cpp troca os operator new/delete
+// globais, entao tudo que passa por new (String, std::vector, Assembly)
+// entra na conta. malloc() direto nao.
+namespace host {
+
+size_t heapInUse();
+size_t heapPeak();
+// Chamadas a new desde o inicio do programa.
+size_t heapAllocations();
+// Recomeca o pico a partir do uso atual.
+void resetHeapPeak();
+
+}  // namespace host
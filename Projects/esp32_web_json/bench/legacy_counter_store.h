@@ -0,0 +1,61 @@
+#pragma once
+
+#include <Arduino.h>
+
+// CounterStore anterior aos ids internados (busca linear com
+// equalsIgnoreCase em 16 entradas String), mantido so como referencia
+// do "antes" no benchmark.
+class LegacyCounterStore {
+public:
+  static constexpr size_t kMaxCounters = 16;
+
+  bool increment(const String& name, int32_t amount = 1) {
+    const int index = findOrCreate(name);
+    if (index < 0) {
+      return false;
+    }
+
+    entries_[index].value += amount;
+    return true;
+  }
+
+  int32_t get(const String& name) const {
+    const int index = findIndex(name);
+    return index < 0 ? 0 : entries_[index].value;
+  }
+
+private:
+  struct Entry {
+    String name;
+    int32_t value = 0;
+    bool used = false;
+  };
+
+  Entry entries_[kMaxCounters];
+
+  int findIndex(const String& name) const {
+    for (size_t i = 0; i < kMaxCounters; ++i) {
+      if (entries_[i].used && entries_[i].name.equalsIgnoreCase(name)) {
+        return static_cast<int>(i);
+      }
+    }
+    return -1;
+  }
+
+  int findOrCreate(const String& name) {
+    const int found = findIndex(name);
+    if (found >= 0) {
+      return found;
+    }
+
+    for (size_t i = 0; i < kMaxCounters; ++i) {
+      if (!entries_[i].used) {
+        entries_[i].used = true;
+        entries_[i].name = name;
+        entries_[i].value = 0;
+        return static_cast<int>(i);
+      }
+    }
+    return -1;
+  }
+};
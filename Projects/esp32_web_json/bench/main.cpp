@@ -0,0 +1,645 @@
+// Benchmark no host do runtime de scripts (pio run -e native &&
+// .pio/build/native/program [iteracoes]).
+//
+//   counters  COUNT x INC: CounterStore antigo (busca linear por String)
+//             x novo por nome (hash) x novo por id (o que o ScriptVM faz)
+//   vm        instrucoes COUNT por segundo em ScriptVM::tick() e bytes de
+//             bytecode por instrucao
+//   scheduler custo de ScriptScheduler::tick() com os slots em WAIT
+//   jitter    atraso dos despertares de um pulso WAITUS: loop() a cada 1 ms
+//             x ScriptTimer (relogio virtual, timer ideal)
+//   parse     compilar um script de ~10 KB: corpo inteiro num String (como
+//             server_.arg("plain")) x feed() em blocos de 1436 bytes (como
+//             o upload cru do WebServer); tempo e pico de heap
+//   soak      muitos polls do JSON de status: toJson() antigo com String x
+//             JsonWriter num buffer de 256 bytes; alocacoes por poll e heap
+//             em uso ao longo do teste
+//
+// Antes de medir confere o CounterStore (maiusculas, crescimento ate
+// kMaxCounters), o JsonWriter (escape, numeros, blocos, estouro), a
+// execucao do bytecode, a carga em pedacos (byte a byte igual ao script
+// inteiro, coluna do erro), a intercalacao dos slots do ScriptScheduler e
+// o modo timer (em relogio virtual); codigo de saida 1 se algo divergir.
+
+#include <Arduino.h>
+#include <JsonWriter.h>
+
+#include <chrono>
+#include <string>
+
+#include "counters/counter_store.h"
+#include "host_clock.h"
+#include "host_heap.h"
+#include "legacy_counter_store.h"
+#include "vm/script_scheduler.h"
+#include "vm/script_vm.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t kNames = 16;
+constexpr uint32_t kDefaultIterations = 2000000;
+constexpr const char* kPulseScript = "LOOP\nON 2\nWAITUS 250\nOFF 2\nWAITUS 750\nEND\n";
+constexpr size_t kParseScriptBytes = 10 * 1024;
+constexpr size_t kUploadChunk = 1436;  // HTTP_RAW_BUFLEN do WebServer
+
+// Impede o compilador de juntar as iteracoes do laco medido.
+inline void clobber() {
+  asm volatile("" ::: "memory");
+}
+
+double nsSince(Clock::time_point t0) {
+  return std::chrono::duration<double, std::nano>(Clock::now() - t0).count();
+}
+
+String counterName(size_t i) {
+  return String("contador_") + String(static_cast<unsigned>(i));
+}
+
+// JSON dos writeX() num buffer da pilha, para mensagens e comparacoes.
+String statusOf(const ScriptVM& vm) {
+  char buffer[512];
+  JsonWriter json(buffer, sizeof(buffer));
+  json.beginObject();
+  vm.writeStatusFields(json);
+  json.endObject();
+  return String(json.c_str());
+}
+
+String countersOf(const CounterStore& store) {
+  char buffer[2048];
+  JsonWriter json(buffer, sizeof(buffer));
+  store.writeJson(json);
+  return String(json.c_str());
+}
+
+// CounterStore::toJson() como era antes do JsonWriter.
+String legacyCountersJson(const CounterStore& store) {
+  String json = "[";
+
+  for (size_t i = 0; i < store.size(); ++i) {
+    if (i > 0) {
+      json += ",";
+    }
+
+    String safeName = store.name(static_cast<CounterStore::Id>(i));
+    safeName.replace("\\", "\\\\");
+    safeName.replace("\"", "\\\"");
+
+    json += "{\"name\":\"" + safeName + "\",\"value\":" + String(store.value(static_cast<CounterStore::Id>(i))) + "}";
+  }
+
+  json += "]";
+  return json;
+}
+
+void appendTo(void* context, const char* data, size_t length) {
+  static_cast<std::string*>(context)->append(data, length);
+}
+
+void discard(void* context, const char*, size_t length) {
+  *static_cast<size_t*>(context) += length;
+}
+
+void writeSample(JsonWriter& json) {
+  json.beginObject();
+  json.field("a", 1);
+  json.key("b").beginArray().value(true).value(false).null().endArray();
+  json.field("s", "q\"\\\n\x01");
+  json.field("n", INT32_MIN);
+  json.field("u", UINT64_MAX);
+  json.field("f", -1.25, 1);
+  json.field("g", 812.5f, 1);
+  json.field("z", -0.01, 1);
+  json.field("x", NAN, 2);
+  json.key("e").beginObject().endObject();
+  json.key("l").beginArray().beginArray().endArray().beginArray().value(1u).endArray().endArray();
+  json.endObject();
+}
+
+bool checkJson() {
+  const char* expected =
+      "{\"a\":1,\"b\":[true,false,null],\"s\":\"q\\\"\\\\\\n\\u0001\",\"n\":-2147483648,"
+      "\"u\":18446744073709551615,\"f\":-1.3,\"g\":812.5,\"z\":0.0,\"x\":null,\"e\":{},\"l\":[[],[1]]}";
+
+  char buffer[256];
+  JsonWriter whole(buffer, sizeof(buffer));
+  writeSample(whole);
+  if (whole.overflowed() || strcmp(whole.c_str(), expected) != 0) {
+    fprintf(stderr, "[CHECK] JsonWriter: %s\n", whole.c_str());
+    return false;
+  }
+
+  // Em blocos de 7 bytes pelo sink, sem tocar no heap.
+  std::string chunked;
+  chunked.reserve(256);
+  char small[7];
+  const size_t allocations = host::heapAllocations();
+  JsonWriter streamed(small, sizeof(small), appendTo, &chunked);
+  writeSample(streamed);
+  streamed.flush();
+  if (chunked != expected || host::heapAllocations() != allocations) {
+    fprintf(stderr, "[CHECK] JsonWriter em blocos: %s\n", chunked.c_str());
+    return false;
+  }
+
+  JsonWriter tiny(small, sizeof(small));
+  writeSample(tiny);
+  if (!tiny.overflowed() || strlen(tiny.c_str()) != sizeof(small) - 1 || tiny.total() != strlen(expected)) {
+    fprintf(stderr, "[CHECK] JsonWriter sem estouro sinalizado\n");
+    return false;
+  }
+
+  // Limite de 9e15 sobre o valor escalado pelas casas decimais.
+  JsonWriter edge(buffer, sizeof(buffer));
+  edge.beginArray();
+  edge.value(8.0e9, 6).value(9.0e9, 6).value(9.0e9, 1).value(2.0e13, 6).value(1.0e10, 200);
+  edge.endArray();
+  const char* edgeExpected = "[8000000000.000000,null,9000000000.0,null,null]";
+  if (edge.overflowed() || strcmp(edge.c_str(), edgeExpected) != 0) {
+    fprintf(stderr, "[CHECK] JsonWriter no limite: %s\n", edge.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool check() {
+  CounterStore store;
+  bool ok = true;
+
+  for (size_t i = 0; i < CounterStore::kMaxCounters; ++i) {
+    if (store.intern(counterName(i)) != i) {
+      fprintf(stderr, "[CHECK] intern(%zu) fora de ordem\n", i);
+      ok = false;
+    }
+  }
+  if (store.intern("excedente") != CounterStore::kInvalidId) {
+    fprintf(stderr, "[CHECK] aceitou contador alem de kMaxCounters\n");
+    ok = false;
+  }
+  if (store.find("CONTADOR_700") != 700 || store.find("contador_7000") != CounterStore::kInvalidId) {
+    fprintf(stderr, "[CHECK] busca sem maiusculas divergiu\n");
+    ok = false;
+  }
+
+  store.increment("Contador_3", 5);
+  store.decrement("contador_3", 2);
+  if (store.get("CONTADOR_3") != 3 || store.value(3) != 3) {
+    fprintf(stderr, "[CHECK] valor por nome x por id divergiu\n");
+    ok = false;
+  }
+  return ok;
+}
+
+bool expectError(ScriptVM& vm, const char* script, const char* expected) {
+  String error;
+  if (vm.loadScript(script, error) || error != expected) {
+    fprintf(stderr, "[CHECK] esperado \"%s\", veio \"%s\"\n", expected, error.c_str());
+    return false;
+  }
+  return true;
+}
+
+// Script de ~10 KB com comentarios longos (o bytecode cabe em kCodeBytes).
+String parseScript() {
+  String script;
+  for (size_t i = 0; script.length() < kParseScriptBytes; ++i) {
+    const String block = "b" + String(static_cast<unsigned>(i / 8));
+    if (i % 8 == 0) {
+      script += "LABEL " + block + "\n";
+    }
+    script += "  COUNT " + counterName(i % kNames) + " INC " + String(static_cast<unsigned>(i)) +
+              "   # incrementa o contador do passo, comentario so para encher\r\n";
+    if (i % 8 == 7) {
+      script += "  IF COUNT " + counterName(i % kNames) + " >= 100000 JMP " + block + "\n";
+    }
+  }
+  return script;
+}
+
+// feed() em blocos de 'chunk' bytes.
+bool feedChunks(ScriptVM& vm, const String& script, size_t chunk, String& error) {
+  vm.beginLoad();
+  for (size_t at = 0; at < script.length(); at += chunk) {
+    const size_t length = script.length() - at < chunk ? script.length() - at : chunk;
+    if (!vm.feed(script.c_str() + at, length)) {
+      break;
+    }
+  }
+  return vm.endLoad(error);
+}
+
+bool checkStreaming() {
+  CounterStore store;
+  ScriptVM whole(store);
+  ScriptVM bytes(store);
+  String error;
+  const String script = parseScript();
+
+  if (!whole.loadScript(script, error) || !feedChunks(bytes, script, 1, error) ||
+      statusOf(whole) != statusOf(bytes)) {
+    fprintf(stderr, "[CHECK] carga em pedacos divergiu (%s)\n", error.c_str());
+    return false;
+  }
+
+  // Sem '\n' no fim, e o erro no meio de um bloco.
+  if (feedChunks(bytes, "ON 1\r\n\tWAIT 1x", 3, error) || error != "Linha 2, coluna 7: delay invalido.") {
+    fprintf(stderr, "[CHECK] coluna do erro divergiu: %s\n", error.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool checkControlFlow() {
+  CounterStore store;
+  ScriptVM vm(store);
+  String error;
+  const char* script =
+      "COUNT i SET 0\n"
+      "LABEL topo\n"
+      "COUNT i INC\n"
+      "IF COUNT i < 10 JMP topo\n"
+      "LOOP 3\n"
+      "  LOOP 4\n"
+      "    COUNT n INC\n"
+      "  END\n"
+      "END\n"
+      "JMP pula\n"
+      "COUNT nunca INC\n"
+      "LABEL pula\n"
+      "IF IN 5 JMP fim   # digitalRead() do shim le LOW\n"
+      "COUNT baixo INC\n"
+      "LABEL fim\n";
+  if (!vm.loadScript(script, error)) {
+    fprintf(stderr, "[CHECK] %s\n", error.c_str());
+    return false;
+  }
+
+  vm.start();
+  for (int i = 0; i < 16 && vm.isRunning(); ++i) {
+    vm.tick();
+  }
+  if (vm.isRunning() || store.get("i") != 10 || store.get("n") != 12 || store.get("nunca") != 0 ||
+      store.get("baixo") != 1) {
+    fprintf(stderr, "[CHECK] desvios divergiram: %s\n", countersOf(store).c_str());
+    return false;
+  }
+
+  // Laco infinito sem WAIT: cada tick() para no limite de instrucoes.
+  vm.loadScript("LOOP\nCOUNT giro INC\nEND\n", error);
+  vm.start();
+  vm.tick();
+  const int32_t perTick = store.get("giro");
+  vm.tick();
+  if (!vm.isRunning() || perTick == 0 || store.get("giro") != 2 * perTick) {
+    fprintf(stderr, "[CHECK] limite por tick divergiu (%d)\n", static_cast<int>(perTick));
+    return false;
+  }
+
+  return expectError(vm, "JMP lugar\n", "Linha 1, coluna 5: rotulo nao definido (lugar).") &&
+         expectError(vm, "LABEL a\nLABEL A\n", "Linha 2, coluna 7: rotulo repetido (A).") &&
+         expectError(vm, "LOOP 2\nON 1\n", "Linha 1, coluna 1: LOOP sem END.") &&
+         expectError(vm, "END\n", "Linha 1, coluna 1: END sem LOOP.") &&
+         expectError(vm, "IF COUNT x ~ 1 JMP a\n", "Linha 1, coluna 12: sintaxe invalida em IF COUNT.");
+}
+
+bool checkScheduler() {
+  CounterStore store;
+  ScriptScheduler scheduler(store);
+  String error;
+  host::useVirtualClock(true);
+  host::setTimeUs(0xFFFFFF00ull * 1000);  // Alem da volta de millis() em 32 bits
+
+  bool ok = scheduler.load(0, "LOOP\nCOUNT a INC\nWAIT 10\nEND\n", error) &&
+            scheduler.load(1, "LOOP\nCOUNT b INC\nWAIT 25\nEND\n", error) &&
+            scheduler.load(2, "COUNT c INC\n", error);
+  scheduler.start(0);
+  scheduler.start(1);
+  scheduler.start(2);
+
+  for (uint32_t t = 0; t <= 100; ++t) {
+    scheduler.tick();
+    host::setTimeUs(host::timeUs() + 1000);
+  }
+  ok = ok && store.get("a") == 11 && store.get("b") == 5 && store.get("c") == 1 && scheduler.runnableCount() == 2;
+
+  scheduler.stop(1);
+  ok = ok && scheduler.runnableCount() == 1 && !scheduler.task(1).isRunning();
+
+  // Modo timer: fora do heap, e so para scripts sem contadores.
+  ok = ok && !scheduler.startTimed(2, error) && scheduler.load(3, kPulseScript, error) &&
+       scheduler.startTimed(3, error) && scheduler.runnableCount() == 1;
+  host::runTimersUntil(host::timeUs() + 10000);
+  ok = ok && scheduler.task(3).isRunning() && scheduler.task(3).wakeAtUs() > host::timeUs();
+  scheduler.stop(3);
+  host::runTimersUntil(host::timeUs() + 10000);
+  ok = ok && !scheduler.task(3).isRunning();
+  // LOOP sem WAIT para no limite de instrucoes: o timer volta com atraso
+  // minimo em vez de 0 (sem isso runTimersUntil() nao sai daqui).
+  ok = ok && scheduler.load(3, "LOOP\nON 2\nOFF 2\nEND\n", error) && scheduler.startTimed(3, error);
+  host::runTimersUntil(host::timeUs() + 10000);
+  ok = ok && scheduler.task(3).isRunning() && scheduler.task(3).wakeAtUs() == 0;
+  scheduler.stop(3);
+  host::useVirtualClock(false);
+
+  if (!ok) {
+    fprintf(stderr, "[CHECK] escalonador divergiu (%s): %s\n", error.c_str(), countersOf(store).c_str());
+  }
+  return ok;
+}
+
+bool checkVm() {
+  CounterStore store;
+  ScriptVM vm(store);
+  String error;
+  const char* script =
+      "ON 2\n"
+      "COUNT a INC 300\n"
+      "COUNT A DEC 2   # comentario\n"
+      "COUNT b SET -70000\n"
+      "COUNT c SET 9\n"
+      "COUNT c RESET\n"
+      "COUNT d DEC\n"
+      "OFF 2\n";
+  if (!vm.loadScript(script, error)) {
+    fprintf(stderr, "[CHECK] %s\n", error.c_str());
+    return false;
+  }
+
+  vm.start();
+  vm.tick();
+  if (vm.isRunning() || store.get("a") != 298 || store.get("b") != -70000 || store.get("c") != 0 ||
+      store.get("d") != -1) {
+    fprintf(stderr, "[CHECK] bytecode divergiu: %s\n", countersOf(store).c_str());
+    return false;
+  }
+
+  if (vm.loadScript("ON 2\nBLINK 3\n", error) || error != "Linha 2, coluna 1: comando desconhecido (BLINK).") {
+    fprintf(stderr, "[CHECK] erro de sintaxe inesperado: %s\n", error.c_str());
+    return false;
+  }
+  return checkStreaming() && checkControlFlow();
+}
+
+void benchCounters(uint32_t iterations) {
+  String names[kNames];
+  for (size_t i = 0; i < kNames; ++i) {
+    names[i] = counterName(i);
+  }
+
+  // O ultimo nome e o pior caso da busca linear antiga.
+  const String& hot = names[kNames - 1];
+  volatile int32_t sink = 0;
+
+  LegacyCounterStore legacy;
+  for (const String& name : names) {
+    legacy.increment(name, 0);
+  }
+  Clock::time_point t0 = Clock::now();
+  for (uint32_t i = 0; i < iterations; ++i) {
+    legacy.increment(hot);
+    clobber();
+  }
+  const double legacyNs = nsSince(t0) / iterations;
+  sink = legacy.get(hot);
+
+  CounterStore store;
+  for (const String& name : names) {
+    store.intern(name);
+  }
+  t0 = Clock::now();
+  for (uint32_t i = 0; i < iterations; ++i) {
+    store.increment(hot);
+    clobber();
+  }
+  const double byNameNs = nsSince(t0) / iterations;
+
+  const CounterStore::Id id = store.find(hot);
+  t0 = Clock::now();
+  for (uint32_t i = 0; i < iterations; ++i) {
+    store.add(id, 1);
+    clobber();
+  }
+  const double byIdNs = nsSince(t0) / iterations;
+  sink = store.value(id);
+  (void)sink;
+
+  printf("counters (%zu nomes, %u x INC)\n", kNames, iterations);
+  printf("  antes  String linear   %8.2f ns/op  %10.0f op/s\n", legacyNs, 1e9 / legacyNs);
+  printf("  depois nome (hash)     %8.2f ns/op  %10.0f op/s\n", byNameNs, 1e9 / byNameNs);
+  printf("  depois id internado    %8.2f ns/op  %10.0f op/s\n", byIdNs, 1e9 / byIdNs);
+}
+
+void benchVm(uint32_t iterations) {
+  String script;
+  for (size_t i = 0; i < 128; ++i) {
+    script += "COUNT " + counterName(i % kNames) + " INC\n";
+  }
+
+  CounterStore store;
+  ScriptVM vm(store);
+  String error;
+  if (!vm.loadScript(script, error)) {
+    fprintf(stderr, "[VM] %s\n", error.c_str());
+    return;
+  }
+
+  const uint32_t runs = iterations / 128 + 1;
+  Clock::time_point t0 = Clock::now();
+  for (uint32_t r = 0; r < runs; ++r) {
+    vm.start();
+    while (vm.isRunning()) {
+      vm.tick();
+    }
+  }
+  const double ns = nsSince(t0) / (runs * 128.0);
+
+  printf("vm (ScriptVM::tick, COUNT x INC)\n");
+  printf("  %8.2f ns/instr  %10.0f instr/s\n", ns, 1e9 / ns);
+  printf("  sizeof(ScriptVM) %zu bytes\n", sizeof(ScriptVM));
+}
+
+void benchScheduler(uint32_t iterations) {
+  CounterStore store;
+  ScriptScheduler scheduler(store);
+  String error;
+  for (size_t slot = 0; slot < ScriptScheduler::kMaxTasks; ++slot) {
+    scheduler.load(slot, "LOOP\nWAIT 60000\nEND\n", error);
+    scheduler.start(slot);
+  }
+  scheduler.tick();
+
+  Clock::time_point t0 = Clock::now();
+  for (uint32_t i = 0; i < iterations; ++i) {
+    scheduler.tick();
+    clobber();
+  }
+  const double ns = nsSince(t0) / iterations;
+
+  printf("scheduler (%zu slots em WAIT)\n", ScriptScheduler::kMaxTasks);
+  printf("  %8.2f ns/tick\n", ns);
+}
+
+void benchJitter() {
+  CounterStore store;
+  ScriptScheduler scheduler(store);
+  String error;
+  scheduler.load(0, kPulseScript, error);
+
+  host::useVirtualClock(true);
+  host::setTimeUs(0);
+
+  // loop() como em main.cpp: tick() a cada 1 ms, fora de fase com o pulso.
+  scheduler.start(0);
+  for (uint64_t t = 0; t < 1000000; t += 1000) {
+    host::setTimeUs(t + 137);
+    scheduler.tick();
+  }
+  const String loopStatus = statusOf(scheduler.task(0));
+
+  scheduler.startTimed(0, error);
+  host::runTimersUntil(host::timeUs() + 1000000);
+  const String timerStatus = statusOf(scheduler.task(0));
+  scheduler.stop(0);
+  host::useVirtualClock(false);
+
+  printf("jitter (ON 250 us / OFF 750 us, 1 s)\n");
+  printf("  loop  %s\n", loopStatus.c_str());
+  printf("  timer %s\n", timerStatus.c_str());
+}
+
+void benchParse(uint32_t iterations) {
+  CounterStore store;
+  ScriptVM vm(store);
+  String error;
+  const String source = parseScript();
+  const uint32_t runs = iterations / 20000 + 1;
+
+  // Antes: o WebServer junta o corpo num String e loadScript() o percorre.
+  size_t base = host::heapInUse();
+  host::resetHeapPeak();
+  Clock::time_point t0 = Clock::now();
+  for (uint32_t r = 0; r < runs; ++r) {
+    const String body(source.c_str());
+    vm.loadScript(body, error);
+  }
+  const double wholeUs = nsSince(t0) / runs / 1000.0;
+  const size_t wholePeak = host::heapPeak() - base;
+
+  base = host::heapInUse();
+  host::resetHeapPeak();
+  t0 = Clock::now();
+  bool ok = true;
+  for (uint32_t r = 0; r < runs; ++r) {
+    ok = feedChunks(vm, source, kUploadChunk, error) && ok;
+  }
+  const double streamUs = nsSince(t0) / runs / 1000.0;
+  const size_t streamPeak = host::heapPeak() - base;
+  if (!ok) {
+    fprintf(stderr, "[PARSE] %s\n", error.c_str());
+    return;
+  }
+
+  printf("parse (%u bytes, %s)\n", source.length(), statusOf(vm).c_str());
+  printf("  String inteiro  %8.1f us  %6.2f MB/s  pico heap %6zu bytes\n", wholeUs, source.length() / wholeUs,
+         wholePeak);
+  printf("  feed %4zu bytes %8.1f us  %6.2f MB/s  pico heap %6zu bytes\n", kUploadChunk, streamUs,
+         source.length() / streamUs, streamPeak);
+}
+
+// Heap em uso em 5 pontos do teste: no host nao ha fragmentacao para
+// medir, entao vale a tendencia (no ESP32, "heap" de /api/status).
+struct HeapTrend {
+  size_t samples[5];
+  size_t count = 0;
+
+  void sample() {
+    if (count < 5) {
+      samples[count++] = host::heapInUse();
+    }
+  }
+
+  String text() const {
+    String out;
+    for (size_t i = 0; i < count; ++i) {
+      out += " " + String(static_cast<unsigned long>(samples[i]));
+    }
+    return out;
+  }
+};
+
+void benchSoak(uint32_t iterations) {
+  CounterStore store;
+  ScriptScheduler scheduler(store);
+  String error;
+  for (size_t i = 0; i < kNames; ++i) {
+    store.set(counterName(i) + "_\"aspas\"", static_cast<int32_t>(i * 1000));
+  }
+  for (size_t slot = 0; slot < ScriptScheduler::kMaxTasks; ++slot) {
+    scheduler.load(slot, kPulseScript, error);
+  }
+
+  const uint32_t polls = iterations / 20 + 1;
+  const uint32_t checkpoint = polls / 4 + 1;
+  size_t sent = 0;
+
+  // Antes: cada poll monta e descarta um String.
+  HeapTrend legacyTrend;
+  size_t allocations = host::heapAllocations();
+  Clock::time_point t0 = Clock::now();
+  for (uint32_t i = 0; i < polls; ++i) {
+    const String json = legacyCountersJson(store);
+    sent += json.length();
+    if (i % checkpoint == 0) {
+      legacyTrend.sample();
+    }
+  }
+  const double legacyNs = nsSince(t0) / polls;
+  const double legacyAllocs = static_cast<double>(host::heapAllocations() - allocations) / polls;
+
+  // Depois: /api/tasks inteiro (slots + contadores) num buffer de 256 bytes.
+  HeapTrend writerTrend;
+  allocations = host::heapAllocations();
+  t0 = Clock::now();
+  for (uint32_t i = 0; i < polls; ++i) {
+    char buffer[256];
+    JsonWriter json(buffer, sizeof(buffer), discard, &sent);
+    json.beginObject().key("tasks");
+    scheduler.writeTasks(json);
+    json.field("runnable", scheduler.runnableCount());
+    json.key("counters");
+    store.writeJson(json);
+    json.endObject();
+    json.flush();
+    if (i % checkpoint == 0) {
+      writerTrend.sample();
+    }
+  }
+  const double writerNs = nsSince(t0) / polls;
+  const double writerAllocs = static_cast<double>(host::heapAllocations() - allocations) / polls;
+
+  printf("soak (%u polls, %zu contadores, %zu bytes enviados)\n", polls, kNames, sent);
+  printf("  antes  toJson String      %8.0f ns/poll  %6.2f alocacoes/poll  heap em uso:%s\n", legacyNs,
+         legacyAllocs, legacyTrend.text().c_str());
+  printf("  depois JsonWriter /tasks  %8.0f ns/poll  %6.2f alocacoes/poll  heap em uso:%s\n", writerNs,
+         writerAllocs, writerTrend.text().c_str());
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const uint32_t iterations = argc > 1 ? static_cast<uint32_t>(strtoul(argv[1], nullptr, 10)) : kDefaultIterations;
+
+  if (!check() || !checkJson() || !checkVm() || !checkScheduler()) {
+    return 1;
+  }
+
+  benchCounters(iterations);
+  benchVm(iterations);
+  benchScheduler(iterations);
+  benchJitter();
+  benchParse(iterations);
+  benchSoak(iterations);
+  return 0;
+}
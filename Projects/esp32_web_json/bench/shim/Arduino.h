@@ -0,0 +1,108 @@
+#pragma once
+
+// Subconjunto do core Arduino-ESP32 usado por CounterStore e ScriptVM, para
+// compilar e medir no host (env:native). O relogio vem de host_clock.h; os
+// pinos nao fazem nada.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <math.h>
+#include <string>
+
+#define LOW 0
+#define HIGH 1
+#define INPUT 0x01
+#define OUTPUT 0x03
+
+uint32_t millis();
+uint32_t micros();
+void delayMicroseconds(uint32_t us);
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t, uint8_t) {}
+inline int digitalRead(uint8_t) { return LOW; }
+
+// Secoes criticas do FreeRTOS: no host os timers rodam na mesma thread.
+typedef int portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED 0
+#define portENTER_CRITICAL(mux) ((void)(mux))
+#define portEXIT_CRITICAL(mux) ((void)(mux))
+
+class String {
+public:
+  String(const char* s = "") : s_(s ? s : "") {}
+  String(const std::string& s) : s_(s) {}
+  explicit String(char c) : s_(1, c) {}
+  explicit String(int v) : s_(std::to_string(v)) {}
+  explicit String(unsigned v) : s_(std::to_string(v)) {}
+  explicit String(long v) : s_(std::to_string(v)) {}
+  explicit String(unsigned long v) : s_(std::to_string(v)) {}
+
+  const char* c_str() const { return s_.c_str(); }
+  unsigned int length() const { return static_cast<unsigned int>(s_.size()); }
+  bool isEmpty() const { return s_.empty(); }
+  long toInt() const { return strtol(s_.c_str(), nullptr, 10); }
+
+  int indexOf(char c, unsigned int from = 0) const {
+    const size_t pos = s_.find(c, from);
+    return pos == std::string::npos ? -1 : static_cast<int>(pos);
+  }
+  String substring(unsigned int from, unsigned int to) const {
+    if (from >= s_.size() || to <= from) {
+      return String();
+    }
+    return String(s_.substr(from, to - from));
+  }
+  void replace(const char* find, const char* with) {
+    const size_t findLen = strlen(find);
+    const size_t withLen = strlen(with);
+    for (size_t pos = s_.find(find); pos != std::string::npos; pos = s_.find(find, pos + withLen)) {
+      s_.replace(pos, findLen, with);
+    }
+  }
+  void trim() {
+    const size_t first = s_.find_first_not_of(" \t\r\n");
+    if (first == std::string::npos) {
+      s_.clear();
+      return;
+    }
+    s_ = s_.substr(first, s_.find_last_not_of(" \t\r\n") - first + 1);
+  }
+  void toUpperCase() {
+    for (char& c : s_) {
+      c = static_cast<char>(toupper(static_cast<unsigned char>(c)));
+    }
+  }
+  bool equalsIgnoreCase(const String& s) const {
+    return s_.size() == s.s_.size() && strcasecmp(s_.c_str(), s.s_.c_str()) == 0;
+  }
+
+  String& operator+=(const String& s) {
+    s_ += s.s_;
+    return *this;
+  }
+  String& operator+=(const char* s) {
+    s_ += s;
+    return *this;
+  }
+  String& operator+=(char c) {
+    s_ += c;
+    return *this;
+  }
+  friend String operator+(const String& a, const String& b) { return String(a.s_ + b.s_); }
+  friend String operator+(const String& a, const char* b) { return String(a.s_ + b); }
+  friend String operator+(const char* a, const String& b) { return String(a + b.s_); }
+
+  char operator[](unsigned int i) const { return i < s_.size() ? s_[i] : '\0'; }
+  bool operator==(const char* s) const { return s && s_ == s; }
+  bool operator==(const String& s) const { return s_ == s.s_; }
+  bool operator!=(const char* s) const { return !(*this == s); }
+  bool operator!=(const String& s) const { return !(*this == s); }
+
+private:
+  std::string s_;
+};
@@ -1,38 +1,87 @@
 #include "counter_store.h"
 
+#include <strings.h>
+
 CounterStore::CounterStore() {
   clear();
 }
 
+CounterStore::Id CounterStore::intern(const char* name, size_t length) {
+  if (length == 0 || length > kMaxNameLength) {
+    return kInvalidId;
+  }
+
+  const uint32_t hash = hashName(name, length);
+  size_t slot = probe(name, length, hash);
+  if (slots_[slot] != kEmptySlot) {
+    return slots_[slot];
+  }
+
+  if (values_.size() >= kMaxCounters) {
+    return kInvalidId;
+  }
+
+  if ((values_.size() + 1) * 2 > slots_.size()) {
+    rehash(slots_.size() * 2);
+    slot = probe(name, length, hash);
+  }
+
+  const Id id = static_cast<Id>(values_.size());
+  nameOffsets_.push_back(static_cast<uint16_t>(names_.size()));
+  nameLengths_.push_back(static_cast<uint8_t>(length));
+  names_.insert(names_.end(), name, name + length);
+  names_.push_back('\0');
+  hashes_.push_back(hash);
+  values_.push_back(0);
+  slots_[slot] = id;
+  return id;
+}
+
+CounterStore::Id CounterStore::intern(const String& name) {
+  return intern(name.c_str(), name.length());
+}
+
+CounterStore::Id CounterStore::find(const char* name, size_t length) const {
+  if (length == 0 || length > kMaxNameLength) {
+    return kInvalidId;
+  }
+
+  return slots_[probe(name, length, hashName(name, length))];
+}
+
+CounterStore::Id CounterStore::find(const String& name) const {
+  return find(name.c_str(), name.length());
+}
+
 bool CounterStore::exists(const String& name) const {
-  return findIndex(name) >= 0;
+  return find(name) != kInvalidId;
 }
 
 int32_t CounterStore::get(const String& name) const {
-  const int index = findIndex(name);
-  if (index < 0) {
+  const Id id = find(name);
+  if (id == kInvalidId) {
     return 0;
   }
-  return entries_[index].value;
+  return values_[id];
 }
 
 bool CounterStore::set(const String& name, int32_t value) {
-  const int index = findOrCreate(name);
-  if (index < 0) {
+  const Id id = intern(name);
+  if (id == kInvalidId) {
     return false;
   }
 
-  entries_[index].value = value;
+  values_[id] = value;
   return true;
 }
 
 bool CounterStore::increment(const String& name, int32_t amount) {
-  const int index = findOrCreate(name);
-  if (index < 0) {
+  const Id id = intern(name);
+  if (id == kInvalidId) {
     return false;
   }
 
-  entries_[index].value += amount;
+  values_[id] += amount;
   return true;
 }
 
@@ -44,63 +93,73 @@ bool CounterStore::reset(const String& name) {
   return set(name, 0);
 }
 
-void CounterStore::clear() {
-  for (size_t i = 0; i < kMaxCounters; ++i) {
-    entries_[i].name = "";
-    entries_[i].value = 0;
-    entries_[i].used = false;
+void CounterStore::resetAll() {
+  for (int32_t& value : values_) {
+    value = 0;
   }
 }
 
-String CounterStore::toJson() const {
-  String json = "[";
-  bool first = true;
-
-  for (size_t i = 0; i < kMaxCounters; ++i) {
-    if (!entries_[i].used) {
-      continue;
-    }
-
-    if (!first) {
-      json += ",";
-    }
-    first = false;
-
-    String safeName = entries_[i].name;
-    safeName.replace("\\", "\\\\");
-    safeName.replace("\"", "\\\"");
+void CounterStore::clear() {
+  values_.clear();
+  hashes_.clear();
+  nameOffsets_.clear();
+  nameLengths_.clear();
+  names_.clear();
+  values_.reserve(kInitialCapacity);
+  hashes_.reserve(kInitialCapacity);
+  nameOffsets_.reserve(kInitialCapacity);
+  nameLengths_.reserve(kInitialCapacity);
+  slots_.assign(kInitialCapacity * 2, kEmptySlot);
+}
 
-    json += "{\"name\":\"" + safeName + "\",\"value\":" + String(entries_[i].value) + "}";
+void CounterStore::writeJson(JsonWriter& json) const {
+  json.beginArray();
+  for (size_t i = 0; i < values_.size(); ++i) {
+    json.beginObject();
+    json.key("name").value(name(static_cast<Id>(i)), nameLengths_[i]);
+    json.field("value", values_[i]);
+    json.endObject();
   }
-
-  json += "]";
-  return json;
+  json.endArray();
 }
 
-int CounterStore::findIndex(const String& name) const {
-  for (size_t i = 0; i < kMaxCounters; ++i) {
-    if (entries_[i].used && entries_[i].name.equalsIgnoreCase(name)) {
-      return static_cast<int>(i);
+// FNV-1a sobre o nome em minusculas (ASCII, como o strncasecmp).
+uint32_t CounterStore::hashName(const char* name, size_t length) {
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < length; ++i) {
+    uint8_t c = static_cast<uint8_t>(name[i]);
+    if (c >= 'A' && c <= 'Z') {
+      c += 'a' - 'A';
     }
+    hash ^= c;
+    hash *= 16777619u;
   }
-
-  return -1;
+  return hash;
 }
 
-int CounterStore::findOrCreate(const String& name) {
-  const int found = findIndex(name);
-  if (found >= 0) {
-    return found;
+// Slot do nome, ou o primeiro slot vazio da sequencia de sondagem.
+size_t CounterStore::probe(const char* name, size_t length, uint32_t hash) const {
+  const size_t mask = slots_.size() - 1;
+  size_t slot = hash & mask;
+  while (slots_[slot] != kEmptySlot) {
+    const Id id = slots_[slot];
+    if (hashes_[id] == hash && nameLengths_[id] == length &&
+        strncasecmp(&names_[nameOffsets_[id]], name, length) == 0) {
+      break;
+    }
+    slot = (slot + 1) & mask;
   }
+  return slot;
+}
 
-  for (size_t i = 0; i < kMaxCounters; ++i) {
-    if (!entries_[i].used) {
-      entries_[i].used = true;
-      entries_[i].name = name;
-      entries_[i].value = 0;
-      return static_cast<int>(i);
+void CounterStore::rehash(size_t slotCount) {
+  slots_.assign(slotCount, kEmptySlot);
+  const size_t mask = slotCount - 1;
+  for (size_t id = 0; id < hashes_.size(); ++id) {
+    size_t slot = hashes_[id] & mask;
+    while (slots_[slot] != kEmptySlot) {
+      slot = (slot + 1) & mask;
     }
+    slots_[slot] = static_cast<Id>(id);
   }
-
-  return -1;
 }
@@ -1,32 +1,66 @@
 #pragma once
 
 #include <Arduino.h>
+#include <JsonWriter.h>
 
+#include <vector>
+
+// Contadores com nomes internados: cada nome recebe um id pequeno e estável
+// (indice no array de valores) ao ser visto pela primeira vez, e o caminho
+// quente (ScriptVM::tick) soma direto em values_[id]. Nomes sao
+// comparados sem diferenciar maiusculas. A busca por nome usa uma tabela
+// hash de enderecamento aberto (sondagem linear) que dobra de tamanho
+// conforme a REST API ou os scripts criam nomes, ate kMaxCounters.
 class CounterStore {
 public:
-  static constexpr size_t kMaxCounters = 16;
+  using Id = uint16_t;
+  static constexpr Id kInvalidId = 0xFFFF;
+  static constexpr size_t kInitialCapacity = 16;
+  static constexpr size_t kMaxCounters = 1024;
+  static constexpr size_t kMaxNameLength = 31;
 
   CounterStore();
 
+  // Id do nome, criando o contador (valor 0) se preciso. kInvalidId se o
+  // nome for vazio, longo demais ou a tabela estiver cheia.
+  Id intern(const char* name, size_t length);
+  Id intern(const String& name);
+  // Id de um nome existente, ou kInvalidId.
+  Id find(const char* name, size_t length) const;
+  Id find(const String& name) const;
+
+  // Acesso por id: sem busca. O id deve ter vindo de intern().
+  int32_t value(Id id) const { return values_[id]; }
+  void setValue(Id id, int32_t value) { values_[id] = value; }
+  void add(Id id, int32_t amount) { values_[id] += amount; }
+  const char* name(Id id) const { return &names_[nameOffsets_[id]]; }
+  size_t size() const { return values_.size(); }
+
   bool exists(const String& name) const;
   int32_t get(const String& name) const;
   bool set(const String& name, int32_t value);
   bool increment(const String& name, int32_t amount = 1);
   bool decrement(const String& name, int32_t amount = 1);
   bool reset(const String& name);
+  // Zera os valores; nomes e ids continuam validos.
+  void resetAll();
+  // Remove todos os nomes: invalida os ids (recarregar o script).
   void clear();
 
-  String toJson() const;
+  // [{"name":"...","value":n},...]
+  void writeJson(JsonWriter& json) const;
 
 private:
-  struct Entry {
-    String name;
-    int32_t value;
-    bool used;
-  };
+  static constexpr Id kEmptySlot = 0xFFFF;
 
-  Entry entries_[kMaxCounters];
+  std::vector<int32_t> values_;
+  std::vector<uint32_t> hashes_;
+  std::vector<uint16_t> nameOffsets_;
+  std::vector<uint8_t> nameLengths_;
+  std::vector<char> names_;     // Nomes terminados em '\0', em sequencia
+  std::vector<Id> slots_;       // Potencia de 2, no maximo meio cheia
 
-  int findIndex(const String& name) const;
-  int findOrCreate(const String& name);
+  static uint32_t hashName(const char* name, size_t length);
+  size_t probe(const char* name, size_t length, uint32_t hash) const;
+  void rehash(size_t slotCount);
 };
@@ -1,7 +1,7 @@
 #include <Arduino.h>
 
 #include "counters/counter_store.h"
-#include "vm/script_vm.h"
+#include "vm/script_scheduler.h"
 #include "web/web_control_server.h"
 
 namespace {
@@ -9,8 +9,8 @@ constexpr const char* kApSsid = "ESP32-SCRIPT";
 constexpr const char* kApPassword = "12345678";
 
 CounterStore gCounters;
-ScriptVM gVm(gCounters);
-WebControlServer gWeb(gVm);
+ScriptScheduler gScheduler(gCounters);
+WebControlServer gWeb(gScheduler, gCounters);
 }  // namespace
 
 void setup() {
@@ -31,6 +31,6 @@ void setup() {
 
 void loop() {
 	gWeb.loop();
-	gVm.tick();
+	gScheduler.tick();
 	delay(1);
 }
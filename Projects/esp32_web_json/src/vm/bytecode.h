@@ -0,0 +1,116 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Bytecode do ScriptVM: um byte de opcode seguido dos operandos em varint
+// (LEB128 sem sinal; valores com sinal em zigzag). Nomes de contadores nao
+// aparecem no codigo: o operando e o id internado no CounterStore, que
+// funciona como tabela de constantes.
+//
+//   On      pin
+//   Off     pin
+//   Wait    ms
+//   WaitUs  us
+//   CountAdd   id  delta(zigzag)   COUNT INC/DEC
+//   CountSet   id  valor(zigzag)   COUNT SET
+//   CountReset id                  COUNT RESET
+//   Jmp        off16               JMP rotulo
+//   JmpIfIn    pin off16           IF IN pin JMP rotulo
+//   JmpIfNotIn pin off16           IF NOT IN pin JMP rotulo
+//   JmpIfCount id cmp valor(zigzag) off16
+//                                  IF COUNT c <cmp> valor JMP rotulo
+//   LoopInit   slot n              LOOP n
+//   LoopNext   slot off16          END (volta enquanto --laco > 0)
+//
+// Desvios usam off16: int16 little-endian de tamanho fixo, relativo ao fim
+// da instrucao, para poder ser corrigido depois quando o rotulo vem adiante.
+namespace bytecode {
+
+enum Opcode : uint8_t {
+  kOn,
+  kOff,
+  kWait,
+  kCountAdd,
+  kCountSet,
+  kCountReset,
+  kJmp,
+  kJmpIfIn,
+  kJmpIfNotIn,
+  kJmpIfCount,
+  kLoopInit,
+  kLoopNext,
+  kWaitUs
+};
+
+enum Compare : uint8_t {
+  kEq,
+  kNe,
+  kLt,
+  kLe,
+  kGt,
+  kGe
+};
+
+inline bool compare(uint8_t cmp, int32_t a, int32_t b) {
+  switch (cmp) {
+    case kEq: return a == b;
+    case kNe: return a != b;
+    case kLt: return a < b;
+    case kLe: return a <= b;
+    case kGt: return a > b;
+    default: return a >= b;
+  }
+}
+
+// Maior varint de 32 bits.
+constexpr size_t kMaxVarintBytes = 5;
+
+inline uint32_t zigzag(int32_t v) {
+  return (static_cast<uint32_t>(v) << 1) ^ static_cast<uint32_t>(v >> 31);
+}
+
+inline int32_t unzigzag(uint32_t v) {
+  return static_cast<int32_t>(v >> 1) ^ -static_cast<int32_t>(v & 1);
+}
+
+// Grava v em out (ao menos kMaxVarintBytes livres); retorna os bytes usados.
+inline size_t writeVarint(uint8_t* out, uint32_t v) {
+  size_t n = 0;
+  while (v >= 0x80) {
+    out[n++] = static_cast<uint8_t>(v | 0x80);
+    v >>= 7;
+  }
+  out[n++] = static_cast<uint8_t>(v);
+  return n;
+}
+
+inline void writeOffset(uint8_t* out, int16_t offset) {
+  out[0] = static_cast<uint8_t>(offset);
+  out[1] = static_cast<uint8_t>(static_cast<uint16_t>(offset) >> 8);
+}
+
+inline int16_t readOffset(const uint8_t* code, size_t& pc) {
+  const uint16_t v = static_cast<uint16_t>(code[pc] | (code[pc + 1] << 8));
+  pc += 2;
+  return static_cast<int16_t>(v);
+}
+
+// Le um varint em code[pc] e avanca pc. O codigo vem do proprio
+// compilador, entao nao ha checagem de limite.
+inline uint32_t readVarint(const uint8_t* code, size_t& pc) {
+  uint32_t v = code[pc++];
+  if (v < 0x80) {
+    return v;
+  }
+  v &= 0x7F;
+  for (uint8_t shift = 7;; shift += 7) {
+    const uint8_t b = code[pc++];
+    v |= static_cast<uint32_t>(b & 0x7F) << shift;
+    if (b < 0x80) {
+      return v;
+    }
+  }
+}
+
+}  // namespace bytecode
@@ -0,0 +1,576 @@
+// Compilador do ScriptVM: texto -> bytecode (vm/bytecode.h), uma linha por
+// vez. feed() aceita pedacos de qualquer tamanho (p. ex. os blocos do corpo
+// HTTP); cada linha completa e tokenizada no proprio buffer de linha e
+// emitida direto em code_, sem String nem copia do script. Erros trazem
+// linha e coluna.
+
+#include "script_vm.h"
+
+#include <new>
+
+namespace {
+
+constexpr size_t kMaxLineLength = 120;
+constexpr size_t kMaxTokens = 8;
+constexpr size_t kMaxNameLength = CounterStore::kMaxNameLength;
+
+struct Token {
+  const char* text;
+  uint8_t length;
+  uint8_t column;   // 1-based
+};
+
+bool isSpace(char c) {
+  return c == ' ' || c == '\t';
+}
+
+// Palavra-chave sem diferenciar maiusculas.
+bool is(const Token& token, const char* word) {
+  const size_t length = strlen(word);
+  return token.length == length && strncasecmp(token.text, word, length) == 0;
+}
+
+// Decimal com sinal opcional e sem estouro; false se sobrar algo.
+bool parseNumber(const Token& token, bool allowSign, int64_t min, int64_t max, int64_t& out) {
+  size_t i = 0;
+  bool negative = false;
+  if (allowSign && i < token.length && (token.text[i] == '-' || token.text[i] == '+')) {
+    negative = token.text[i] == '-';
+    ++i;
+  }
+  if (i == token.length) {
+    return false;
+  }
+
+  int64_t value = 0;
+  for (; i < token.length; ++i) {
+    const char c = token.text[i];
+    if (c < '0' || c > '9') {
+      return false;
+    }
+    value = value * 10 + (c - '0');
+    if (value > max - min) {
+      return false;
+    }
+  }
+
+  out = negative ? -value : value;
+  return out >= min && out <= max;
+}
+
+bool parseInt32(const Token& token, int32_t& out) {
+  int64_t value = 0;
+  if (!parseNumber(token, true, INT32_MIN, INT32_MAX, value)) {
+    return false;
+  }
+  out = static_cast<int32_t>(value);
+  return true;
+}
+
+bool parseUint32(const Token& token, uint32_t& out) {
+  int64_t value = 0;
+  if (!parseNumber(token, false, 0, UINT32_MAX, value)) {
+    return false;
+  }
+  out = static_cast<uint32_t>(value);
+  return true;
+}
+
+bool parseCompare(const Token& token, uint8_t& out) {
+  if (is(token, "==") || is(token, "=")) {
+    out = bytecode::kEq;
+  } else if (is(token, "!=") || is(token, "<>")) {
+    out = bytecode::kNe;
+  } else if (is(token, "<")) {
+    out = bytecode::kLt;
+  } else if (is(token, "<=")) {
+    out = bytecode::kLe;
+  } else if (is(token, ">")) {
+    out = bytecode::kGt;
+  } else if (is(token, ">=")) {
+    out = bytecode::kGe;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+struct ScriptVM::Assembly {
+  static constexpr size_t kMaxLabels = 32;
+  static constexpr size_t kMaxFixups = 64;
+  static constexpr size_t kMaxLoopDepth = 8;
+  static constexpr uint16_t kUndefined = 0xFFFF;
+
+  struct Label {
+    char name[kMaxNameLength + 1];
+    uint8_t length;
+    uint16_t pos;     // Offset em code_, ou kUndefined
+    uint16_t line;    // Primeira referencia, para o erro de rotulo faltando
+    uint8_t column;
+  };
+
+  struct Fixup {
+    uint16_t at;      // Offset do off16 a corrigir
+    uint8_t label;
+  };
+
+  struct OpenLoop {
+    uint8_t slot;     // kMaxLoops: LOOP sem contagem (infinito)
+    uint16_t body;
+    uint16_t line;
+    uint8_t column;
+  };
+
+  // Linha em montagem e seus tokens (apontam para dentro de 'line').
+  char line[kMaxLineLength + 1];
+  size_t lineLength = 0;
+  bool lineTooLong = false;
+  uint16_t lineNumber = 1;
+  Token tokens[kMaxTokens];
+  size_t tokenCount = 0;
+
+  Label labels[kMaxLabels];
+  size_t labelCount = 0;
+  Fixup fixups[kMaxFixups];
+  size_t fixupCount = 0;
+  OpenLoop loops[kMaxLoopDepth];
+  size_t loopDepth = 0;
+  uint8_t loopSlots = 0;
+
+  bool failed = false;
+  String error;
+
+  // Coluna do token i, ou logo apos o fim da linha se ele faltar.
+  uint8_t column(size_t i) const {
+    return i < tokenCount ? tokens[i].column : static_cast<uint8_t>(lineLength + 1);
+  }
+
+  String text(size_t i) const {
+    if (i >= tokenCount) {
+      return String();
+    }
+    char buffer[kMaxLineLength + 1];
+    memcpy(buffer, tokens[i].text, tokens[i].length);
+    buffer[tokens[i].length] = '\0';
+    return String(buffer);
+  }
+
+  bool fail(uint16_t atLine, uint8_t atColumn, const String& message) {
+    if (!failed) {
+      failed = true;
+      error = "Linha " + String(static_cast<unsigned>(atLine)) + ", coluna " +
+              String(static_cast<unsigned>(atColumn)) + ": " + message + ".";
+    }
+    return false;
+  }
+
+  bool fail(size_t token, const String& message) { return fail(lineNumber, column(token), message); }
+
+  // Indice do rotulo (criado como indefinido na primeira referencia), ou -1
+  // se o nome for longo demais ou a tabela estiver cheia.
+  int labelIndex(size_t token) {
+    const Token& name = tokens[token];
+    for (size_t i = 0; i < labelCount; ++i) {
+      if (labels[i].length == name.length && strncasecmp(labels[i].name, name.text, name.length) == 0) {
+        return static_cast<int>(i);
+      }
+    }
+    if (labelCount >= kMaxLabels || name.length > kMaxNameLength) {
+      return -1;
+    }
+
+    Label& label = labels[labelCount];
+    memcpy(label.name, name.text, name.length);
+    label.name[name.length] = '\0';
+    label.length = name.length;
+    label.pos = kUndefined;
+    label.line = lineNumber;
+    label.column = name.column;
+    return static_cast<int>(labelCount++);
+  }
+
+  // Separa a linha em tokens; '#' comeca comentario.
+  bool tokenize() {
+    tokenCount = 0;
+    size_t i = 0;
+    while (i < lineLength) {
+      while (i < lineLength && isSpace(line[i])) {
+        ++i;
+      }
+      if (i >= lineLength || line[i] == '#') {
+        break;
+      }
+      if (tokenCount >= kMaxTokens) {
+        return fail(lineNumber, static_cast<uint8_t>(i + 1), "tokens demais na linha");
+      }
+
+      const size_t start = i;
+      while (i < lineLength && !isSpace(line[i]) && line[i] != '#') {
+        ++i;
+      }
+      tokens[tokenCount++] = Token{&line[start], static_cast<uint8_t>(i - start), static_cast<uint8_t>(start + 1)};
+    }
+    return true;
+  }
+};
+
+ScriptVM::~ScriptVM() {
+  delete assembly_;
+}
+
+bool ScriptVM::beginLoad() {
+  stop();
+  delete assembly_;
+  codeLength_ = 0;
+  instructionCount_ = 0;
+  assembly_ = new (std::nothrow) Assembly();
+  if (assembly_ == nullptr) {
+    lastError_ = "Sem memoria para compilar o script.";
+    return false;
+  }
+  return true;
+}
+
+bool ScriptVM::feed(const char* data, size_t length) {
+  if (assembly_ == nullptr || assembly_->failed) {
+    return false;
+  }
+
+  Assembly& as = *assembly_;
+  for (size_t i = 0; i < length; ++i) {
+    const char c = data[i];
+    if (c == '\n') {
+      if (!finishLine(as)) {
+        return false;
+      }
+      continue;
+    }
+    if (c == '\r') {
+      continue;
+    }
+    if (as.lineLength < kMaxLineLength) {
+      as.line[as.lineLength++] = c;
+    } else {
+      as.lineTooLong = true;
+    }
+  }
+  return true;
+}
+
+bool ScriptVM::endLoad(String& error) {
+  if (assembly_ == nullptr) {
+    error = lastError_.isEmpty() ? String("Carga nao iniciada.") : lastError_;
+    return false;
+  }
+
+  Assembly& as = *assembly_;
+  if (!as.failed && as.lineLength > 0) {
+    finishLine(as);
+  }
+
+  if (!as.failed && as.loopDepth > 0) {
+    const Assembly::OpenLoop& loop = as.loops[as.loopDepth - 1];
+    as.fail(loop.line, loop.column, "LOOP sem END");
+  }
+
+  for (size_t i = 0; !as.failed && i < as.labelCount; ++i) {
+    const Assembly::Label& label = as.labels[i];
+    if (label.pos == Assembly::kUndefined) {
+      as.fail(label.line, label.column, "rotulo nao definido (" + String(label.name) + ")");
+    }
+  }
+
+  const bool ok = !as.failed;
+  if (ok) {
+    for (size_t i = 0; i < as.fixupCount; ++i) {
+      const Assembly::Fixup& fixup = as.fixups[i];
+      const int32_t offset = static_cast<int32_t>(as.labels[fixup.label].pos) - (fixup.at + 2);
+      bytecode::writeOffset(&code_[fixup.at], static_cast<int16_t>(offset));
+    }
+    lastError_ = "";
+  } else {
+    codeLength_ = 0;
+    instructionCount_ = 0;
+    lastError_ = as.error;
+    error = as.error;
+  }
+
+  delete assembly_;
+  assembly_ = nullptr;
+  return ok;
+}
+
+bool ScriptVM::loadScript(const String& script, String& error) {
+  if (!beginLoad()) {
+    error = lastError_;
+    return false;
+  }
+  feed(script.c_str(), script.length());
+  return endLoad(error);
+}
+
+bool ScriptVM::finishLine(Assembly& as) {
+  bool ok = true;
+  if (as.lineTooLong) {
+    ok = as.fail(as.lineNumber, static_cast<uint8_t>(kMaxLineLength + 1),
+                 "linha longa demais (max " + String(static_cast<unsigned>(kMaxLineLength)) + ")");
+  } else if (as.tokenize() && as.tokenCount > 0) {
+    ok = parseLine(as);
+  } else {
+    ok = !as.failed;
+  }
+
+  as.lineLength = 0;
+  as.lineTooLong = false;
+  ++as.lineNumber;
+  return ok;
+}
+
+bool ScriptVM::parseLine(Assembly& as) {
+  const Token& cmd = as.tokens[0];
+
+  if (is(cmd, "ON") || is(cmd, "OFF")) {
+    int32_t pin = 0;
+    if (as.tokenCount < 2 || !parseInt32(as.tokens[1], pin) || pin < 0) {
+      return as.fail(1, "pino invalido para comando " + as.text(0));
+    }
+
+    return emitLine(as, is(cmd, "ON") ? bytecode::kOn : bytecode::kOff, 1, static_cast<uint32_t>(pin));
+  }
+
+  if (is(cmd, "WAIT") || is(cmd, "DELAY")) {
+    uint32_t delayMs = 0;
+    if (as.tokenCount < 2 || !parseUint32(as.tokens[1], delayMs)) {
+      return as.fail(1, "delay invalido");
+    }
+
+    return emitLine(as, bytecode::kWait, 1, delayMs);
+  }
+
+  if (is(cmd, "WAITUS")) {
+    uint32_t delayUs = 0;
+    if (as.tokenCount < 2 || !parseUint32(as.tokens[1], delayUs)) {
+      return as.fail(1, "delay invalido em WAITUS");
+    }
+
+    return emitLine(as, bytecode::kWaitUs, 1, delayUs);
+  }
+
+  if (is(cmd, "COUNT") || is(cmd, "COUNTER")) {
+    return parseCount(as);
+  }
+
+  if (is(cmd, "LABEL")) {
+    const int label = as.tokenCount < 2 ? -1 : as.labelIndex(1);
+    if (label < 0) {
+      return as.fail(1, "rotulo invalido ou limite de rotulos atingido");
+    }
+    if (as.labels[label].pos != Assembly::kUndefined) {
+      return as.fail(1, "rotulo repetido (" + as.text(1) + ")");
+    }
+
+    as.labels[label].pos = static_cast<uint16_t>(codeLength_);
+    return true;
+  }
+
+  if (is(cmd, "JMP")) {
+    return emitLine(as, bytecode::kJmp, 0) && emitBranch(as, 1);
+  }
+
+  if (is(cmd, "IF")) {
+    return parseBranch(as);
+  }
+
+  if (is(cmd, "LOOP") || is(cmd, "END") || is(cmd, "ENDLOOP")) {
+    return parseLoop(as);
+  }
+
+  return as.fail(0, "comando desconhecido (" + as.text(0) + ")");
+}
+
+// COUNT <nome> INC|DEC [valor] | SET <valor> | RESET
+bool ScriptVM::parseCount(Assembly& as) {
+  if (as.tokenCount < 3) {
+    return as.fail(as.tokenCount, "sintaxe de contador invalida");
+  }
+
+  const Token& name = as.tokens[1];
+  const Token& action = as.tokens[2];
+  const CounterStore::Id counter = counters_.intern(name.text, name.length);
+  if (counter == CounterStore::kInvalidId) {
+    return as.fail(1, "nome de contador invalido ou limite de contadores atingido");
+  }
+
+  int32_t value = 0;
+
+  if (is(action, "INC") || is(action, "DEC")) {
+    if (as.tokenCount < 4) {
+      value = 1;
+    } else if (!parseInt32(as.tokens[3], value)) {
+      return as.fail(3, "valor invalido em COUNT " + as.text(2));
+    }
+
+    if (is(action, "DEC")) {
+      value = -value;
+    }
+    return emitLine(as, bytecode::kCountAdd, 2, counter, bytecode::zigzag(value));
+  }
+
+  if (is(action, "SET")) {
+    if (as.tokenCount < 4 || !parseInt32(as.tokens[3], value)) {
+      return as.fail(3, "valor invalido em COUNT SET");
+    }
+
+    return emitLine(as, bytecode::kCountSet, 2, counter, bytecode::zigzag(value));
+  }
+
+  if (is(action, "RESET")) {
+    return emitLine(as, bytecode::kCountReset, 1, counter);
+  }
+
+  return as.fail(2, "acao de contador desconhecida (" + as.text(2) + ")");
+}
+
+// IF [NOT] IN <pino> JMP <rotulo>
+// IF COUNT <nome> <==|!=|<|<=|>|>=> <valor> JMP <rotulo>
+bool ScriptVM::parseBranch(Assembly& as) {
+  size_t next = 1;
+  bool negate = false;
+  if (next < as.tokenCount && is(as.tokens[next], "NOT")) {
+    negate = true;
+    ++next;
+  }
+
+  if (next >= as.tokenCount) {
+    return as.fail(next, "condicao desconhecida em IF");
+  }
+
+  const Token& kind = as.tokens[next++];
+
+  if (is(kind, "IN")) {
+    int32_t pin = 0;
+    if (next >= as.tokenCount || !parseInt32(as.tokens[next], pin) || pin < 0) {
+      return as.fail(next, "pino invalido em IF IN");
+    }
+    ++next;
+
+    if (!emitLine(as, negate ? bytecode::kJmpIfNotIn : bytecode::kJmpIfIn, 1, static_cast<uint32_t>(pin))) {
+      return false;
+    }
+  } else if (is(kind, "COUNT") && !negate) {
+    int32_t value = 0;
+    uint8_t cmp = 0;
+    // Aponta para o primeiro token que falta ou nao confere.
+    size_t bad = next + 1;
+    if (bad < as.tokenCount && parseCompare(as.tokens[bad], cmp)) {
+      ++bad;
+      if (bad < as.tokenCount && parseInt32(as.tokens[bad], value)) {
+        bad = 0;
+      }
+    }
+    if (bad != 0) {
+      return as.fail(bad, "sintaxe invalida em IF COUNT");
+    }
+
+    const Token& name = as.tokens[next];
+    const CounterStore::Id counter = counters_.intern(name.text, name.length);
+    if (counter == CounterStore::kInvalidId) {
+      return as.fail(next, "nome de contador invalido ou limite de contadores atingido");
+    }
+    next += 3;
+
+    // cmp < 0x80: o varint e o proprio byte, lido direto em tick().
+    if (!emitLine(as, bytecode::kJmpIfCount, 3, counter, cmp, bytecode::zigzag(value))) {
+      return false;
+    }
+  } else {
+    return as.fail(next - 1, "condicao desconhecida em IF");
+  }
+
+  if (next >= as.tokenCount || !is(as.tokens[next], "JMP")) {
+    return as.fail(next, "esperado JMP em IF");
+  }
+
+  return emitBranch(as, next + 1);
+}
+
+// LOOP <n> ... END repete o corpo n vezes; LOOP ... END sem n, para sempre.
+bool ScriptVM::parseLoop(Assembly& as) {
+  if (is(as.tokens[0], "LOOP")) {
+    if (as.loopDepth >= Assembly::kMaxLoopDepth) {
+      return as.fail(0, "LOOPs aninhados demais");
+    }
+
+    Assembly::OpenLoop& loop = as.loops[as.loopDepth];
+    loop.line = as.lineNumber;
+    loop.column = as.tokens[0].column;
+    loop.slot = kMaxLoops;
+
+    if (as.tokenCount > 1) {
+      uint32_t count = 0;
+      if (!parseUint32(as.tokens[1], count) || count == 0) {
+        return as.fail(1, "contagem invalida em LOOP");
+      }
+      if (as.loopSlots >= kMaxLoops) {
+        return as.fail(0, "limite de LOOPs com contagem atingido");
+      }
+
+      loop.slot = as.loopSlots++;
+      if (!emitLine(as, bytecode::kLoopInit, 2, loop.slot, count)) {
+        return false;
+      }
+    }
+
+    loop.body = static_cast<uint16_t>(codeLength_);
+    ++as.loopDepth;
+    return true;
+  }
+
+  if (as.loopDepth == 0) {
+    return as.fail(0, "END sem LOOP");
+  }
+
+  const Assembly::OpenLoop& loop = as.loops[--as.loopDepth];
+  const bool counted = loop.slot < kMaxLoops;
+  if (!emitLine(as, counted ? bytecode::kLoopNext : bytecode::kJmp, counted ? 1 : 0, loop.slot)) {
+    return false;
+  }
+
+  const int32_t offset = static_cast<int32_t>(loop.body) - static_cast<int32_t>(codeLength_ + 2);
+  bytecode::writeOffset(&code_[codeLength_], static_cast<int16_t>(offset));
+  codeLength_ += 2;
+  return true;
+}
+
+// Grava opcode e operandos (varint) no fim de code_. Sobra espaco para o
+// off16 de um desvio, que emitBranch() grava em seguida.
+bool ScriptVM::emitLine(Assembly& as, uint8_t opcode, uint8_t operandCount, uint32_t a, uint32_t b, uint32_t c) {
+  if (codeLength_ + 3 + operandCount * bytecode::kMaxVarintBytes > kCodeBytes) {
+    return as.fail(0, "script excede o limite de bytecode (" + String(static_cast<unsigned>(kCodeBytes)) + " bytes)");
+  }
+
+  const uint32_t operands[] = {a, b, c};
+  code_[codeLength_++] = opcode;
+  for (uint8_t i = 0; i < operandCount; ++i) {
+    codeLength_ += bytecode::writeVarint(&code_[codeLength_], operands[i]);
+  }
+  ++instructionCount_;
+  return true;
+}
+
+// off16 do desvio para o rotulo no token indicado, corrigido em endLoad().
+bool ScriptVM::emitBranch(Assembly& as, size_t token) {
+  const int index = token < as.tokenCount ? as.labelIndex(token) : -1;
+  if (index < 0 || as.fixupCount >= Assembly::kMaxFixups) {
+    return as.fail(token, "rotulo invalido ou limite de desvios atingido");
+  }
+
+  as.fixups[as.fixupCount].at = static_cast<uint16_t>(codeLength_);
+  as.fixups[as.fixupCount].label = static_cast<uint8_t>(index);
+  ++as.fixupCount;
+  bytecode::writeOffset(&code_[codeLength_], 0);
+  codeLength_ += 2;
+  return true;
+}
@@ -0,0 +1,177 @@
+#include "script_scheduler.h"
+
+#include <utility>
+
+namespace {
+
+template <size_t... I>
+std::array<ScriptVM, sizeof...(I)> makeSlots(CounterStore& counters, std::index_sequence<I...>) {
+  return {{((void)I, ScriptVM(counters))...}};
+}
+
+}  // namespace
+
+ScriptScheduler::ScriptScheduler(CounterStore& counters)
+    : slots_(makeSlots(counters, std::make_index_sequence<kMaxTasks>())), heapSize_(0) {
+  memset(heapPos_, kNotQueued, sizeof(heapPos_));
+}
+
+bool ScriptScheduler::load(size_t slot, const String& script, String& error) {
+  if (slot >= kMaxTasks) {
+    error = "Slot invalido.";
+    return false;
+  }
+
+  timers_[slot].detach();
+  remove(static_cast<uint8_t>(slot));
+  return slots_[slot].loadScript(script, error);
+}
+
+bool ScriptScheduler::beginLoad(size_t slot) {
+  if (slot >= kMaxTasks) {
+    return false;
+  }
+
+  timers_[slot].detach();
+  remove(static_cast<uint8_t>(slot));
+  return slots_[slot].beginLoad();
+}
+
+bool ScriptScheduler::feed(size_t slot, const char* data, size_t length) {
+  return slot < kMaxTasks && slots_[slot].feed(data, length);
+}
+
+bool ScriptScheduler::endLoad(size_t slot, String& error) {
+  if (slot >= kMaxTasks) {
+    error = "Slot invalido.";
+    return false;
+  }
+  return slots_[slot].endLoad(error);
+}
+
+bool ScriptScheduler::start(size_t slot) {
+  if (slot >= kMaxTasks) {
+    return false;
+  }
+
+  timers_[slot].detach();
+  remove(static_cast<uint8_t>(slot));
+  slots_[slot].start();
+  if (slots_[slot].isRunning()) {
+    push(static_cast<uint8_t>(slot), static_cast<uint64_t>(esp_timer_get_time()));
+  }
+  return true;
+}
+
+bool ScriptScheduler::startTimed(size_t slot, String& error) {
+  if (slot >= kMaxTasks) {
+    error = "Slot invalido.";
+    return false;
+  }
+
+  remove(static_cast<uint8_t>(slot));
+  return timers_[slot].attach(slots_[slot], error);
+}
+
+bool ScriptScheduler::stop(size_t slot) {
+  if (slot >= kMaxTasks) {
+    return false;
+  }
+
+  timers_[slot].detach();
+  remove(static_cast<uint8_t>(slot));
+  slots_[slot].stop();
+  return true;
+}
+
+void ScriptScheduler::tick() {
+  const uint64_t now = static_cast<uint64_t>(esp_timer_get_time());
+
+  // Tira primeiro todos os vencidos: um slot que volta com despertar
+  // "agora" (limite de instrucoes) so roda de novo no proximo tick().
+  uint8_t due[kMaxTasks];
+  size_t dueCount = 0;
+  while (heapSize_ > 0 && heap_[0].wakeUs <= now) {
+    due[dueCount++] = heap_[0].slot;
+    remove(heap_[0].slot);
+  }
+
+  for (size_t i = 0; i < dueCount; ++i) {
+    ScriptVM& vm = slots_[due[i]];
+    vm.tick();
+    if (vm.isRunning()) {
+      const uint64_t wake = vm.wakeAtUs();
+      push(due[i], wake != 0 ? wake : now);
+    }
+  }
+}
+
+void ScriptScheduler::writeTasks(JsonWriter& json) const {
+  json.beginArray();
+  for (size_t i = 0; i < kMaxTasks; ++i) {
+    json.beginObject().field("slot", i);
+    slots_[i].writeStatusFields(json);
+    json.endObject();
+  }
+  json.endArray();
+}
+
+void ScriptScheduler::push(uint8_t slot, uint64_t wakeUs) {
+  const size_t index = heapSize_++;
+  place(index, Entry{wakeUs, slot});
+  siftUp(index);
+}
+
+void ScriptScheduler::remove(uint8_t slot) {
+  const uint8_t index = heapPos_[slot];
+  if (index == kNotQueued) {
+    return;
+  }
+
+  heapPos_[slot] = kNotQueued;
+  const Entry last = heap_[--heapSize_];
+  if (index == heapSize_) {
+    return;
+  }
+
+  place(index, last);
+  siftUp(index);
+  siftDown(heapPos_[last.slot]);
+}
+
+void ScriptScheduler::place(size_t index, const Entry& entry) {
+  heap_[index] = entry;
+  heapPos_[entry.slot] = static_cast<uint8_t>(index);
+}
+
+void ScriptScheduler::siftUp(size_t index) {
+  const Entry entry = heap_[index];
+  while (index > 0) {
+    const size_t parent = (index - 1) / 2;
+    if (entry.wakeUs >= heap_[parent].wakeUs) {
+      break;
+    }
+    place(index, heap_[parent]);
+    index = parent;
+  }
+  place(index, entry);
+}
+
+void ScriptScheduler::siftDown(size_t index) {
+  const Entry entry = heap_[index];
+  for (;;) {
+    size_t child = index * 2 + 1;
+    if (child >= heapSize_) {
+      break;
+    }
+    if (child + 1 < heapSize_ && heap_[child + 1].wakeUs < heap_[child].wakeUs) {
+      ++child;
+    }
+    if (heap_[child].wakeUs >= entry.wakeUs) {
+      break;
+    }
+    place(index, heap_[child]);
+    index = child;
+  }
+  place(index, entry);
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <array>
+
+#include "counters/counter_store.h"
+#include "vm/script_timer.h"
+#include "vm/script_vm.h"
+
+// Varios scripts ao mesmo tempo, cada um num slot com seu ScriptVM (pc,
+// WAIT e LOOPs proprios); os contadores sao compartilhados. Os slots em
+// execucao ficam num min-heap indexado pelo proximo despertar, entao
+// tick() so toca nos que ja podem rodar: O(log n) por despertar, e slot
+// parado ou em WAIT nao custa nada. Um slot pode, em vez disso, rodar no
+// seu ScriptTimer (startTimed): ai fica fora do heap.
+class ScriptScheduler {
+public:
+  static constexpr size_t kMaxTasks = 4;
+
+  explicit ScriptScheduler(CounterStore& counters);
+
+  // Carrega um script no slot (parando-o antes).
+  bool load(size_t slot, const String& script, String& error);
+  // O mesmo em partes (ScriptVM::beginLoad/feed/endLoad), p. ex. direto
+  // do corpo HTTP ou de um arquivo.
+  bool beginLoad(size_t slot);
+  bool feed(size_t slot, const char* data, size_t length);
+  bool endLoad(size_t slot, String& error);
+  bool start(size_t slot);
+  bool startTimed(size_t slot, String& error);
+  bool stop(size_t slot);
+  void tick();
+
+  const ScriptVM& task(size_t slot) const { return slots_[slot]; }
+  size_t runnableCount() const { return heapSize_; }
+  // [{"slot":n,<ScriptVM::writeStatusFields>},...]
+  void writeTasks(JsonWriter& json) const;
+
+private:
+  static constexpr uint8_t kNotQueued = 0xFF;
+
+  struct Entry {
+    uint64_t wakeUs;
+    uint8_t slot;
+  };
+
+  std::array<ScriptVM, kMaxTasks> slots_;
+  ScriptTimer timers_[kMaxTasks];
+  Entry heap_[kMaxTasks];
+  uint8_t heapPos_[kMaxTasks];
+  size_t heapSize_;
+
+  void push(uint8_t slot, uint64_t wakeUs);
+  void remove(uint8_t slot);
+  void place(size_t index, const Entry& entry);
+  void siftUp(size_t index);
+  void siftDown(size_t index);
+};
@@ -0,0 +1,103 @@
+#include "script_timer.h"
+
+namespace {
+// Script que parou no limite de instrucoes (LOOP sem WAIT) volta depois de
+// um tick do FreeRTOS, nao ja: com atraso 0 o esp_timer dispararia sem
+// parar e a task dele (e o Wi-Fi) ficaria sem CPU.
+constexpr uint64_t kBusyRearmUs = 1000;
+// Piso de um WAITUS curto ou ja vencido (WAITUS 0 em laco da no mesmo).
+constexpr uint64_t kMinRearmUs = 50;
+}  // namespace
+
+ScriptTimer::ScriptTimer() : timer_(nullptr), vm_(nullptr), active_(false), inCallback_(false), lock_(portMUX_INITIALIZER_UNLOCKED) {}
+
+ScriptTimer::~ScriptTimer() {
+  detach();
+  if (timer_ != nullptr) {
+    esp_timer_delete(timer_);
+  }
+}
+
+bool ScriptTimer::attach(ScriptVM& vm, String& error) {
+  detach();
+
+  if (!vm.isGpioOnly()) {
+    error = "Modo timer aceita so ON/OFF/WAIT/WAITUS/JMP/IF IN/LOOP.";
+    return false;
+  }
+
+  if (timer_ == nullptr) {
+    esp_timer_create_args_t args = {};
+    args.callback = &ScriptTimer::onTimer;
+    args.arg = this;
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.name = "script_vm";
+    if (esp_timer_create(&args, &timer_) != ESP_OK) {
+      timer_ = nullptr;
+      error = "Falha ao criar esp_timer.";
+      return false;
+    }
+  }
+
+  vm_ = &vm;
+  vm.start();
+  vm.setTimed(true);
+  active_.store(true);
+  step();
+  return true;
+}
+
+void ScriptTimer::detach() {
+  portENTER_CRITICAL(&lock_);
+  const bool wasActive = active_.exchange(false);
+  if (wasActive) {
+    esp_timer_stop(timer_);
+  }
+  portEXIT_CRITICAL(&lock_);
+  if (!wasActive) {
+    return;
+  }
+
+  while (inCallback_.load()) {
+    delayMicroseconds(10);
+  }
+  vm_->setTimed(false);
+  vm_ = nullptr;
+}
+
+void ScriptTimer::onTimer(void* arg) {
+  static_cast<ScriptTimer*>(arg)->step();
+}
+
+void ScriptTimer::step() {
+  inCallback_.store(true);
+  if (active_.load()) {
+    vm_->tick();
+    if (vm_->isRunning()) {
+      arm();
+    } else {
+      active_.store(false);
+      vm_->setTimed(false);
+    }
+  }
+  inCallback_.store(false);
+}
+
+void ScriptTimer::arm() {
+  const int64_t wake = static_cast<int64_t>(vm_->wakeAtUs());
+  uint64_t delay = kBusyRearmUs;
+  if (wake != 0) {
+    const int64_t now = esp_timer_get_time();
+    delay = wake > now ? static_cast<uint64_t>(wake - now) : 0;
+    if (delay < kMinRearmUs) {
+      delay = kMinRearmUs;
+    }
+  }
+
+  // Um detach() entre a checagem e o start deixaria o timer armado.
+  portENTER_CRITICAL(&lock_);
+  if (active_.load()) {
+    esp_timer_start_once(timer_, delay);
+  }
+  portEXIT_CRITICAL(&lock_);
+}
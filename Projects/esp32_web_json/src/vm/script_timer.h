@@ -0,0 +1,37 @@
+#pragma once
+
+#include <Arduino.h>
+#include <esp_timer.h>
+
+#include <atomic>
+
+#include "vm/script_vm.h"
+
+// Roda um ScriptVM a partir de um esp_timer one-shot, armado para o fim de
+// cada WAIT/WAITUS. Os passos saem na task do esp_timer, entao as bordas de
+// ON/OFF nao dependem de WebControlServer::loop() (so scripts
+// ScriptVM::isGpioOnly()).
+class ScriptTimer {
+public:
+  ScriptTimer();
+  ~ScriptTimer();
+
+  // O VM ja deve estar carregado; start() e chamado aqui.
+  bool attach(ScriptVM& vm, String& error);
+  // Desarma e espera um callback em curso terminar.
+  void detach();
+  bool isActive() const { return active_.load(); }
+
+private:
+  esp_timer_handle_t timer_;
+  ScriptVM* vm_;
+  std::atomic<bool> active_;
+  std::atomic<bool> inCallback_;
+  // Protege o par active_/esp_timer: detach() desliga e para o timer e
+  // arm() confere e rearma sob a mesma trava, sem rearmar depois do stop.
+  portMUX_TYPE lock_;
+
+  static void onTimer(void* arg);
+  void step();
+  void arm();
+};
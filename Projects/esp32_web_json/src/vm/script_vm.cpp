@@ -1,67 +1,36 @@
 #include "script_vm.h"
 
+#include <esp_timer.h>
+
 ScriptVM::ScriptVM(CounterStore& counters)
     : counters_(counters),
+      codeLength_(0),
       instructionCount_(0),
       pc_(0),
       running_(false),
-      waitUntilMs_(0),
+      waitUntilUs_(0),
+      timed_(false),
+      jitterSamples_(0),
+      jitterLastUs_(0),
+      jitterMaxUs_(0),
+      jitterSumUs_(0),
+      assembly_(nullptr),
       lastError_("") {}
 
-bool ScriptVM::loadScript(const String& script, String& error) {
-  stop();
-  instructionCount_ = 0;
-
-  size_t lineNumber = 1;
-  int start = 0;
-
-  while (start <= script.length()) {
-    int end = script.indexOf('\n', start);
-    if (end < 0) {
-      end = script.length();
-    }
-
-    String line = script.substring(start, end);
-    line.replace("\r", "");
-    line.trim();
-
-    if (!line.isEmpty()) {
-      Instruction instruction{};
-      if (!parseLine(line, lineNumber, instruction, error)) {
-        lastError_ = error;
-        return false;
-      }
-
-      if (instructionCount_ >= kMaxInstructions) {
-        error = "Script excede o limite de instrucoes (128).";
-        lastError_ = error;
-        return false;
-      }
-
-      instructions_[instructionCount_++] = instruction;
-    }
-
-    if (end >= script.length()) {
-      break;
-    }
-
-    start = end + 1;
-    ++lineNumber;
-  }
-
-  lastError_ = "";
-  return true;
-}
-
 void ScriptVM::start() {
   pc_ = 0;
-  waitUntilMs_ = 0;
+  waitUntilUs_ = 0;
+  jitterSamples_ = 0;
+  jitterLastUs_ = 0;
+  jitterMaxUs_ = 0;
+  jitterSumUs_ = 0;
+  memset(loopCounters_, 0, sizeof(loopCounters_));
   running_ = instructionCount_ > 0;
 }
 
 void ScriptVM::stop() {
   running_ = false;
-  waitUntilMs_ = 0;
+  waitUntilUs_ = 0;
 }
 
 void ScriptVM::tick() {
@@ -69,247 +38,192 @@ void ScriptVM::tick() {
     return;
   }
 
-  if (isWaiting()) {
+  const uint64_t now = static_cast<uint64_t>(esp_timer_get_time());
+  if (isWaiting(now)) {
     return;
   }
 
-  while (running_ && pc_ < instructionCount_) {
-    const Instruction& instruction = instructions_[pc_++];
-    execute(instruction);
-
-    if (instruction.type == OpType::Wait) {
-      break;
+  // O proximo WAIT conta do fim do anterior, nao da hora em que este tick
+  // rodou: um atraso pequeno de um despertar nao se acumula nos seguintes.
+  uint64_t base = now;
+  if (waitUntilUs_ != 0) {
+    const uint64_t late = now - waitUntilUs_;
+    jitterLastUs_ = late > UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(late);
+    if (jitterLastUs_ > jitterMaxUs_) {
+      jitterMaxUs_ = jitterLastUs_;
     }
+    jitterSumUs_ += jitterLastUs_;
+    ++jitterSamples_;
+    base = waitUntilUs_;
+    waitUntilUs_ = 0;
   }
 
-  if (pc_ >= instructionCount_) {
-    running_ = false;
-  }
-}
-
-bool ScriptVM::isRunning() const {
-  return running_;
-}
-
-String ScriptVM::getLastError() const {
-  return lastError_;
-}
-
-String ScriptVM::getStatusJson() const {
-  String json = "{";
-  json += "\"running\":" + String(running_ ? "true" : "false");
-  json += ",\"pc\":" + String(static_cast<uint32_t>(pc_));
-  json += ",\"instructionCount\":" + String(static_cast<uint32_t>(instructionCount_));
-  json += ",\"lastError\":\"";
-
-  String safeError = lastError_;
-  safeError.replace("\\", "\\\\");
-  safeError.replace("\"", "\\\"");
-
-  json += safeError + "\"";
-  json += ",\"counters\":" + counters_.toJson();
-  json += "}";
-  return json;
-}
-
-bool ScriptVM::parseLine(const String& line, size_t lineNumber, Instruction& out, String& error) {
-  String raw = line;
-  const int commentPos = raw.indexOf('#');
-  if (commentPos >= 0) {
-    raw = raw.substring(0, commentPos);
-  }
-
-  raw.trim();
-  if (raw.isEmpty()) {
-    return true;
-  }
-
-  size_t pos = 0;
-  String cmd = nextToken(raw, pos);
-  cmd.toUpperCase();
+  const uint8_t* code = code_;
+  size_t pc = pc_.load();
+  uint16_t budget = kInstructionsPerTick;
 
-  if (cmd == "ON" || cmd == "OFF") {
-    const String pinToken = nextToken(raw, pos);
-    int32_t pin = 0;
-    if (pinToken.isEmpty() || !parseInt32(pinToken, pin) || pin < 0) {
-      error = "Linha " + String(lineNumber) + ": pino invalido para comando " + cmd + ".";
-      return false;
+  while (pc < codeLength_) {
+    if (budget-- == 0) {
+      pc_ = pc;
+      return;
     }
 
-    out.type = (cmd == "ON") ? OpType::On : OpType::Off;
-    out.pin = static_cast<int>(pin);
-    out.waitMs = 0;
-    out.counter = "";
-    out.value = 0;
-    return true;
-  }
-
-  if (cmd == "WAIT" || cmd == "DELAY") {
-    const String delayToken = nextToken(raw, pos);
-    uint32_t delayMs = 0;
-    if (delayToken.isEmpty() || !parseUint32(delayToken, delayMs)) {
-      error = "Linha " + String(lineNumber) + ": delay invalido.";
-      return false;
-    }
+    switch (code[pc++]) {
+      case bytecode::kOn: {
+        const uint8_t pin = static_cast<uint8_t>(bytecode::readVarint(code, pc));
+        pinMode(pin, OUTPUT);
+        digitalWrite(pin, HIGH);
+        break;
+      }
 
-    out.type = OpType::Wait;
-    out.pin = -1;
-    out.waitMs = delayMs;
-    out.counter = "";
-    out.value = 0;
-    return true;
-  }
+      case bytecode::kOff: {
+        const uint8_t pin = static_cast<uint8_t>(bytecode::readVarint(code, pc));
+        pinMode(pin, OUTPUT);
+        digitalWrite(pin, LOW);
+        break;
+      }
 
-  if (cmd == "COUNT" || cmd == "COUNTER") {
-    const String counterName = nextToken(raw, pos);
-    String action = nextToken(raw, pos);
-    action.toUpperCase();
+      case bytecode::kWait:
+      case bytecode::kWaitUs: {
+        const uint64_t unitUs = code[pc - 1] == bytecode::kWait ? 1000 : 1;
+        const uint64_t waitUs = bytecode::readVarint(code, pc) * unitUs;
+        // Atrasado mais que um WAIT inteiro: reancora em vez de correr atras.
+        waitUntilUs_ = base + waitUs > now ? base + waitUs : now + waitUs;
+        pc_ = pc;
+        running_ = pc < codeLength_;
+        return;
+      }
 
-    if (counterName.isEmpty() || action.isEmpty()) {
-      error = "Linha " + String(lineNumber) + ": sintaxe de contador invalida.";
-      return false;
-    }
+      case bytecode::kCountAdd: {
+        const CounterStore::Id id = static_cast<CounterStore::Id>(bytecode::readVarint(code, pc));
+        counters_.add(id, bytecode::unzigzag(bytecode::readVarint(code, pc)));
+        break;
+      }
 
-    out.pin = -1;
-    out.waitMs = 0;
-    out.counter = counterName;
-    out.value = 0;
-
-    if (action == "INC") {
-      String amountToken = nextToken(raw, pos);
-      if (amountToken.isEmpty()) {
-        out.value = 1;
-      } else if (!parseInt32(amountToken, out.value)) {
-        error = "Linha " + String(lineNumber) + ": valor invalido em COUNT INC.";
-        return false;
+      case bytecode::kCountSet: {
+        const CounterStore::Id id = static_cast<CounterStore::Id>(bytecode::readVarint(code, pc));
+        counters_.setValue(id, bytecode::unzigzag(bytecode::readVarint(code, pc)));
+        break;
       }
 
-      out.type = OpType::CounterInc;
-      return true;
-    }
+      case bytecode::kCountReset:
+        counters_.setValue(static_cast<CounterStore::Id>(bytecode::readVarint(code, pc)), 0);
+        break;
 
-    if (action == "DEC") {
-      String amountToken = nextToken(raw, pos);
-      if (amountToken.isEmpty()) {
-        out.value = 1;
-      } else if (!parseInt32(amountToken, out.value)) {
-        error = "Linha " + String(lineNumber) + ": valor invalido em COUNT DEC.";
-        return false;
+      case bytecode::kJmp: {
+        const int16_t offset = bytecode::readOffset(code, pc);
+        pc += offset;
+        break;
       }
 
-      out.type = OpType::CounterDec;
-      return true;
-    }
+      case bytecode::kJmpIfIn:
+      case bytecode::kJmpIfNotIn: {
+        const bool wantHigh = code[pc - 1] == bytecode::kJmpIfIn;
+        const uint8_t pin = static_cast<uint8_t>(bytecode::readVarint(code, pc));
+        const int16_t offset = bytecode::readOffset(code, pc);
+        if ((digitalRead(pin) == HIGH) == wantHigh) {
+          pc += offset;
+        }
+        break;
+      }
 
-    if (action == "SET") {
-      String valueToken = nextToken(raw, pos);
-      if (valueToken.isEmpty() || !parseInt32(valueToken, out.value)) {
-        error = "Linha " + String(lineNumber) + ": valor invalido em COUNT SET.";
-        return false;
+      case bytecode::kJmpIfCount: {
+        const CounterStore::Id id = static_cast<CounterStore::Id>(bytecode::readVarint(code, pc));
+        const uint8_t cmp = code[pc++];
+        const int32_t value = bytecode::unzigzag(bytecode::readVarint(code, pc));
+        const int16_t offset = bytecode::readOffset(code, pc);
+        if (bytecode::compare(cmp, counters_.value(id), value)) {
+          pc += offset;
+        }
+        break;
       }
 
-      out.type = OpType::CounterSet;
-      return true;
-    }
+      case bytecode::kLoopInit: {
+        const uint8_t slot = code[pc++];
+        loopCounters_[slot] = bytecode::readVarint(code, pc);
+        break;
+      }
 
-    if (action == "RESET") {
-      out.type = OpType::CounterReset;
-      return true;
+      case bytecode::kLoopNext: {
+        const uint8_t slot = code[pc++];
+        const int16_t offset = bytecode::readOffset(code, pc);
+        if (--loopCounters_[slot] > 0) {
+          pc += offset;
+        }
+        break;
+      }
     }
-
-    error = "Linha " + String(lineNumber) + ": acao de contador desconhecida (" + action + ").";
-    return false;
   }
 
-  error = "Linha " + String(lineNumber) + ": comando desconhecido (" + cmd + ").";
-  return false;
+  pc_ = pc;
+  running_ = false;
 }
 
-String ScriptVM::nextToken(const String& line, size_t& pos) {
-  while (pos < static_cast<size_t>(line.length()) && line[static_cast<unsigned int>(pos)] == ' ') {
-    ++pos;
-  }
-
-  if (pos >= static_cast<size_t>(line.length())) {
-    return "";
-  }
-
-  size_t start = pos;
-  while (pos < static_cast<size_t>(line.length()) && line[static_cast<unsigned int>(pos)] != ' ') {
-    ++pos;
-  }
-
-  return line.substring(start, pos);
+bool ScriptVM::isRunning() const {
+  return running_;
 }
 
-bool ScriptVM::parseInt32(const String& token, int32_t& out) {
-  if (token.isEmpty()) {
-    return false;
-  }
-
-  char* end = nullptr;
-  const long parsed = strtol(token.c_str(), &end, 10);
-  if (end == token.c_str() || *end != '\0') {
-    return false;
-  }
-
-  out = static_cast<int32_t>(parsed);
-  return true;
+uint64_t ScriptVM::wakeAtUs() const {
+  return waitUntilUs_;
 }
 
-bool ScriptVM::parseUint32(const String& token, uint32_t& out) {
-  if (token.isEmpty()) {
-    return false;
-  }
-
-  char* end = nullptr;
-  const unsigned long parsed = strtoul(token.c_str(), &end, 10);
-  if (end == token.c_str() || *end != '\0') {
-    return false;
+bool ScriptVM::isGpioOnly() const {
+  size_t pc = 0;
+  while (pc < codeLength_) {
+    switch (code_[pc++]) {
+      case bytecode::kOn:
+      case bytecode::kOff:
+      case bytecode::kWait:
+      case bytecode::kWaitUs:
+        bytecode::readVarint(code_, pc);
+        break;
+
+      case bytecode::kJmp:
+        pc += 2;
+        break;
+
+      case bytecode::kJmpIfIn:
+      case bytecode::kJmpIfNotIn:
+        bytecode::readVarint(code_, pc);
+        pc += 2;
+        break;
+
+      case bytecode::kLoopInit:
+        bytecode::readVarint(code_, pc);
+        bytecode::readVarint(code_, pc);
+        break;
+
+      case bytecode::kLoopNext:
+        bytecode::readVarint(code_, pc);
+        pc += 2;
+        break;
+
+      default:
+        return false;
+    }
   }
-
-  out = static_cast<uint32_t>(parsed);
   return true;
 }
 
-bool ScriptVM::isWaiting() const {
-  if (waitUntilMs_ == 0) {
-    return false;
-  }
+String ScriptVM::getLastError() const {
+  return lastError_;
+}
 
-  return static_cast<int32_t>(millis() - waitUntilMs_) < 0;
+void ScriptVM::writeStatusFields(JsonWriter& json) const {
+  json.field("running", running_);
+  json.field("pc", pc_.load());
+  json.field("instructionCount", instructionCount_);
+  json.field("codeBytes", codeLength_);
+  json.field("mode", timed_ ? "timer" : "loop");
+  json.key("jitterUs").beginObject();
+  json.field("samples", jitterSamples_);
+  json.field("last", jitterLastUs_);
+  json.field("avg", jitterSamples_ ? static_cast<uint32_t>(jitterSumUs_.load() / jitterSamples_) : 0u);
+  json.field("max", jitterMaxUs_);
+  json.endObject();
+  json.field("lastError", lastError_);
 }
 
-void ScriptVM::execute(const Instruction& instruction) {
-  switch (instruction.type) {
-    case OpType::On:
-      pinMode(instruction.pin, OUTPUT);
-      digitalWrite(instruction.pin, HIGH);
-      break;
-
-    case OpType::Off:
-      pinMode(instruction.pin, OUTPUT);
-      digitalWrite(instruction.pin, LOW);
-      break;
-
-    case OpType::Wait:
-      waitUntilMs_ = millis() + instruction.waitMs;
-      break;
-
-    case OpType::CounterInc:
-      counters_.increment(instruction.counter, instruction.value);
-      break;
-
-    case OpType::CounterDec:
-      counters_.decrement(instruction.counter, instruction.value);
-      break;
-
-    case OpType::CounterSet:
-      counters_.set(instruction.counter, instruction.value);
-      break;
-
-    case OpType::CounterReset:
-      counters_.reset(instruction.counter);
-      break;
-  }
+bool ScriptVM::isWaiting(uint64_t nowUs) const {
+  return waitUntilUs_ != 0 && nowUs < waitUntilUs_;
 }
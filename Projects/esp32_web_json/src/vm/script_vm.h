@@ -1,55 +1,83 @@
 #pragma once
 
 #include <Arduino.h>
+#include <JsonWriter.h>
+
+#include <atomic>
 
 #include "counters/counter_store.h"
+#include "vm/bytecode.h"
 
 class ScriptVM {
 public:
   explicit ScriptVM(CounterStore& counters);
+  ~ScriptVM();
 
+  // Carga em partes: beginLoad(), feed() com pedacos de qualquer tamanho
+  // (compilados linha a linha) e endLoad(), que resolve os rotulos. Apos
+  // um erro, feed() devolve false e endLoad() traz "Linha L, coluna C: ...".
+  bool beginLoad();
+  bool feed(const char* data, size_t length);
+  bool endLoad(String& error);
   bool loadScript(const String& script, String& error);
   void start();
   void stop();
   void tick();
 
   bool isRunning() const;
+  // Fim do WAIT/WAITUS em curso (esp_timer_get_time), ou 0 se pode rodar ja.
+  uint64_t wakeAtUs() const;
+  // So ON/OFF/WAIT/WAITUS/desvios/LOOP: pode rodar no callback do esp_timer
+  // (ScriptTimer), que nao toca no CounterStore.
+  bool isGpioOnly() const;
+  // Modo mostrado em writeStatusFields(); quem troca e o ScriptScheduler.
+  void setTimed(bool timed) { timed_ = timed; }
   String getLastError() const;
-  String getStatusJson() const;
+  // "running":...,"lastError":"..." dentro de um objeto ja aberto (sem
+  // contadores, que sao de todos os slots).
+  void writeStatusFields(JsonWriter& json) const;
 
 private:
-  enum class OpType {
-    On,
-    Off,
-    Wait,
-    CounterInc,
-    CounterDec,
-    CounterSet,
-    CounterReset
-  };
-
-  struct Instruction {
-    OpType type;
-    int pin;
-    uint32_t waitMs;
-    String counter;
-    int32_t value;
-  };
-
-  static constexpr size_t kMaxInstructions = 128;
+  // Menos que o antigo instructions_[128] (~3 KB). COUNT INC ocupa 3 bytes
+  // e ON/OFF 2, entao cabem centenas de instrucoes.
+  static constexpr size_t kCodeBytes = 2048;
+  // Instrucoes por tick(): um laco sem WAIT continua no tick seguinte em
+  // vez de segurar WebControlServer::loop().
+  static constexpr uint16_t kInstructionsPerTick = 64;
+  // LOOP n com contagem: cada um tem seu contador fixo (slot).
+  static constexpr size_t kMaxLoops = 16;
+
+  // Linha em montagem, rotulos, desvios pendentes e LOOPs abertos; so
+  // existe entre beginLoad() e endLoad() (script_parser.cpp).
+  struct Assembly;
 
   CounterStore& counters_;
-  Instruction instructions_[kMaxInstructions];
+  uint8_t code_[kCodeBytes];
+  size_t codeLength_;
   size_t instructionCount_;
-  size_t pc_;
+  // pc_ e a soma de jitter sao lidos pela task web (writeStatusFields)
+  // enquanto o callback do ScriptTimer escreve: atomicos, para nao sair
+  // valor rasgado (a soma tem 64 bits).
+  std::atomic<size_t> pc_;   // Offset em code_
   bool running_;
-  uint32_t waitUntilMs_;
+  uint64_t waitUntilUs_;
+  bool timed_;
+  // Atraso de cada despertar em relacao ao fim do WAIT, em us.
+  uint32_t jitterSamples_;
+  uint32_t jitterLastUs_;
+  uint32_t jitterMaxUs_;
+  std::atomic<uint64_t> jitterSumUs_;
+  uint32_t loopCounters_[kMaxLoops];
+  Assembly* assembly_;
   String lastError_;
 
-  bool parseLine(const String& line, size_t lineNumber, Instruction& out, String& error);
-  static String nextToken(const String& line, size_t& pos);
-  static bool parseInt32(const String& token, int32_t& out);
-  static bool parseUint32(const String& token, uint32_t& out);
-  bool isWaiting() const;
-  void execute(const Instruction& instruction);
+  bool finishLine(Assembly& as);
+  bool parseLine(Assembly& as);
+  bool parseCount(Assembly& as);
+  bool parseBranch(Assembly& as);
+  bool parseLoop(Assembly& as);
+  bool emitLine(Assembly& as, uint8_t opcode, uint8_t operandCount, uint32_t a = 0, uint32_t b = 0,
+                uint32_t c = 0);
+  bool emitBranch(Assembly& as, size_t token);
+  bool isWaiting(uint64_t nowUs) const;
 };
@@ -1,28 +1,40 @@
 #include "web_control_server.h"
 
 #include <FS.h>
+#include <JsonResponse.h>
 #include <SPIFFS.h>
 
-WebControlServer::WebControlServer(ScriptVM& vm)
-    : server_(80), vm_(vm), script_("") {}
+#include "web_assets.h"
+
+namespace {
+constexpr const char* kUploadPath = "/upload.tmp";
+constexpr const char* kExampleScript = "# Exemplo\n"
+                                       "ON 2\n"
+                                       "WAIT 1000\n"
+                                       "OFF 2\n"
+                                       "COUNT ciclos INC 1\n";
+// Bloco de leitura do arquivo na carga do boot (pilha do loopTask).
+constexpr size_t kLoadChunk = 128;
+}  // namespace
+
+WebControlServer::WebControlServer(ScriptScheduler& scheduler, CounterStore& counters)
+    : server_(80), scheduler_(scheduler), counters_(counters), uploadBytes_(0), uploadOk_(false), uploadSaved_(false) {}
 
 void WebControlServer::begin(const char* apSsid, const char* apPassword) {
   WiFi.mode(WIFI_AP);
   WiFi.softAP(apSsid, apPassword);
 
   SPIFFS.begin(true);
-  if (!loadScriptFromStorage()) {
-    script_ = "# Exemplo\n"
-              "ON 2\n"
-              "WAIT 1000\n"
-              "OFF 2\n"
-              "COUNT ciclos INC 1\n";
+  SPIFFS.remove(kUploadPath);
+  if (!SPIFFS.exists(scriptPath(0))) {
+    saveScriptToStorage(0, kExampleScript);
+  }
+  for (size_t slot = 0; slot < ScriptScheduler::kMaxTasks; ++slot) {
+    loadScriptFromStorage(slot);
   }
-
-  String error;
-  vm_.loadScript(script_, error);
 
   setupRoutes();
+  staticAssetHeaders(server_);
   server_.begin();
 }
 
@@ -36,237 +48,324 @@ IPAddress WebControlServer::ip() const {
 
 void WebControlServer::setupRoutes() {
   server_.on("/", HTTP_GET, [this]() { handleRoot(); });
-  server_.on("/api/script", HTTP_GET, [this]() { handleGetScript(); });
-  server_.on("/api/script", HTTP_POST, [this]() { handleSetScript(); });
+  server_.on("/api/script", HTTP_GET, [this]() { sendScript(0); });
+  // O corpo (text/plain) chega em blocos no segundo handler (raw), antes
+  // do primeiro.
+  server_.on(
+      "/api/script", HTTP_POST, [this]() { finishScript(0); }, [this]() { receiveScript(0); });
   server_.on("/api/run", HTTP_POST, [this]() { handleRun(); });
   server_.on("/api/stop", HTTP_POST, [this]() { handleStop(); });
   server_.on("/api/status", HTTP_GET, [this]() { handleStatus(); });
+  server_.on("/api/counters", HTTP_GET, [this]() { handleGetCounters(); });
+  server_.on("/api/counters", HTTP_POST, [this]() { handleSetCounter(); });
+  server_.on("/api/counters", HTTP_DELETE, [this]() { handleResetCounters(); });
+
+  // Slots do ScriptScheduler (?slot=N); as rotas acima usam o slot 0.
+  server_.on("/api/tasks", HTTP_GET, [this]() { handleGetTasks(); });
+  server_.on("/api/tasks/script", HTTP_GET, [this]() {
+    size_t slot = 0;
+    if (slotArg(slot)) {
+      sendScript(slot);
+    }
+  });
+  server_.on(
+      "/api/tasks/script", HTTP_POST,
+      [this]() {
+        size_t slot = 0;
+        if (slotArg(slot)) {
+          finishScript(slot);
+        }
+      },
+      [this]() {
+        size_t slot = 0;
+        if (parseSlot(slot)) {
+          receiveScript(slot);
+        }
+      });
+  server_.on("/api/tasks/start", HTTP_POST, [this]() {
+    size_t slot = 0;
+    if (slotArg(slot)) {
+      startSlot(slot);
+    }
+  });
+  server_.on("/api/tasks/stop", HTTP_POST, [this]() {
+    size_t slot = 0;
+    if (slotArg(slot)) {
+      scheduler_.stop(slot);
+      server_.send(200, "application/json", "{\"ok\":true,\"message\":\"parado\"}");
+    }
+  });
 
   server_.onNotFound([this]() {
     server_.send(404, "application/json", "{\"error\":\"not_found\"}");
   });
 }
 
-bool WebControlServer::loadScriptFromStorage() {
-  if (!SPIFFS.exists("/script.txt")) {
+// Slot 0 fica no arquivo de sempre, para scripts ja gravados.
+String WebControlServer::scriptPath(size_t slot) {
+  if (slot == 0) {
+    return "/script.txt";
+  }
+  return "/task" + String(static_cast<uint32_t>(slot)) + ".txt";
+}
+
+// Compila o arquivo em blocos, sem trazer o script inteiro para a RAM.
+bool WebControlServer::loadScriptFromStorage(size_t slot) {
+  const String path = scriptPath(slot);
+  if (!SPIFFS.exists(path)) {
     return false;
   }
 
-  File file = SPIFFS.open("/script.txt", FILE_READ);
+  File file = SPIFFS.open(path, FILE_READ);
   if (!file) {
     return false;
   }
 
-  script_ = file.readString();
+  char buffer[kLoadChunk];
+  bool ok = scheduler_.beginLoad(slot);
+  while (ok && file.available()) {
+    const size_t length = file.read(reinterpret_cast<uint8_t*>(buffer), sizeof(buffer));
+    ok = length > 0 && scheduler_.feed(slot, buffer, length);
+  }
   file.close();
-  return !script_.isEmpty();
+
+  String error;
+  return scheduler_.endLoad(slot, error) && ok;
 }
 
-bool WebControlServer::saveScriptToStorage(const String& script) {
-  File file = SPIFFS.open("/script.txt", FILE_WRITE);
+bool WebControlServer::saveScriptToStorage(size_t slot, const char* script) {
+  File file = SPIFFS.open(scriptPath(slot), FILE_WRITE);
   if (!file) {
     return false;
   }
 
   const size_t written = file.print(script);
   file.close();
-  return written == script.length();
+  return written == strlen(script);
 }
 
-void WebControlServer::handleRoot() {
-  static const char page[] PROGMEM = R"HTML(
-<!doctype html>
-<html lang="pt-BR">
-<head>
-  <meta charset="utf-8" />
-  <meta name="viewport" content="width=device-width,initial-scale=1" />
-  <title>ESP32 Script Runtime</title>
-  <style>
-    :root {
-      --bg0: #f5f2ea;
-      --bg1: #e7dcc6;
-      --ink: #1c1f1a;
-      --accent: #17624a;
-      --accent-2: #d6852d;
-      --card: #fffaf0;
-      --line: #d2c6ae;
-    }
-    body {
-      margin: 0;
-      font-family: "Trebuchet MS", "Verdana", sans-serif;
-      color: var(--ink);
-      background: radial-gradient(circle at top right, var(--bg1), var(--bg0) 45%);
-      min-height: 100vh;
-      padding: 16px;
-    }
-    .wrap {
-      max-width: 980px;
-      margin: 0 auto;
-      background: var(--card);
-      border: 1px solid var(--line);
-      border-radius: 14px;
-      padding: 14px;
-      box-shadow: 0 8px 30px rgba(0,0,0,0.09);
-    }
-    h1 {
-      margin: 0 0 8px;
-      font-size: 1.2rem;
-      letter-spacing: 0.4px;
-    }
-    .grid {
-      display: grid;
-      grid-template-columns: 1fr;
-      gap: 10px;
-    }
-    textarea {
-      width: 100%;
-      min-height: 320px;
-      font-family: "Consolas", monospace;
-      font-size: 14px;
-      border: 1px solid var(--line);
-      border-radius: 10px;
-      background: #fffdf8;
-      padding: 10px;
-      box-sizing: border-box;
-    }
-    .row {
-      display: flex;
-      gap: 8px;
-      flex-wrap: wrap;
-    }
-    button {
-      border: 0;
-      border-radius: 10px;
-      padding: 10px 14px;
-      cursor: pointer;
-      color: #fff;
-      background: var(--accent);
-      font-weight: 700;
-      transition: transform .15s ease;
-    }
-    button.alt { background: #7a2f2f; }
-    button.warn { background: var(--accent-2); color: #1f1405; }
-    button:hover { transform: translateY(-1px); }
-    pre {
-      margin: 0;
-      background: #1b1f24;
-      color: #e9f1ff;
-      padding: 10px;
-      border-radius: 10px;
-      min-height: 80px;
-      overflow: auto;
-    }
-    .help {
-      font-size: 13px;
-      line-height: 1.4;
-      background: #f8f2e4;
-      border: 1px solid var(--line);
-      border-radius: 10px;
-      padding: 8px;
-    }
-  </style>
-</head>
-<body>
-  <div class="wrap">
-    <h1>ESP32 Script Runtime</h1>
-    <div class="grid">
-      <textarea id="script"></textarea>
-      <div class="row">
-        <button id="save">Salvar Script</button>
-        <button id="run" class="warn">Executar</button>
-        <button id="stop" class="alt">Parar</button>
-        <button id="refresh">Status</button>
-      </div>
-      <div class="help">
-        Comandos:\nON pin\nOFF pin\nWAIT ms\nCOUNT nome INC [valor]\nCOUNT nome DEC [valor]\nCOUNT nome SET valor\nCOUNT nome RESET
-      </div>
-      <pre id="out"></pre>
-    </div>
-  </div>
-  <script>
-    const scriptEl = document.getElementById('script');
-    const outEl = document.getElementById('out');
-
-    const show = (msg) => { outEl.textContent = msg; };
-
-    async function loadScript() {
-      const r = await fetch('/api/script');
-      scriptEl.value = await r.text();
-    }
-
-    async function saveScript() {
-      const r = await fetch('/api/script', { method: 'POST', body: scriptEl.value });
-      show(await r.text());
-    }
-
-    async function runScript() {
-      const r = await fetch('/api/run', { method: 'POST' });
-      show(await r.text());
-      await getStatus();
-    }
-
-    async function stopScript() {
-      const r = await fetch('/api/stop', { method: 'POST' });
-      show(await r.text());
-      await getStatus();
-    }
+// Como slotArg(), mas sem responder: serve ao handler do corpo.
+bool WebControlServer::parseSlot(size_t& slot) {
+  const long value = server_.hasArg("slot") ? server_.arg("slot").toInt() : -1;
+  if (value < 0 || value >= static_cast<long>(ScriptScheduler::kMaxTasks)) {
+    return false;
+  }
 
-    async function getStatus() {
-      const r = await fetch('/api/status');
-      show(JSON.stringify(await r.json(), null, 2));
-    }
+  slot = static_cast<size_t>(value);
+  return true;
+}
 
-    document.getElementById('save').onclick = saveScript;
-    document.getElementById('run').onclick = runScript;
-    document.getElementById('stop').onclick = stopScript;
-    document.getElementById('refresh').onclick = getStatus;
+bool WebControlServer::slotArg(size_t& slot) {
+  if (!parseSlot(slot)) {
+    server_.send(400, "application/json", "{\"error\":\"slot_invalido\"}");
+    return false;
+  }
+  return true;
+}
 
-    loadScript().then(getStatus);
-    setInterval(getStatus, 1000);
-  </script>
-</body>
-</html>
-)HTML";
+void WebControlServer::sendScript(size_t slot) {
+  const String path = scriptPath(slot);
+  File file = SPIFFS.exists(path) ? SPIFFS.open(path, FILE_READ) : File();
+  if (!file) {
+    server_.send(200, "text/plain; charset=utf-8", "");
+    return;
+  }
 
-  server_.send(200, "text/html", page);
+  server_.streamFile(file, "text/plain; charset=utf-8");
+  file.close();
 }
 
-void WebControlServer::handleGetScript() {
-  server_.send(200, "text/plain; charset=utf-8", script_);
+// Cada bloco do corpo vai direto para o compilador do slot e para o
+// arquivo temporario. O slot so e parado no primeiro bloco: corpo vazio
+// nao mexe no script atual.
+void WebControlServer::receiveScript(size_t slot) {
+  HTTPRaw& raw = server_.raw();
+
+  switch (raw.status) {
+    case RAW_START:
+      uploadBytes_ = 0;
+      uploadOk_ = true;
+      uploadSaved_ = true;
+      break;
+
+    case RAW_WRITE:
+      if (raw.currentSize == 0 || !uploadOk_) {
+        break;
+      }
+      if (uploadBytes_ == 0) {
+        upload_ = SPIFFS.open(kUploadPath, FILE_WRITE);
+        uploadSaved_ = static_cast<bool>(upload_);
+        uploadOk_ = scheduler_.beginLoad(slot);
+      }
+      uploadBytes_ += raw.currentSize;
+      uploadOk_ = uploadOk_ && scheduler_.feed(slot, reinterpret_cast<const char*>(raw.buf), raw.currentSize);
+      if (uploadOk_ && uploadSaved_) {
+        uploadSaved_ = upload_.write(raw.buf, raw.currentSize) == raw.currentSize;
+      }
+      break;
+
+    case RAW_END:
+      if (upload_) {
+        upload_.close();
+      }
+      // Flash cheia no meio, ou corpo que nao chegou inteiro.
+      if (uploadBytes_ != raw.totalSize) {
+        uploadSaved_ = false;
+      }
+      break;
+
+    case RAW_ABORTED:
+      // Cliente caiu no meio: descarta o parcial e volta ao script gravado.
+      if (upload_) {
+        upload_.close();
+      }
+      SPIFFS.remove(kUploadPath);
+      if (uploadBytes_ > 0) {
+        String error;
+        scheduler_.endLoad(slot, error);
+        loadScriptFromStorage(slot);
+      }
+      uploadBytes_ = 0;
+      uploadOk_ = false;
+      break;
+  }
 }
 
-void WebControlServer::handleSetScript() {
-  const String incoming = server_.arg("plain");
-  if (incoming.isEmpty()) {
+void WebControlServer::finishScript(size_t slot) {
+  if (uploadBytes_ == 0) {
     server_.send(400, "application/json", "{\"error\":\"script_vazio\"}");
     return;
   }
+  uploadBytes_ = 0;
 
+  // Falhou: o slot ficou com o bytecode vazio do beginLoad(), mas o arquivo
+  // ainda e o script anterior; recompila-o para os dois baterem.
   String error;
-  if (!vm_.loadScript(incoming, error)) {
-    String safeError = error;
-    safeError.replace("\\", "\\\\");
-    safeError.replace("\"", "\\\"");
-    String payload = "{\"error\":\"" + safeError + "\"}";
-    server_.send(400, "application/json", payload);
+  if (!scheduler_.endLoad(slot, error)) {
+    SPIFFS.remove(kUploadPath);
+    loadScriptFromStorage(slot);
+    sendError(error);
+    return;
+  }
+
+  // Compilou, mas o temporario esta incompleto: mantem o script gravado e
+  // volta o slot para ele.
+  if (!uploadSaved_) {
+    SPIFFS.remove(kUploadPath);
+    loadScriptFromStorage(slot);
+    server_.send(500, "application/json", "{\"error\":\"falha_ao_gravar\"}");
     return;
   }
 
-  script_ = incoming;
-  saveScriptToStorage(script_);
+  SPIFFS.remove(scriptPath(slot));
+  if (!SPIFFS.rename(kUploadPath, scriptPath(slot))) {
+    // O slot ja roda o script novo; o temporario fica como unica copia.
+    server_.send(500, "application/json", "{\"error\":\"falha_ao_renomear\"}");
+    return;
+  }
   server_.send(200, "application/json", "{\"ok\":true,\"message\":\"script_salvo\"}");
 }
 
+void WebControlServer::sendError(const String& error) {
+  String safeError = error;
+  safeError.replace("\\", "\\\\");
+  safeError.replace("\"", "\\\"");
+  server_.send(400, "application/json", "{\"error\":\"" + safeError + "\"}");
+}
+
+void WebControlServer::handleRoot() {
+  serveStaticAsset(server_, INDEX_HTML);
+}
+
 void WebControlServer::handleRun() {
-  vm_.start();
+  startSlot(0);
+}
+
+// ?mode=timer roda o slot no esp_timer (ScriptTimer) em vez de no loop().
+void WebControlServer::startSlot(size_t slot) {
+  if (server_.arg("mode") == "timer") {
+    String error;
+    if (!scheduler_.startTimed(slot, error)) {
+      sendError(error);
+      return;
+    }
+  } else {
+    scheduler_.start(slot);
+  }
+
   server_.send(200, "application/json", "{\"ok\":true,\"message\":\"executando\"}");
 }
 
 void WebControlServer::handleStop() {
-  vm_.stop();
+  scheduler_.stop(0);
   server_.send(200, "application/json", "{\"ok\":true,\"message\":\"parado\"}");
 }
 
+// "heap" e para acompanhar fragmentacao em teste longo: free cai com
+// vazamento, largest cai com fragmentacao.
 void WebControlServer::handleStatus() {
-  server_.send(200, "application/json", vm_.getStatusJson());
+  JsonResponse json(server_);
+  json.beginObject();
+  scheduler_.task(0).writeStatusFields(json);
+  json.key("counters");
+  counters_.writeJson(json);
+  json.key("heap").beginObject();
+  json.field("free", ESP.getFreeHeap());
+  json.field("largest", ESP.getMaxAllocHeap());
+  json.field("minFree", ESP.getMinFreeHeap());
+  json.endObject();
+  json.endObject();
+}
+
+void WebControlServer::handleGetCounters() {
+  JsonResponse json(server_);
+  counters_.writeJson(json);
+}
+
+// POST /api/counters?name=<nome>[&value=<n>]: cria ou ajusta um contador.
+void WebControlServer::handleSetCounter() {
+  const String name = server_.arg("name");
+  const int32_t value = server_.hasArg("value") ? server_.arg("value").toInt() : 0;
+  if (!counters_.set(name, value)) {
+    server_.send(400, "application/json", "{\"error\":\"contador_invalido\"}");
+    return;
+  }
+
+  server_.send(200, "application/json", "{\"ok\":true,\"message\":\"contador_salvo\"}");
+}
+
+// Zera os valores; os nomes continuam valendo para o script carregado.
+// Com ?names=1 tambem libera os nomes (os criados pela API e os de scripts
+// antigos ocupam ids ate kMaxCounters): os ids ficam invalidos, entao os
+// slots param e os scripts gravados sao recompilados, internando de novo so
+// os nomes que ainda usam.
+void WebControlServer::handleResetCounters() {
+  if (server_.arg("names") != "1") {
+    counters_.resetAll();
+    server_.send(200, "application/json", "{\"ok\":true,\"message\":\"contadores_zerados\"}");
+    return;
+  }
+
+  // Para e esvazia cada slot: nenhum bytecode fica com id antigo, nem o
+  // de slot sem script gravado.
+  for (size_t slot = 0; slot < ScriptScheduler::kMaxTasks; ++slot) {
+    String error;
+    scheduler_.beginLoad(slot);
+    scheduler_.endLoad(slot, error);
+  }
+  counters_.clear();
+  for (size_t slot = 0; slot < ScriptScheduler::kMaxTasks; ++slot) {
+    loadScriptFromStorage(slot);
+  }
+  server_.send(200, "application/json", "{\"ok\":true,\"message\":\"contadores_removidos\"}");
+}
+
+void WebControlServer::handleGetTasks() {
+  JsonResponse json(server_);
+  json.beginObject().key("tasks");
+  scheduler_.writeTasks(json);
+  json.field("runnable", scheduler_.runnableCount());
+  json.key("counters");
+  counters_.writeJson(json);
+  json.endObject();
 }
@@ -1,14 +1,16 @@
 #pragma once
 
 #include <Arduino.h>
+#include <FS.h>
 #include <WebServer.h>
 #include <WiFi.h>
 
-#include "vm/script_vm.h"
+#include "counters/counter_store.h"
+#include "vm/script_scheduler.h"
 
 class WebControlServer {
 public:
-  explicit WebControlServer(ScriptVM& vm);
+  WebControlServer(ScriptScheduler& scheduler, CounterStore& counters);
 
   void begin(const char* apSsid, const char* apPassword);
   void loop();
@@ -17,17 +19,34 @@ public:
 
 private:
   WebServer server_;
-  ScriptVM& vm_;
-  String script_;
+  ScriptScheduler& scheduler_;
+  CounterStore& counters_;
+  // Upload em curso: o corpo vai em blocos para o compilador e para um
+  // arquivo temporario, que so substitui o script se compilar e se o
+  // arquivo tiver sido gravado inteiro (uploadSaved_).
+  File upload_;
+  size_t uploadBytes_;
+  bool uploadOk_;
+  bool uploadSaved_;
 
   void setupRoutes();
-  bool loadScriptFromStorage();
-  bool saveScriptToStorage(const String& script);
+  static String scriptPath(size_t slot);
+  bool loadScriptFromStorage(size_t slot);
+  bool saveScriptToStorage(size_t slot, const char* script);
+  bool parseSlot(size_t& slot);
+  bool slotArg(size_t& slot);
+  void sendScript(size_t slot);
+  void receiveScript(size_t slot);
+  void finishScript(size_t slot);
+  void startSlot(size_t slot);
+  void sendError(const String& error);
 
   void handleRoot();
-  void handleGetScript();
-  void handleSetScript();
   void handleRun();
   void handleStop();
   void handleStatus();
+  void handleGetCounters();
+  void handleSetCounter();
+  void handleResetCounters();
+  void handleGetTasks();
 };
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <Arduino.h>
+#include <WebServer.h>
+
+#include "JsonWriter.h"
+
+// JsonWriter ligado à resposta do WebServer: cabeçalhos com
+// Transfer-Encoding: chunked e o JSON sai em blocos de kBufferSize bytes
+// direto para o socket, sem montar String. A resposta termina no destrutor.
+//
+//     void handleStatus() {
+//         JsonResponse json(server);
+//         json.beginObject().field("ok", true).endObject();
+//     }
+class JsonResponse : public JsonWriter {
+public:
+    static constexpr size_t kBufferSize = 256;
+
+    explicit JsonResponse(WebServer& server, int code = 200)
+        : JsonWriter(buffer_, sizeof(buffer_), &JsonResponse::send, this), server_(server) {
+        server_.setContentLength(CONTENT_LENGTH_UNKNOWN);
+        server_.send(code, "application/json", "");
+    }
+
+    ~JsonResponse() {
+        flush();
+        server_.sendContent("", 0);   // Bloco vazio: fim do chunked
+    }
+
+    JsonResponse(const JsonResponse&) = delete;
+    JsonResponse& operator=(const JsonResponse&) = delete;
+
+private:
+    WebServer& server_;
+    char buffer_[kBufferSize];
+
+    static void send(void* context, const char* data, size_t length) {
+        static_cast<JsonResponse*>(context)->server_.sendContent(data, length);
+    }
+};
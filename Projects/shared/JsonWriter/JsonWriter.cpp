@@ -0,0 +1,260 @@
+#include "JsonWriter.h"
+
+#include <math.h>
+
+JsonWriter::JsonWriter(char* buffer, size_t capacity, Sink sink, void* context)
+    : buffer_(buffer),
+      capacity_(capacity),
+      used_(0),
+      total_(0),
+      sink_(sink),
+      context_(context),
+      hasItems_(0),
+      depth_(0),
+      afterKey_(false),
+      overflowed_(false) {}
+
+JsonWriter& JsonWriter::beginObject() {
+    open('{');
+    return *this;
+}
+
+JsonWriter& JsonWriter::endObject() {
+    close('}');
+    return *this;
+}
+
+JsonWriter& JsonWriter::beginArray() {
+    open('[');
+    return *this;
+}
+
+JsonWriter& JsonWriter::endArray() {
+    close(']');
+    return *this;
+}
+
+JsonWriter& JsonWriter::key(const char* name) {
+    separate();
+    put('"');
+    putEscaped(name, strlen(name));
+    put('"');
+    put(':');
+    afterKey_ = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(const char* text) {
+    return text == nullptr ? null() : value(text, strlen(text));
+}
+
+JsonWriter& JsonWriter::value(const char* text, size_t length) {
+    separate();
+    put('"');
+    putEscaped(text, length);
+    put('"');
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(bool flag) {
+    separate();
+    if (flag) {
+        put("true", 4);
+    } else {
+        put("false", 5);
+    }
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(long long number) {
+    separate();
+    if (number < 0) {
+        put('-');
+        // Sem estouro em LLONG_MIN.
+        putUnsigned(0ULL - static_cast<unsigned long long>(number));
+    } else {
+        putUnsigned(static_cast<unsigned long long>(number));
+    }
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(unsigned long long number) {
+    separate();
+    putUnsigned(number);
+    return *this;
+}
+
+// Sem printf: "%f" puxa o dtoa da newlib, que aloca na primeira chamada.
+JsonWriter& JsonWriter::value(double number, uint8_t decimals) {
+    if (decimals > 6) {
+        decimals = 6;
+    }
+
+    unsigned long long scale = 1;
+    for (uint8_t i = 0; i < decimals; ++i) {
+        scale *= 10;
+    }
+
+    // O limite vale para o valor já escalado: acima de 2^53 o double perde
+    // unidades e, mais adiante, a conversão para inteiro estoura.
+    if (isnan(number) || isinf(number) || fabs(number) * scale >= 9.0e15) {
+        return null();
+    }
+
+    const bool negative = number < 0;
+    const unsigned long long scaled = static_cast<unsigned long long>(fabs(number) * scale + 0.5);
+
+    separate();
+    if (negative && scaled != 0) {
+        put('-');
+    }
+    putUnsigned(scaled / scale);
+    if (decimals > 0) {
+        put('.');
+        unsigned long long fraction = scaled % scale;
+        char digits[6];
+        for (uint8_t i = decimals; i > 0; --i) {
+            digits[i - 1] = static_cast<char>('0' + fraction % 10);
+            fraction /= 10;
+        }
+        put(digits, decimals);
+    }
+    return *this;
+}
+
+JsonWriter& JsonWriter::null() {
+    separate();
+    put("null", 4);
+    return *this;
+}
+
+JsonWriter& JsonWriter::raw(const char* json) {
+    separate();
+    put(json, strlen(json));
+    return *this;
+}
+
+void JsonWriter::flush() {
+    if (sink_ != nullptr && used_ > 0) {
+        sink_(context_, buffer_, used_);
+        used_ = 0;
+    }
+}
+
+const char* JsonWriter::c_str() {
+    if (capacity_ == 0) {
+        return "";
+    }
+    buffer_[used_ < capacity_ ? used_ : capacity_ - 1] = '\0';
+    return buffer_;
+}
+
+// Vírgula antes de cada elemento, menos o primeiro do nível e o valor
+// logo após a chave.
+void JsonWriter::separate() {
+    if (afterKey_) {
+        afterKey_ = false;
+        return;
+    }
+    if (depth_ == 0) {
+        return;
+    }
+
+    const uint32_t bit = 1UL << (depth_ - 1);
+    if (hasItems_ & bit) {
+        put(',');
+    }
+    hasItems_ |= bit;
+}
+
+void JsonWriter::open(char bracket) {
+    separate();
+    put(bracket);
+    if (depth_ < kMaxDepth) {
+        ++depth_;
+        hasItems_ &= ~(1UL << (depth_ - 1));
+    }
+}
+
+void JsonWriter::close(char bracket) {
+    if (depth_ > 0) {
+        --depth_;
+    }
+    afterKey_ = false;
+    put(bracket);
+}
+
+void JsonWriter::put(char c) {
+    put(&c, 1);
+}
+
+// Sem sink guarda 1 byte para o '\0' de c_str().
+void JsonWriter::put(const char* data, size_t length) {
+    total_ += length;
+    const size_t limit = sink_ != nullptr ? capacity_ : (capacity_ > 0 ? capacity_ - 1 : 0);
+
+    while (length > 0) {
+        if (used_ == limit) {
+            if (sink_ == nullptr || limit == 0) {
+                overflowed_ = true;
+                return;
+            }
+            flush();
+        }
+
+        const size_t room = limit - used_;
+        const size_t chunk = length < room ? length : room;
+        memcpy(buffer_ + used_, data, chunk);
+        used_ += chunk;
+        data += chunk;
+        length -= chunk;
+    }
+}
+
+void JsonWriter::putEscaped(const char* text, size_t length) {
+    static const char kHex[] = "0123456789abcdef";
+
+    size_t start = 0;
+    for (size_t i = 0; i < length; ++i) {
+        const uint8_t c = static_cast<uint8_t>(text[i]);
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+
+        put(text + start, i - start);
+        start = i + 1;
+        switch (c) {
+            case '"':
+                put("\\\"", 2);
+                break;
+            case '\\':
+                put("\\\\", 2);
+                break;
+            case '\n':
+                put("\\n", 2);
+                break;
+            case '\r':
+                put("\\r", 2);
+                break;
+            case '\t':
+                put("\\t", 2);
+                break;
+            default: {
+                const char escaped[] = {'\\', 'u', '0', '0', kHex[c >> 4], kHex[c & 0x0F]};
+                put(escaped, sizeof(escaped));
+                break;
+            }
+        }
+    }
+    put(text + start, length - start);
+}
+
+void JsonWriter::putUnsigned(unsigned long long number) {
+    char digits[20];
+    size_t count = 0;
+    do {
+        digits[sizeof(digits) - 1 - count++] = static_cast<char>('0' + number % 10);
+        number /= 10;
+    } while (number != 0);
+    put(digits + sizeof(digits) - count, count);
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Escritor de JSON sem heap: monta o texto num buffer fornecido por quem
+// chama (pilha ou membro) e, quando ele enche, entrega o bloco ao sink
+// (p. ex. a resposta chunked do WebServer, ver JsonResponse.h). Sem sink o
+// texto fica no buffer e o excedente é descartado (overflowed()).
+//
+// Vírgulas e aspas ficam por conta do escritor:
+//     json.beginObject().field("rpm", 812.5f, 1).key("ids").beginArray();
+//     json.value(0x201).value(0x420).endArray().endObject();
+class JsonWriter {
+public:
+    using Sink = void (*)(void* context, const char* data, size_t length);
+
+    // Profundidade máxima de objetos/arrays aninhados.
+    static constexpr uint8_t kMaxDepth = 32;
+
+    JsonWriter(char* buffer, size_t capacity, Sink sink = nullptr, void* context = nullptr);
+
+    JsonWriter& beginObject();
+    JsonWriter& endObject();
+    JsonWriter& beginArray();
+    JsonWriter& endArray();
+    JsonWriter& key(const char* name);
+
+    // Texto com escape; nullptr vira null.
+    JsonWriter& value(const char* text);
+    JsonWriter& value(const char* text, size_t length);
+    JsonWriter& value(const String& text) { return value(text.c_str(), text.length()); }
+    JsonWriter& value(bool flag);
+    JsonWriter& value(int number) { return value(static_cast<long long>(number)); }
+    JsonWriter& value(unsigned number) { return value(static_cast<unsigned long long>(number)); }
+    JsonWriter& value(long number) { return value(static_cast<long long>(number)); }
+    JsonWriter& value(unsigned long number) { return value(static_cast<unsigned long long>(number)); }
+    JsonWriter& value(long long number);
+    JsonWriter& value(unsigned long long number);
+    // Ponto fixo com 'decimals' casas (até 6); NaN/infinito viram null.
+    JsonWriter& value(double number, uint8_t decimals);
+    JsonWriter& null();
+    // Fragmento JSON já pronto, copiado como está.
+    JsonWriter& raw(const char* json);
+
+    template <typename T>
+    JsonWriter& field(const char* name, T v) {
+        return key(name).value(v);
+    }
+    JsonWriter& field(const char* name, double number, uint8_t decimals) {
+        return key(name).value(number, decimals);
+    }
+
+    // Entrega ao sink o que estiver no buffer.
+    void flush();
+
+    // Texto acumulado (terminado em '\0'); com sink, só o que falta enviar.
+    const char* c_str();
+    size_t length() const { return used_; }
+    // Bytes gerados desde o início, enviados ou não.
+    size_t total() const { return total_; }
+    // Sem sink, o buffer encheu e o JSON saiu truncado.
+    bool overflowed() const { return overflowed_; }
+
+private:
+    char* buffer_;
+    size_t capacity_;
+    size_t used_;
+    size_t total_;
+    Sink sink_;
+    void* context_;
+    uint32_t hasItems_;    // Bit por nível: já tem elemento, precisa de vírgula
+    uint8_t depth_;
+    bool afterKey_;
+    bool overflowed_;
+
+    void separate();
+    void open(char bracket);
+    void close(char bracket);
+    void put(char c);
+    void put(const char* data, size_t length);
+    void putEscaped(const char* text, size_t length);
+    void putUnsigned(unsigned long long number);
+};
@@ -0,0 +1,30 @@
+#include "StaticAsset.h"
+
+namespace {
+
+const char IF_NONE_MATCH[] = "If-None-Match";
+
+// If-None-Match aceita lista de ETags, forma fraca (W/"...") e "*".
+bool etagMatches(const String& header, const char* etag) {
+    if (header.length() == 0) return false;
+    if (header == "*") return true;
+    return strstr(header.c_str(), etag) != nullptr;
+}
+
+} // namespace
+
+void staticAssetHeaders(WebServer& server) {
+    static const char* keys[] = {IF_NONE_MATCH};
+    server.collectHeaders(keys, 1);
+}
+
+void serveStaticAsset(WebServer& server, const StaticAsset& asset, const char* cacheControl) {
+    server.sendHeader("ETag", asset.etag);
+    server.sendHeader("Cache-Control", cacheControl);
+    if (etagMatches(server.header(IF_NONE_MATCH), asset.etag)) {
+        server.send(304);
+        return;
+    }
+    server.sendHeader("Content-Encoding", "gzip");
+    server.send_P(200, asset.contentType, reinterpret_cast<const char*>(asset.data), asset.length);
+}
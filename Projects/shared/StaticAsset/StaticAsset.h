@@ -0,0 +1,24 @@
+#pragma once
+
+#include <Arduino.h>
+#include <WebServer.h>
+
+// Arquivo estático comprimido com gzip no build (shared/gzip_assets.py) e
+// gravado na flash. O navegador descompacta; o ESP32 só copia os bytes.
+struct StaticAsset {
+    const uint8_t* data;
+    size_t length;
+    const char* etag;         // Forte e entre aspas: hash do conteúdo comprimido
+    const char* contentType;
+};
+
+// Passa a guardar o cabeçalho If-None-Match das requisições (o WebServer só
+// guarda os registrados). Chamar antes de server.begin(); substitui uma
+// lista anterior de collectHeaders.
+void staticAssetHeaders(WebServer& server);
+
+// Envia o asset com Content-Encoding: gzip, ETag e Cache-Control. Se o
+// navegador revalidar com o mesmo ETag responde 304 sem corpo.
+// "no-cache" guarda a página mas revalida a cada carga, então um firmware
+// novo aparece na hora e uma página igual custa só o 304.
+void serveStaticAsset(WebServer& server, const StaticAsset& asset, const char* cacheControl = "no-cache");
@@ -0,0 +1,110 @@
+"""Compacta as páginas web com gzip em arrays na flash (StaticAsset).
+
+No platformio.ini do projeto:
+
+    lib_extra_dirs = ../shared
+    extra_scripts = pre:../shared/gzip_assets.py
+    custom_web_assets =
+        web/index.html INDEX_HTML
+
+Cada linha de custom_web_assets: <arquivo> <NOME> [content-type]. Antes de
+cada build é gerado include/web_assets.h com um StaticAsset NOME por arquivo
+(dados gzip, ETag forte derivado do conteúdo e content-type). O header só é
+regravado quando muda, para não forçar recompilação.
+
+Também roda fora do PlatformIO: python gzip_assets.py <pasta do projeto>
+"""
+
+import configparser
+import gzip
+import hashlib
+import os
+import sys
+
+OUTPUT = os.path.join("include", "web_assets.h")
+
+CONTENT_TYPES = {
+    ".html": "text/html; charset=utf-8",
+    ".htm": "text/html; charset=utf-8",
+    ".css": "text/css",
+    ".js": "application/javascript",
+    ".json": "application/json",
+    ".svg": "image/svg+xml",
+    ".ico": "image/x-icon",
+}
+
+
+def parse_spec(text):
+    assets = []
+    for line in text.splitlines():
+        line = line.split(";", 1)[0].strip()
+        if not line:
+            continue
+        parts = line.split()
+        if len(parts) < 2:
+            raise ValueError("custom_web_assets: esperado '<arquivo> <NOME> [content-type]': " + line)
+        path, name = parts[0], parts[1]
+        ctype = " ".join(parts[2:]) or CONTENT_TYPES.get(os.path.splitext(path)[1].lower(), "application/octet-stream")
+        assets.append((path, name, ctype))
+    return assets
+
+
+def render(project_dir, assets):
+    out = [
+        "// Gerado por shared/gzip_assets.py a partir de custom_web_assets"
+        " (platformio.ini). Não editar:",
+        "// altere os arquivos de origem.",
+        "#pragma once",
+        "",
+        "#include <StaticAsset.h>",
+    ]
+    for path, name, ctype in assets:
+        with open(os.path.join(project_dir, path), "rb") as f:
+            raw = f.read()
+        # mtime=0: mesma entrada, mesmos bytes (e mesmo ETag) a cada build.
+        packed = gzip.compress(raw, compresslevel=9, mtime=0)
+        etag = hashlib.sha1(packed).hexdigest()[:16]
+        out.append("")
+        out.append("// %s: %d -> %d bytes" % (path, len(raw), len(packed)))
+        out.append("static const uint8_t %s_GZ[] PROGMEM = {" % name)
+        for i in range(0, len(packed), 16):
+            out.append("    " + ", ".join("0x%02x" % b for b in packed[i:i + 16]) + ",")
+        out.append("};")
+        out.append('static const StaticAsset %s = {%s_GZ, sizeof(%s_GZ), "\\"%s\\"", "%s"};'
+                   % (name, name, name, etag, ctype))
+        print("[gzip_assets] %s -> %s: %d -> %d bytes" % (path, name, len(raw), len(packed)))
+    return "\n".join(out) + "\n"
+
+
+def generate(project_dir, spec):
+    assets = parse_spec(spec)
+    if not assets:
+        return
+    text = render(project_dir, assets)
+    target = os.path.join(project_dir, OUTPUT)
+    if os.path.exists(target):
+        with open(target, "r", encoding="utf-8") as f:
+            if f.read() == text:
+                return
+    os.makedirs(os.path.dirname(target), exist_ok=True)
+    with open(target, "w", encoding="utf-8") as f:
+        f.write(text)
+
+
+def spec_from_ini(project_dir):
+    ini = configparser.ConfigParser(interpolation=None)
+    ini.read(os.path.join(project_dir, "platformio.ini"), encoding="utf-8")
+    for section in ini.sections():
+        if section == "env" or section.startswith("env:"):
+            if ini.has_option(section, "custom_web_assets"):
+                return ini.get(section, "custom_web_assets")
+    return ""
+
+
+try:
+    Import("env")  # noqa: F821 - fornecido pelo SCons do PlatformIO
+    generate(env.subst("$PROJECT_DIR"), env.GetProjectOption("custom_web_assets", ""))  # noqa: F821
+except NameError:
+    if __name__ == "__main__":
+        directory = sys.argv[1] if len(sys.argv) > 1 else "."
+        generate(directory, spec_from_ini(directory))